@@ -86,7 +86,14 @@ namespace Falcor
             {
                 gpDevice->getResourceAllocator()->release(mDynamicData);
             }
-            mDynamicData = gpDevice->getResourceAllocator()->allocate(mSize, getBufferDataAlignment(this));
+            if (mTransientDynamicData)
+            {
+                mDynamicData = gpDevice->getResourceAllocator()->allocateTransient(mSize, getBufferDataAlignment(this));
+            }
+            else
+            {
+                mDynamicData = gpDevice->getResourceAllocator()->allocate(mSize, getBufferDataAlignment(this));
+            }
             mApiHandle = mDynamicData.pResourceHandle;
             invalidateViews();
             return mDynamicData.pData;
@@ -131,8 +138,7 @@ namespace Falcor
 
         mCommandsPending = true;
         // Allocate a buffer on the upload heap
-        uint8_t* pInitData = (uint8_t*)pData + offset;
-        Buffer::SharedPtr pUploadBuffer = Buffer::create(numBytes, Buffer::BindFlags::None, Buffer::CpuAccess::Write, pInitData);
+        Buffer::SharedPtr pUploadBuffer = Buffer::create(numBytes, Buffer::BindFlags::None, Buffer::CpuAccess::Write, pData);
 
         copyBufferRegion(pBuffer, offset, pUploadBuffer.get(), 0, numBytes);
     }
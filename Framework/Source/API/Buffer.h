@@ -146,6 +146,7 @@ namespace Falcor
         size_t mSize = 0;
         CpuAccess mCpuAccess;
         ResourceAllocator::AllocationData mDynamicData;
+        bool mTransientDynamicData = false; // Map with WriteDiscard allocates with ResourceAllocator::allocateTransient(). The owner has to update the buffer again once the allocation is retired.
         Buffer::SharedPtr mpStagingResource; // For buffers that have both CPU read flag and can be used by the GPU
     };
 }
\ No newline at end of file
@@ -41,6 +41,7 @@ namespace Falcor
     ConstantBuffer::ConstantBuffer(const std::string& name, const ReflectionResourceType::SharedConstPtr& pReflectionType, size_t size) :
         VariablesBuffer(name, pReflectionType, size, 1, Buffer::BindFlags::Constant, Buffer::CpuAccess::Write)
     {
+        mTransientDynamicData = true;
     }
 
     ConstantBuffer::SharedPtr ConstantBuffer::create(const std::string& name, const ReflectionResourceType::SharedConstPtr& pReflectionType, size_t overrideSize)
@@ -70,7 +71,9 @@ namespace Falcor
 
     bool ConstantBuffer::uploadToGPU(size_t offset, size_t size)
     {
-        if (mDirty) mpCbv = nullptr;
+        // Transient pages are recycled once they're retired, so data living in one can't be used by new draws
+        if (gpDevice->getResourceAllocator()->isRetired(mDynamicData)) markDirty(0, mSize);
+        if (isDirty()) mpCbv = nullptr;
         return VariablesBuffer::uploadToGPU(offset, size);
     }
 
@@ -31,6 +31,6 @@ namespace Falcor
 {
     struct LowLevelContextApiData
     {
-        FencedPool<CommandAllocatorHandle>::SharedPtr pAllocatorPool;
+        FencedRecycler<CommandAllocatorHandle>::SharedPtr pAllocatorPool;
     };
 }
\ No newline at end of file
@@ -152,8 +152,9 @@ namespace Falcor
 
         //Get buffer data
         std::vector<uint8> result;
-		uint32_t actualRowSize = footprint.Footprint.Width * getFormatBytesPerBlock(pTexture->getFormat());
-        result.resize(rowCount * actualRowSize);
+        // rowSize accounts for block-compressed formats, where a row is a row of blocks
+        uint32_t actualRowSize = (uint32_t)rowSize;
+        result.resize(rowCount * actualRowSize * footprint.Footprint.Depth);
         uint8* pData = reinterpret_cast<uint8*>(pBuffer->map(Buffer::MapType::Read));
 
         for(uint32_t z = 0 ; z < footprint.Footprint.Depth ; z++)
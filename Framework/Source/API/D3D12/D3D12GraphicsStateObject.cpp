@@ -33,6 +33,7 @@
 #include "API/FBO.h"
 #include "API/Texture.h"
 #include "API/Device.h"
+#include "API/GraphicsStateCache.h"
 
 namespace Falcor
 {
@@ -99,6 +100,87 @@ namespace Falcor
     bool getIsNvApiGraphicsPsoRequired(const GraphicsStateObject::Desc& desc) { return false; }
 #endif
     
+    /** Hash everything in a pipeline desc which affects the compiled pipeline. Used as the key in the GraphicsStateCache's pipeline library.
+        The root signature isn't included. If a library pipeline was compiled with a different one, the device rejects it and the pipeline is compiled again.
+    */
+    static uint64_t hashPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+    {
+        // 64-bit FNV-1a. Structs with padding are hashed field by field.
+        uint64_t hash = 0xcbf29ce484222325ull;
+        auto combineData = [&hash](const void* pData, size_t size)
+        {
+            const uint8_t* pBytes = (const uint8_t*)pData;
+            for (size_t i = 0; i < size; i++)
+            {
+                hash ^= pBytes[i];
+                hash *= 0x100000001b3ull;
+            }
+        };
+        auto combine = [&combineData](uint64_t value) { combineData(&value, sizeof(value)); };
+
+        for (const D3D12_SHADER_BYTECODE* pShader : { &desc.VS, &desc.PS, &desc.GS, &desc.HS, &desc.DS })
+        {
+            combine(pShader->BytecodeLength);
+            combineData(pShader->pShaderBytecode, pShader->BytecodeLength);
+        }
+
+        combine(desc.BlendState.AlphaToCoverageEnable);
+        combine(desc.BlendState.IndependentBlendEnable);
+        for (const auto& rt : desc.BlendState.RenderTarget)
+        {
+            combine(rt.BlendEnable);
+            combine(rt.LogicOpEnable);
+            combine(rt.SrcBlend);
+            combine(rt.DestBlend);
+            combine(rt.BlendOp);
+            combine(rt.SrcBlendAlpha);
+            combine(rt.DestBlendAlpha);
+            combine(rt.BlendOpAlpha);
+            combine(rt.LogicOp);
+            combine(rt.RenderTargetWriteMask);
+        }
+        combine(desc.SampleMask);
+        combineData(&desc.RasterizerState, sizeof(desc.RasterizerState));
+
+        const D3D12_DEPTH_STENCIL_DESC& ds = desc.DepthStencilState;
+        combine(ds.DepthEnable);
+        combine(ds.DepthWriteMask);
+        combine(ds.DepthFunc);
+        combine(ds.StencilEnable);
+        combine(ds.StencilReadMask);
+        combine(ds.StencilWriteMask);
+        for (const D3D12_DEPTH_STENCILOP_DESC* pFace : { &ds.FrontFace, &ds.BackFace })
+        {
+            combineData(pFace, sizeof(*pFace));
+        }
+
+        for (uint32_t i = 0; i < desc.InputLayout.NumElements; i++)
+        {
+            const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+            combineData(element.SemanticName, strlen(element.SemanticName));
+            combine(element.SemanticIndex);
+            combine(element.Format);
+            combine(element.InputSlot);
+            combine(element.AlignedByteOffset);
+            combine(element.InputSlotClass);
+            combine(element.InstanceDataStepRate);
+        }
+
+        combine(desc.IBStripCutValue);
+        combine(desc.PrimitiveTopologyType);
+        combine(desc.NumRenderTargets);
+        for (uint32_t rt = 0; rt < desc.NumRenderTargets; rt++)
+        {
+            combine(desc.RTVFormats[rt]);
+        }
+        combine(desc.DSVFormat);
+        combine(desc.SampleDesc.Count);
+        combine(desc.SampleDesc.Quality);
+        combine(desc.NodeMask);
+        combine(desc.Flags);
+        return hash;
+    }
+
     bool GraphicsStateObject::apiInit()
     {
         D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
@@ -149,7 +231,27 @@ namespace Falcor
         }
         else
         {
-            d3d_call(gpDevice->getApiHandle()->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&mApiHandle)));
+            // Start from the compiled pipeline in the library if there is one. The device rejects it if it was compiled by a different driver or GPU, or with a different root signature.
+            const uint64_t contentHash = hashPipelineDesc(desc);
+            std::vector<uint8_t> cachedBlob;
+            bool fromLibrary = false;
+            if (GraphicsStateCache::findPipeline(contentHash, cachedBlob))
+            {
+                desc.CachedPSO.pCachedBlob = cachedBlob.data();
+                desc.CachedPSO.CachedBlobSizeInBytes = cachedBlob.size();
+                fromLibrary = SUCCEEDED(gpDevice->getApiHandle()->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&mApiHandle)));
+                desc.CachedPSO = {};
+            }
+
+            if (fromLibrary == false)
+            {
+                d3d_call(gpDevice->getApiHandle()->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&mApiHandle)));
+                ID3DBlobPtr pBlob;
+                if (mApiHandle && GraphicsStateCache::isPipelineRecordingEnabled() && SUCCEEDED(mApiHandle->GetCachedBlob(&pBlob)))
+                {
+                    GraphicsStateCache::storePipeline(contentHash, pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+                }
+            }
         }
         return true;
     }
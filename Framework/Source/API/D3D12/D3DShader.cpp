@@ -161,14 +161,29 @@ namespace Falcor
 
     bool Shader::init(const Blob& shaderBlob, const std::string& entryPointName, CompilerFlags flags, std::string& log)
     {
-        if (shaderBlob.type != Blob::Type::String)
+        ShaderData* pData = (ShaderData*)mpPrivateData;
+        if (shaderBlob.type == Blob::Type::Bytecode)
+        {
+            // Pre-compiled DXBC, for example from the shader cache
+            ID3DBlob* pBlob = nullptr;
+            if (FAILED(D3DCreateBlob(shaderBlob.data.size(), &pBlob)))
+            {
+                log = "Can't allocate a shader blob";
+                return false;
+            }
+            memcpy(pBlob->GetBufferPointer(), shaderBlob.data.data(), shaderBlob.data.size());
+            pData->pBlob.Attach(pBlob);
+        }
+        else if (shaderBlob.type == Blob::Type::String)
+        {
+            // Compile the shader
+            pData->pBlob = compile(shaderBlob, entryPointName, flags, log);
+        }
+        else
         {
-            logError("D3D shader compilation only supports string inputs");
+            logError("D3D shader creation only supports string or bytecode inputs");
             return false;
         }
-        // Compile the shader
-        ShaderData* pData = (ShaderData*)mpPrivateData;
-        pData->pBlob = compile(shaderBlob, entryPointName, flags, log);
 
         if (pData->pBlob == nullptr)
         {
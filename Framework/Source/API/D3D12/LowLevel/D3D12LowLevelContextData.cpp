@@ -32,8 +32,11 @@
 
 namespace Falcor
 {
+    // Command allocators the GPU is done with which are kept for reuse. Bursts of flushes above this free their allocators.
+    static const uint32_t kMaxAvailableAllocators = 8;
+
     template<D3D12_COMMAND_LIST_TYPE type>
-    static ID3D12CommandAllocatorPtr newCommandAllocator(void* pUserData)
+    static ID3D12CommandAllocatorPtr newCommandAllocator()
     {
         ID3D12CommandAllocatorPtr pAllocator;
         if (FAILED(gpDevice->getApiHandle()->CreateCommandAllocator(type, IID_PPV_ARGS(&pAllocator))))
@@ -56,18 +59,18 @@ namespace Falcor
         switch (cmdListType)
         {
         case D3D12_COMMAND_LIST_TYPE_DIRECT:
-            pThis->mpApiData->pAllocatorPool = FencedPool<CommandAllocatorHandle>::create(pThis->mpFence, newCommandAllocator<D3D12_COMMAND_LIST_TYPE_DIRECT>);
+            pThis->mpApiData->pAllocatorPool = FencedRecycler<CommandAllocatorHandle>::create(pThis->mpFence, newCommandAllocator<D3D12_COMMAND_LIST_TYPE_DIRECT>, nullptr, kMaxAvailableAllocators);
             break;
         case D3D12_COMMAND_LIST_TYPE_COMPUTE:
-            pThis->mpApiData->pAllocatorPool = FencedPool<CommandAllocatorHandle>::create(pThis->mpFence, newCommandAllocator<D3D12_COMMAND_LIST_TYPE_COMPUTE>);
+            pThis->mpApiData->pAllocatorPool = FencedRecycler<CommandAllocatorHandle>::create(pThis->mpFence, newCommandAllocator<D3D12_COMMAND_LIST_TYPE_COMPUTE>, nullptr, kMaxAvailableAllocators);
             break;
         case D3D12_COMMAND_LIST_TYPE_COPY:
-            pThis->mpApiData->pAllocatorPool = FencedPool<CommandAllocatorHandle>::create(pThis->mpFence, newCommandAllocator<D3D12_COMMAND_LIST_TYPE_COPY>);
+            pThis->mpApiData->pAllocatorPool = FencedRecycler<CommandAllocatorHandle>::create(pThis->mpFence, newCommandAllocator<D3D12_COMMAND_LIST_TYPE_COPY>, nullptr, kMaxAvailableAllocators);
             break;
         default:
             should_not_get_here();
         }
-        pThis->mpAllocator = pThis->mpApiData->pAllocatorPool->newObject();
+        pThis->mpAllocator = pThis->mpApiData->pAllocatorPool->acquire();
 
         // Create a command list
         ID3D12Device* pDevice = gpDevice->getApiHandle().GetInterfacePtr();
@@ -87,7 +90,7 @@ namespace Falcor
     void LowLevelContextData::reset()
     {
         mpFence->gpuSignal(mpQueue);
-        mpAllocator = mpApiData->pAllocatorPool->newObject();
+        mpAllocator = mpApiData->pAllocatorPool->exchange(mpAllocator);
         d3d_call(mpList->Close());
         d3d_call(mpAllocator->Reset());
         d3d_call(mpList->Reset(mpAllocator, nullptr));
@@ -27,6 +27,7 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "API/Device.h"
+#include "API/GraphicsStateCache.h"
 #include "VR/OpenVR/VRSystem.h"
 
 namespace Falcor
@@ -70,7 +71,9 @@ namespace Falcor
         mVsyncOn = desc.enableVsync;
 
         // Create the swap-chain
-        mpResourceAllocator = ResourceAllocator::create(1024 * 1024 * 2, mpRenderContext->getLowLevelData()->getFence());
+        // Heaps are larger than linear pages. The transient pages used by constant buffers keep their own, smaller size in both modes.
+        size_t allocatorPageSize = (desc.resourceAllocatorMode == ResourceAllocator::Mode::Tlsf) ? 1024 * 1024 * 64 : 1024 * 1024 * 2;
+        mpResourceAllocator = ResourceAllocator::create(allocatorPageSize, mpRenderContext->getLowLevelData()->getFence(), desc.resourceAllocatorMode);
 
         mpFrameFence = GpuFence::create();
 
@@ -175,6 +178,7 @@ namespace Falcor
 
         for (uint32_t i = 0; i < arraysize(mCmdQueues); i++) mCmdQueues[i].clear();
         for (uint32_t i = 0; i < mSwapChainBufferCount; i++) mpSwapChainFbos[i].reset();
+        GraphicsStateCache::clear();
         mDeferredReleases = decltype(mDeferredReleases)();
 
         mpRenderContext.reset();
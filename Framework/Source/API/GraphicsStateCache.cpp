@@ -0,0 +1,282 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "GraphicsStateCache.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/Platform/OS.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kLibraryMagic = 0x4c4f5347;   // 'GSOL'
+        const uint32_t kLibraryVersion = 1;
+
+        struct Entry
+        {
+            Entry(const GraphicsStateObject::SharedPtr& pGso, uint64_t use) : pGso(pGso), lastUse(use) {}
+            GraphicsStateObject::SharedPtr pGso;
+            std::atomic<uint64_t> lastUse;      // Updated under the shared lock, so lookups don't serialize
+        };
+
+        struct CacheData
+        {
+            std::shared_mutex mutex;
+            std::unordered_multimap<uint64_t, Entry> entries;
+            uint32_t capacity = GraphicsStateCache::kDefaultCapacity;
+            std::atomic<uint64_t> useCounter{ 0 };
+            std::atomic<uint64_t> hits{ 0 };
+            std::atomic<uint64_t> misses{ 0 };
+            std::atomic<uint64_t> evictions{ 0 };
+
+            std::mutex libraryMutex;
+            std::unordered_map<uint64_t, std::vector<uint8_t>> library;
+            std::atomic<bool> recording{ false };
+            std::atomic<uint64_t> libraryHits{ 0 };
+        };
+
+        CacheData& getData()
+        {
+            static CacheData data;
+            return data;
+        }
+
+        GraphicsStateObject::SharedPtr findEntry(CacheData& data, const GraphicsStateObject::Desc& desc, uint64_t hash)
+        {
+            auto range = data.entries.equal_range(hash);
+            for (auto it = range.first; it != range.second; it++)
+            {
+                if (desc == it->second.pGso->getDesc())
+                {
+                    it->second.lastUse.store(data.useCounter++, std::memory_order_relaxed);
+                    return it->second.pGso;
+                }
+            }
+            return nullptr;
+        }
+
+        /** Drop the least recently used entries until the cache is below its capacity. Evicts an eighth of the capacity at once, so the scan is amortized over many insertions.
+            Must be called with the exclusive lock held.
+        */
+        void evict(CacheData& data)
+        {
+            if (data.entries.size() <= data.capacity) return;
+
+            size_t target = data.capacity - data.capacity / 8;
+            std::vector<uint64_t> uses;
+            uses.reserve(data.entries.size());
+            for (const auto& e : data.entries) uses.push_back(e.second.lastUse.load(std::memory_order_relaxed));
+            size_t evictCount = data.entries.size() - target;
+            std::nth_element(uses.begin(), uses.begin() + (evictCount - 1), uses.end());
+            uint64_t threshold = uses[evictCount - 1];
+
+            for (auto it = data.entries.begin(); it != data.entries.end() && evictCount > 0;)
+            {
+                if (it->second.lastUse.load(std::memory_order_relaxed) <= threshold)
+                {
+                    it = data.entries.erase(it);
+                    evictCount--;
+                    data.evictions++;
+                }
+                else
+                {
+                    it++;
+                }
+            }
+        }
+    }
+
+    GraphicsStateObject::SharedPtr GraphicsStateCache::get(const GraphicsStateObject::Desc& desc)
+    {
+        CacheData& data = getData();
+        const uint64_t hash = desc.getHash();
+        {
+            std::shared_lock<std::shared_mutex> lock(data.mutex);
+            GraphicsStateObject::SharedPtr pGso = findEntry(data, desc, hash);
+            if (pGso)
+            {
+                data.hits++;
+                return pGso;
+            }
+        }
+
+        // Create the state object outside of the lock, compiling the pipeline can take a while. If another thread created the same one meanwhile, use theirs.
+        GraphicsStateObject::SharedPtr pNewGso = GraphicsStateObject::create(desc);
+        if (pNewGso == nullptr) return nullptr;
+
+        std::unique_lock<std::shared_mutex> lock(data.mutex);
+        GraphicsStateObject::SharedPtr pGso = findEntry(data, desc, hash);
+        if (pGso)
+        {
+            data.hits++;
+            return pGso;
+        }
+        data.misses++;
+        data.entries.emplace(std::piecewise_construct, std::forward_as_tuple(hash), std::forward_as_tuple(pNewGso, data.useCounter++));
+        evict(data);
+        return pNewGso;
+    }
+
+    void GraphicsStateCache::setCapacity(uint32_t capacity)
+    {
+        CacheData& data = getData();
+        std::unique_lock<std::shared_mutex> lock(data.mutex);
+        data.capacity = std::max(capacity, 1u);
+        evict(data);
+    }
+
+    uint32_t GraphicsStateCache::getCapacity()
+    {
+        CacheData& data = getData();
+        std::shared_lock<std::shared_mutex> lock(data.mutex);
+        return data.capacity;
+    }
+
+    void GraphicsStateCache::clear()
+    {
+        CacheData& data = getData();
+        std::unique_lock<std::shared_mutex> lock(data.mutex);
+        data.entries.clear();
+    }
+
+    GraphicsStateCache::Stats GraphicsStateCache::getStats()
+    {
+        CacheData& data = getData();
+        Stats stats;
+        stats.hits = data.hits;
+        stats.misses = data.misses;
+        stats.evictions = data.evictions;
+        stats.libraryHits = data.libraryHits;
+        {
+            std::shared_lock<std::shared_mutex> lock(data.mutex);
+            stats.entryCount = (uint32_t)data.entries.size();
+        }
+        {
+            std::lock_guard<std::mutex> lock(data.libraryMutex);
+            stats.libraryEntryCount = (uint32_t)data.library.size();
+        }
+        return stats;
+    }
+
+    bool GraphicsStateCache::loadPipelineLibrary(const std::string& filename)
+    {
+        CacheData& data = getData();
+        data.recording = true;
+
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            logWarning("GraphicsStateCache::loadPipelineLibrary() - can't find " + filename + ". Starting with an empty library.");
+            return false;
+        }
+
+        BinaryFileStream stream(fullpath, BinaryFileStream::Mode::Read);
+        uint32_t magic = 0, version = 0, count = 0;
+        stream >> magic >> version >> count;
+        if (stream.isGood() == false || magic != kLibraryMagic || version != kLibraryVersion)
+        {
+            logWarning("GraphicsStateCache::loadPipelineLibrary() - " + filename + " is not a pipeline library or was written by a different version. Starting with an empty library.");
+            return false;
+        }
+
+        std::unordered_map<uint64_t, std::vector<uint8_t>> library;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint64_t hash = 0, size = 0;
+            stream >> hash >> size;
+            if (stream.isGood() == false || size > stream.getRemainingStreamSize())
+            {
+                logWarning("GraphicsStateCache::loadPipelineLibrary() - " + filename + " is truncated. Starting with an empty library.");
+                return false;
+            }
+            std::vector<uint8_t>& blob = library[hash];
+            blob.resize((size_t)size);
+            stream.read(blob.data(), blob.size());
+        }
+
+        std::lock_guard<std::mutex> lock(data.libraryMutex);
+        for (auto& it : library) data.library[it.first] = std::move(it.second);
+        return true;
+    }
+
+    void GraphicsStateCache::setPipelineRecordingEnabled(bool enabled)
+    {
+        getData().recording = enabled;
+    }
+
+    bool GraphicsStateCache::isPipelineRecordingEnabled()
+    {
+        return getData().recording;
+    }
+
+    bool GraphicsStateCache::savePipelineLibrary(const std::string& filename)
+    {
+        CacheData& data = getData();
+        std::lock_guard<std::mutex> lock(data.libraryMutex);
+
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+        stream << kLibraryMagic << kLibraryVersion << (uint32_t)data.library.size();
+        for (const auto& it : data.library)
+        {
+            stream << it.first << (uint64_t)it.second.size();
+            stream.write(it.second.data(), it.second.size());
+        }
+        if (stream.isGood() == false)
+        {
+            logError("GraphicsStateCache::savePipelineLibrary() - can't write " + filename);
+            stream.remove();
+            return false;
+        }
+        return true;
+    }
+
+    bool GraphicsStateCache::findPipeline(uint64_t contentHash, std::vector<uint8_t>& blob)
+    {
+        CacheData& data = getData();
+        std::lock_guard<std::mutex> lock(data.libraryMutex);
+        auto it = data.library.find(contentHash);
+        if (it == data.library.end()) return false;
+        blob = it->second;
+        data.libraryHits++;
+        return true;
+    }
+
+    void GraphicsStateCache::storePipeline(uint64_t contentHash, const void* pData, size_t size)
+    {
+        CacheData& data = getData();
+        if (data.recording == false) return;
+        std::lock_guard<std::mutex> lock(data.libraryMutex);
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        data.library[contentHash].assign(pBytes, pBytes + size);
+    }
+}
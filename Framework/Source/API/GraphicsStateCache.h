@@ -0,0 +1,116 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "API/GraphicsStateObject.h"
+
+namespace Falcor
+{
+    /** Process-wide cache of graphics state objects, shared by all GraphicsState objects.
+        Entries are keyed by GraphicsStateObject::Desc::getHash(). Lookups can be made from any thread.
+        When the cache grows past its capacity, the least recently used entries are dropped. State objects which are still referenced elsewhere stay alive.
+
+        The cache can also keep a pipeline library, which holds the API's compiled pipeline for every state object created in a session.
+        Saving the library at exit and loading it at startup lets later sessions create their state objects without compiling them again.
+        The pipelines are keyed by a hash of their content, since a desc references objects which only exist in the current process.
+    */
+    class GraphicsStateCache
+    {
+    public:
+        static const uint32_t kDefaultCapacity = 4096;
+
+        /** Cache statistics for the current process
+        */
+        struct Stats
+        {
+            uint64_t hits = 0;              ///< Lookups which found an existing state object
+            uint64_t misses = 0;            ///< Lookups which created a state object
+            uint64_t evictions = 0;         ///< Entries dropped because the cache was full
+            uint64_t libraryHits = 0;       ///< Pipelines found in the library
+            uint32_t entryCount = 0;        ///< Number of entries in the cache
+            uint32_t libraryEntryCount = 0; ///< Number of pipelines in the library
+        };
+
+        /** Get the state object matching a desc, creating it if it's not in the cache
+            \return The state object, or nullptr if it couldn't be created
+        */
+        static GraphicsStateObject::SharedPtr get(const GraphicsStateObject::Desc& desc);
+
+        /** Set the maximum number of entries. Excess entries are evicted on the next insertion.
+        */
+        static void setCapacity(uint32_t capacity);
+
+        /** Get the maximum number of entries
+        */
+        static uint32_t getCapacity();
+
+        /** Remove all the entries. The pipeline library is kept.
+        */
+        static void clear();
+
+        /** Get the statistics
+        */
+        static Stats getStats();
+
+        /** Load a pipeline library saved by savePipelineLibrary() and start recording the pipelines created from here on.
+            A library written by a different driver or GPU is still loaded, its pipelines are rejected when they're used and compiled again.
+            \param[in] filename The library file. Can also include a full path or relative path from a data directory
+            \return false if the file couldn't be read, otherwise true. Recording is enabled either way.
+        */
+        static bool loadPipelineLibrary(const std::string& filename);
+
+        /** Enable or disable recording the pipelines of the state objects created into the library. Recording is disabled by default.
+        */
+        static void setPipelineRecordingEnabled(bool enabled);
+
+        /** Check if pipelines are recorded into the library
+        */
+        static bool isPipelineRecordingEnabled();
+
+        /** Write the pipeline library to a file
+            \param[in] filename The full path of the file
+            \return true if the file was written, otherwise false
+        */
+        static bool savePipelineLibrary(const std::string& filename);
+
+        /** Look up a compiled pipeline in the library. Used by the API backends when creating state objects.
+            \param[in] contentHash A hash of everything which affects the compiled pipeline
+            \param[out] blob The pipeline data
+            \return true if the library has a pipeline with the hash, otherwise false
+        */
+        static bool findPipeline(uint64_t contentHash, std::vector<uint8_t>& blob);
+
+        /** Add a compiled pipeline to the library if recording is enabled. Used by the API backends when creating state objects.
+            \param[in] contentHash A hash of everything which affects the compiled pipeline
+            \param[in] pData The pipeline data
+            \param[in] size The pipeline data size in bytes
+        */
+        static void storePipeline(uint64_t contentHash, const void* pData, size_t size);
+    };
+}
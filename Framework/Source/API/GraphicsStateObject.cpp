@@ -78,6 +78,46 @@ namespace Falcor
         return b;
     }
 
+    uint64_t GraphicsStateObject::Desc::getHash() const
+    {
+        if (mHashValid) return mHash;
+
+        // 64-bit FNV-1a over the fields operator==() compares. Missing states are equal to the default ones, so both hash the same.
+        uint64_t hash = 0xcbf29ce484222325ull;
+        auto combine = [&hash](uint64_t value)
+        {
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                hash ^= (value >> (i * 8)) & 0xff;
+                hash *= 0x100000001b3ull;
+            }
+        };
+        auto combineState = [&combine](const void* pState, const void* pDefault)
+        {
+            combine((pState == pDefault) ? 0 : (uint64_t)(uintptr_t)pState);
+        };
+
+        combine((uint64_t)(uintptr_t)mpLayout.get());
+        combine((uint64_t)(uintptr_t)mpProgram.get());
+        combine((uint64_t)(uintptr_t)mpRootSignature.get());
+        combineState(mpRasterizerState.get(), spDefaultRasterizerState.get());
+        combineState(mpBlendState.get(), spDefaultBlendState.get());
+        combineState(mpDepthStencilState.get(), spDefaultDepthStencilState.get());
+        combine(mSampleMask);
+        combine((uint64_t)mPrimType);
+        combine(mSinglePassStereoEnabled ? 1 : 0);
+        for (uint32_t i = 0; i < Fbo::getMaxColorTargetCount(); i++)
+        {
+            combine(((uint64_t)mFboDesc.getColorTargetFormat(i) << 1) | (mFboDesc.isColorTargetUav(i) ? 1 : 0));
+        }
+        combine(((uint64_t)mFboDesc.getDepthStencilFormat() << 1) | (mFboDesc.isDepthStencilUav() ? 1 : 0));
+        combine(mFboDesc.getSampleCount());
+
+        mHash = hash;
+        mHashValid = true;
+        return mHash;
+    }
+
     GraphicsStateObject::~GraphicsStateObject()
     {
         gpDevice->releaseResource(mApiHandle);
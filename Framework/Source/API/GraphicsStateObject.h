@@ -65,16 +65,16 @@ namespace Falcor
         class Desc
         {
         public:
-            Desc& setRootSignature(RootSignature::SharedPtr pSignature) { mpRootSignature = pSignature; return *this; }
-            Desc& setVertexLayout(VertexLayout::SharedConstPtr pLayout) { mpLayout = pLayout; return *this; }
-            Desc& setFboFormats(const Fbo::Desc& fboFormats) { mFboDesc = fboFormats; return *this; }
-            Desc& setProgramVersion(ProgramVersion::SharedConstPtr pProgram) { mpProgram = pProgram; return *this; }
-            Desc& setBlendState(BlendState::SharedPtr pBlendState) { mpBlendState = pBlendState; return *this; }
-            Desc& setRasterizerState(RasterizerState::SharedPtr pRasterizerState) { mpRasterizerState = pRasterizerState; return *this; }
-            Desc& setDepthStencilState(DepthStencilState::SharedPtr pDepthStencilState) { mpDepthStencilState = pDepthStencilState; return *this; }
-            Desc& setSampleMask(uint32_t sampleMask) { mSampleMask = sampleMask; return *this; }
-            Desc& setPrimitiveType(PrimitiveType type) { mPrimType = type; return *this; }
-            Desc& setSinglePassStereoEnable(bool sps) { mSinglePassStereoEnabled = sps; return *this; }
+            Desc& setRootSignature(RootSignature::SharedPtr pSignature) { mpRootSignature = pSignature; mHashValid = false; return *this; }
+            Desc& setVertexLayout(VertexLayout::SharedConstPtr pLayout) { mpLayout = pLayout; mHashValid = false; return *this; }
+            Desc& setFboFormats(const Fbo::Desc& fboFormats) { mFboDesc = fboFormats; mHashValid = false; return *this; }
+            Desc& setProgramVersion(ProgramVersion::SharedConstPtr pProgram) { mpProgram = pProgram; mHashValid = false; return *this; }
+            Desc& setBlendState(BlendState::SharedPtr pBlendState) { mpBlendState = pBlendState; mHashValid = false; return *this; }
+            Desc& setRasterizerState(RasterizerState::SharedPtr pRasterizerState) { mpRasterizerState = pRasterizerState; mHashValid = false; return *this; }
+            Desc& setDepthStencilState(DepthStencilState::SharedPtr pDepthStencilState) { mpDepthStencilState = pDepthStencilState; mHashValid = false; return *this; }
+            Desc& setSampleMask(uint32_t sampleMask) { mSampleMask = sampleMask; mHashValid = false; return *this; }
+            Desc& setPrimitiveType(PrimitiveType type) { mPrimType = type; mHashValid = false; return *this; }
+            Desc& setSinglePassStereoEnable(bool sps) { mSinglePassStereoEnabled = sps; mHashValid = false; return *this; }
 
             BlendState::SharedPtr getBlendState() const { return mpBlendState; }
             RasterizerState::SharedPtr getRasterizerState() const { return mpRasterizerState; }
@@ -89,8 +89,14 @@ namespace Falcor
 
             bool operator==(const Desc& other) const;
 
+            /** Get a 64-bit hash of the desc. Descs which compare equal have the same hash. The hash is computed on first use and kept until the desc changes.
+            */
+            uint64_t getHash() const;
+
         private:
             friend class GraphicsStateObject;
+            mutable uint64_t mHash = 0;
+            mutable bool mHashValid = false;
             VertexLayout::SharedConstPtr mpLayout;
             Fbo::Desc mFboDesc;
             ProgramVersion::SharedConstPtr mpProgram;
@@ -104,8 +110,8 @@ namespace Falcor
 
 #ifdef FALCOR_VK
         public:
-            Desc& setVao(const Vao::SharedConstPtr& pVao) { mpVao = pVao; return *this; }
-            Desc& setRenderPass(VkRenderPass renderPass) { mRenderPass = renderPass; return *this; }
+            Desc& setVao(const Vao::SharedConstPtr& pVao) { mpVao = pVao; mHashValid = false; return *this; }
+            Desc& setRenderPass(VkRenderPass renderPass) { mRenderPass = renderPass; mHashValid = false; return *this; }
             const Vao::SharedConstPtr& getVao() const { return mpVao; }
             VkRenderPass getRenderPass() const {return mRenderPass;}
         private:
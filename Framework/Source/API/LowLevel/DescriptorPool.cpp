@@ -36,24 +36,21 @@ namespace Falcor
         return pThis->apiInit() ? pThis : nullptr;
     }
 
-    DescriptorPool::DescriptorPool(const Desc& desc, GpuFence::SharedPtr pFence) : mDesc(desc), mpFence(pFence) {}
+    DescriptorPool::DescriptorPool(const Desc& desc, GpuFence::SharedPtr pFence) : mDesc(desc), mpFence(pFence)
+    {
+        // Allocations are never reused, dropping them once the GPU is done with them frees their descriptors
+        mpDeferredReleases = FencedRecycler<std::shared_ptr<DescriptorSetApiData>>::create(pFence, nullptr, nullptr, 0);
+    }
 
     DescriptorPool::~DescriptorPool() = default;
 
     void DescriptorPool::executeDeferredReleases()
     {
-        uint64_t gpuVal = mpFence->getGpuValue();
-        while (mpDeferredReleases.size() && mpDeferredReleases.top().fenceValue <= gpuVal)
-        {
-            mpDeferredReleases.pop();
-        }
+        mpDeferredReleases->collect();
     }
 
     void DescriptorPool::releaseAllocation(std::shared_ptr<DescriptorSetApiData> pData)
     {
-        DeferredRelease d;
-        d.pData = pData;
-        d.fenceValue = mpFence->getCpuValue();
-        mpDeferredReleases.push(d);
+        mpDeferredReleases->retire(pData);
     }
 }
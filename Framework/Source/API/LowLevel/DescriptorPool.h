@@ -28,8 +28,7 @@
 #pragma once
 #include "Framework.h"
 #include <queue>
-#include "API/LowLevel/GpuFence.h"
-#include <queue>
+#include "API/LowLevel/FencedRecycler.h"
 
 namespace Falcor
 {
@@ -104,13 +103,6 @@ namespace Falcor
         std::shared_ptr<ApiData> mpApiData;
         GpuFence::SharedPtr mpFence;
 
-        struct DeferredRelease
-        {
-            std::shared_ptr<DescriptorSetApiData> pData;
-            uint64_t fenceValue;
-            bool operator>(const DeferredRelease& other) const { return fenceValue > other.fenceValue; }
-        };
-
-        std::priority_queue<DeferredRelease, std::vector<DeferredRelease>, std::greater<DeferredRelease>> mpDeferredReleases;
+        FencedRecycler<std::shared_ptr<DescriptorSetApiData>>::SharedPtr mpDeferredReleases;
     };
 }
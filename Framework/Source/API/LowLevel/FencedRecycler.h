@@ -0,0 +1,191 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <deque>
+#include <vector>
+#include <functional>
+#include "GpuFence.h"
+
+namespace Falcor
+{
+    /** Recycles objects which can only be reused or destroyed once the GPU is done with them.
+        Retired objects are grouped in buckets by the fence value they wait for. The fence values are increasing, so the buckets form a timeline which is consumed from the front.
+        Retiring and acquiring an object are O(1). The number of completed objects kept for reuse is bounded by a high-water mark, objects above it are destroyed.
+        With a high-water mark of 0, the recycler is a deferred-release queue: the destroy function is called for every object once the GPU is done with it.
+    */
+    template<typename ObjectType>
+    class FencedRecycler
+    {
+    public:
+        using SharedPtr = std::shared_ptr<FencedRecycler<ObjectType>>;
+        using SharedConstPtr = std::shared_ptr<const FencedRecycler<ObjectType>>;
+        using CreateFuncType = std::function<ObjectType()>;
+        using DestroyFuncType = std::function<void(ObjectType&)>;
+
+        static const uint32_t kUnlimited = uint32_t(-1);
+
+        /** Recycler statistics
+        */
+        struct Counters
+        {
+            uint64_t created = 0;           ///< Objects created by acquire() because no completed object was available
+            uint64_t recycled = 0;          ///< Objects acquire() returned from the completed objects
+            uint64_t retired = 0;           ///< Objects passed to retire()
+            uint64_t destroyed = 0;         ///< Completed objects passed to the destroy function or dropped because of the high-water mark
+            uint32_t pendingCount = 0;      ///< Objects the GPU may still be using
+            uint32_t availableCount = 0;    ///< Completed objects kept for reuse
+            uint32_t peakPendingCount = 0;  ///< Largest number of pending objects so far
+        };
+
+        /** Create a recycler
+            \param[in] pFence The fence which tells when the GPU is done with an object
+            \param[in] createFunc Creates an object when acquire() has no completed object to return. Can be empty if acquire() is never called.
+            \param[in] destroyFunc Called for completed objects which are not kept for reuse. Can be empty, in which case the objects are just dropped.
+            \param[in] highWaterMark Maximum number of completed objects kept for reuse
+        */
+        static SharedPtr create(GpuFence::SharedConstPtr pFence, CreateFuncType createFunc, DestroyFuncType destroyFunc = nullptr, uint32_t highWaterMark = kUnlimited)
+        {
+            return SharedPtr(new FencedRecycler(pFence, createFunc, destroyFunc, highWaterMark));
+        }
+
+        /** Hand an object back to the recycler. It becomes available once the GPU reaches the fence's current CPU value.
+        */
+        void retire(ObjectType object)
+        {
+            uint64_t fenceValue = mpFence->getCpuValue();
+            if (mBuckets.empty() || mBuckets.back().fenceValue < fenceValue)
+            {
+                mBuckets.push_back({ fenceValue, 0 });
+            }
+            // A fence value smaller than the last bucket's is added to that bucket. It waits longer than needed, but is still safe.
+            mBuckets.back().count++;
+            mPending.push_back(std::move(object));
+
+            mCounters.retired++;
+            mCounters.peakPendingCount = std::max(mCounters.peakPendingCount, (uint32_t)mPending.size());
+        }
+
+        /** Get an object the GPU is done with, or create a new one if there is none
+        */
+        ObjectType acquire()
+        {
+            collect();
+            if (mAvailable.size())
+            {
+                ObjectType object = std::move(mAvailable.back());
+                mAvailable.pop_back();
+                mCounters.recycled++;
+                return object;
+            }
+
+            mCounters.created++;
+            return mCreateFunc();
+        }
+
+        /** Retire an object and acquire another one in its place
+        */
+        ObjectType exchange(ObjectType object)
+        {
+            retire(std::move(object));
+            return acquire();
+        }
+
+        /** Move the objects the GPU is done with to the available objects. Objects above the high-water mark are destroyed.
+        */
+        void collect()
+        {
+            uint64_t gpuValue = mpFence->getGpuValue();
+            while (mBuckets.size() && mBuckets.front().fenceValue <= gpuValue)
+            {
+                for (uint32_t i = 0; i < mBuckets.front().count; i++)
+                {
+                    if (mAvailable.size() < mHighWaterMark)
+                    {
+                        mAvailable.push_back(std::move(mPending.front()));
+                    }
+                    else
+                    {
+                        destroy(mPending.front());
+                    }
+                    mPending.pop_front();
+                }
+                mBuckets.pop_front();
+            }
+        }
+
+        /** Set the maximum number of completed objects kept for reuse. Objects above the new mark are destroyed immediately.
+        */
+        void setHighWaterMark(uint32_t highWaterMark)
+        {
+            mHighWaterMark = highWaterMark;
+            while (mAvailable.size() > mHighWaterMark)
+            {
+                destroy(mAvailable.back());
+                mAvailable.pop_back();
+            }
+        }
+
+        uint32_t getHighWaterMark() const { return mHighWaterMark; }
+
+        /** Get the statistics
+        */
+        Counters getCounters() const
+        {
+            Counters counters = mCounters;
+            counters.pendingCount = (uint32_t)mPending.size();
+            counters.availableCount = (uint32_t)mAvailable.size();
+            return counters;
+        }
+
+    private:
+        FencedRecycler(GpuFence::SharedConstPtr pFence, CreateFuncType createFunc, DestroyFuncType destroyFunc, uint32_t highWaterMark) :
+            mpFence(pFence), mCreateFunc(createFunc), mDestroyFunc(destroyFunc), mHighWaterMark(highWaterMark) {}
+
+        void destroy(ObjectType& object)
+        {
+            if (mDestroyFunc) mDestroyFunc(object);
+            mCounters.destroyed++;
+        }
+
+        struct Bucket
+        {
+            uint64_t fenceValue;
+            uint32_t count;
+        };
+
+        GpuFence::SharedConstPtr mpFence;
+        CreateFuncType mCreateFunc;
+        DestroyFuncType mDestroyFunc;
+        uint32_t mHighWaterMark;
+        Counters mCounters;
+
+        std::deque<Bucket> mBuckets;
+        std::deque<ObjectType> mPending;
+        std::vector<ObjectType> mAvailable;
+    };
+}
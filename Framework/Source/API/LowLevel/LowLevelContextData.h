@@ -26,7 +26,7 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #pragma once
-#include "API/LowLevel/FencedPool.h"
+#include "API/LowLevel/FencedRecycler.h"
 
 namespace Falcor
 {
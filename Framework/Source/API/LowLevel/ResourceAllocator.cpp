@@ -31,49 +31,73 @@
 
 namespace Falcor
 {
-    ResourceAllocator::~ResourceAllocator()
+    ResourceAllocator::ResourceAllocator(size_t pageSize, GpuFence::SharedPtr pFence, Mode mode, size_t transientPageSize) : mPageSize(pageSize), mpFence(pFence), mMode(mode), mTransientPageSize(transientPageSize)
     {
-        mDeferredReleases = decltype(mDeferredReleases)();
+        // Released allocations and retired transient pages are never handed out again by the recyclers. Their memory is returned to the pages and heaps once the GPU is done with them.
+        mpDeferredReleases = FencedRecycler<AllocationData>::create(pFence, nullptr, [this](AllocationData& data) { releaseNow(data); }, 0);
+        mpRetiredTransientPages = FencedRecycler<PageData::UniquePtr>::create(pFence, nullptr, [this](PageData::UniquePtr& pPage) { mAvailableTransientPages.push(std::move(pPage)); }, 0);
     }
 
-    ResourceAllocator::SharedPtr ResourceAllocator::create(size_t pageSize, GpuFence::SharedPtr pFence)
+    ResourceAllocator::~ResourceAllocator()
     {
-        SharedPtr pAllocator = SharedPtr(new ResourceAllocator(pageSize, pFence));
-        pAllocator->allocateNewPage();
-        return pAllocator;
+        mpDeferredReleases = nullptr;
     }
 
-    void ResourceAllocator::allocateNewPage()
+    ResourceAllocator::SharedPtr ResourceAllocator::create(size_t pageSize, GpuFence::SharedPtr pFence, Mode mode, size_t transientPageSize)
     {
-        if (mpActivePage)
+        SharedPtr pAllocator = SharedPtr(new ResourceAllocator(pageSize, pFence, mode, transientPageSize));
+        if (mode == Mode::Linear)
         {
-            mUsedPages[mCurrentPageId] = std::move(mpActivePage);
+            pAllocator->allocateNewPage();
         }
+        return pAllocator;
+    }
 
-        if (mAvailablePages.size())
+    ResourceAllocator::PageData::UniquePtr ResourceAllocator::getAvailablePage(std::queue<PageData::UniquePtr>& availablePages, size_t pageSize)
+    {
+        PageData::UniquePtr pPage;
+        if (availablePages.size())
         {
-            mpActivePage = std::move(mAvailablePages.front());
-            mAvailablePages.pop();
-            mpActivePage->allocationsCount = 0;
-            mpActivePage->currentOffset = 0;
+            pPage = std::move(availablePages.front());
+            availablePages.pop();
+            pPage->allocationsCount = 0;
         }
         else
         {
-            mpActivePage = std::make_unique<PageData>();
-            initBasePageData((*mpActivePage), mPageSize);
+            pPage = std::make_unique<PageData>();
+            initBasePageData((*pPage), pageSize);
+        }
+
+        pPage->currentOffset = 0;
+        return pPage;
+    }
+
+    void ResourceAllocator::allocateNewPage()
+    {
+        if (mpActivePage)
+        {
+            mUsedPages[mCurrentPageId] = std::move(mpActivePage);
         }
 
-        mpActivePage->currentOffset = 0;
+        mpActivePage = getAvailablePage(mAvailablePages, mPageSize);
         mCurrentPageId++;
     }
 
     ResourceAllocator::AllocationData ResourceAllocator::allocate(size_t size, size_t alignment)
     {
         AllocationData data;
-        if (size > mPageSize)
+
+        // A heap page can only hold blocks which still fit after aligning their start, see TlsfAllocator::getRequiredFreeBlockSize()
+        const bool fitsInPage = (mMode == Mode::Tlsf) ? (TlsfAllocator::getRequiredFreeBlockSize(size, alignment) <= mPageSize) : (size <= mPageSize);
+        if (fitsInPage == false)
         {
             data.pageID = ResourceAllocator::AllocationData::kMegaPageId;
             initBasePageData(data, size);
+            mDedicatedAllocationCount++;
+        }
+        else if (mMode == Mode::Tlsf)
+        {
+            data = allocateFromHeap(size, alignment);
         }
         else
         {
@@ -93,45 +117,148 @@ namespace Falcor
             mpActivePage->allocationsCount++;
         }
 
-        data.fenceValue = mpFence->getCpuValue();
+        return data;
+    }
+
+    ResourceAllocator::AllocationData ResourceAllocator::allocateFromHeap(size_t size, size_t alignment)
+    {
+        AllocationData data;
+        uint64_t offset = TlsfAllocator::kInvalidOffset;
+        uint32_t freeSlot = (uint32_t)mHeaps.size();
+        for (uint32_t i = 0; i < mHeaps.size(); i++)
+        {
+            if (mHeaps[i] == nullptr)
+            {
+                freeSlot = std::min(freeSlot, i);
+                continue;
+            }
+
+            offset = mHeaps[i]->pAllocator->allocate(size, alignment);
+            if (offset != TlsfAllocator::kInvalidOffset)
+            {
+                data.pageID = i;
+                break;
+            }
+        }
+
+        if (offset == TlsfAllocator::kInvalidOffset)
+        {
+            HeapData::UniquePtr pHeap = std::make_unique<HeapData>();
+            initBasePageData(*pHeap, mPageSize);
+            pHeap->pAllocator = TlsfAllocator::create(mPageSize);
+            offset = pHeap->pAllocator->allocate(size, alignment);
+            assert(offset != TlsfAllocator::kInvalidOffset);
+
+            if (freeSlot == mHeaps.size()) mHeaps.emplace_back();
+            mHeaps[freeSlot] = std::move(pHeap);
+            data.pageID = freeSlot;
+        }
+
+        const HeapData* pHeap = mHeaps[data.pageID].get();
+        data.offset = offset;
+        data.pData = pHeap->pData + offset;
+        data.pResourceHandle = pHeap->pResourceHandle;
+        return data;
+    }
+
+    ResourceAllocator::AllocationData ResourceAllocator::allocateTransient(size_t size, size_t alignment)
+    {
+        if (size > mTransientPageSize)
+        {
+            return allocate(size, alignment);
+        }
+
+        size_t currentOffset = mpTransientPage ? align_to(alignment, mpTransientPage->currentOffset) : 0;
+        if (mpTransientPage == nullptr || currentOffset + size > mTransientPageSize)
+        {
+            // Work recorded from now on can't use the retired page, so it can be recycled once the current fence value is reached
+            if (mpTransientPage)
+            {
+                mpRetiredTransientPages->retire(std::move(mpTransientPage));
+            }
+            mpTransientPage = getAvailablePage(mAvailableTransientPages, mTransientPageSize);
+            mTransientPageId++;
+            currentOffset = 0;
+        }
+
+        AllocationData data;
+        data.transient = true;
+        data.pageID = mTransientPageId;
+        data.offset = currentOffset;
+        data.pData = mpTransientPage->pData + currentOffset;
+        data.pResourceHandle = mpTransientPage->pResourceHandle;
+        mpTransientPage->currentOffset = currentOffset + size;
         return data;
     }
 
     void ResourceAllocator::release(AllocationData& data)
     {
         assert(data.pResourceHandle);
-        mDeferredReleases.push(data);
+        // Transient allocations are reclaimed with their page
+        if (data.transient == false)
+        {
+            mpDeferredReleases->retire(data);
+        }
     }
 
-    void ResourceAllocator::executeDeferredReleases()
+    void ResourceAllocator::releaseNow(const AllocationData& data)
     {
-        uint64_t gpuVal = mpFence->getGpuValue();
-        while (mDeferredReleases.size() && mDeferredReleases.top().fenceValue <= gpuVal)
+        if (data.pageID == AllocationData::kMegaPageId)
         {
-            const AllocationData& data = mDeferredReleases.top();
-            if (data.pageID == mCurrentPageId)
+            // Dropping the allocation will release the resource
+            mDedicatedAllocationCount--;
+        }
+        else if (mMode == Mode::Tlsf)
+        {
+            auto& pHeap = mHeaps[data.pageID];
+            pHeap->pAllocator->release(data.offset);
+            if (data.pageID != 0 && pHeap->pAllocator->isEmpty())
             {
-                mpActivePage->allocationsCount--;
-                if (mpActivePage->allocationsCount == 0)
-                {
-                    mpActivePage->currentOffset = 0;
-                }
+                pHeap = nullptr;
             }
-            else
+        }
+        else if (data.pageID == mCurrentPageId)
+        {
+            mpActivePage->allocationsCount--;
+            if (mpActivePage->allocationsCount == 0)
+            {
+                mpActivePage->currentOffset = 0;
+            }
+        }
+        else
+        {
+            auto& pData = mUsedPages[data.pageID];
+            pData->allocationsCount--;
+            if (pData->allocationsCount == 0)
             {
-                if (data.pageID != AllocationData::kMegaPageId)
-                {
-                    auto& pData = mUsedPages[data.pageID];
-                    pData->allocationsCount--;
-                    if (pData->allocationsCount == 0)
-                    {
-                        mAvailablePages.push(std::move(pData));
-                        mUsedPages.erase(data.pageID);
-                    }
-                }
-                // else it's a mega-page. Popping it will release the resource
+                mAvailablePages.push(std::move(pData));
+                mUsedPages.erase(data.pageID);
             }
-            mDeferredReleases.pop();
         }
     }
+
+    void ResourceAllocator::executeDeferredReleases()
+    {
+        mpDeferredReleases->collect();
+        mpRetiredTransientPages->collect();
+    }
+
+    ResourceAllocator::Stats ResourceAllocator::getStats() const
+    {
+        Stats stats;
+        for (const auto& pHeap : mHeaps)
+        {
+            if (pHeap == nullptr) continue;
+            TlsfAllocator::Stats heapStats = pHeap->pAllocator->getStats();
+            stats.heapCount++;
+            stats.heapBytes += heapStats.size;
+            stats.usedBytes += heapStats.usedBytes;
+            stats.freeBytes += heapStats.freeBytes;
+            stats.largestFreeBlock = std::max(stats.largestFreeBlock, heapStats.largestFreeBlock);
+            stats.freeBlockCount += heapStats.freeBlockCount;
+        }
+        stats.dedicatedAllocationCount = mDedicatedAllocationCount;
+        stats.pendingReleaseCount = mpDeferredReleases->getCounters().pendingCount;
+        return stats;
+    }
 }
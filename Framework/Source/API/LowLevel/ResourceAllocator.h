@@ -29,7 +29,8 @@
 #ifdef FALCOR_LOW_LEVEL_API
 #include <unordered_map>
 #include <queue>
-#include "GpuFence.h"
+#include "FencedRecycler.h"
+#include "TlsfAllocator.h"
 
 namespace Falcor
 {
@@ -39,7 +40,41 @@ namespace Falcor
         using SharedPtr = std::shared_ptr<ResourceAllocator>;
         using SharedConstPtr = std::shared_ptr<const ResourceAllocator>;
 
-        static SharedPtr create(size_t pageSize, GpuFence::SharedPtr pFence);
+        /** How allocate() manages memory
+        */
+        enum class Mode
+        {
+            Linear,     ///< Allocations are carved linearly out of pages. A page is recycled once all of its allocations are released. Suited for short-lived allocations.
+            Tlsf,       ///< Allocations are suballocated from heaps with a TLSF allocator, and a block can be reused as soon as it's released. Suited for long-lived allocations of mixed sizes.
+        };
+
+        /** Allocator statistics. The heap statistics are only collected in Tlsf mode.
+        */
+        struct Stats
+        {
+            uint32_t heapCount = 0;                 ///< Number of heaps
+            uint64_t heapBytes = 0;                 ///< Total size of the heaps in bytes
+            uint64_t usedBytes = 0;                 ///< Bytes in allocated heap blocks
+            uint64_t freeBytes = 0;                 ///< Bytes in free heap blocks
+            uint64_t largestFreeBlock = 0;          ///< Size of the largest free heap block in bytes
+            uint32_t freeBlockCount = 0;            ///< Number of free heap blocks
+            uint32_t dedicatedAllocationCount = 0;  ///< Number of allocations larger than a page, which got a resource of their own
+            uint32_t pendingReleaseCount = 0;       ///< Number of released allocations waiting for the GPU to be done with them
+
+            /** Get the fraction of the free heap memory which is not in the largest free block
+            */
+            float getFragmentation() const { return freeBytes ? 1.0f - float(largestFreeBlock) / float(freeBytes) : 0.0f; }
+        };
+
+        static const size_t kDefaultTransientPageSize = 1024 * 1024 * 2;
+
+        /** Create an allocator
+            \param[in] pageSize In Linear mode, the size of a page. In Tlsf mode, the size of a heap. Larger allocations get a resource of their own.
+            \param[in] pFence The fence which tells when the GPU is done with released allocations
+            \param[in] mode How allocate() manages memory. allocateTransient() uses linear pages in both modes.
+            \param[in] transientPageSize The size of the pages used by allocateTransient(). Kept separate from pageSize, since every retired page stays allocated while the GPU uses it.
+        */
+        static SharedPtr create(size_t pageSize, GpuFence::SharedPtr pFence, Mode mode = Mode::Linear, size_t transientPageSize = kDefaultTransientPageSize);
         struct BaseData
         {
             ResourceHandle pResourceHandle;
@@ -50,20 +85,36 @@ namespace Falcor
         struct AllocationData : public BaseData
         {
             uint64_t pageID = 0;
-            uint64_t fenceValue = 0;
+            bool transient = false;
 
             static const uint64_t kMegaPageId = -1;
-            bool operator<(const AllocationData& other)  const { return fenceValue > other.fenceValue; }
         };
         ~ResourceAllocator();
 
         AllocationData allocate(size_t size, size_t alignment = 1);
+
+        /** Allocate memory which is reclaimed together with the page it was allocated from, instead of being released.
+            Transient pages are filled linearly. A full page is retired, and recycled once the GPU is done with the work recorded while it was active.
+            Allocations larger than a transient page fall back to allocate().
+        */
+        AllocationData allocateTransient(size_t size, size_t alignment = 1);
+
+        /** Check if an allocation belongs to a retired transient page. Its memory can't be referenced by GPU work recorded from now on.
+        */
+        bool isRetired(const AllocationData& data) const { return data.transient && (data.pageID != mTransientPageId); }
+
         void release(AllocationData& data);
         size_t getPageSize() const { return mPageSize; }
+        size_t getTransientPageSize() const { return mTransientPageSize; }
+        Mode getMode() const { return mMode; }
         void executeDeferredReleases();
 
+        /** Get the statistics
+        */
+        Stats getStats() const;
+
     private:
-        ResourceAllocator(size_t pageSize, GpuFence::SharedPtr pFence) : mPageSize(pageSize), mpFence(pFence) {}
+        ResourceAllocator(size_t pageSize, GpuFence::SharedPtr pFence, Mode mode, size_t transientPageSize);
         struct PageData : public BaseData
         {
             uint32_t allocationsCount = 0;
@@ -71,17 +122,35 @@ namespace Falcor
 
             using UniquePtr = std::unique_ptr<PageData>;
         };
-        
+
+        struct HeapData : public BaseData
+        {
+            TlsfAllocator::UniquePtr pAllocator;
+
+            using UniquePtr = std::unique_ptr<HeapData>;
+        };
+
+        Mode mMode;
         GpuFence::SharedPtr mpFence;
         size_t mPageSize = 0;
         size_t mCurrentPageId = 0;
         PageData::UniquePtr mpActivePage;
+        PageData::UniquePtr mpTransientPage;
+        uint64_t mTransientPageId = 0;
+        size_t mTransientPageSize = 0;
 
-        std::priority_queue<AllocationData> mDeferredReleases;
+        FencedRecycler<AllocationData>::SharedPtr mpDeferredReleases;
+        FencedRecycler<PageData::UniquePtr>::SharedPtr mpRetiredTransientPages;
         std::unordered_map<size_t, PageData::UniquePtr> mUsedPages;
         std::queue<PageData::UniquePtr> mAvailablePages;
+        std::queue<PageData::UniquePtr> mAvailableTransientPages;
+        std::vector<HeapData::UniquePtr> mHeaps;    // Empty heaps are destroyed, except for the first one, so the vector can have holes
+        uint32_t mDedicatedAllocationCount = 0;
 
         void allocateNewPage();
+        void releaseNow(const AllocationData& data);
+        AllocationData allocateFromHeap(size_t size, size_t alignment);
+        static PageData::UniquePtr getAvailablePage(std::queue<PageData::UniquePtr>& availablePages, size_t pageSize);
         static void initBasePageData(BaseData& data, size_t size);
     };
 }
@@ -0,0 +1,295 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TlsfAllocator.h"
+
+namespace Falcor
+{
+    static uint32_t bitScanReverse64(uint64_t a)
+    {
+        uint32_t high = uint32_t(a >> 32);
+        return high ? bitScanReverse(high) + 32 : bitScanReverse(uint32_t(a));
+    }
+
+    static uint32_t bitScanForward64(uint64_t a)
+    {
+        uint32_t low = uint32_t(a);
+        return low ? bitScanForward(low) : bitScanForward(uint32_t(a >> 32)) + 32;
+    }
+
+    /** Get the free list a block belongs to. Sizes are in units of kMinBlockSize. Small sizes get a list each, larger sizes are split into kSlCount lists per power of 2.
+    */
+    static void mapSize(uint64_t units, uint32_t slBits, uint32_t& fl, uint32_t& sl)
+    {
+        const uint32_t slCount = 1 << slBits;
+        if (units < slCount)
+        {
+            fl = 0;
+            sl = uint32_t(units);
+        }
+        else
+        {
+            uint32_t msb = bitScanReverse64(units);
+            sl = uint32_t(units >> (msb - slBits)) - slCount;
+            fl = msb - slBits + 1;
+        }
+    }
+
+    TlsfAllocator::UniquePtr TlsfAllocator::create(uint64_t size)
+    {
+        return UniquePtr(new TlsfAllocator(size));
+    }
+
+    TlsfAllocator::TlsfAllocator(uint64_t size) : mSize(size - size % kMinBlockSize)
+    {
+        for (auto& lists : mFreeLists)
+        {
+            for (auto& head : lists) head = kInvalidBlock;
+        }
+
+        if (mSize)
+        {
+            insertFreeBlock(createBlock(0, mSize));
+        }
+    }
+
+    uint32_t TlsfAllocator::createBlock(uint64_t offset, uint64_t size)
+    {
+        uint32_t index;
+        if (mUnusedBlocks.size())
+        {
+            index = mUnusedBlocks.back();
+            mUnusedBlocks.pop_back();
+            mBlocks[index] = Block();
+        }
+        else
+        {
+            index = (uint32_t)mBlocks.size();
+            mBlocks.push_back(Block());
+        }
+        mBlocks[index].offset = offset;
+        mBlocks[index].size = size;
+        return index;
+    }
+
+    void TlsfAllocator::destroyBlock(uint32_t index)
+    {
+        mUnusedBlocks.push_back(index);
+    }
+
+    void TlsfAllocator::insertFreeBlock(uint32_t index)
+    {
+        uint32_t fl, sl;
+        Block& block = mBlocks[index];
+        mapSize(block.size / kMinBlockSize, kSlBits, fl, sl);
+
+        block.isFree = true;
+        block.prevFree = kInvalidBlock;
+        block.nextFree = mFreeLists[fl][sl];
+        if (block.nextFree != kInvalidBlock) mBlocks[block.nextFree].prevFree = index;
+        mFreeLists[fl][sl] = index;
+        mFlBitmap |= 1ull << fl;
+        mSlBitmaps[fl] |= 1u << sl;
+
+        mFreeBytes += block.size;
+        mFreeBlockCount++;
+    }
+
+    void TlsfAllocator::removeFreeBlock(uint32_t index)
+    {
+        uint32_t fl, sl;
+        Block& block = mBlocks[index];
+        mapSize(block.size / kMinBlockSize, kSlBits, fl, sl);
+
+        if (block.prevFree != kInvalidBlock) mBlocks[block.prevFree].nextFree = block.nextFree;
+        if (block.nextFree != kInvalidBlock) mBlocks[block.nextFree].prevFree = block.prevFree;
+        if (mFreeLists[fl][sl] == index)
+        {
+            mFreeLists[fl][sl] = block.nextFree;
+            if (block.nextFree == kInvalidBlock)
+            {
+                mSlBitmaps[fl] &= ~(1u << sl);
+                if (mSlBitmaps[fl] == 0) mFlBitmap &= ~(1ull << fl);
+            }
+        }
+        block.isFree = false;
+        block.prevFree = kInvalidBlock;
+        block.nextFree = kInvalidBlock;
+
+        mFreeBytes -= block.size;
+        mFreeBlockCount--;
+    }
+
+    /** Round a size in units of kMinBlockSize up to the next list boundary, so that any block in the list it maps to is large enough.
+    */
+    static uint64_t roundUpToList(uint64_t units, uint32_t slBits)
+    {
+        if (units >= (1ull << slBits))
+        {
+            units += (1ull << (bitScanReverse64(units) - slBits)) - 1;
+        }
+        return units;
+    }
+
+    uint64_t TlsfAllocator::getRequiredFreeBlockSize(uint64_t size, uint64_t alignment)
+    {
+        assert(alignment && (alignment & (alignment - 1)) == 0);
+        size = align_to(kMinBlockSize, std::max(size, uint64_t(1)));
+        alignment = std::max(alignment, uint64_t(kMinBlockSize));
+
+        // Smallest size in the list findFreeBlock() starts searching at
+        uint64_t units = roundUpToList((size + alignment - kMinBlockSize) / kMinBlockSize, kSlBits);
+        if (units >= kSlCount)
+        {
+            const uint32_t shift = bitScanReverse64(units) - kSlBits;
+            units = (units >> shift) << shift;
+        }
+        return units * kMinBlockSize;
+    }
+
+    uint32_t TlsfAllocator::findFreeBlock(uint64_t size) const
+    {
+        // Round the size up to the next list boundary, so that any block in the list found is large enough
+        const uint64_t units = roundUpToList(size / kMinBlockSize, kSlBits);
+
+        uint32_t fl, sl;
+        mapSize(units, kSlBits, fl, sl);
+        if (fl >= kFlCount) return kInvalidBlock;
+
+        uint32_t slMap = mSlBitmaps[fl] & (~0u << sl);
+        if (slMap == 0)
+        {
+            uint64_t flMap = (fl + 1 < 64) ? (mFlBitmap & (~0ull << (fl + 1))) : 0;
+            if (flMap == 0) return kInvalidBlock;
+            fl = bitScanForward64(flMap);
+            slMap = mSlBitmaps[fl];
+        }
+        return mFreeLists[fl][bitScanForward(slMap)];
+    }
+
+    void TlsfAllocator::splitBlock(uint32_t index, uint64_t size)
+    {
+        if (mBlocks[index].size == size) return;
+
+        // createBlock() can reallocate mBlocks, so don't hold a reference across it
+        uint32_t remainder = createBlock(mBlocks[index].offset + size, mBlocks[index].size - size);
+        Block& block = mBlocks[index];
+        mBlocks[remainder].prevPhysical = index;
+        mBlocks[remainder].nextPhysical = block.nextPhysical;
+        if (block.nextPhysical != kInvalidBlock) mBlocks[block.nextPhysical].prevPhysical = remainder;
+        block.nextPhysical = remainder;
+        block.size = size;
+        insertFreeBlock(remainder);
+    }
+
+    uint64_t TlsfAllocator::allocate(uint64_t size, uint64_t alignment)
+    {
+        assert(alignment && (alignment & (alignment - 1)) == 0);
+        size = align_to(kMinBlockSize, std::max(size, uint64_t(1)));
+        alignment = std::max(alignment, uint64_t(kMinBlockSize));
+
+        // Over-allocate so the block can start at an aligned offset
+        const uint64_t padding = alignment - kMinBlockSize;
+        uint32_t index = findFreeBlock(size + padding);
+        if (index == kInvalidBlock) return kInvalidOffset;
+        removeFreeBlock(index);
+
+        // Split the unaligned start of the block into a free block of its own
+        const uint64_t alignedOffset = align_to(alignment, mBlocks[index].offset);
+        if (alignedOffset != mBlocks[index].offset)
+        {
+            uint32_t head = index;
+            splitBlock(head, alignedOffset - mBlocks[head].offset);
+            index = mBlocks[head].nextPhysical;
+            removeFreeBlock(index);
+            insertFreeBlock(head);
+        }
+
+        splitBlock(index, size);
+        mAllocatedBlocks[mBlocks[index].offset] = index;
+        return mBlocks[index].offset;
+    }
+
+    void TlsfAllocator::release(uint64_t offset)
+    {
+        auto it = mAllocatedBlocks.find(offset);
+        if (it == mAllocatedBlocks.end())
+        {
+            logError("TlsfAllocator::release() - offset " + std::to_string(offset) + " isn't an allocated block");
+            return;
+        }
+        uint32_t index = it->second;
+        mAllocatedBlocks.erase(it);
+
+        // Merge with the free neighbors
+        uint32_t next = mBlocks[index].nextPhysical;
+        if (next != kInvalidBlock && mBlocks[next].isFree)
+        {
+            removeFreeBlock(next);
+            mBlocks[index].size += mBlocks[next].size;
+            mBlocks[index].nextPhysical = mBlocks[next].nextPhysical;
+            if (mBlocks[next].nextPhysical != kInvalidBlock) mBlocks[mBlocks[next].nextPhysical].prevPhysical = index;
+            destroyBlock(next);
+        }
+
+        uint32_t prev = mBlocks[index].prevPhysical;
+        if (prev != kInvalidBlock && mBlocks[prev].isFree)
+        {
+            removeFreeBlock(prev);
+            mBlocks[prev].size += mBlocks[index].size;
+            mBlocks[prev].nextPhysical = mBlocks[index].nextPhysical;
+            if (mBlocks[index].nextPhysical != kInvalidBlock) mBlocks[mBlocks[index].nextPhysical].prevPhysical = prev;
+            destroyBlock(index);
+            index = prev;
+        }
+
+        insertFreeBlock(index);
+    }
+
+    TlsfAllocator::Stats TlsfAllocator::getStats() const
+    {
+        Stats stats;
+        stats.size = mSize;
+        stats.freeBytes = mFreeBytes;
+        stats.usedBytes = mSize - mFreeBytes;
+        stats.allocationCount = (uint32_t)mAllocatedBlocks.size();
+        stats.freeBlockCount = mFreeBlockCount;
+
+        // The largest block is in the highest non-empty list
+        if (mFlBitmap)
+        {
+            uint32_t fl = bitScanReverse64(mFlBitmap);
+            uint32_t sl = bitScanReverse(mSlBitmaps[fl]);
+            for (uint32_t index = mFreeLists[fl][sl]; index != kInvalidBlock; index = mBlocks[index].nextFree)
+            {
+                stats.largestFreeBlock = std::max(stats.largestFreeBlock, mBlocks[index].size);
+            }
+        }
+        return stats;
+    }
+}
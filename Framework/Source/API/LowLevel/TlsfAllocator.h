@@ -0,0 +1,135 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <unordered_map>
+
+namespace Falcor
+{
+    /** Two-level segregated fit (TLSF) allocator which manages offsets inside a range of memory.
+        The allocator doesn't touch the memory itself, so it can suballocate GPU heaps and can be used without a device.
+        Allocation and release are O(1). Free blocks are merged with their neighbors when they are released.
+    */
+    class TlsfAllocator
+    {
+    public:
+        using UniquePtr = std::unique_ptr<TlsfAllocator>;
+
+        static const uint64_t kInvalidOffset = uint64_t(-1);
+        static const uint64_t kMinBlockSize = 256;  ///< Allocation sizes and offsets are multiples of this
+
+        /** Allocator statistics
+        */
+        struct Stats
+        {
+            uint64_t size = 0;              ///< Size of the managed range in bytes
+            uint64_t usedBytes = 0;         ///< Bytes in allocated blocks, including the rounding to kMinBlockSize
+            uint64_t freeBytes = 0;         ///< Bytes in free blocks
+            uint64_t largestFreeBlock = 0;  ///< Size of the largest free block in bytes
+            uint32_t allocationCount = 0;   ///< Number of allocated blocks
+            uint32_t freeBlockCount = 0;    ///< Number of free blocks
+
+            /** Get the fraction of the free memory which is not in the largest free block. 0 means there's no fragmentation.
+            */
+            float getFragmentation() const { return freeBytes ? 1.0f - float(largestFreeBlock) / float(freeBytes) : 0.0f; }
+        };
+
+        /** Create an allocator
+            \param[in] size Size of the managed range in bytes. Rounded down to a multiple of kMinBlockSize.
+        */
+        static UniquePtr create(uint64_t size);
+
+        /** Allocate a block
+            \param[in] size Size of the block in bytes
+            \param[in] alignment Alignment of the block offset. Must be a power of 2.
+            \return The offset of the block, or kInvalidOffset if there's no free block large enough
+        */
+        uint64_t allocate(uint64_t size, uint64_t alignment = kMinBlockSize);
+
+        /** Get the size of the free block allocate() looks for. It includes the padding needed to align the block and the rounding of the free lists, so it can exceed the requested size by more than the alignment.
+            An allocation always succeeds in an empty allocator whose size is at least this large.
+            \param[in] size Size of the block in bytes
+            \param[in] alignment Alignment of the block offset. Must be a power of 2.
+        */
+        static uint64_t getRequiredFreeBlockSize(uint64_t size, uint64_t alignment = kMinBlockSize);
+
+        /** Release a block
+            \param[in] offset The offset returned by allocate()
+        */
+        void release(uint64_t offset);
+
+        /** Get the size of the managed range in bytes
+        */
+        uint64_t getSize() const { return mSize; }
+
+        /** Check if there are no allocated blocks
+        */
+        bool isEmpty() const { return mAllocatedBlocks.empty(); }
+
+        /** Get the statistics
+        */
+        Stats getStats() const;
+
+    private:
+        TlsfAllocator(uint64_t size);
+
+        static const uint32_t kSlBits = 4;
+        static const uint32_t kSlCount = 1 << kSlBits;
+        static const uint32_t kFlCount = 48;
+        static const uint32_t kInvalidBlock = uint32_t(-1);
+
+        struct Block
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t prevPhysical = kInvalidBlock;
+            uint32_t nextPhysical = kInvalidBlock;
+            uint32_t prevFree = kInvalidBlock;
+            uint32_t nextFree = kInvalidBlock;
+            bool isFree = false;
+        };
+
+        uint64_t mSize = 0;
+        uint64_t mFreeBytes = 0;
+        uint32_t mFreeBlockCount = 0;
+        uint64_t mFlBitmap = 0;
+        uint32_t mSlBitmaps[kFlCount] = {};
+        uint32_t mFreeLists[kFlCount][kSlCount];
+
+        std::vector<Block> mBlocks;
+        std::vector<uint32_t> mUnusedBlocks;
+        std::unordered_map<uint64_t, uint32_t> mAllocatedBlocks;   // Offset to block index
+
+        uint32_t createBlock(uint64_t offset, uint64_t size);
+        void destroyBlock(uint32_t index);
+        void insertFreeBlock(uint32_t index);
+        void removeFreeBlock(uint32_t index);
+        uint32_t findFreeBlock(uint64_t size) const;
+        void splitBlock(uint32_t index, uint64_t size);
+    };
+}
@@ -85,6 +85,21 @@ namespace Falcor
     {
         Buffer::apiInit(false);
         mData.assign(mSize, 0);
+        markDirty(0, mSize);
+    }
+
+    void VariablesBuffer::markDirty(size_t offset, size_t size)
+    {
+        if (isDirty())
+        {
+            mDirtyBegin = std::min(mDirtyBegin, offset);
+            mDirtyEnd = std::max(mDirtyEnd, offset + size);
+        }
+        else
+        {
+            mDirtyBegin = offset;
+            mDirtyEnd = offset + size;
+        }
     }
 
     size_t VariablesBuffer::getVariableOffset(const std::string& varName) const
@@ -95,14 +110,22 @@ namespace Falcor
 
     bool VariablesBuffer::uploadToGPU(size_t offset, size_t size)
     {
-        if(mDirty == false)
+        if(isDirty() == false)
         {
             return false;
         }
 
         if(size == -1)
         {
-            size = mSize - offset;
+            if ((offset == 0) && (mCpuAccess != CpuAccess::Write))
+            {
+                offset = mDirtyBegin;
+                size = mDirtyEnd - mDirtyBegin;
+            }
+            else
+            {
+                size = mSize - offset;
+            }
         }
 
         if(size + offset > mSize)
@@ -111,8 +134,9 @@ namespace Falcor
             return false;
         }
 
-        updateData(mData.data(), offset, size);
-        mDirty = false;
+        updateData(mData.data() + offset, offset, size);
+        mDirtyBegin = 0;
+        mDirtyEnd = 0;
         return true;
     }
 
@@ -177,7 +201,7 @@ namespace Falcor
         {
             const uint8_t* pVar = mData.data() + offset + elementIndex * mElementSize;
             *(VarType*)pVar = value;
-            mDirty = true;
+            markDirty((size_t)(pVar - mData.data()), sizeof(VarType));
         }
     }
 
@@ -277,7 +301,7 @@ namespace Falcor
             {
                 pData[i] = pValue[i];
             }
-            mDirty = true;
+            markDirty((size_t)((uint8_t*)pData - mData.data()), count * sizeof(VarType));
         }
     }
 
@@ -391,6 +415,6 @@ namespace Falcor
             return;
         }
         std::memcpy(mData.data() + offset, pSrc, size);
-        mDirty = true;
+        markDirty(offset, size);
     }
 }
@@ -54,6 +54,7 @@ namespace Falcor
         virtual ~VariablesBuffer() = 0;
 
         /** Apply the changes to the actual GPU buffer.
+            When called with the default arguments, only the byte range modified since the last upload is uploaded. Buffers created with CpuAccess::Write get new memory on every update, so they always upload their entire content.
             Note that it is possible to use this function to update only part of the GPU copy of the buffer. This might lead to inconsistencies between the GPU and CPU buffer, so make sure you know what you are doing.
             \param[in] offset Offset into the buffer to write to
             \param[in] size Number of bytes to upload. If this value is -1, will update the [Offset, EndOfBuffer] range.
@@ -80,6 +81,10 @@ namespace Falcor
 
         size_t getElementSize() const { return mElementSize; }
 
+        /** Check if the CPU copy was modified since the last upload
+        */
+        bool isDirty() const { return mDirtyBegin < mDirtyEnd; }
+
     protected:
         template<typename T>
         void setVariable(const std::string& name, size_t elementIndex, const T& value);
@@ -93,9 +98,14 @@ namespace Falcor
         template<typename T>
         void setVariableArray(const std::string& name, size_t elementIndex, const T* pValue, size_t count);
 
+        /** Add a byte range to the range which will be uploaded on the next uploadToGPU() call
+        */
+        void markDirty(size_t offset, size_t size);
+
         ReflectionResourceType::SharedConstPtr mpReflector;
         std::vector<uint8_t> mData;
-        mutable bool mDirty = true;
+        size_t mDirtyBegin = 0;     ///< Start of the range modified since the last upload
+        size_t mDirtyEnd = 0;       ///< End of the range modified since the last upload. The range is empty if it's not larger than mDirtyBegin
         size_t mElementCount;
         size_t mElementSize;
         std::string mName;
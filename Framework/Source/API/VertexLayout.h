@@ -73,6 +73,14 @@ namespace Falcor
             mVertexStride += getFormatBytesPerBlock(Elem.format) * Elem.arraySize;
         }
 
+        /** Add unused bytes to the vertex. Use this when the buffer holds data which isn't bound to the shader.
+            \param size Number of bytes to add to the vertex stride.
+        */
+        void addPadding(uint32_t size)
+        {
+            mVertexStride += size;
+        }
+
         /** Return the element offset pointed to by Index
         */
         uint32_t getElementOffset(uint32_t index) const
@@ -200,6 +208,9 @@ namespace Falcor
             pProg->removeDefine("HAS_TEXCRD");
             pProg->removeDefine("HAS_COLORS");
             pProg->removeDefine("HAS_LIGHTMAP_UV");
+            pProg->removeDefine("HAS_QUANTIZED_POSITION");
+            pProg->removeDefine("HAS_PACKED_NORMAL");
+            pProg->removeDefine("HAS_PACKED_BITANGENT");
 
             for (const auto& l : mpBufferLayouts)
             {
@@ -207,13 +218,20 @@ namespace Falcor
                 {
                     for (uint32_t i = 0; i < l->getElementCount(); i++)
                     {
+                        // The packed formats of VertexQuantizer need to be decoded by the vertex shader. The others are converted by the input assembler.
+                        if (l->getElementShaderLocation(i) == VERTEX_POSITION_LOC && l->getElementFormat(i) == ResourceFormat::RGBA16Unorm)
+                        {
+                            pProg->addDefine("HAS_QUANTIZED_POSITION");
+                        }
                         if (l->getElementShaderLocation(i) == VERTEX_NORMAL_LOC)
                         {
                             pProg->addDefine("HAS_NORMAL");
+                            if (l->getElementFormat(i) == ResourceFormat::RG16Snorm) pProg->addDefine("HAS_PACKED_NORMAL");
                         }
                         if (l->getElementShaderLocation(i) == VERTEX_BITANGENT_LOC)
                         {
                             pProg->addDefine("HAS_BITANGENT");
+                            if (l->getElementFormat(i) == ResourceFormat::RG16Snorm) pProg->addDefine("HAS_PACKED_BITANGENT");
                         }
                         if (l->getElementShaderLocation(i) == VERTEX_TEXCOORD_LOC)
                         {
@@ -34,13 +34,15 @@ namespace Falcor
 {
     struct LowLevelContextApiData
     {
-        FencedPool<VkCommandBuffer>::SharedPtr pCmdBufferAllocator;
+        FencedRecycler<VkCommandBuffer>::SharedPtr pCmdBufferAllocator;
         bool recordingCmds = false;
     };
 
-    VkCommandBuffer createCommandBuffer(void* pUserData)
+    // Command buffers the GPU is done with which are kept for reuse. Bursts of flushes above this free their command buffers.
+    static const uint32_t kMaxAvailableCmdBuffers = 8;
+
+    VkCommandBuffer createCommandBuffer(LowLevelContextData* pThis)
     {
-        LowLevelContextData* pThis = (LowLevelContextData*)pUserData;
         VkCommandBufferAllocateInfo cmdBufAllocateInfo = {};
         cmdBufAllocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         cmdBufAllocateInfo.commandPool        = pThis->getCommandAllocator();
@@ -51,6 +53,11 @@ namespace Falcor
         return cmdBuf;
     }
 
+    void destroyCommandBuffer(LowLevelContextData* pThis, VkCommandBuffer& cmdBuf)
+    {
+        vkFreeCommandBuffers(gpDevice->getApiHandle(), pThis->getCommandAllocator(), 1, &cmdBuf);
+    }
+
     LowLevelContextData::SharedPtr LowLevelContextData::create(LowLevelContextData::CommandQueueType type, CommandQueueHandle queue)
     {
         SharedPtr pThis = SharedPtr(new LowLevelContextData);
@@ -70,8 +77,12 @@ namespace Falcor
         }
         pThis->mpAllocator = CommandAllocatorHandle::create(pool);
         pThis->mpApiData = new LowLevelContextApiData;
-        pThis->mpApiData->pCmdBufferAllocator = FencedPool<VkCommandBuffer>::create(pThis->mpFence, createCommandBuffer, pThis.get());
-        pThis->mpList = pThis->mpApiData->pCmdBufferAllocator->newObject();
+        LowLevelContextData* pData = pThis.get();
+        pThis->mpApiData->pCmdBufferAllocator = FencedRecycler<VkCommandBuffer>::create(pThis->mpFence,
+            [pData]() { return createCommandBuffer(pData); },
+            [pData](VkCommandBuffer& cmdBuf) { destroyCommandBuffer(pData, cmdBuf); },
+            kMaxAvailableCmdBuffers);
+        pThis->mpList = pThis->mpApiData->pCmdBufferAllocator->acquire();
 
         return pThis;
     }
@@ -89,7 +100,7 @@ namespace Falcor
             beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
             beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
             beginInfo.pInheritanceInfo = nullptr;
-            mpList = mpApiData->pCmdBufferAllocator->newObject();
+            mpList = mpApiData->pCmdBufferAllocator->exchange(mpList);
             vk_call(vkBeginCommandBuffer(mpList, &beginInfo));
             mpApiData->recordingCmds = true;
         }
@@ -165,6 +165,22 @@ struct MaterialData
     SamplerState samplerState;  // The sampler state to use when sampling the object
 };
 
+/**
+    A material in the bindless material table. The textures and the sampler are indices into the table's texture and sampler arrays.
+    Index 0 of both arrays is never assigned, missing textures use it.
+*/
+struct BindlessMaterialData
+{
+    MaterialDesc desc;
+    MaterialValues values;
+    uint32_t layers[MatMaxLayers];
+    uint32_t alphaMap;
+    uint32_t normalMap;
+    uint32_t heightMap;
+    uint32_t ambientMap;
+    uint32_t samplerState;
+};
+
 struct PreparedMaterialData
 {
     MaterialDesc    desc;
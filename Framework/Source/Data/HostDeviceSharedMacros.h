@@ -34,6 +34,8 @@
 
 #define MAX_INSTANCES 64    ///< Max supported instances per draw call
 #define MAX_BONES 128       ///< Max supported bones per model
+#define MAX_BINDLESS_TEXTURES 2048  ///< Size of the texture array of the bindless material table
+#define MAX_BINDLESS_SAMPLERS 32    ///< Size of the sampler array of the bindless material table
 
 /*******************************************************************
                     Glue code for CPU/GPU compilation
@@ -25,6 +25,8 @@
 # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
+#ifndef _FALCOR_VERTEX_ATTRIB_H_
+#define _FALCOR_VERTEX_ATTRIB_H_
 
 #define VERTEX_POSITION_LOC         0
 #define VERTEX_NORMAL_LOC           1
@@ -48,3 +50,18 @@
 #define VERTEX_BONE_WEIGHT_NAME     "BONE_WEIGHTS"
 #define VERTEX_BONE_ID_NAME         "BONE_IDS"
 #define VERTEX_DIFFUSE_COLOR_NAME   "DIFFUSE_COLOR"
+
+#ifndef __cplusplus
+/** Decode a normal or bitangent packed with octahedral encoding (see VertexQuantizer::encodeOctahedral())
+*/
+float3 decodeOctahedralUnitVector(float2 e)
+{
+    float3 v = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.x += (v.x >= 0.0) ? -t : t;
+    v.y += (v.y >= 0.0) ? -t : t;
+    return normalize(v);
+}
+#endif
+
+#endif // _FALCOR_VERTEX_ATTRIB_H_
@@ -65,7 +65,7 @@
 #if defined FALCOR_D3D12 || defined FALCOR_VK
 #include "API/DescriptorSet.h"
 #include "API/LowLevel/DescriptorPool.h"
-#include "API/LowLevel/FencedPool.h"
+#include "API/LowLevel/FencedRecycler.h"
 #include "API/LowLevel/GpuFence.h"
 #include "API/LowLevel/RootSignature.h"
 #endif //FALCOR_D3D12 || defined FALCOR_VK
@@ -88,6 +88,7 @@
 #include "Graphics/Program/GraphicsProgram.h"
 #include "Graphics/Program/ComputeProgram.h"
 #include "Graphics/Program/ParameterBlock.h"
+#include "Graphics/Program/ShaderCache.h"
 
 // Material
 #include "Graphics/Material/Material.h"
@@ -120,16 +121,21 @@
 #include "Utils/Logger.h"
 #include "Utils/TextRenderer.h"
 #include "Utils/CpuTimer.h"
+#include "Utils/BoundingBoxArray.h"
 #include "Utils/UserInput.h"
 #include "Utils/Profiler.h"
+#include "Utils/CpuProfiler.h"
 #include "Utils/StringUtils.h"
 #include "Utils/BinaryFileStream.h"
+#include "Utils/MappedFileStream.h"
+#include "Utils/Lz4.h"
 #include "Utils/Video/VideoEncoder.h"
 #include "Utils/Video/VideoEncoderUI.h"
 #include "Utils/Video/VideoDecoder.h"
 #include "Utils/Platform/OS.h"
 #include "Utils/Platform/ProgressBar.h"
-#include "Utils/ThreadPool.h"
+#include "Utils/TaskScheduler.h"
+#include "Utils/RadixSort.h"
 
 // VR
 #include "VR/OpenVR/VRSystem.h"
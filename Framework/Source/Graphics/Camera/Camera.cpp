@@ -29,6 +29,7 @@
 #include "Camera.h"
 #include "glm/gtx/quaternion.hpp"
 #include "Utils/AABB.h"
+#include "Utils/BoundingBoxArray.h"
 #include "Utils/Math/FalcorMath.h"
 #include "API/ConstantBuffer.h"
 
@@ -196,6 +197,42 @@ namespace Falcor
         return !isInside;
     }
 
+    bool Camera::isObjectCulled(const BoundingBox& box, uint32_t& planeMask) const
+    {
+        calculateCameraParameters();
+
+        uint32_t intersectingPlanes = 0;
+        for (int plane = 0; plane < 6; plane++)
+        {
+            if ((planeMask & (1 << plane)) == 0) continue;
+
+            // The corner furthest along the plane normal is behind the plane, the box is outside
+            glm::vec3 signedExtent = box.extent * mFrustumPlanes[plane].sign;
+            if (glm::dot(box.center + signedExtent, mFrustumPlanes[plane].xyz) <= mFrustumPlanes[plane].negW) return true;
+
+            // The nearest corner is behind the plane, the box straddles it
+            if (glm::dot(box.center - signedExtent, mFrustumPlanes[plane].xyz) <= mFrustumPlanes[plane].negW)
+            {
+                intersectingPlanes |= (1 << plane);
+            }
+        }
+
+        planeMask = intersectingPlanes;
+        return false;
+    }
+
+    size_t Camera::cullBoundingBoxes(const BoundingBoxArray& boxes, std::vector<uint32_t>& visibleIndices) const
+    {
+        calculateCameraParameters();
+
+        glm::vec4 planes[6];
+        for (int plane = 0; plane < 6; plane++)
+        {
+            planes[plane] = glm::vec4(mFrustumPlanes[plane].xyz, mFrustumPlanes[plane].negW);
+        }
+        return boxes.cull(planes, 6, visibleIndices);
+    }
+
     void Camera::setRightEyeMatrices(const glm::mat4& view, const glm::mat4& proj)
     {
         mData.rightEyeViewMat = view;
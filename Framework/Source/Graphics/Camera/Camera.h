@@ -36,6 +36,7 @@
 namespace Falcor
 {
     struct BoundingBox;
+    class BoundingBoxArray;
     class ConstantBuffer;
 
     /** Camera class. Default transform matrices are interpreted as left eye transform during stereo rendering.
@@ -161,6 +162,24 @@ namespace Falcor
         */
         bool isObjectCulled(const BoundingBox& box) const;
 
+        /** Bit-mask with all six frustum planes set. See isObjectCulled()
+        */
+        static const uint32_t kAllFrustumPlanes = 0x3f;
+
+        /** Check if an object should be culled, testing only a subset of the frustum planes. Used for hierarchical culling - planes a parent box is fully inside of don't need to be tested for its children.
+            \param[in] box Bounding box of the object to check
+            \param[in,out] planeMask On input, a bit per frustum plane to test. On output, the planes which intersect the box. 0 means the box is fully inside the frustum. Not modified if the box is culled
+            \return true if the box is outside the frustum
+        */
+        bool isObjectCulled(const BoundingBox& box, uint32_t& planeMask) const;
+
+        /** Frustum-cull a batch of bounding boxes. Gives the same results as calling isObjectCulled() on each box, but tests several boxes at once using SIMD.
+            \param[in] boxes The boxes to test
+            \param[out] visibleIndices Indices of the boxes which are at least partially inside the frustum, in increasing order
+            \return The number of visible boxes
+        */
+        size_t cullBoundingBoxes(const BoundingBoxArray& boxes, std::vector<uint32_t>& visibleIndices) const;
+
         /** Set camera data into a program's constant buffer.
             \param[in] pBuffer The constant buffer to set the parameters into.
             \param[in] varName The name of the light variable in the program.
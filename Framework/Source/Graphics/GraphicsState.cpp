@@ -28,6 +28,7 @@
 #include "Framework.h"
 #include "GraphicsState.h"
 #include "Graphics/Program/ProgramVars.h"
+#include "API/GraphicsStateCache.h"
 
 namespace Falcor
 {
@@ -61,8 +62,6 @@ namespace Falcor
         {
             setViewport(i, mViewports[i], true);
         }
-
-        mpGsoGraph = StateGraph::create();
     }
 
     GraphicsState::~GraphicsState() = default;
@@ -75,30 +74,28 @@ namespace Falcor
             mpVao->getVertexLayout()->addVertexAttribDclToProg(mpProgram.get());
         }
         const ProgramVersion::SharedConstPtr pProgVersion = mpProgram ? mpProgram->getActiveVersion() : nullptr;
-        bool newProgVersion = pProgVersion.get() != mCachedData.pProgramVersion;
-        if (newProgVersion)
+        if (pProgVersion.get() != mCachedData.pProgramVersion)
         {
             mCachedData.pProgramVersion = pProgVersion.get();
-            mpGsoGraph->walk((void*)pProgVersion.get());
+            mGsoDirty = true;
         }
     
         RootSignature::SharedPtr pRoot = pVars ? pVars->getRootSignature() : RootSignature::getEmpty();
-
         if (mCachedData.pRootSig != pRoot.get())
         {
             mCachedData.pRootSig = pRoot.get();
-            mpGsoGraph->walk((void*)mCachedData.pRootSig);
+            mGsoDirty = true;
         }
 
         const Fbo::Desc* pFboDesc = mpFbo ? &mpFbo->getDesc() : nullptr;
         if(mCachedData.pFboDesc != pFboDesc)
         {
-            mpGsoGraph->walk((void*)pFboDesc);
             mCachedData.pFboDesc = pFboDesc;
+            mGsoDirty = true;
         }
 
-        GraphicsStateObject::SharedPtr pGso = mpGsoGraph->getCurrentNode();
-        if(pGso == nullptr)
+        // The pointers compared above stay valid while mpGso is alive, since its desc holds references to them and FBO descs are never freed
+        if (mGsoDirty || mpGso == nullptr)
         {
             mDesc.setProgramVersion(pProgVersion);
             mDesc.setFboFormats(mpFbo ? mpFbo->getDesc() : Fbo::Desc());
@@ -110,23 +107,11 @@ namespace Falcor
             mDesc.setRootSignature(pRoot);
 
             mDesc.setSinglePassStereoEnable(mEnableSinglePassStereo);
-            
-            StateGraph::CompareFunc cmpFunc = [&desc = mDesc](GraphicsStateObject::SharedPtr pGso) -> bool
-            {
-                return pGso && (desc == pGso->getDesc());
-            };
 
-            if (mpGsoGraph->scanForMatchingNode(cmpFunc))
-            {
-                pGso = mpGsoGraph->getCurrentNode();
-            }
-            else
-            {
-                pGso = GraphicsStateObject::create(mDesc);
-                mpGsoGraph->setCurrentNodeData(pGso);
-            }
+            mpGso = GraphicsStateCache::get(mDesc);
+            mGsoDirty = false;
         }
-        return pGso;
+        return mpGso;
     }
 
     GraphicsState& GraphicsState::setFbo(const Fbo::SharedPtr& pFbo, bool setVp0Sc0)
@@ -170,7 +155,7 @@ namespace Falcor
             mDesc.setVao(pVao);
 #endif
 
-            mpGsoGraph->walk(pVao ? (void*)pVao->getVertexLayout().get() : nullptr);
+            mGsoDirty = true;
         }
         return *this;
     }
@@ -180,7 +165,7 @@ namespace Falcor
         if(mDesc.getBlendState() != pBlendState)
         {
             mDesc.setBlendState(pBlendState);
-            mpGsoGraph->walk((void*)pBlendState.get());
+            mGsoDirty = true;
         }
         return *this;
     }
@@ -190,7 +175,7 @@ namespace Falcor
         if(mDesc.getRasterizerState() != pRasterizerState)
         {
             mDesc.setRasterizerState(pRasterizerState);
-            mpGsoGraph->walk((void*)pRasterizerState.get());
+            mGsoDirty = true;
         }
         return *this;
     }
@@ -200,7 +185,7 @@ namespace Falcor
         if(mDesc.getSampleMask() != sampleMask)
         {
             mDesc.setSampleMask(sampleMask);
-            mpGsoGraph->walk((void*)(uint64_t)sampleMask);
+            mGsoDirty = true;
         }
         return *this; 
     }
@@ -210,7 +195,7 @@ namespace Falcor
         if(mDesc.getDepthStencilState() != pDepthStencilState)
         {
             mDesc.setDepthStencilState(pDepthStencilState);
-            mpGsoGraph->walk((void*)pDepthStencilState.get());
+            mGsoDirty = true;
         }
         return *this;
     }
@@ -275,7 +260,7 @@ namespace Falcor
     {
 #if _ENABLE_NVAPI
         mEnableSinglePassStereo = enable;
-        mpGsoGraph->walk((void*)enable);
+        mGsoDirty = true;
 #else
         if (enable)
         {
@@ -34,7 +34,6 @@
 #include "API/DepthStencilState.h"
 #include "API/BlendState.h"
 #include <stack>
-#include "Utils/Graph.h"
 
 namespace Falcor
 {
@@ -259,7 +258,8 @@ namespace Falcor
         };
         CachedData mCachedData;
 
-        using StateGraph = Graph<GraphicsStateObject::SharedPtr, void*>;
-        StateGraph::SharedPtr mpGsoGraph;
+        // The GSO returned by the last getGSO() call. It's looked up in the GraphicsStateCache again once the state changes.
+        GraphicsStateObject::SharedPtr mpGso;
+        bool mGsoDirty = true;
     };
 }
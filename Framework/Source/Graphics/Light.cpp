@@ -33,8 +33,10 @@
 #include "API/Buffer.h"
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <cstring>
 #include "Data/VertexAttrib.h"
 #include "Graphics/Model/Model.h"
+#include "Graphics/Model/Loaders/VertexQuantizer.h"
 
 
 namespace Falcor
@@ -454,9 +456,25 @@ namespace Falcor
                 return;
             }
 
+            if (VertexQuantizer::isPackedLayout(pMesh->getVao()->getVertexLayout().get()))
+            {
+                logWarning("Area light meshes can't use quantized vertices. Load the model without Model::LoadFlags::QuantizeVertices.");
+                return;
+            }
+
             // Read data from the buffers
             const glm::ivec3* indices = (const glm::ivec3*)mIndexBuf->map(Buffer::MapType::Read);
-            const glm::vec3* vertices = (const glm::vec3*)mVertexBuf->map(Buffer::MapType::Read);
+            const uint8_t* pVertexData = (const uint8_t*)mVertexBuf->map(Buffer::MapType::Read);
+
+            // The position buffer might interleave other attributes
+            const auto& pVao = pMesh->getVao();
+            Vao::ElementDesc posDesc = pVao->getElementIndexByLocation(VERTEX_POSITION_LOC);
+            const VertexBufferLayout* pPosLayout = pVao->getVertexLayout()->getBufferLayout(posDesc.vbIndex).get();
+            std::vector<glm::vec3> vertices(pMesh->getVertexCount());
+            for (uint32_t v = 0; v < pMesh->getVertexCount(); v++)
+            {
+                std::memcpy(&vertices[v], pVertexData + pPosLayout->getStride() * v + pPosLayout->getElementOffset(posDesc.elementIndex), sizeof(glm::vec3));
+            }
 
             // Calculate surface area of the mesh
             mSurfaceArea = 0.f;
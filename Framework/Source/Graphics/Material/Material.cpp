@@ -36,12 +36,104 @@
 #include "Graphics/Program/ProgramVars.h"
 #include "Graphics/Program/GraphicsProgram.h"
 #include <cstring>
+#include <mutex>
+#include <unordered_map>
 
 namespace Falcor
 {
     static const char* kMaterialVarName = "materialBlock";
     uint32_t Material::sMaterialCounter = 0;
-    std::vector<Material::DescId> Material::sDescIdentifier;
+
+    namespace
+    {
+        /** Interns material descs. Materials with byte-wise identical descs share the same ref-counted identifier.
+            Lookup and release are O(1), and the table can be accessed from multiple threads so that materials can be finalized by loader threads.
+        */
+        class MaterialDescTable
+        {
+        public:
+            /** Get the identifier of a desc, adding it to the table if it's not there yet. Increments the desc's ref-count.
+            */
+            uint64_t acquire(const MaterialDesc& desc)
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                auto result = mDescToEntry.emplace(desc, Entry());
+                Entry& entry = result.first->second;
+                if (result.second)
+                {
+                    entry.id = mNextId++;
+                    mIdToDesc[entry.id] = &result.first->first;
+                }
+                entry.refCount++;
+                return entry.id;
+            }
+
+            /** Decrement the ref-count of an identifier.
+                \return true if this was the last reference and the identifier was removed from the table
+            */
+            bool release(uint64_t id)
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                auto it = mIdToDesc.find(id);
+                if (it == mIdToDesc.end())
+                {
+                    should_not_get_here();
+                    return false;
+                }
+
+                auto descIt = mDescToEntry.find(*it->second);
+                assert(descIt != mDescToEntry.end() && descIt->second.refCount > 0);
+                if (--descIt->second.refCount > 0) return false;
+
+                mIdToDesc.erase(it);
+                mDescToEntry.erase(descIt);
+                return true;
+            }
+
+        private:
+            struct DescHash
+            {
+                size_t operator()(const MaterialDesc& desc) const
+                {
+                    // FNV-1a over the raw bytes, to match the byte-wise comparison
+                    const uint8_t* pData = reinterpret_cast<const uint8_t*>(&desc);
+                    uint64_t hash = 14695981039346656037ull;
+                    for (size_t i = 0; i < sizeof(MaterialDesc); i++)
+                    {
+                        hash = (hash ^ pData[i]) * 1099511628211ull;
+                    }
+                    return (size_t)hash;
+                }
+            };
+
+            struct DescEqual
+            {
+                bool operator()(const MaterialDesc& a, const MaterialDesc& b) const
+                {
+                    return std::memcmp(&a, &b, sizeof(MaterialDesc)) == 0;
+                }
+            };
+
+            struct Entry
+            {
+                uint64_t id = 0;
+                uint32_t refCount = 0;
+            };
+
+            std::mutex mMutex;
+            std::unordered_map<MaterialDesc, Entry, DescHash, DescEqual> mDescToEntry;
+            std::unordered_map<uint64_t, const MaterialDesc*> mIdToDesc;    // Points at the keys of mDescToEntry, which are stable
+            uint64_t mNextId = 0;
+        };
+
+        MaterialDescTable& getDescTable()
+        {
+            // Never destroyed, materials held in static objects can be released after static destruction started
+            static MaterialDescTable* pTable = new MaterialDescTable;
+            return *pTable;
+        }
+    }
+
     ParameterBlockReflection::SharedConstPtr Material::spBlockReflection;
 
     Material::Material(const std::string& name) : mName(name)
@@ -410,43 +502,26 @@ namespace Falcor
 
     void Material::removeDescIdentifier() const
     {
-        for(size_t i = 0 ; i < sDescIdentifier.size() ; i++)
+        if (mDescIdentifier != kInvalidDescIdentifier)
         {
-            if(mDescIdentifier == sDescIdentifier[i].id)
+            if (getDescTable().release(mDescIdentifier))
             {
-                sDescIdentifier[i].refCount--;
-                if(sDescIdentifier[i].refCount == 0)
-                {
-                    MaterialSystem::removeMaterial(mDescIdentifier);
-                    sDescIdentifier.erase(sDescIdentifier.begin() + i);
-                }
+                MaterialSystem::removeMaterial(mDescIdentifier);
             }
+            mDescIdentifier = kInvalidDescIdentifier;
         }
     }
 
     void Material::updateDescIdentifier() const
     {
-        static uint64_t identifier = 0;
-
+        // Acquire the new identifier before releasing the old one, so that an unchanged desc keeps its entry
+        uint64_t descIdentifier = getDescTable().acquire(mData.desc);
         removeDescIdentifier();
+        mDescIdentifier = descIdentifier;
         mDescDirty = false;
-        for(auto& a : sDescIdentifier)
-        {
-            if(std::memcmp(&mData.desc, &a.desc, sizeof(mData.desc)) == 0)
-            {
-                mDescIdentifier = a.id;
-                a.refCount++;
-                return;
-            }
-        }
-
-        // Not found, add it to the vector
-        sDescIdentifier.push_back({mData.desc, identifier, 1});
-        mDescIdentifier = identifier;
-        identifier++;
     }
 
-    size_t Material::getDescIdentifier() const
+    uint64_t Material::getDescIdentifier() const
     {
         finalize();
         return mDescIdentifier;
@@ -550,6 +625,12 @@ namespace Falcor
         return ParameterBlock::SharedConstPtr(mpParamBlock);
     }
 
+    const MaterialData& Material::getData() const
+    {
+        finalize();
+        return mData;
+    }
+
     void Material::createParameterBlock()
     {
         if (spBlockReflection == nullptr)
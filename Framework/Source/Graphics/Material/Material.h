@@ -320,6 +320,10 @@ namespace Falcor
         /** Get the ParameterBlock object for the material. Each material is created with a parameter-block. Using it is more efficient than assigning data to a custom constant-buffer.
         */
         ParameterBlock::SharedConstPtr getParameterBlock() const;
+
+        /** Get the material's data, after the pending desc changes were applied. Used to copy the material into a MaterialTable.
+        */
+        const MaterialData& getData() const;
     private:
         void finalize() const;
         void normalize() const;
@@ -336,20 +340,15 @@ namespace Falcor
 
         // The next functions and fields are used for material compilation into shaders.
         // We only compile based on the material descriptor, so as an optimization we minimize the number of shader permutations based on the desc
-        struct DescId
-        {
-            MaterialDesc desc;
-            uint64_t id;
-            uint32_t refCount;
-        };
+        // Identical descs are interned into a shared, ref-counted identifier. See the desc table in Material.cpp
+        static const uint64_t kInvalidDescIdentifier = uint64_t(-1);
         mutable bool mDescDirty = true;
         mutable std::string mDescString;
-        mutable size_t mDescIdentifier;
+        mutable uint64_t mDescIdentifier = kInvalidDescIdentifier;
         void updateDescIdentifier() const;
         void removeDescIdentifier() const;
         void updateDescString() const;
         static uint32_t sMaterialCounter;
-        static std::vector<DescId> sDescIdentifier; // vector is slower then map, but map requires 'less' operator. This vector is only being used when the material is dirty, which shouldn't happen often
 
         ParameterBlock::SharedPtr mpParamBlock;
         static ParameterBlockReflection::SharedConstPtr spBlockReflection;
@@ -30,6 +30,7 @@
 #include "Material.h"
 #include "Graphics/Program/Program.h"
 #include <map>
+#include <mutex>
 
 namespace Falcor
 {
@@ -39,19 +40,23 @@ namespace Falcor
         using MaterialProgramMap = std::map<uint64_t, ProgramVersionMap>;
 
         static MaterialProgramMap gMaterialProgramMap;
+        static std::mutex gMaterialProgramMapMutex; // Materials can be released from loader threads
 
         void reset()
         {
+            std::lock_guard<std::mutex> lock(gMaterialProgramMapMutex);
             gMaterialProgramMap.clear();
         }
 
         void removeMaterial(uint64_t descIdentifier)
         {
+            std::lock_guard<std::mutex> lock(gMaterialProgramMapMutex);
             gMaterialProgramMap.erase(descIdentifier);
         }
 
         void removeProgramVersion(const ProgramVersion* pProgramVersion)
         {
+            std::lock_guard<std::mutex> lock(gMaterialProgramMapMutex);
             if(gMaterialProgramMap.size())
             {
                 for(auto& it : gMaterialProgramMap)
@@ -0,0 +1,212 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MaterialTable.h"
+#include "Graphics/Program/GraphicsProgram.h"
+
+namespace Falcor
+{
+    static const char* kMaterialTableVarName = "materialTable";
+    static const char* kMaterialBufferName = "materials";
+    static const size_t kInitialMaterialCapacity = 64;
+
+    static_assert(sizeof(BindlessMaterialData) % sizeof(glm::vec4) == 0, "BindlessMaterialData size should be a multiple of 16");
+
+    ParameterBlockReflection::SharedConstPtr MaterialTable::spBlockReflection;
+
+    MaterialTable::SharedPtr MaterialTable::create()
+    {
+        return SharedPtr(new MaterialTable());
+    }
+
+    MaterialTable::MaterialTable()
+    {
+        if (spBlockReflection == nullptr)
+        {
+            Program::DefineList defines;
+            defines.add("_MS_BINDLESS_MATERIALS");
+            GraphicsProgram::SharedPtr pProgram = GraphicsProgram::createFromFile("", "Framework/Shaders/MaterialTableBlock.slang", defines);
+            ProgramReflection::SharedConstPtr pReflection = pProgram->getActiveVersion()->getReflector();
+            spBlockReflection = pReflection->getParameterBlock(kMaterialTableVarName);
+            assert(spBlockReflection);
+        }
+
+        mpParamBlock = ParameterBlock::create(spBlockReflection, false);
+        mTexturesBinding = spBlockReflection->getResourceBinding("textures");
+        mSamplersBinding = spBlockReflection->getResourceBinding("samplers");
+        mTextures.resize(1);
+        mSamplers.resize(1);
+        createMaterialBuffer(kInitialMaterialCapacity);
+    }
+
+    void MaterialTable::createMaterialBuffer(size_t elementCount)
+    {
+        ReflectionResourceType::SharedConstPtr pType;
+        for (const auto& resource : spBlockReflection->getResourceVec())
+        {
+            if (resource.name == kMaterialBufferName) pType = resource.pType;
+        }
+        assert(pType);
+
+        mpMaterialBuffer = StructuredBuffer::create(kMaterialBufferName, pType, elementCount, Resource::BindFlags::ShaderResource);
+        assert(mpMaterialBuffer->getElementSize() == sizeof(BindlessMaterialData));
+        mpParamBlock->setStructuredBuffer(kMaterialBufferName, mpMaterialBuffer);
+
+        // The new buffer is empty, all the materials need to be written again
+        mMaterialData.clear();
+    }
+
+    uint32_t MaterialTable::addMaterial(const Material::SharedPtr& pMaterial)
+    {
+        auto it = mMaterialIndices.emplace(pMaterial.get(), (uint32_t)mMaterials.size());
+        if (it.second)
+        {
+            mMaterials.push_back(pMaterial);
+        }
+        return it.first->second;
+    }
+
+    uint32_t MaterialTable::getMaterialIndex(const Material* pMaterial) const
+    {
+        auto it = mMaterialIndices.find(pMaterial);
+        return (it == mMaterialIndices.end()) ? kInvalidIndex : it->second;
+    }
+
+    uint32_t MaterialTable::registerTexture(const Texture::SharedPtr& pTexture, std::vector<Texture::SharedPtr>& textures)
+    {
+        if (pTexture == nullptr) return 0;
+
+        auto it = mTextureIndices.find(pTexture.get());
+        if (it != mTextureIndices.end()) return it->second;
+
+        if (textures.size() == MAX_BINDLESS_TEXTURES)
+        {
+            mOverflow = true;
+            return 0;
+        }
+        uint32_t index = (uint32_t)textures.size();
+        textures.push_back(pTexture);
+        mTextureIndices[pTexture.get()] = index;
+        return index;
+    }
+
+    uint32_t MaterialTable::registerSampler(const Sampler::SharedPtr& pSampler, std::vector<Sampler::SharedPtr>& samplers)
+    {
+        if (pSampler == nullptr) return 0;
+
+        auto it = mSamplerIndices.find(pSampler.get());
+        if (it != mSamplerIndices.end()) return it->second;
+
+        if (samplers.size() == MAX_BINDLESS_SAMPLERS)
+        {
+            mOverflow = true;
+            return 0;
+        }
+        uint32_t index = (uint32_t)samplers.size();
+        samplers.push_back(pSampler);
+        mSamplerIndices[pSampler.get()] = index;
+        return index;
+    }
+
+    void MaterialTable::update()
+    {
+        if (mpMaterialBuffer->getElementCount() < mMaterials.size())
+        {
+            createMaterialBuffer(std::max(mMaterials.size(), mpMaterialBuffer->getElementCount() * 2));
+        }
+
+        // The resource arrays are rebuilt from scratch, so that textures which are no longer used are released. Materials which keep their textures keep their indices.
+        std::vector<Texture::SharedPtr> textures(1);
+        std::vector<Sampler::SharedPtr> samplers(1);
+        mTextureIndices.clear();
+        mSamplerIndices.clear();
+        mOverflow = false;
+
+        const size_t writtenCount = mMaterialData.size();
+        mMaterialData.resize(mMaterials.size());
+        for (size_t i = 0; i < mMaterials.size(); i++)
+        {
+            const MaterialData& data = mMaterials[i]->getData();
+            BindlessMaterialData entry;
+            entry.desc = data.desc;
+            entry.values = data.values;
+            for (uint32_t layer = 0; layer < MatMaxLayers; layer++)
+            {
+                entry.layers[layer] = registerTexture(data.textures.layers[layer], textures);
+            }
+            entry.alphaMap = registerTexture(data.textures.alphaMap, textures);
+            entry.normalMap = registerTexture(data.textures.normalMap, textures);
+            entry.heightMap = registerTexture(data.textures.heightMap, textures);
+            entry.ambientMap = registerTexture(data.textures.ambientMap, textures);
+            entry.samplerState = registerSampler(data.samplerState, samplers);
+
+            // Only write the entries which changed, the buffer uploads the dirty range
+            if ((i >= writtenCount) || (std::memcmp(&entry, &mMaterialData[i], sizeof(entry)) != 0))
+            {
+                mMaterialData[i] = entry;
+                mpMaterialBuffer->setBlob(&entry, i * sizeof(entry), sizeof(entry));
+            }
+        }
+
+        // Each assignment invalidates the block's descriptor set, so only touch the slots which changed
+        for (size_t i = 1; i < std::max(textures.size(), mTextures.size()); i++)
+        {
+            const Texture::SharedPtr& pTexture = (i < textures.size()) ? textures[i] : nullptr;
+            if ((i >= mTextures.size()) || (mTextures[i] != pTexture))
+            {
+                mpParamBlock->setSrv(mTexturesBinding, (uint32_t)i, pTexture ? pTexture->getSRV() : nullptr);
+            }
+        }
+        for (size_t i = 1; i < std::max(samplers.size(), mSamplers.size()); i++)
+        {
+            const Sampler::SharedPtr& pSampler = (i < samplers.size()) ? samplers[i] : nullptr;
+            if ((i >= mSamplers.size()) || (mSamplers[i] != pSampler))
+            {
+                mpParamBlock->setSampler(mSamplersBinding, (uint32_t)i, pSampler);
+            }
+        }
+        mTextures.swap(textures);
+        mSamplers.swap(samplers);
+
+        if (mOverflow && (mOverflowReported == false))
+        {
+            logWarning("MaterialTable::update() - the materials use more than " + std::to_string(MAX_BINDLESS_TEXTURES) + " textures or " + std::to_string(MAX_BINDLESS_SAMPLERS) + " samplers. The remaining ones will be sampled as missing.");
+        }
+        mOverflowReported = mOverflow;
+    }
+
+    void MaterialTable::clear()
+    {
+        mMaterials.clear();
+        mMaterialIndices.clear();
+        mMaterialData.clear();
+
+        // Release the textures and the samplers
+        update();
+    }
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "Graphics/Material/Material.h"
+#include "API/StructuredBuffer.h"
+
+namespace Falcor
+{
+    /** A table of materials which is bound once and shared by all the draws, instead of binding each material's parameter block.
+        The materials are stored in a structured buffer of BindlessMaterialData. Their textures and samplers are registered in the table's descriptor arrays and referenced by index.
+        Shaders compiled with _MS_BINDLESS_MATERIALS declare the table as `gMaterialTable` and fetch materials with getBindlessMaterial(), see ShaderCommon.slang.
+    */
+    class MaterialTable
+    {
+    public:
+        using SharedPtr = std::shared_ptr<MaterialTable>;
+        using SharedConstPtr = std::shared_ptr<const MaterialTable>;
+
+        static const uint32_t kInvalidIndex = uint32_t(-1);
+
+        /** Create an empty table
+        */
+        static SharedPtr create();
+
+        /** Add a material to the table. The material's data is copied into the table on the next update() call.
+            \param[in] pMaterial The material to add
+            \return The material's index in the table. Adding a material twice returns the same index.
+        */
+        uint32_t addMaterial(const Material::SharedPtr& pMaterial);
+
+        /** Get the index of a material in the table
+            \return The material's index, or kInvalidIndex if it wasn't added
+        */
+        uint32_t getMaterialIndex(const Material* pMaterial) const;
+
+        /** Copy the materials' current data into the table. Only the materials which changed since the last call are uploaded, and the descriptor arrays are only rewritten when the set of textures changes.
+            Textures which are no longer used by any of the materials are released.
+        */
+        void update();
+
+        /** Remove all the materials from the table
+        */
+        void clear();
+
+        /** Get the number of materials in the table
+        */
+        uint32_t getMaterialCount() const { return (uint32_t)mMaterials.size(); }
+
+        /** Get the number of textures registered by the last update() call
+        */
+        uint32_t getTextureCount() const { return (uint32_t)mTextures.size() - 1; }
+
+        /** Get the number of samplers registered by the last update() call
+        */
+        uint32_t getSamplerCount() const { return (uint32_t)mSamplers.size() - 1; }
+
+        /** Get the parameter block to bind to `gMaterialTable`
+        */
+        ParameterBlock::SharedConstPtr getParameterBlock() const { return mpParamBlock; }
+
+    private:
+        MaterialTable();
+
+        void createMaterialBuffer(size_t elementCount);
+        uint32_t registerTexture(const Texture::SharedPtr& pTexture, std::vector<Texture::SharedPtr>& textures);
+        uint32_t registerSampler(const Sampler::SharedPtr& pSampler, std::vector<Sampler::SharedPtr>& samplers);
+
+        std::vector<Material::SharedPtr> mMaterials;
+        std::unordered_map<const Material*, uint32_t> mMaterialIndices;
+        std::vector<BindlessMaterialData> mMaterialData;    ///< The data last written into the buffer
+
+        // Index 0 of both arrays is reserved for missing resources
+        std::vector<Texture::SharedPtr> mTextures;
+        std::vector<Sampler::SharedPtr> mSamplers;
+        std::unordered_map<const Texture*, uint32_t> mTextureIndices;
+        std::unordered_map<const Sampler*, uint32_t> mSamplerIndices;
+        bool mOverflow = false;             ///< Set when the resources didn't fit into the arrays during the current update
+        bool mOverflowReported = false;
+
+        StructuredBuffer::SharedPtr mpMaterialBuffer;
+        ParameterBlock::SharedPtr mpParamBlock;
+        ParameterBlock::BindLocation mTexturesBinding;
+        ParameterBlock::BindLocation mSamplersBinding;
+        static ParameterBlockReflection::SharedConstPtr spBlockReflection;
+    };
+}
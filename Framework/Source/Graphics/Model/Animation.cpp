@@ -27,110 +27,449 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "Animation.h"
-#include "AnimationController.h"
-#include "glm/gtc/matrix_transform.hpp"
-#include "glm/gtx/transform.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FALCOR_ANIMATION_SIMD
+#endif
 
 namespace Falcor
 {
-    Animation::UniquePtr Animation::create(const std::string& name, const std::vector<AnimationSet>& animationSets, float duration, float ticksPerSecond)
+    namespace
     {
-        return UniquePtr(new Animation(name, animationSets, duration, ticksPerSecond));
-    }
+        // Number of tracks which are interpolated and converted to matrices together
+        const uint32_t kBatchSize = 16;
 
-    Animation::Animation(const std::string& name, const std::vector<AnimationSet>& animationSets, float duration, float ticksPerSecond) : mName(name), mAnimationSets(animationSets), mDuration(duration), mTicksPerSecond(ticksPerSecond)
-    {
+        // The interpolation is written once against these operations, and instantiated for both the SIMD type and float
+        template<typename V> V load(const float* p);
+        template<> inline float load<float>(const float* p) { return *p; }
+        inline void store(float* p, float v) { *p = v; }
+        template<typename V> V splat(float f);
+        template<> inline float splat<float>(float f) { return f; }
+        inline float add(float a, float b) { return a + b; }
+        inline float sub(float a, float b) { return a - b; }
+        inline float mul(float a, float b) { return a * b; }
+        inline float div(float a, float b) { return a / b; }
+        inline float negateIfNegative(float a, float sign) { return std::signbit(sign) ? -a : a; }
+        inline float squareRoot(float a) { return std::sqrt(a); }
 
-    }
+#ifdef FALCOR_ANIMATION_SIMD
+        using SimdFloat = __m128;
+        const uint32_t kSimdWidth = 4;
+        template<> inline SimdFloat load<SimdFloat>(const float* p) { return _mm_loadu_ps(p); }
+        inline void store(float* p, SimdFloat v) { _mm_storeu_ps(p, v); }
+        template<> inline SimdFloat splat<SimdFloat>(float f) { return _mm_set1_ps(f); }
+        inline SimdFloat add(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+        inline SimdFloat sub(SimdFloat a, SimdFloat b) { return _mm_sub_ps(a, b); }
+        inline SimdFloat mul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+        inline SimdFloat div(SimdFloat a, SimdFloat b) { return _mm_div_ps(a, b); }
+        inline SimdFloat negateIfNegative(SimdFloat a, SimdFloat sign) { return _mm_xor_ps(a, _mm_and_ps(sign, _mm_set1_ps(-0.0f))); }
+        inline SimdFloat squareRoot(SimdFloat a) { return _mm_sqrt_ps(a); }
+#else
+        const uint32_t kSimdWidth = 1;
+#endif
+        static_assert(kBatchSize % kSimdWidth == 0, "The batch size must be a multiple of the SIMD width");
 
-    Animation::~Animation() = default;
+        /** The keys of a batch of tracks, in SoA layout. Lane i is the i-th track of the batch.
+        */
+        struct TrackBatch
+        {
+            float translation0[3][kBatchSize];
+            float translation1[3][kBatchSize];
+            float translationRatio[kBatchSize];
+            float rotation0[4][kBatchSize];
+            float rotation1[4][kBatchSize];
+            float rotationRatio[kBatchSize];
+            float scaling0[3][kBatchSize];
+            float scaling1[3][kBatchSize];
+            float scalingRatio[kBatchSize];
+            float output[16][kBatchSize];   // Matrices, or translation, rotation and scaling
+        };
+
+        /** Find the last key at or before ticks
+        */
+        uint32_t findKey(const float* pTimes, uint32_t count, float ticks, uint32_t& cursor)
+        {
+            uint32_t key = cursor;
+            if (key < count && pTimes[key] <= ticks)
+            {
+                // Playing forward, the key is usually the same as in the last frame, or the next one
+                if (key + 1 == count || ticks < pTimes[key + 1]) return key;
+                if (key + 2 == count || ticks < pTimes[key + 2])
+                {
+                    cursor = key + 1;
+                    return cursor;
+                }
+            }
+
+            // The time jumped or looped around
+            key = (uint32_t)(std::upper_bound(pTimes, pTimes + count, ticks) - pTimes);
+            cursor = (key > 0) ? key - 1 : 0;
+            return cursor;
+        }
+
+        /** Find the two keys to interpolate between. After the last key, the channel interpolates towards the first key of the next loop.
+            \return The interpolation ratio
+        */
+        float findKeyPair(const float* pTimes, const Animation::KeyRange& range, float ticks, float duration, uint32_t& cursor, uint32_t& key0, uint32_t& key1)
+        {
+            const float* pRangeTimes = pTimes + range.first;
+            const uint32_t key = findKey(pRangeTimes, range.count, ticks, cursor);
+            const uint32_t next = (key + 1 == range.count) ? 0 : key + 1;
+            key0 = range.first + key;
+            key1 = range.first + next;
+
+            float diff = pRangeTimes[next] - pRangeTimes[key];
+            if (diff < 0)
+            {
+                diff += duration;
+            }
+            return (diff > 0) ? glm::clamp((ticks - pRangeTimes[key]) / diff, 0.0f, 1.0f) : 0.0f;
+        }
+
+        template<uint32_t N>
+        void setLane(float (&dst)[N][kBatchSize], uint32_t lane, const float* pValue)
+        {
+            for (uint32_t c = 0; c < N; c++) dst[c][lane] = pValue[c];
+        }
+
+        /** Gather the keys of a vec3 channel into a batch lane. Channels without keys use the default value.
+        */
+        void gatherVec3(const std::vector<float>& times, const std::vector<glm::vec3>& values, const Animation::KeyRange& range, float ticks, float duration, uint32_t& cursor, float defaultValue,
+            float (&dst0)[3][kBatchSize], float (&dst1)[3][kBatchSize], float* pRatio, uint32_t lane)
+        {
+            if (range.count == 0)
+            {
+                const glm::vec3 value(defaultValue);
+                setLane(dst0, lane, &value.x);
+                setLane(dst1, lane, &value.x);
+                pRatio[lane] = 0;
+                return;
+            }
+
+            uint32_t key0, key1;
+            pRatio[lane] = findKeyPair(times.data(), range, ticks, duration, cursor, key0, key1);
+            setLane(dst0, lane, &values[key0].x);
+            setLane(dst1, lane, &values[key1].x);
+        }
+
+        /** Gather the keys of a batch of tracks
+        */
+        void gatherBatch(const Animation& animation, uint32_t first, uint32_t count, float ticks, Animation::Cursor* pCursors, TrackBatch& batch)
+        {
+            const Animation::Keyframes& k = animation.getKeyframes();
+            const float duration = animation.getDuration();
+            for (uint32_t lane = 0; lane < count; lane++)
+            {
+                const Animation::Track& track = k.tracks[first + lane];
+                Animation::Cursor& cursor = pCursors[first + lane];
+                gatherVec3(k.translationTimes, k.translationValues, track.translation, ticks, duration, cursor.translation, 0.0f, batch.translation0, batch.translation1, batch.translationRatio, lane);
+                gatherVec3(k.scalingTimes, k.scalingValues, track.scaling, ticks, duration, cursor.scaling, 1.0f, batch.scaling0, batch.scaling1, batch.scalingRatio, lane);
+
+                if (track.rotation.count == 0)
+                {
+                    const glm::quat identity(1, 0, 0, 0);
+                    setLane(batch.rotation0, lane, &identity.x);
+                    setLane(batch.rotation1, lane, &identity.x);
+                    batch.rotationRatio[lane] = 0;
+                }
+                else
+                {
+                    uint32_t key0, key1;
+                    batch.rotationRatio[lane] = findKeyPair(k.rotationTimes.data(), track.rotation, ticks, duration, cursor.rotation, key0, key1);
+                    const glm::quat rotation0 = animation.getRotation(key0);
+                    const glm::quat rotation1 = animation.getRotation(key1);
+                    setLane(batch.rotation0, lane, &rotation0.x);
+                    setLane(batch.rotation1, lane, &rotation1.x);
+                }
+            }
+        }
+
+        /** Interpolate the lanes [i, i + width) of a batch. The rotation is not normalized.
+        */
+        template<typename V>
+        void interpolateLanes(const TrackBatch& b, uint32_t i, V (&t)[3], V (&q)[4], V (&s)[3])
+        {
+            V tRatio = load<V>(&b.translationRatio[i]);
+            V sRatio = load<V>(&b.scalingRatio[i]);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                V t0 = load<V>(&b.translation0[c][i]);
+                t[c] = add(t0, mul(sub(load<V>(&b.translation1[c][i]), t0), tRatio));
+                V s0 = load<V>(&b.scaling0[c][i]);
+                s[c] = add(s0, mul(sub(load<V>(&b.scaling1[c][i]), s0), sRatio));
+            }
+
+            // Normalized lerp along the shorter arc. The keys are close enough for the difference to slerp not to matter.
+            V q0[4], q1[4];
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                q0[c] = load<V>(&b.rotation0[c][i]);
+                q1[c] = load<V>(&b.rotation1[c][i]);
+            }
+            V cosAngle = add(add(mul(q0[0], q1[0]), mul(q0[1], q1[1])), add(mul(q0[2], q1[2]), mul(q0[3], q1[3])));
+            V rRatio = load<V>(&b.rotationRatio[i]);
+            V rRatio1 = negateIfNegative(rRatio, cosAngle);
+            V rRatio0 = sub(splat<V>(1.0f), rRatio);
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                q[c] = add(mul(q0[c], rRatio0), mul(q1[c], rRatio1));
+            }
+        }
+
+        /** Interpolate the lanes [i, i + width) of a batch and convert them into translation * rotation * scaling matrices
+        */
+        template<typename V>
+        void evaluateLanes(TrackBatch& b, uint32_t i)
+        {
+            V one = splat<V>(1.0f);
+            V t[3], q[4], s[3];
+            interpolateLanes(b, i, t, q, s);
+
+            // Rotation matrix of the unnormalized quaternion, the normalization folds into the 2/|q|^2 factor
+            V scale = div(splat<V>(2.0f), add(add(mul(q[0], q[0]), mul(q[1], q[1])), add(mul(q[2], q[2]), mul(q[3], q[3]))));
+            V x = q[0], y = q[1], z = q[2], w = q[3];
+            V xx = mul(mul(x, x), scale), yy = mul(mul(y, y), scale), zz = mul(mul(z, z), scale);
+            V xy = mul(mul(x, y), scale), xz = mul(mul(x, z), scale), yz = mul(mul(y, z), scale);
+            V wx = mul(mul(w, x), scale), wy = mul(mul(w, y), scale), wz = mul(mul(w, z), scale);
+
+            // Column-major, like glm
+            store(&b.output[0][i], mul(sub(one, add(yy, zz)), s[0]));
+            store(&b.output[1][i], mul(add(xy, wz), s[0]));
+            store(&b.output[2][i], mul(sub(xz, wy), s[0]));
+            store(&b.output[4][i], mul(sub(xy, wz), s[1]));
+            store(&b.output[5][i], mul(sub(one, add(xx, zz)), s[1]));
+            store(&b.output[6][i], mul(add(yz, wx), s[1]));
+            store(&b.output[8][i], mul(add(xz, wy), s[2]));
+            store(&b.output[9][i], mul(sub(yz, wx), s[2]));
+            store(&b.output[10][i], mul(sub(one, add(xx, yy)), s[2]));
+            store(&b.output[12][i], t[0]);
+            store(&b.output[13][i], t[1]);
+            store(&b.output[14][i], t[2]);
+        }
+
+        /** Interpolate the lanes [i, i + width) of a batch into translation, normalized rotation (x, y, z, w) and scaling
+        */
+        template<typename V>
+        void evaluateLanesTrs(TrackBatch& b, uint32_t i)
+        {
+            V t[3], q[4], s[3];
+            interpolateLanes(b, i, t, q, s);
+            V invLength = div(splat<V>(1.0f), squareRoot(add(add(mul(q[0], q[0]), mul(q[1], q[1])), add(mul(q[2], q[2]), mul(q[3], q[3])))));
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                store(&b.output[c][i], t[c]);
+                store(&b.output[7 + c][i], s[c]);
+            }
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                store(&b.output[3 + c][i], mul(q[c], invLength));
+            }
+        }
 
-    template<typename T>
-    uint32_t findCurrentFrame(T channel, float ticks)
+        // Used to quantize the smallest three components of a rotation, which are in [-1/sqrt(2), 1/sqrt(2)]
+        const float kSqrt2 = 1.41421356f;
+        const float kPackedQuatScale = 32767.0f;
+    }
+
+    Animation::UniquePtr Animation::create(const std::string& name, const std::vector<AnimationSet>& animationSets, float duration, float ticksPerSecond)
     {
-        uint32_t curKeyID = channel.lastKeyUsed;
-        while(curKeyID < channel.keys.size() - 1)
+        Keyframes keyframes;
+        for (const auto& set : animationSets)
         {
-            if(channel.keys[curKeyID + 1].time > ticks)
+            if (set.translation.keys.empty() && set.rotation.keys.empty() && set.scaling.keys.empty()) continue;
+
+            Track track;
+            track.boneID = set.boneID;
+            track.translation = { (uint32_t)keyframes.translationTimes.size(), (uint32_t)set.translation.keys.size() };
+            for (const auto& key : set.translation.keys)
             {
-                break;
+                keyframes.translationTimes.push_back(key.time);
+                keyframes.translationValues.push_back(key.value);
             }
-            curKeyID++;
+            track.rotation = { (uint32_t)keyframes.rotationTimes.size(), (uint32_t)set.rotation.keys.size() };
+            for (const auto& key : set.rotation.keys)
+            {
+                keyframes.rotationTimes.push_back(key.time);
+                keyframes.rotationValues.push_back(key.value);
+            }
+            track.scaling = { (uint32_t)keyframes.scalingTimes.size(), (uint32_t)set.scaling.keys.size() };
+            for (const auto& key : set.scaling.keys)
+            {
+                keyframes.scalingTimes.push_back(key.time);
+                keyframes.scalingValues.push_back(key.value);
+            }
+            keyframes.tracks.push_back(track);
         }
-        return curKeyID;
+        return create(name, std::move(keyframes), duration, ticksPerSecond);
     }
 
-    glm::vec3 interpolate(const glm::vec3& start, const glm::vec3& end, float ratio)
+    Animation::UniquePtr Animation::create(const std::string& name, Keyframes keyframes, float duration, float ticksPerSecond)
     {
-        return start + ((end - start) * ratio);
+        return UniquePtr(new Animation(name, std::move(keyframes), duration, ticksPerSecond));
     }
 
-    glm::quat interpolate(const glm::quat& start, const glm::quat& end, float ratio)
+    Animation::Animation(const std::string& name, Keyframes keyframes, float duration, float ticksPerSecond) : mName(name), mDuration(duration), mTicksPerSecond(ticksPerSecond), mKeyframes(std::move(keyframes))
     {
-        return glm::slerp(start, end, ratio);
     }
 
-    template<typename KeyType>
-    KeyType Animation::calcCurrentKey(AnimationChannel<KeyType>& channel, float ticks, float lastUpdateTime)
+    Animation::~Animation() = default;
+
+    void Animation::evaluate(float ticks, Cursor* pCursors, glm::mat4* pLocalTransforms) const
     {
-        KeyType curValue;
-        if(channel.keys.size() > 0)
+        TrackBatch batch;
+        for (uint32_t first = 0; first < mKeyframes.tracks.size(); first += kBatchSize)
         {
-            if(ticks < lastUpdateTime)
+            const uint32_t count = std::min(kBatchSize, (uint32_t)mKeyframes.tracks.size() - first);
+            gatherBatch(*this, first, count, ticks, pCursors, batch);
+
+            uint32_t lane = 0;
+#ifdef FALCOR_ANIMATION_SIMD
+            for (; lane + kSimdWidth <= count; lane += kSimdWidth)
+            {
+                evaluateLanes<SimdFloat>(batch, lane);
+            }
+#endif
+            for (; lane < count; lane++)
             {
-                channel.lastKeyUsed = 0;
+                evaluateLanes<float>(batch, lane);
             }
 
-            // search for the next keyframe
-            uint32_t curKeyIndex = findCurrentFrame(channel, ticks);
-            uint32_t nextKeyIndex = (curKeyIndex + 1) % channel.keys.size();
-            const AnimationKey<KeyType>& curKey = channel.keys[curKeyIndex];
-            const AnimationKey<KeyType>& nextKey = channel.keys[nextKeyIndex];
+            for (lane = 0; lane < count; lane++)
+            {
+                glm::mat4& m = pLocalTransforms[first + lane];
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    m[c] = glm::vec4(batch.output[c * 4][lane], batch.output[c * 4 + 1][lane], batch.output[c * 4 + 2][lane], (c == 3) ? 1.0f : 0.0f);
+                }
+            }
+        }
+    }
+
+    void Animation::evaluate(float ticks, Cursor* pCursors, LocalTransform* pBoneTransforms) const
+    {
+        TrackBatch batch;
+        for (uint32_t first = 0; first < mKeyframes.tracks.size(); first += kBatchSize)
+        {
+            const uint32_t count = std::min(kBatchSize, (uint32_t)mKeyframes.tracks.size() - first);
+            gatherBatch(*this, first, count, ticks, pCursors, batch);
 
-            assert(ticks >= curKey.time);
-            // Interpolate between them
-            float diff = nextKey.time - curKey.time;
-            if(diff < 0)
+            uint32_t lane = 0;
+#ifdef FALCOR_ANIMATION_SIMD
+            for (; lane + kSimdWidth <= count; lane += kSimdWidth)
             {
-                diff += mDuration;
+                evaluateLanesTrs<SimdFloat>(batch, lane);
             }
-            else if(diff == 0)
+#endif
+            for (; lane < count; lane++)
             {
-                curValue = curKey.value;
+                evaluateLanesTrs<float>(batch, lane);
             }
-            else
+
+            for (lane = 0; lane < count; lane++)
             {
-                float ratio = (ticks - curKey.time) / diff;
-                curValue = interpolate(curKey.value, nextKey.value, ratio);
+                LocalTransform& transform = pBoneTransforms[mKeyframes.tracks[first + lane].boneID];
+                transform.translation = glm::vec3(batch.output[0][lane], batch.output[1][lane], batch.output[2][lane]);
+                transform.rotation = glm::quat(batch.output[6][lane], batch.output[3][lane], batch.output[4][lane], batch.output[5][lane]);
+                transform.scaling = glm::vec3(batch.output[7][lane], batch.output[8][lane], batch.output[9][lane]);
             }
-            channel.lastKeyUsed = curKeyIndex;
         }
-        return curValue;
     }
 
-    void Animation::animate(double totalTime, AnimationController* pAnimationController)
+    glm::mat4 Animation::LocalTransform::getMatrix() const
     {
-        // Calculate the relative time
-        float ticks = (float)fmod(totalTime * mTicksPerSecond, mDuration);
+        glm::mat4 matrix = glm::mat4_cast(rotation);
+        matrix[0] *= scaling.x;
+        matrix[1] *= scaling.y;
+        matrix[2] *= scaling.z;
+        matrix[3] = glm::vec4(translation, 1);
+        return matrix;
+    }
 
-        for(auto& Key : mAnimationSets)
+    Animation::LocalTransform Animation::LocalTransform::fromMatrix(const glm::mat4& matrix)
+    {
+        LocalTransform transform;
+        glm::vec3 axes[3] = { glm::vec3(matrix[0]), glm::vec3(matrix[1]), glm::vec3(matrix[2]) };
+        transform.translation = glm::vec3(matrix[3]);
+        transform.scaling = glm::vec3(glm::length(axes[0]), glm::length(axes[1]), glm::length(axes[2]));
+
+        // Mirroring goes into the scaling, so that the rest is a rotation
+        if (glm::dot(glm::cross(axes[0], axes[1]), axes[2]) < 0) transform.scaling.x = -transform.scaling.x;
+        for (uint32_t c = 0; c < 3; c++)
         {
-            glm::mat4 translation;
-            translation[3] = glm::vec4(calcCurrentKey(Key.translation, ticks, Key.lastUpdateTime), 1);
+            if (transform.scaling[c] != 0) axes[c] /= transform.scaling[c];
+        }
+        transform.rotation = glm::normalize(glm::quat_cast(glm::mat3(axes[0], axes[1], axes[2])));
+        return transform;
+    }
 
-            glm::mat4 scaling;
-            if (Key.scaling.keys.size() > 0)
-            {
-                glm::scale(calcCurrentKey(Key.scaling, ticks, Key.lastUpdateTime));
-            }
+    Animation::LocalTransform Animation::LocalTransform::blend(const LocalTransform& a, const LocalTransform& b, float weight)
+    {
+        LocalTransform result;
+        result.translation = glm::mix(a.translation, b.translation, weight);
+        result.scaling = glm::mix(a.scaling, b.scaling, weight);
+        const float weightB = (glm::dot(a.rotation, b.rotation) < 0) ? -weight : weight;
+        result.rotation = glm::normalize(a.rotation * (1 - weight) + b.rotation * weightB);
+        return result;
+    }
 
-            glm::quat q = calcCurrentKey(Key.rotation, ticks, Key.lastUpdateTime);
-            glm::mat4 rotation = glm::mat4_cast(q);
+    size_t Animation::getKeyframesSize() const
+    {
+        const Keyframes& k = mKeyframes;
+        return k.tracks.size() * sizeof(Track) +
+            (k.translationTimes.size() + k.rotationTimes.size() + k.scalingTimes.size()) * sizeof(float) +
+            (k.translationValues.size() + k.scalingValues.size()) * sizeof(glm::vec3) +
+            k.rotationValues.size() * sizeof(glm::quat) + k.packedRotationValues.size() * sizeof(PackedQuat);
+    }
 
-            Key.lastUpdateTime = ticks;
+    Animation::PackedQuat Animation::packRotation(const glm::quat& rotation)
+    {
+        const float q[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+        uint32_t largest = 0;
+        for (uint32_t c = 1; c < 4; c++)
+        {
+            if (std::abs(q[c]) > std::abs(q[largest])) largest = c;
+        }
+
+        // q and -q are the same rotation. Flip the quaternion so that the dropped component is positive.
+        const float sign = (q[largest] < 0) ? -1.0f : 1.0f;
+        PackedQuat packed;
+        uint32_t word = 0;
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            if (c == largest) continue;
+            const float value = glm::clamp(q[c] * sign * kSqrt2, -1.0f, 1.0f);
+            packed.data[word++] = (uint16_t)(std::lround((value * 0.5f + 0.5f) * kPackedQuatScale) << 1);
+        }
+        packed.data[0] |= (uint16_t)(largest & 1);
+        packed.data[1] |= (uint16_t)(largest >> 1);
+        return packed;
+    }
 
-            glm::mat4 T = translation * rotation * scaling;
-            pAnimationController->setBoneLocalTransform(Key.boneID, T);
+    glm::quat Animation::unpackRotation(const PackedQuat& packed)
+    {
+        const uint32_t largest = (packed.data[0] & 1) | ((packed.data[1] & 1) << 1);
+        float q[4];
+        float lengthSquared = 0;
+        uint32_t word = 0;
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            if (c == largest) continue;
+            q[c] = ((float)(packed.data[word++] >> 1) * (2.0f / kPackedQuatScale) - 1.0f) / kSqrt2;
+            lengthSquared += q[c] * q[c];
         }
+        q[largest] = std::sqrt(std::max(0.0f, 1.0f - lengthSquared));
+        return glm::quat(q[3], q[0], q[1], q[2]);
+    }
+
+    float Animation::getTicks(double totalTime) const
+    {
+        if (mDuration <= 0) return 0;
+        double ticks = fmod(totalTime * mTicksPerSecond, (double)mDuration);
+        if (ticks < 0) ticks += mDuration;
+        // Rounding can produce exactly the duration
+        return std::min((float)ticks, std::nextafter(mDuration, 0.0f));
     }
 }
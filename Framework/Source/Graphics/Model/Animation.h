@@ -26,14 +26,15 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #pragma once
+#include <memory>
+#include <string>
 #include <vector>
 #include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
 #include "glm/gtc/quaternion.hpp"
 
 namespace Falcor
 {
-    class AnimationController;
-
     class Animation
     {
     public:
@@ -51,33 +52,146 @@ namespace Falcor
         struct AnimationChannel
         {
             std::vector<AnimationKey<T>> keys;
-            uint32_t lastKeyUsed = 0;
         };
 
+        /** The keys of one bone, as importers produce them. Converted into Keyframes by create().
+        */
         struct AnimationSet
         {
             uint32_t boneID;
             AnimationChannel<glm::vec3> translation;
             AnimationChannel<glm::vec3> scaling;
             AnimationChannel<glm::quat> rotation;
-            float lastUpdateTime = 0;
         };
 
+        /** A range of keys in one of the Keyframes arrays
+        */
+        struct KeyRange
+        {
+            uint32_t first = 0;
+            uint32_t count = 0;
+        };
+
+        /** A rotation quantized to 48 bits with the smallest-three encoding. The largest component is dropped and recovered from the unit length, the others are stored as 15-bit fixed point in [-1/sqrt(2), 1/sqrt(2)].
+            The low bits of the first two words hold the index of the dropped component. The error is below 0.01 degrees.
+        */
+        struct PackedQuat
+        {
+            uint16_t data[3];
+        };
+
+        /** A local transform in the form which is blended
+        */
+        struct LocalTransform
+        {
+            glm::vec3 translation = glm::vec3(0);
+            glm::quat rotation = glm::quat(1, 0, 0, 0);
+            glm::vec3 scaling = glm::vec3(1);
+
+            /** Get the translation * rotation * scaling matrix
+            */
+            glm::mat4 getMatrix() const;
+
+            /** Decompose a matrix without shear
+            */
+            static LocalTransform fromMatrix(const glm::mat4& matrix);
+
+            /** Interpolate between two transforms. The rotation uses a normalized lerp along the shorter arc.
+                \param[in] weight Weight of b
+            */
+            static LocalTransform blend(const LocalTransform& a, const LocalTransform& b, float weight);
+        };
+
+        /** The channels of one bone
+        */
+        struct Track
+        {
+            uint32_t boneID = 0;
+            KeyRange translation;
+            KeyRange rotation;
+            KeyRange scaling;
+        };
+
+        /** Keyframe storage of an animation. The keys of all tracks are packed into one contiguous structure-of-arrays per channel type, sorted by time within each track.
+            Key lookups only touch the times array, and evaluating a batch of tracks reads a few cache lines per channel type.
+        */
+        struct Keyframes
+        {
+            std::vector<Track> tracks;
+            std::vector<float> translationTimes;
+            std::vector<glm::vec3> translationValues;
+            std::vector<float> rotationTimes;
+            std::vector<glm::quat> rotationValues;
+            std::vector<PackedQuat> packedRotationValues;   ///< Replaces rotationValues in animations with quantized rotations
+            std::vector<float> scalingTimes;
+            std::vector<glm::vec3> scalingValues;
+        };
+
+        /** The key each channel of a track used last. Playback advances by less than a key per frame most of the time, so starting the search from the cursor makes the lookup O(1). Seeks and loops fall back to a binary search.
+        */
+        struct Cursor
+        {
+            uint32_t translation = 0;
+            uint32_t rotation = 0;
+            uint32_t scaling = 0;
+        };
+
+        /** Create an animation from per-bone key vectors. Tracks without any keys are dropped.
+        */
         static UniquePtr create(const std::string& name, const std::vector<AnimationSet>& animationSets, float duration, float ticksPerSecond);
+
+        /** Create an animation from keyframes which are already in the packed layout
+        */
+        static UniquePtr create(const std::string& name, Keyframes keyframes, float duration, float ticksPerSecond);
+
         ~Animation();
-        void animate(double totalTime, AnimationController* pAnimationController);
+
+        /** Convert a time in seconds to the animation time, wrapped into the animation's duration
+            \param[in] totalTime Time in seconds
+            \return Time in ticks, in [0, duration)
+        */
+        float getTicks(double totalTime) const;
+
+        /** Evaluate the local transforms of all tracks
+            \param[in] ticks Time in ticks, in [0, duration)
+            \param[in,out] pCursors The cursor of every track. Zero-initialize before the first call.
+            \param[out] pLocalTransforms Receives the local transform of every track, in track order
+        */
+        void evaluate(float ticks, Cursor* pCursors, glm::mat4* pLocalTransforms) const;
+
+        /** Evaluate the local transforms of all tracks, in the form used for blending
+            \param[in] ticks Time in ticks, in [0, duration)
+            \param[in,out] pCursors The cursor of every track. Zero-initialize before the first call.
+            \param[in,out] pBoneTransforms Indexed by bone ID. Receives the local transform of every animated bone, the other bones are left unchanged.
+        */
+        void evaluate(float ticks, Cursor* pCursors, LocalTransform* pBoneTransforms) const;
+
         const std::string& getName() const { return mName; }
+        float getDuration() const { return mDuration; }
+        float getTicksPerSecond() const { return mTicksPerSecond; }
+        const Keyframes& getKeyframes() const { return mKeyframes; }
+        uint32_t getTrackCount() const { return (uint32_t)mKeyframes.tracks.size(); }
+        bool hasPackedRotations() const { return mKeyframes.packedRotationValues.size() > 0; }
+
+        /** Get the size of the keyframes in bytes
+        */
+        size_t getKeyframesSize() const;
+
+        /** Get the rotation of a key, unpacking it if needed
+            \param[in] key Index into the rotation arrays of the keyframes
+        */
+        glm::quat getRotation(uint32_t key) const { return hasPackedRotations() ? unpackRotation(mKeyframes.packedRotationValues[key]) : mKeyframes.rotationValues[key]; }
+
+        static PackedQuat packRotation(const glm::quat& rotation);
+        static glm::quat unpackRotation(const PackedQuat& packed);
 
     private:
-        Animation(const std::string& name, const std::vector<AnimationSet>& animationSets, float duration, float ticksPerSecond);
-        
+        Animation(const std::string& name, Keyframes keyframes, float duration, float ticksPerSecond);
+
         const std::string mName;
         float mDuration;
         float mTicksPerSecond;
 
-        std::vector<AnimationSet> mAnimationSets;
-
-        template<typename _KeyType>
-        _KeyType calcCurrentKey(AnimationChannel<_KeyType>& channel, float ticks, float lastUpdateTime);
+        Keyframes mKeyframes;
     };
-}
\ No newline at end of file
+}
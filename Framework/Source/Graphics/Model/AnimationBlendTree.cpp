@@ -0,0 +1,203 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "AnimationBlendTree.h"
+#include "AnimationController.h"
+
+namespace Falcor
+{
+    AnimationBlendTree::SharedPtr AnimationBlendTree::create()
+    {
+        return SharedPtr(new AnimationBlendTree());
+    }
+
+    uint32_t AnimationBlendTree::addNode(const Node& node)
+    {
+        mNodes.push_back(node);
+        uint32_t nodeID = (uint32_t)mNodes.size() - 1;
+        if (mRoot == kInvalidNode) mRoot = nodeID;
+        return nodeID;
+    }
+
+    uint32_t AnimationBlendTree::addClip(uint32_t animationID, float speed, double timeOffset)
+    {
+        Node node;
+        node.type = Type::Clip;
+        node.animationID = animationID;
+        node.speed = speed;
+        node.timeOffset = timeOffset;
+        return addNode(node);
+    }
+
+    uint32_t AnimationBlendTree::addBlend(uint32_t input0, uint32_t input1, float weight, const BoneMask& mask)
+    {
+        assert(input0 < mNodes.size() && input1 < mNodes.size());
+        Node node;
+        node.type = Type::Blend;
+        node.inputs[0] = input0;
+        node.inputs[1] = input1;
+        node.weight = weight;
+        node.targetWeight = weight;
+        node.mask = mask;
+        return addNode(node);
+    }
+
+    uint32_t AnimationBlendTree::addAdditive(uint32_t base, uint32_t additive, float weight, const BoneMask& mask)
+    {
+        assert(base < mNodes.size() && additive < mNodes.size());
+        if (mNodes[additive].type != Type::Clip)
+        {
+            logWarning("AnimationBlendTree::addAdditive() - the additive input must be a clip node");
+            return kInvalidNode;
+        }
+
+        Node node;
+        node.type = Type::Additive;
+        node.inputs[0] = base;
+        node.inputs[1] = additive;
+        node.weight = weight;
+        node.targetWeight = weight;
+        node.mask = mask;
+        return addNode(node);
+    }
+
+    void AnimationBlendTree::setAnimation(uint32_t node, uint32_t animationID)
+    {
+        assert(node < mNodes.size() && mNodes[node].type == Type::Clip);
+        mNodes[node].animationID = animationID;
+        mNodes[node].cursors.clear();
+    }
+
+    void AnimationBlendTree::setWeight(uint32_t node, float weight)
+    {
+        assert(node < mNodes.size() && mNodes[node].type != Type::Clip);
+        mNodes[node].weight = weight;
+        mNodes[node].targetWeight = weight;
+        mNodes[node].weightSpeed = 0;
+    }
+
+    void AnimationBlendTree::fadeWeight(uint32_t node, float targetWeight, float duration)
+    {
+        assert(node < mNodes.size() && mNodes[node].type != Type::Clip);
+        if (duration <= 0)
+        {
+            setWeight(node, targetWeight);
+            return;
+        }
+        Node& n = mNodes[node];
+        n.targetWeight = targetWeight;
+        n.weightSpeed = std::abs(targetWeight - n.weight) / duration;
+    }
+
+    const std::vector<Animation::LocalTransform>& AnimationBlendTree::evaluate(const AnimationController& controller, double currentTime)
+    {
+        static const std::vector<Animation::LocalTransform> kEmpty;
+        if (mRoot == kInvalidNode) return kEmpty;
+
+        // Fades advance with the time between evaluations. Going back in time doesn't rewind them.
+        const float elapsedTime = mEvaluated ? (float)std::max(0.0, currentTime - mLastTime) : 0.0f;
+        mLastTime = currentTime;
+        mEvaluated = true;
+
+        evaluateNode(mRoot, controller, currentTime, elapsedTime);
+        return mNodes[mRoot].transforms;
+    }
+
+    void AnimationBlendTree::evaluateNode(uint32_t nodeID, const AnimationController& controller, double currentTime, float elapsedTime)
+    {
+        Node& node = mNodes[nodeID];
+        node.transforms = controller.getBindPose();
+
+        if (node.type == Type::Clip)
+        {
+            const Animation* pAnimation = (node.animationID == AnimationController::kBindPoseAnimationId) ? nullptr : controller.getAnimation(node.animationID);
+            if (pAnimation)
+            {
+                if (node.cursors.size() != pAnimation->getTrackCount()) node.cursors.assign(pAnimation->getTrackCount(), Animation::Cursor());
+                const double clipTime = currentTime * node.speed + node.timeOffset;
+                pAnimation->evaluate(pAnimation->getTicks(clipTime), node.cursors.data(), node.transforms.data());
+            }
+            return;
+        }
+
+        if (node.weightSpeed > 0)
+        {
+            const float step = node.weightSpeed * elapsedTime;
+            node.weight = (node.weight < node.targetWeight) ? std::min(node.weight + step, node.targetWeight) : std::max(node.weight - step, node.targetWeight);
+            if (node.weight == node.targetWeight) node.weightSpeed = 0;
+        }
+
+        evaluateNode(node.inputs[0], controller, currentTime, elapsedTime);
+        evaluateNode(node.inputs[1], controller, currentTime, elapsedTime);
+        const auto& input0 = mNodes[node.inputs[0]].transforms;
+        const auto& input1 = mNodes[node.inputs[1]].transforms;
+
+        if (node.type == Type::Additive)
+        {
+            // The reference is the first frame of the additive clip
+            const Node& clip = mNodes[node.inputs[1]];
+            if (node.reference.empty() || node.referenceAnimation != clip.animationID)
+            {
+                node.reference = controller.getBindPose();
+                const Animation* pAnimation = (clip.animationID == AnimationController::kBindPoseAnimationId) ? nullptr : controller.getAnimation(clip.animationID);
+                if (pAnimation)
+                {
+                    std::vector<Animation::Cursor> cursors(pAnimation->getTrackCount());
+                    pAnimation->evaluate(0, cursors.data(), node.reference.data());
+                }
+                node.referenceAnimation = clip.animationID;
+            }
+        }
+
+        for (size_t bone = 0; bone < node.transforms.size(); bone++)
+        {
+            const float weight = node.mask.empty() ? node.weight : node.weight * node.mask[bone];
+            Animation::LocalTransform& result = node.transforms[bone];
+            if (node.type == Type::Blend)
+            {
+                result = Animation::LocalTransform::blend(input0[bone], input1[bone], weight);
+            }
+            else
+            {
+                // Apply the difference to the reference in the bone's space
+                const Animation::LocalTransform& base = input0[bone];
+                const Animation::LocalTransform& additive = input1[bone];
+                const Animation::LocalTransform& reference = node.reference[bone];
+                Animation::LocalTransform delta;
+                delta.translation = additive.translation - reference.translation;
+                delta.rotation = glm::inverse(reference.rotation) * additive.rotation;
+                delta.scaling = additive.scaling / reference.scaling;
+                delta = Animation::LocalTransform::blend(Animation::LocalTransform(), delta, weight);
+
+                result.translation = base.translation + delta.translation;
+                result.rotation = glm::normalize(base.rotation * delta.rotation);
+                result.scaling = base.scaling * delta.scaling;
+            }
+        }
+    }
+}
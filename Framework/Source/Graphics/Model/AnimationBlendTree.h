@@ -0,0 +1,148 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <memory>
+#include <vector>
+#include "Animation.h"
+
+namespace Falcor
+{
+    class AnimationController;
+
+    /** Combines several animations into the pose of a model instance.
+        Clip nodes play an animation. Blend nodes interpolate between two inputs. Additive nodes add the motion of a clip, relative to the clip's first frame, on top of another input.
+        Blend and additive weights can be scaled per bone with a mask (see AnimationController#createBoneMask()), and can be faded over time to cross-fade between inputs.
+        A tree holds playback state, so every pose needs its own tree. See AnimationController::Pose::pBlendTree.
+    */
+    class AnimationBlendTree
+    {
+    public:
+        using SharedPtr = std::shared_ptr<AnimationBlendTree>;
+        static const uint32_t kInvalidNode = -1;
+
+        /** Per-bone weights, indexed by bone ID. An empty mask is 1 for all bones.
+        */
+        using BoneMask = std::vector<float>;
+
+        static SharedPtr create();
+
+        /** Add a node which plays an animation
+            \param[in] animationID The animation, or AnimationController::kBindPoseAnimationId
+            \param[in] speed Playback speed
+            \param[in] timeOffset Added to the clip time, in seconds
+            \return The ID of the new node
+        */
+        uint32_t addClip(uint32_t animationID, float speed = 1, double timeOffset = 0);
+
+        /** Add a node which interpolates between two inputs
+            \param[in] input0 Output when the weight is 0
+            \param[in] input1 Output when the weight is 1
+            \param[in] weight The weight of input1
+            \param[in] mask Per-bone multiplier of the weight
+            \return The ID of the new node
+        */
+        uint32_t addBlend(uint32_t input0, uint32_t input1, float weight, const BoneMask& mask = BoneMask());
+
+        /** Add a node which adds the motion of a clip on top of another input. The motion is the difference between the clip and its first frame.
+            \param[in] base The input to add to
+            \param[in] additive A clip node
+            \param[in] weight Scale of the added motion
+            \param[in] mask Per-bone multiplier of the weight
+            \return The ID of the new node, or kInvalidNode if additive is not a clip node
+        */
+        uint32_t addAdditive(uint32_t base, uint32_t additive, float weight, const BoneMask& mask = BoneMask());
+
+        /** Set the node whose output is the pose. Defaults to the first node which was added.
+        */
+        void setRoot(uint32_t node) { assert(node < mNodes.size()); mRoot = node; }
+        uint32_t getRoot() const { return mRoot; }
+
+        /** Change the animation of a clip node. The animation restarts at the clip's time offset.
+        */
+        void setAnimation(uint32_t node, uint32_t animationID);
+
+        /** Set the weight of a blend or additive node. Stops a fade in progress.
+        */
+        void setWeight(uint32_t node, float weight);
+        float getWeight(uint32_t node) const { return mNodes[node].weight; }
+
+        /** Move the weight of a blend or additive node linearly to a target, over a period of time. Fading the weight of a blend node to 0 or 1 cross-fades between its inputs.
+            \param[in] node The node
+            \param[in] targetWeight The final weight
+            \param[in] duration Length of the fade, in seconds
+        */
+        void fadeWeight(uint32_t node, float targetWeight, float duration);
+
+        /** Evaluate the tree
+            \param[in] controller The controller which owns the animations
+            \param[in] currentTime Time in seconds
+            \return The local transform of every bone, indexed by bone ID
+        */
+        const std::vector<Animation::LocalTransform>& evaluate(const AnimationController& controller, double currentTime);
+
+    private:
+        AnimationBlendTree() = default;
+
+        enum class Type
+        {
+            Clip,
+            Blend,
+            Additive
+        };
+
+        struct Node
+        {
+            Type type = Type::Clip;
+
+            // Clip
+            uint32_t animationID = kInvalidNode;
+            float speed = 1;
+            double timeOffset = 0;
+            std::vector<Animation::Cursor> cursors;
+
+            // Blend and additive
+            uint32_t inputs[2] = { kInvalidNode, kInvalidNode };
+            float weight = 1;
+            float targetWeight = 1;
+            float weightSpeed = 0;      // Per second, 0 when not fading
+            BoneMask mask;
+            uint32_t referenceAnimation = kInvalidNode;
+            std::vector<Animation::LocalTransform> reference;  // Additive: the first frame of the additive clip
+
+            std::vector<Animation::LocalTransform> transforms;
+        };
+
+        uint32_t addNode(const Node& node);
+        void evaluateNode(uint32_t nodeID, const AnimationController& controller, double currentTime, float elapsedTime);
+
+        std::vector<Node> mNodes;
+        uint32_t mRoot = kInvalidNode;
+        double mLastTime = 0;
+        bool mEvaluated = false;
+    };
+}
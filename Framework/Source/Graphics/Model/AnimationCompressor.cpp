@@ -0,0 +1,249 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "AnimationCompressor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace Falcor
+{
+    namespace
+    {
+        float translationError(const glm::vec3& value, const glm::vec3& original)
+        {
+            return glm::length(value - original);
+        }
+
+        float scalingError(const glm::vec3& value, const glm::vec3& original)
+        {
+            float error = 0;
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                error = std::max(error, std::abs(value[c] - original[c]) / std::max(std::abs(original[c]), 1e-6f));
+            }
+            return error;
+        }
+
+        float rotationError(const glm::quat& value, const glm::quat& original)
+        {
+            // Stable for small angles, unlike acos of the dot product
+            const glm::quat aligned = (glm::dot(value, original) < 0) ? -original : original;
+            return 2.0f * std::atan2(glm::length(value - aligned), glm::length(value + aligned));
+        }
+
+        // The interpolation the evaluator uses, see Animation.cpp
+        glm::vec3 interpolate(const glm::vec3& a, const glm::vec3& b, float ratio)
+        {
+            return a + (b - a) * ratio;
+        }
+
+        glm::quat interpolate(const glm::quat& a, const glm::quat& b, float ratio)
+        {
+            const float ratioB = (glm::dot(a, b) < 0) ? -ratio : ratio;
+            return glm::normalize(a * (1 - ratio) + b * ratioB);
+        }
+
+        // Longest run of keys a single segment can skip. Bounds the cost of measuring a segment.
+        const uint32_t kMaxSegmentLength = 256;
+
+        /** Select the keys of a channel which reproduce all of its keys within an error bound. The first and last keys are always kept, so that looping is unaffected.
+            \param[in] pTimes Key times
+            \param[in] pValues The values the compressed channel will store (the quantized values)
+            \param[in] pOriginal The original values
+            \param[in] count Number of keys
+            \param[in] maxError The error bound
+            \param[in] error Measures the error of a value against the original
+            \param[out] maxErrorOut The largest error of the selected keys at the original keys
+            \return Indices of the selected keys
+        */
+        template<typename T, typename ErrorFunc>
+        std::vector<uint32_t> selectKeys(const float* pTimes, const T* pValues, const T* pOriginal, uint32_t count, float maxError, ErrorFunc error, float& maxErrorOut)
+        {
+            maxErrorOut = 0;
+            std::vector<uint32_t> keys;
+            if (count == 0) return keys;
+
+            // A constant channel needs one key
+            float constantError = 0;
+            for (uint32_t i = 0; i < count; i++) constantError = std::max(constantError, error(pValues[0], pOriginal[i]));
+            if (constantError <= maxError)
+            {
+                maxErrorOut = constantError;
+                keys.push_back(0);
+                return keys;
+            }
+
+            // Measure the error of interpolating between two keys at the keys in between
+            auto segmentError = [&](uint32_t first, uint32_t last)
+            {
+                float segment = 0;
+                const float length = pTimes[last] - pTimes[first];
+                for (uint32_t i = first + 1; i < last; i++)
+                {
+                    const float ratio = (length > 0) ? (pTimes[i] - pTimes[first]) / length : 0.0f;
+                    segment = std::max(segment, error(interpolate(pValues[first], pValues[last], ratio), pOriginal[i]));
+                }
+                return segment;
+            };
+
+            // Extend each segment as far as it can reproduce the keys it skips. Measuring a segment costs its length, so the end is found by galloping and then bisecting instead of stepping one key at a time.
+            // The error isn't monotonic in the segment length, so this can stop short of the longest valid segment. Every selected segment is still within the bound.
+            uint32_t anchor = 0;
+            keys.push_back(0);
+            maxErrorOut = error(pValues[0], pOriginal[0]);
+            while (anchor + 1 < count)
+            {
+                const uint32_t last = std::min(count - 1, anchor + kMaxSegmentLength);
+                uint32_t next = anchor + 1;     // The longest segment known to be within the bound
+                uint32_t fail = last + 1;       // The shortest segment known to exceed it
+                for (uint32_t step = 1; next < last; step *= 2)
+                {
+                    const uint32_t candidate = std::min(last, next + step);
+                    if (segmentError(anchor, candidate) > maxError)
+                    {
+                        fail = candidate;
+                        break;
+                    }
+                    next = candidate;
+                }
+                while (next + 1 < fail)
+                {
+                    const uint32_t candidate = next + (fail - next) / 2;
+                    if (segmentError(anchor, candidate) <= maxError) next = candidate;
+                    else fail = candidate;
+                }
+                maxErrorOut = std::max(maxErrorOut, std::max(segmentError(anchor, next), error(pValues[next], pOriginal[next])));
+                keys.push_back(next);
+                anchor = next;
+            }
+            return keys;
+        }
+    }
+
+    Animation::UniquePtr AnimationCompressor::compress(const Animation& animation, const Settings& settings, Report* pReport)
+    {
+        const Animation::Keyframes& src = animation.getKeyframes();
+        Animation::Keyframes dst;
+        Report report;
+        report.originalSize = animation.getKeyframesSize();
+
+        std::vector<glm::quat> original, quantized;
+        for (const Animation::Track& track : src.tracks)
+        {
+            Animation::Track result;
+            result.boneID = track.boneID;
+            BoneError boneError;
+            boneError.boneID = track.boneID;
+
+            // Translation
+            const float* pTimes = src.translationTimes.data() + track.translation.first;
+            const glm::vec3* pValues = src.translationValues.data() + track.translation.first;
+            std::vector<uint32_t> keys = selectKeys(pTimes, pValues, pValues, track.translation.count, settings.maxTranslationError, translationError, boneError.translation);
+            result.translation = { (uint32_t)dst.translationTimes.size(), (uint32_t)keys.size() };
+            for (uint32_t key : keys)
+            {
+                dst.translationTimes.push_back(pTimes[key]);
+                dst.translationValues.push_back(pValues[key]);
+            }
+
+            // Scaling
+            pTimes = src.scalingTimes.data() + track.scaling.first;
+            pValues = src.scalingValues.data() + track.scaling.first;
+            keys = selectKeys(pTimes, pValues, pValues, track.scaling.count, settings.maxScalingError, scalingError, boneError.scaling);
+            result.scaling = { (uint32_t)dst.scalingTimes.size(), (uint32_t)keys.size() };
+            for (uint32_t key : keys)
+            {
+                dst.scalingTimes.push_back(pTimes[key]);
+                dst.scalingValues.push_back(pValues[key]);
+            }
+
+            // Rotation. The keys are selected with the quantized values, so the error includes the quantization.
+            pTimes = src.rotationTimes.data() + track.rotation.first;
+            original.resize(track.rotation.count);
+            quantized.resize(track.rotation.count);
+            std::vector<Animation::PackedQuat> packed(settings.quantizeRotations ? track.rotation.count : 0);
+            for (uint32_t i = 0; i < track.rotation.count; i++)
+            {
+                original[i] = animation.getRotation(track.rotation.first + i);
+                quantized[i] = original[i];
+                if (settings.quantizeRotations)
+                {
+                    packed[i] = Animation::packRotation(original[i]);
+                    quantized[i] = Animation::unpackRotation(packed[i]);
+                }
+            }
+            keys = selectKeys(pTimes, quantized.data(), original.data(), track.rotation.count, settings.maxRotationError, rotationError, boneError.rotation);
+            result.rotation = { (uint32_t)dst.rotationTimes.size(), (uint32_t)keys.size() };
+            for (uint32_t key : keys)
+            {
+                dst.rotationTimes.push_back(pTimes[key]);
+                if (settings.quantizeRotations)
+                {
+                    dst.packedRotationValues.push_back(packed[key]);
+                }
+                else
+                {
+                    dst.rotationValues.push_back(quantized[key]);
+                }
+            }
+
+            dst.tracks.push_back(result);
+            report.boneErrors.push_back(boneError);
+        }
+
+        report.originalKeyCount = (uint32_t)(src.translationTimes.size() + src.rotationTimes.size() + src.scalingTimes.size());
+        report.compressedKeyCount = (uint32_t)(dst.translationTimes.size() + dst.rotationTimes.size() + dst.scalingTimes.size());
+        Animation::UniquePtr pCompressed = Animation::create(animation.getName(), std::move(dst), animation.getDuration(), animation.getTicksPerSecond());
+        report.compressedSize = pCompressed->getKeyframesSize();
+
+        if (pReport) *pReport = std::move(report);
+        return pCompressed;
+    }
+
+    const std::string to_string(const AnimationCompressor::Report& report)
+    {
+        const AnimationCompressor::BoneError* pWorst[3] = {};
+        for (const auto& bone : report.boneErrors)
+        {
+            if (pWorst[0] == nullptr || bone.translation > pWorst[0]->translation) pWorst[0] = &bone;
+            if (pWorst[1] == nullptr || bone.rotation > pWorst[1]->rotation) pWorst[1] = &bone;
+            if (pWorst[2] == nullptr || bone.scaling > pWorst[2]->scaling) pWorst[2] = &bone;
+        }
+
+        const double saved = report.originalSize ? 100.0 * (1.0 - (double)report.compressedSize / (double)report.originalSize) : 0.0;
+        char str[320];
+        int length = std::snprintf(str, sizeof(str), "Keyframes %zu -> %zu bytes (%.1f%% saved), %u -> %u keys.", report.originalSize, report.compressedSize, saved, report.originalKeyCount, report.compressedKeyCount);
+        if (pWorst[0] && length > 0 && length < (int)sizeof(str))
+        {
+            std::snprintf(str + length, sizeof(str) - length, " Max error: translation %g (bone %u), rotation %.3g deg (bone %u), scaling %g (bone %u)",
+                pWorst[0]->translation, pWorst[0]->boneID, glm::degrees(pWorst[1]->rotation), pWorst[1]->boneID, pWorst[2]->scaling, pWorst[2]->boneID);
+        }
+        return str;
+    }
+}
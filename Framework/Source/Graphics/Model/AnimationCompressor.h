@@ -0,0 +1,81 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "Animation.h"
+
+namespace Falcor
+{
+    /** Reduces the memory used by animations. Used by Model::LoadFlags::CompressAnimations.
+        Keys which interpolating their neighbors reproduces within an error bound are removed, channels which don't change collapse to a single key, and rotations are quantized to 48 bits (see Animation::PackedQuat).
+        The error bounds apply to each bone's local transform. Errors accumulate down the hierarchy, so long chains need tighter bounds.
+    */
+    class AnimationCompressor
+    {
+    public:
+        struct Settings
+        {
+            float maxTranslationError = 1e-4f;  ///< Distance, in the units of the model
+            float maxRotationError = 1e-3f;     ///< Angle, in radians
+            float maxScalingError = 1e-4f;      ///< Relative to the scaling
+            bool quantizeRotations = true;      ///< Store the rotations as Animation::PackedQuat
+        };
+
+        /** The largest error introduced into the local transform of a bone, measured at the original keys
+        */
+        struct BoneError
+        {
+            uint32_t boneID = 0;
+            float translation = 0;
+            float rotation = 0;     ///< In radians
+            float scaling = 0;
+        };
+
+        struct Report
+        {
+            size_t originalSize = 0;        ///< Size of the keyframes, in bytes
+            size_t compressedSize = 0;
+            uint32_t originalKeyCount = 0;
+            uint32_t compressedKeyCount = 0;
+            std::vector<BoneError> boneErrors;  ///< One entry per track
+        };
+
+        /** Compress an animation
+            \param[in] animation The animation to compress. Can be compressed already.
+            \param[in] settings Error bounds
+            \param[out] pReport Optional. Receives the memory saved and the error of every bone.
+            \return A new animation
+        */
+        static Animation::UniquePtr compress(const Animation& animation, const Settings& settings, Report* pReport = nullptr);
+    };
+
+    /** Summarize a compression report: the memory saved and the bones with the largest errors
+    */
+    const std::string to_string(const AnimationCompressor::Report& report);
+}
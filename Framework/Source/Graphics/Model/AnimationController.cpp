@@ -30,6 +30,7 @@
 #include "Model.h"
 #include <fstream>
 #include "Animation.h"
+#include "Utils/TaskScheduler.h"
 #include <algorithm>
 
 namespace Falcor
@@ -74,8 +75,57 @@ namespace Falcor
     AnimationController::AnimationController(const std::vector<Bone>& Bones)
     {
         mBones = Bones;
-        mBoneTransforms.resize(mBones.size());
-        mBoneInvTransposeTransforms.resize(mBones.size());
+        const uint32_t boneCount = (uint32_t)mBones.size();
+        mParentIDs.resize(boneCount);
+        mOffsets.resize(boneCount);
+        mBindPose.resize(boneCount);
+        for (uint32_t i = 0; i < boneCount; i++)
+        {
+            const uint32_t parentID = mBones[i].parentID;
+            mParentIDs[i] = (parentID < boneCount) ? parentID : kInvalidBoneID;
+            mOffsets[i] = mBones[i].offset;
+            mBindPose[i] = Animation::LocalTransform::fromMatrix(mBones[i].originalLocalTransform);
+        }
+
+        // Sort the bones parents-first, so that evaluating a pose is a single pass over the bones
+        std::vector<uint32_t> childCount(boneCount + 1, 0);
+        for (uint32_t parentID : mParentIDs)
+        {
+            childCount[(parentID == kInvalidBoneID) ? boneCount : parentID]++;
+        }
+        std::vector<uint32_t> firstChild(boneCount + 2, 0);
+        for (uint32_t i = 0; i <= boneCount; i++)
+        {
+            firstChild[i + 1] = firstChild[i] + childCount[i];
+        }
+        std::vector<uint32_t> children(boneCount);
+        std::vector<uint32_t> next(firstChild.begin(), firstChild.end() - 1);
+        for (uint32_t i = 0; i < boneCount; i++)
+        {
+            const uint32_t parentID = mParentIDs[i];
+            children[next[(parentID == kInvalidBoneID) ? boneCount : parentID]++] = i;
+        }
+
+        mEvaluationOrder.reserve(boneCount);
+        mEvaluationOrder.insert(mEvaluationOrder.end(), children.begin() + firstChild[boneCount], children.begin() + firstChild[boneCount + 1]);
+        for (size_t i = 0; i < mEvaluationOrder.size(); i++)
+        {
+            const uint32_t boneID = mEvaluationOrder[i];
+            mEvaluationOrder.insert(mEvaluationOrder.end(), children.begin() + firstChild[boneID], children.begin() + firstChild[boneID + 1]);
+        }
+
+        if (mEvaluationOrder.size() != boneCount)
+        {
+            logWarning("AnimationController: the bone hierarchy contains a cycle. The bones which are part of it will not be animated correctly.");
+            std::vector<bool> sorted(boneCount, false);
+            for (uint32_t boneID : mEvaluationOrder) sorted[boneID] = true;
+            for (uint32_t i = 0; i < boneCount; i++)
+            {
+                if (sorted[i] == false) mEvaluationOrder.push_back(i);
+            }
+        }
+
+        mPose = createPose();
         setActiveAnimation(kBindPoseAnimationId);
     }
 
@@ -89,40 +139,187 @@ namespace Falcor
     void AnimationController::setBoneLocalTransform(uint32_t boneID, const glm::mat4& transform)
     {
         assert(boneID < mBones.size());
-        mBones[boneID].localTransform = transform;
+        mPose.localTransforms[boneID] = transform;
     }
 
     void AnimationController::animate(double currentTime)
     {
-        if(mActiveAnimation != kBindPoseAnimationId)
+        evaluatePose(mPose, currentTime);
+    }
+
+    void AnimationController::setActiveAnimation(uint32_t id, float fadeDuration)
+    {
+        assert(id == kBindPoseAnimationId || id < mAnimations.size());
+        mActiveAnimation = id;
+        mActiveAnimationFadeDuration = fadeDuration;
+        if (fadeDuration > 0)
+        {
+            // The fade starts at the next animate() call
+            return;
+        }
+
+        if(id == kBindPoseAnimationId)
         {
-            mAnimations[mActiveAnimation]->animate(currentTime, this);
+            // Discard transforms set with setBoneLocalTransform()
+            mPose.evaluatedAnimation = kActiveAnimationId;
         }
+        animate(0);
+    }
+
+    AnimationController::Pose AnimationController::createPose() const
+    {
+        Pose pose;
+        pose.pController = this;
+        resetToBindPose(pose);
+        return pose;
+    }
 
-        for(uint32_t i = 0; i < mBones.size(); i++)
+    void AnimationController::resetToBindPose(Pose& pose) const
+    {
+        pose.localTransforms.resize(mBones.size());
+        for (size_t i = 0; i < mBones.size(); i++)
         {
-            mBones[i].globalTransform = mBones[i].localTransform;
-            if(mBones[i].parentID != kInvalidBoneID)
+            pose.localTransforms[i] = mBones[i].originalLocalTransform;
+        }
+    }
+
+    // The bone matrices are affine and the shaders only use the upper 3x3 of the inverse transpose.
+    // Its columns are the cross products of the columns of the 3x3, which is much cheaper than a full 4x4 inverse.
+    static glm::mat4 inverseTranspose3x3(const glm::mat4& m)
+    {
+        const glm::vec3 c0(m[0]), c1(m[1]), c2(m[2]);
+        const glm::vec3 r0 = glm::cross(c1, c2);
+        const float det = glm::dot(c0, r0);
+        const float invDet = (det != 0) ? 1.0f / det : 0.0f;
+        glm::mat4 result;
+        result[0] = glm::vec4(r0 * invDet, 0);
+        result[1] = glm::vec4(glm::cross(c2, c0) * invDet, 0);
+        result[2] = glm::vec4(glm::cross(c0, c1) * invDet, 0);
+        result[3] = glm::vec4(0, 0, 0, 1);
+        return result;
+    }
+
+    AnimationBlendTree::BoneMask AnimationController::createBoneMask(uint32_t rootBoneID, float weight) const
+    {
+        assert(rootBoneID < mBones.size());
+        std::vector<bool> selected(mBones.size(), false);
+        selected[rootBoneID] = true;
+        AnimationBlendTree::BoneMask mask(mBones.size(), 0.0f);
+        for (uint32_t boneID : mEvaluationOrder)
+        {
+            const uint32_t parentID = mParentIDs[boneID];
+            if (parentID != kInvalidBoneID && selected[parentID]) selected[boneID] = true;
+            if (selected[boneID]) mask[boneID] = weight;
+        }
+        return mask;
+    }
+
+    void AnimationController::evaluatePose(Pose& pose, double currentTime) const
+    {
+        assert(pose.pController == this);
+        const double time = currentTime + pose.timeOffset;
+
+        if (pose.pBlendTree)
+        {
+            const auto& transforms = pose.pBlendTree->evaluate(*this, time);
+            for (size_t i = 0; i < transforms.size(); i++)
             {
-                mBones[i].globalTransform = mBones[mBones[i].parentID].globalTransform * mBones[i].localTransform;
+                pose.localTransforms[i] = transforms[i].getMatrix();
             }
-            mBoneTransforms[i] = mBones[i].globalTransform * mBones[i].offset;
-            mBoneInvTransposeTransforms[i] = transpose(inverse(mBoneTransforms[i]));
+            // Evaluating the animation again after the tree is removed restarts it
+            pose.evaluatedAnimation = kActiveAnimationId;
+        }
+        else
+        {
+            const uint32_t animationID = (pose.animationID == kActiveAnimationId) ? mActiveAnimation : pose.animationID;
+            assert(animationID == kBindPoseAnimationId || animationID < mAnimations.size());
+
+            if (animationID != pose.evaluatedAnimation)
+            {
+                // Start a cross-fade from the animation which was playing. Its cursors are still valid.
+                pose.fadeLength = (pose.animationID == kActiveAnimationId) ? mActiveAnimationFadeDuration : pose.fadeDuration;
+                pose.fading = (pose.fadeLength > 0) && (pose.evaluatedAnimation != kActiveAnimationId) && (pose.boneTransforms.empty() == false);
+                if (pose.fading)
+                {
+                    pose.fadeAnimation = pose.evaluatedAnimation;
+                    pose.fadeStartTime = time;
+                    std::swap(pose.fadeCursors, pose.cursors);
+                }
+
+                // Bones which the new animation doesn't animate stay in the bind pose
+                resetToBindPose(pose);
+                const Animation* pAnimation = (animationID == kBindPoseAnimationId) ? nullptr : mAnimations[animationID].get();
+                pose.cursors.assign(pAnimation ? pAnimation->getTrackCount() : 0, Animation::Cursor());
+                pose.trackTransforms.resize(pose.cursors.size());
+                pose.evaluatedAnimation = animationID;
+            }
+
+            const Animation* pAnimation = (animationID == kBindPoseAnimationId) ? nullptr : mAnimations[animationID].get();
+            const double fadeTime = time - pose.fadeStartTime;
+            const bool wasFading = pose.fading;
+            pose.fading = pose.fading && (fadeTime >= 0) && (fadeTime < pose.fadeLength);
+            if (wasFading && (pose.fading == false)) resetToBindPose(pose);
+
+            if (pose.fading)
+            {
+                // Blend in local space, the matrices can't be interpolated
+                const Animation* pFadeAnimation = (pose.fadeAnimation == kBindPoseAnimationId) ? nullptr : mAnimations[pose.fadeAnimation].get();
+                pose.fadeTransforms[0] = mBindPose;
+                pose.fadeTransforms[1] = mBindPose;
+                if (pFadeAnimation) pFadeAnimation->evaluate(pFadeAnimation->getTicks(time), pose.fadeCursors.data(), pose.fadeTransforms[0].data());
+                if (pAnimation) pAnimation->evaluate(pAnimation->getTicks(time), pose.cursors.data(), pose.fadeTransforms[1].data());
+
+                const float weight = (float)(fadeTime / pose.fadeLength);
+                for (size_t i = 0; i < mBones.size(); i++)
+                {
+                    pose.localTransforms[i] = Animation::LocalTransform::blend(pose.fadeTransforms[0][i], pose.fadeTransforms[1][i], weight).getMatrix();
+                }
+            }
+            else if (pAnimation)
+            {
+                pAnimation->evaluate(pAnimation->getTicks(time), pose.cursors.data(), pose.trackTransforms.data());
+                const auto& tracks = pAnimation->getKeyframes().tracks;
+                for (size_t i = 0; i < tracks.size(); i++)
+                {
+                    pose.localTransforms[tracks[i].boneID] = pose.trackTransforms[i];
+                }
+            }
+        }
+
+        const size_t boneCount = mBones.size();
+        pose.globalTransforms.resize(boneCount);
+        pose.boneTransforms.resize(boneCount);
+        pose.boneInvTransposeTransforms.resize(boneCount);
+        for (uint32_t boneID : mEvaluationOrder)
+        {
+            const uint32_t parentID = mParentIDs[boneID];
+            glm::mat4& global = pose.globalTransforms[boneID];
+            global = (parentID == kInvalidBoneID) ? pose.localTransforms[boneID] : pose.globalTransforms[parentID] * pose.localTransforms[boneID];
+            pose.boneTransforms[boneID] = global * mOffsets[boneID];
+            pose.boneInvTransposeTransforms[boneID] = inverseTranspose3x3(pose.boneTransforms[boneID]);
         }
     }
 
-    void AnimationController::setActiveAnimation(uint32_t id)
+    void AnimationController::evaluatePoses(Pose* const* ppPoses, size_t count, double currentTime)
     {
-        assert(id == kBindPoseAnimationId || id < mAnimations.size());
-        mActiveAnimation = id;
-        if(id == kBindPoseAnimationId)
+        // A pose takes a few microseconds, batch enough of them to amortize the scheduling
+        static const size_t kPosesPerTask = 16;
+        auto evaluateRange = [ppPoses, currentTime](size_t begin, size_t end)
         {
-            for(auto& bone : mBones)
+            for (size_t i = begin; i < end; i++)
             {
-                bone.localTransform = bone.originalLocalTransform;
+                ppPoses[i]->pController->evaluatePose(*ppPoses[i], currentTime);
             }
+        };
+
+        if (count <= kPosesPerTask)
+        {
+            evaluateRange(0, count);
+        }
+        else
+        {
+            TaskScheduler::get()->parallelFor(0, count, evaluateRange, kPosesPerTask);
         }
-        animate(0);
     }
 
     const std::string& AnimationController::getAnimationName(uint32_t ID) const
@@ -30,6 +30,7 @@
 #include <vector>
 #include "glm/mat4x4.hpp"
 #include "Animation.h"
+#include "AnimationBlendTree.h"
 
 namespace Falcor
 {
@@ -47,6 +48,9 @@ namespace Falcor
     class Model;
     class AssimpModelImporter;
 
+    /** Holds the data which is shared by all the instances of an animated model - the skeleton and the animations - and evaluates poses.
+        The state of an animated instance lives in a Pose. The controller owns one pose of its own which backs animate(), getBoneMatrices() and friends.
+    */
     class AnimationController
     {
     public:
@@ -54,6 +58,36 @@ namespace Falcor
         using UniqueConstPtr = std::unique_ptr<const AnimationController>;
         static const uint32_t kInvalidBoneID = -1;
         static const uint32_t kBindPoseAnimationId = -1;
+        static const uint32_t kActiveAnimationId = -2;
+
+        /** The animation state of one model instance. Create it with AnimationController#createPose().
+            A pose references the controller it was created from, the controller must outlive it.
+        */
+        struct Pose
+        {
+            uint32_t animationID = kActiveAnimationId;  ///< The animation to play. kActiveAnimationId follows the controller's active animation.
+            double timeOffset = 0;                      ///< Added to the evaluation time, so that instances playing the same animation don't move in lockstep
+            float fadeDuration = 0;                     ///< When the animation changes, cross-fade from the previous one over this many seconds. Poses which follow the controller use the duration passed to setActiveAnimation().
+            AnimationBlendTree::SharedPtr pBlendTree;   ///< Replaces animationID when set. Trees hold playback state, don't share them between poses.
+
+            const AnimationController* pController = nullptr;
+            uint32_t evaluatedAnimation = kBindPoseAnimationId;
+            std::vector<Animation::Cursor> cursors;
+            std::vector<glm::mat4> trackTransforms;
+
+            // Cross-fade state
+            bool fading = false;
+            uint32_t fadeAnimation = kBindPoseAnimationId;
+            double fadeStartTime = 0;
+            float fadeLength = 0;
+            std::vector<Animation::Cursor> fadeCursors;
+            std::vector<Animation::LocalTransform> fadeTransforms[2];
+
+            std::vector<glm::mat4> localTransforms;
+            std::vector<glm::mat4> globalTransforms;
+            std::vector<glm::mat4> boneTransforms;              ///< Empty until the pose was evaluated
+            std::vector<glm::mat4> boneInvTransposeTransforms;
+        };
 
         static UniquePtr create(const std::vector<Bone>& bones);
         static UniquePtr create(const AnimationController& other);
@@ -64,26 +98,63 @@ namespace Falcor
 
         uint32_t getAnimationCount() const { return uint32_t(mAnimations.size()); }
         const std::string& getAnimationName(uint32_t ID) const;
-        void setActiveAnimation(uint32_t id);
+        /** Set the animation played by the controller's pose and by all the poses which follow it
+            \param[in] id The animation, or kBindPoseAnimationId
+            \param[in] fadeDuration Length of the cross-fade from the current animation, in seconds. 0 switches immediately.
+        */
+        void setActiveAnimation(uint32_t id, float fadeDuration = 0);
         uint32_t getActiveAnimation() const {return mActiveAnimation;}
 
-        const std::vector<mat4>& getBoneMatrices() const { return mBoneTransforms; }
-        const std::vector<mat4>& getBoneInvTransposeMatrices() const { return mBoneInvTransposeTransforms; }
+        const std::vector<mat4>& getBoneMatrices() const { return mPose.boneTransforms; }
+        const std::vector<mat4>& getBoneInvTransposeMatrices() const { return mPose.boneInvTransposeTransforms; }
         uint32_t getBoneCount() const { return uint32_t(mBones.size()); }
+        const std::vector<Bone>& getBones() const { return mBones; }
+        const Animation* getAnimation(uint32_t ID) const { return mAnimations[ID].get(); }
 
         uint32_t getBoneIdFromName(const std::string& name) const;
         void setBoneLocalTransform(uint32_t boneID, const glm::mat4& transform);
 
+        /** Create a pose in the bind pose
+        */
+        Pose createPose() const;
+
+        /** Get the bind pose, indexed by bone ID
+        */
+        const std::vector<Animation::LocalTransform>& getBindPose() const { return mBindPose; }
+
+        /** Create a mask for AnimationBlendTree which selects a bone and its descendants
+            \param[in] rootBoneID The top-most bone to select
+            \param[in] weight The weight of the selected bones. The other bones get 0.
+        */
+        AnimationBlendTree::BoneMask createBoneMask(uint32_t rootBoneID, float weight = 1) const;
+
+        /** Evaluate a pose. Thread-safe as long as every thread evaluates a different pose.
+            \param[in,out] pose A pose created by this controller
+            \param[in] currentTime Time in seconds
+        */
+        void evaluatePose(Pose& pose, double currentTime) const;
+
+        /** Evaluate many poses in parallel on the task scheduler. The poses can belong to different controllers.
+            \param[in] ppPoses The poses to evaluate
+            \param[in] count Number of poses
+            \param[in] currentTime Time in seconds
+        */
+        static void evaluatePoses(Pose* const* ppPoses, size_t count, double currentTime);
+
     private:
         AnimationController(const std::vector<Bone>& bones);
+        void resetToBindPose(Pose& pose) const;
 
+        // The skeleton. Bone IDs are only guaranteed to be parents-first for importers which emit them that way, so the hierarchy is walked in mEvaluationOrder.
         std::vector<Bone> mBones;
-        std::vector<glm::mat4> mBoneTransforms;
-        std::vector<glm::mat4> mBoneInvTransposeTransforms;
-        std::vector<Animation::UniquePtr> mAnimations;
+        std::vector<uint32_t> mEvaluationOrder;
+        std::vector<uint32_t> mParentIDs;
+        std::vector<glm::mat4> mOffsets;
+        std::vector<Animation::LocalTransform> mBindPose;
 
+        std::vector<Animation::UniquePtr> mAnimations;
         uint32_t mActiveAnimation = kBindPoseAnimationId;
-
-        void calculateBoneTransforms();
+        float mActiveAnimationFadeDuration = 0;
+        Pose mPose;
     };
 }
\ No newline at end of file
@@ -34,18 +34,26 @@
 
 #include "Framework.h"
 #include "AssimpModelImporter.h"
+#include "TangentSpace.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "VertexQuantizer.h"
 #include "Graphics/Model/Model.h"
 #include "Graphics/Model/Animation.h"
 #include "Graphics/Model/Mesh.h"
 #include "Graphics/Model/AnimationController.h"
+#include "Graphics/Model/AnimationCompressor.h"
 #include "API/Texture.h"
 #include "API/Buffer.h"
 #include "Utils/Platform/OS.h"
 #include "Graphics/TextureHelper.h"
+#include "Graphics/TextureStreamer.h"
+#include "Graphics/TextureProcessor.h"
 #include "API/VertexLayout.h"
 #include "Data/VertexAttrib.h"
 #include "Utils/StringUtils.h"
 #include "API/Device.h"
+#include "Utils/TaskScheduler.h"
 
 namespace Falcor
 {
@@ -59,18 +67,10 @@ namespace Falcor
 
     using VertexIdsVec = std::vector<uvec8_4>;
 
-    template<typename posType>
-    void generateSubmeshTangentData(
-        const std::vector<uint32_t>& indices,
-        uint32_t vertexCount,
-        const posType* vertexPosData,
-        const glm::vec3* vertexNormalData,
-        const glm::vec2* texCrdData,
-        uint32_t texCrdCount,
-        glm::vec3* bitangentData);
-
-
-    void loadBones(const aiMesh* pAiMesh, VertexWeightsVec& weights, VertexIdsVec& ids, uint32_t vertexCount, const std::map<std::string, uint32_t>& boneNameToIdMap)
+    /** Gather the per-vertex bone IDs and weights of a mesh
+        \param[in] pBoneNameToIdMap Maps the bone names to the model's bone IDs. If nullptr, the index of the bone in the mesh is used as the ID.
+    */
+    void loadBones(const aiMesh* pAiMesh, VertexWeightsVec& weights, VertexIdsVec& ids, uint32_t vertexCount, const std::map<std::string, uint32_t>* pBoneNameToIdMap)
     {
         if (pAiMesh->mNumBones > 0xff)
         {
@@ -83,7 +83,7 @@ namespace Falcor
         for (uint32_t bone = 0; bone < pAiMesh->mNumBones; bone++)
         {
             const aiBone* pAiBone = pAiMesh->mBones[bone];
-            uint32_t aiBoneID = boneNameToIdMap.at(std::string(pAiBone->mName.C_Str()));
+            uint32_t aiBoneID = pBoneNameToIdMap ? pBoneNameToIdMap->at(std::string(pAiBone->mName.C_Str())) : bone;
 
             // The way Assimp works, the weights holds the IDs of the vertices it affects.
             // We loop over all the weights, initializing the vertices data along the way
@@ -157,24 +157,133 @@ namespace Falcor
             aiMesh* pMesh = const_cast<aiMesh*>(pAiMesh);
             pMesh->mBitangents = new aiVector3D[pMesh->mNumVertices];
 
-            const glm::vec3* pPos = (glm::vec3*)pMesh->mVertices;
-            glm::vec3* pBi = (glm::vec3*)pMesh->mBitangents;
-            glm::vec3* pNormals = (glm::vec3*)pMesh->mNormals;
             std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
 
-            uint32_t texCrdCount = 0;
-            std::vector<glm::vec2> texCrd;
-            if (pMesh->mTextureCoords[0] != nullptr)
+            // Assimp stores texture coordinates as 3-component vectors, read the first two components in-place
+            TangentSpaceInput input;
+            input.pIndices = indices.data();
+            input.indexCount = indices.size();
+            input.vertexCount = pMesh->mNumVertices;
+            input.pPositions = (const uint8_t*)pMesh->mVertices;
+            input.positionStride = sizeof(aiVector3D);
+            input.pNormals = (const uint8_t*)pMesh->mNormals;
+            input.normalStride = sizeof(aiVector3D);
+            input.pTexCrd = (const uint8_t*)pMesh->mTextureCoords[0];
+            input.texCrdStride = sizeof(aiVector3D);
+
+            generateBitangents(input, (glm::vec3*)pMesh->mBitangents);
+        }
+    }
+
+    template<typename T>
+    void remapVertexStream(T* pStream, uint32_t vertexCount, const std::vector<uint32_t>& remap)
+    {
+        if (pStream == nullptr) return;
+        std::vector<T> source(pStream, pStream + vertexCount);
+        MeshOptimizer::remapVertices(source.data(), sizeof(T), remap, pStream);
+    }
+
+    /** Reorder the triangles and vertices of a triangle mesh in-place with the MeshOptimizer
+    */
+    void optimizeMesh(aiMesh* pMesh, const std::string& filename)
+    {
+        // Falcor doesn't use morph targets, but they would have to be remapped as well
+        if ((pMesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE) || (pMesh->mNumAnimMeshes > 0)) return;
+
+        std::vector<uint32_t> indices = createIndexBufferData(pMesh);
+        MeshOptimizer::Result result;
+        if (MeshOptimizer::optimize(indices.data(), indices.size(), pMesh->mNumVertices, (const uint8_t*)pMesh->mVertices, sizeof(aiVector3D), result) == false)
+        {
+            logWarning("Can't optimize mesh '" + std::string(pMesh->mName.C_Str()) + "' of model " + filename + ". The index buffer isn't a valid triangle list.");
+            return;
+        }
+
+        for (uint32_t f = 0; f < pMesh->mNumFaces; f++)
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                pMesh->mFaces[f].mIndices[i] = result.indices[f * 3 + i];
+            }
+        }
+
+        const uint32_t vertexCount = pMesh->mNumVertices;
+        remapVertexStream(pMesh->mVertices, vertexCount, result.remap);
+        remapVertexStream(pMesh->mNormals, vertexCount, result.remap);
+        remapVertexStream(pMesh->mTangents, vertexCount, result.remap);
+        remapVertexStream(pMesh->mBitangents, vertexCount, result.remap);
+        for (uint32_t i = 0; i < AI_MAX_NUMBER_OF_COLOR_SETS; i++)
+        {
+            remapVertexStream(pMesh->mColors[i], vertexCount, result.remap);
+        }
+        for (uint32_t i = 0; i < AI_MAX_NUMBER_OF_TEXTURECOORDS; i++)
+        {
+            remapVertexStream(pMesh->mTextureCoords[i], vertexCount, result.remap);
+        }
+
+        // Remap the bone weights, dropping the ones which belonged to unreferenced vertices
+        for (uint32_t b = 0; b < pMesh->mNumBones; b++)
+        {
+            aiBone* pBone = pMesh->mBones[b];
+            uint32_t weightCount = 0;
+            for (uint32_t w = 0; w < pBone->mNumWeights; w++)
             {
-                texCrdCount = 1;
-                texCrd.resize(pMesh->mNumVertices);
-                for (size_t i = 0; i < pMesh->mNumVertices; ++i)
+                uint32_t vertexID = result.remap[pBone->mWeights[w].mVertexId];
+                if (vertexID != MeshOptimizer::kUnusedVertex)
                 {
-                    texCrd[i] = glm::vec2(pMesh->mTextureCoords[0][i].x, pMesh->mTextureCoords[0][i].y);
+                    pBone->mWeights[weightCount] = pBone->mWeights[w];
+                    pBone->mWeights[weightCount].mVertexId = vertexID;
+                    weightCount++;
                 }
             }
+            pBone->mNumWeights = weightCount;
+        }
+        pMesh->mNumVertices = result.vertexCount;
+
+        logInfo("Optimized mesh '" + std::string(pMesh->mName.C_Str()) + "' of model " + filename + ". " + to_string(result));
+    }
 
-            generateSubmeshTangentData<glm::vec3>(indices, pAiMesh->mNumVertices, pPos, pNormals, (texCrdCount > 0 ? texCrd.data() : nullptr), texCrdCount, pBi);
+    /** Generate the LOD chain of a triangle mesh. Expects the mesh to be in its final vertex order.
+    */
+    void generateMeshLods(const aiMesh* pMesh, bool optimizeLods, std::vector<MeshSimplifier::Lod>& lods)
+    {
+        if (pMesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE) return;
+
+        std::vector<uint32_t> indices = createIndexBufferData(pMesh);
+        MeshSimplifier::Input input;
+        input.pIndices = indices.data();
+        input.indexCount = indices.size();
+        input.vertexCount = pMesh->mNumVertices;
+        input.pPositions = (const uint8_t*)pMesh->mVertices;
+        input.positionStride = sizeof(aiVector3D);
+        if (pMesh->HasNormals())
+        {
+            input.pNormals = (const uint8_t*)pMesh->mNormals;
+            input.normalStride = sizeof(aiVector3D);
+        }
+
+        // The model's bone IDs aren't known yet, but the simplifier only compares the IDs within the mesh
+        VertexWeightsVec weights;
+        VertexIdsVec ids;
+        if (pMesh->HasBones())
+        {
+            loadBones(pMesh, weights, ids, pMesh->mNumVertices, nullptr);
+            input.pBoneIds = (const uint8_t*)ids.data();
+            input.boneIdStride = sizeof(uvec8_4);
+            input.pBoneWeights = (const uint8_t*)weights.data();
+            input.boneWeightStride = sizeof(vec4);
+        }
+
+        MeshSimplifier::generateLods(input, MeshSimplifier::kImportLodCount, lods);
+
+        if (optimizeLods)
+        {
+            std::vector<uint32_t> optimized;
+            for (auto& lod : lods)
+            {
+                optimized.resize(lod.indices.size());
+                MeshOptimizer::optimizeVertexCache(lod.indices.data(), lod.indices.size(), pMesh->mNumVertices, optimized.data(), nullptr);
+                lod.indices.swap(optimized);
+            }
         }
     }
 
@@ -260,6 +369,11 @@ namespace Falcor
         }
     }
 
+    static std::string getTextureFullpath(const std::string& folder, const std::string& path)
+    {
+        return replaceSubstring(folder + '/' + path, "\\", "/");
+    }
+
     void AssimpModelImporter::loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, BasicMaterial* pMaterial, bool isObjFile, bool useSrgb)
     {
         for (int i = 0; i < AI_TEXTURE_TYPE_MAX; ++i)
@@ -296,10 +410,32 @@ namespace Falcor
                 }
                 else
                 {
-                    // create a new texture
-                    std::string fullpath = folder + '/' + s;
-                    fullpath = replaceSubstring(fullpath, "\\", "/");
-                    pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
+                    // create a new texture. If the image was already decoded while preloading the file, only the upload is left.
+                    std::string fullpath = getTextureFullpath(folder, s);
+                    const auto& preloaded = mpPreloaded->bitmaps.find(s);
+                    bool isNormalMap = (getFalcorTexTypeFromAi(aiType, isObjFile) == BasicMaterial::MapType::NormalMap);
+                    if (is_set(mFlags, Model::LoadFlags::StreamTextures))
+                    {
+                        // Stream the compressed file if there is one. Normal maps stay flat until the streamer loads them.
+                        std::string ddsPath;
+                        if (is_set(mFlags, Model::LoadFlags::CompressTextures) && TextureProcessor::compressTextureFile(fullpath, isSrgbRequired(aiType, useSrgb), isNormalMap, ddsPath))
+                        {
+                            fullpath = ddsPath;
+                        }
+                        pTex = TextureStreamer::createPlaceholderTexture(fullpath, isSrgbRequired(aiType, useSrgb), isNormalMap ? glm::vec4(0.5f, 0.5f, 1, 1) : glm::vec4(1));
+                    }
+                    else if (is_set(mFlags, Model::LoadFlags::CompressTextures))
+                    {
+                        pTex = createCompressedTextureFromFile(fullpath, isSrgbRequired(aiType, useSrgb), isNormalMap);
+                    }
+                    else if (preloaded != mpPreloaded->bitmaps.end() && preloaded->second)
+                    {
+                        pTex = createTextureFromBitmap(preloaded->second.get(), fullpath, true, isSrgbRequired(aiType, useSrgb));
+                    }
+                    else
+                    {
+                        pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
+                    }
                     if (pTex)
                     {
                         mTextureCache[s] = pTex;
@@ -468,7 +604,7 @@ namespace Falcor
                 if (aiToFalcorMesh.find(aiId) == aiToFalcorMesh.end())
                 {
                     // Cache mesh
-                    aiToFalcorMesh[aiId] = createMesh(pScene->mMeshes[aiId]);
+                    aiToFalcorMesh[aiId] = createMesh(pScene->mMeshes[aiId], aiId);
                 }
 
                 mModel.addMeshInstance(aiToFalcorMesh[aiId], aiMatToGLM(transform));
@@ -492,12 +628,14 @@ namespace Falcor
         return parseAiSceneNode(pRoot, pScene, aiToFalcorMeshId);
     }
 
-    bool AssimpModelImporter::initModel(const std::string& filename)
+    AssimpModelImporter::PreloadedFile::PreloadedFile() = default;
+    AssimpModelImporter::PreloadedFile::~PreloadedFile() = default;
+
+    bool AssimpModelImporter::readFile(const std::string& filename, Model::LoadFlags flags, PreloadedFile& file)
     {
-        std::string fullpath;
-        if (findFileInDataDirectories(filename, fullpath) == false)
+        if (findFileInDataDirectories(filename, file.fullpath) == false)
         {
-            logError(std::string("Can't find model file ") + filename, true);
+            file.error = std::string("Can't find model file ") + filename;
             return false;
         }
 
@@ -508,13 +646,13 @@ namespace Falcor
             0;
 
         // aiProcessPreset_TargetRealtime_MaxQuality enabled some optimizations the user might not want
-        if(is_set(mFlags, Model::LoadFlags::FindDegeneratePrimitives) == false)
+        if(is_set(flags, Model::LoadFlags::FindDegeneratePrimitives) == false)
         {
             AssimpFlags &= ~aiProcess_FindDegenerates;
         }
 
         // Avoid merging original meshes
-        if(is_set(mFlags, Model::LoadFlags::DontMergeMeshes))
+        if(is_set(flags, Model::LoadFlags::DontMergeMeshes))
         {
             AssimpFlags &= ~aiProcess_OptimizeMeshes;
         }
@@ -522,25 +660,127 @@ namespace Falcor
         // Never use Assimp's tangent gen code
         AssimpFlags &= ~(aiProcess_CalcTangentSpace);
 
-        Assimp::Importer importer;
-        const aiScene* pScene = importer.ReadFile(fullpath, AssimpFlags);
+        // Our optimizer replaces Assimp's vertex cache optimization
+        const bool optimizeMeshes = is_set(flags, Model::LoadFlags::OptimizeMeshes);
+        if(optimizeMeshes)
+        {
+            AssimpFlags &= ~aiProcess_ImproveCacheLocality;
+        }
+
+        file.pImporter = std::make_unique<Assimp::Importer>();
+        file.pScene = file.pImporter->ReadFile(file.fullpath, AssimpFlags);
 
-        if((pScene == nullptr) || (verifyScene(pScene) == false))
+        if((file.pScene == nullptr) || (verifyScene(file.pScene) == false))
         {
             std::string str("Can't open model file '");
-            str = str + std::string(filename) + "'\n" + importer.GetErrorString();
-            logError(str, true);
+            file.error = str + std::string(filename) + "'\n" + file.pImporter->GetErrorString();
+            file.pScene = nullptr;
             return false;
         }
 
+        if(optimizeMeshes)
+        {
+            const aiScene* pScene = file.pScene;
+            TaskScheduler::get()->parallelFor(0, pScene->mNumMeshes, [&](size_t begin, size_t end)
+            {
+                for(size_t m = begin; m < end; m++)
+                {
+                    optimizeMesh(pScene->mMeshes[m], filename);
+                }
+            }, 1);
+        }
+
+        if(is_set(flags, Model::LoadFlags::GenerateLods))
+        {
+            const aiScene* pScene = file.pScene;
+            file.meshLods.resize(pScene->mNumMeshes);
+            TaskScheduler::get()->parallelFor(0, pScene->mNumMeshes, [&](size_t begin, size_t end)
+            {
+                for(size_t m = begin; m < end; m++)
+                {
+                    generateMeshLods(pScene->mMeshes[m], optimizeMeshes, file.meshLods[m]);
+                }
+            }, 1);
+        }
+
         // Extract the folder name
-        auto last = fullpath.find_last_of("/\\");
-        std::string modelFolder = fullpath.substr(0, last);
+        auto last = file.fullpath.find_last_of("/\\");
+        file.folder = file.fullpath.substr(0, last);
+        return true;
+    }
+
+    Model::PreloadedFile::SharedPtr AssimpModelImporter::preload(const std::string& filename, Model::LoadFlags flags)
+    {
+        auto pFile = std::make_shared<PreloadedFile>();
+        if (readFile(filename, flags, *pFile) == false)
+        {
+            return nullptr;
+        }
+
+        // Streamed textures are read later, by the TextureStreamer
+        const bool compressTextures = is_set(flags, Model::LoadFlags::CompressTextures);
+        if (is_set(flags, Model::LoadFlags::StreamTextures) && (compressTextures == false))
+        {
+            return pFile;
+        }
+
+        // Collect the textures referenced by the materials
+        std::vector<std::string> paths;
+        std::vector<aiTextureType> types;
+        for (uint32_t m = 0; m < pFile->pScene->mNumMaterials; m++)
+        {
+            const aiMaterial* pAiMaterial = pFile->pScene->mMaterials[m];
+            for (int i = 0; i < AI_TEXTURE_TYPE_MAX; ++i)
+            {
+                if (pAiMaterial->GetTextureCount((aiTextureType)i) != 1) continue;
+                aiString path;
+                pAiMaterial->GetTexture((aiTextureType)i, 0, &path);
+                std::string s(path.data);
+                if (s.empty() || pFile->bitmaps.count(s)) continue;
+                pFile->bitmaps[s] = nullptr;
+                paths.push_back(s);
+                types.push_back((aiTextureType)i);
+            }
+        }
+
+        // Fill the DDS cache in parallel. Creating the materials then only reads the cached files.
+        if (compressTextures)
+        {
+            const bool isObjFile = hasSuffix(filename, ".obj", false);
+            const bool useSrgb = !is_set(flags, Model::LoadFlags::AssumeLinearSpaceTextures);
+            TaskScheduler::get()->parallelFor(0, paths.size(), [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    std::string ddsPath;
+                    bool isNormalMap = (getFalcorTexTypeFromAi(types[i], isObjFile) == BasicMaterial::MapType::NormalMap);
+                    TextureProcessor::compressTextureFile(getTextureFullpath(pFile->folder, paths[i]), isSrgbRequired(types[i], useSrgb), isNormalMap, ddsPath);
+                }
+            }, 1);
+            return pFile;
+        }
+
+        // Decode them in parallel. The map doesn't change structure from here on, so each task can write its own entry.
+        TaskScheduler::get()->parallelFor(0, paths.size(), [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                pFile->bitmaps.at(paths[i]) = loadTextureBitmapFromFile(getTextureFullpath(pFile->folder, paths[i]));
+            }
+        }, 1);
+
+        return pFile;
+    }
+
+    bool AssimpModelImporter::initModel(const std::string& filename, const PreloadedFile& file)
+    {
+        mpPreloaded = &file;
+        const aiScene* pScene = file.pScene;
 
         // Order of initialization matters, materials, bones and animations need to loaded before mesh initialization
         bool isObjFile = hasSuffix(filename, ".obj", false);
         bool useSrgbTextures = !is_set(mFlags, Model::LoadFlags::AssumeLinearSpaceTextures);
-        if(createAllMaterials(pScene, modelFolder, isObjFile, useSrgbTextures) == false)
+        if(createAllMaterials(pScene, file.folder, isObjFile, useSrgbTextures) == false)
         {
             logError(std::string("Can't create materials for model ") + filename, true);
             return false;
@@ -555,10 +795,21 @@ namespace Falcor
         return true;
     }
 
-    bool AssimpModelImporter::import(Model& model, const std::string& filename, Model::LoadFlags flags)
+    bool AssimpModelImporter::import(Model& model, const std::string& filename, Model::LoadFlags flags, const PreloadedFile* pPreloaded)
     {
+        PreloadedFile file;
+        if (pPreloaded == nullptr)
+        {
+            if (readFile(filename, flags, file) == false)
+            {
+                logError(file.error, true);
+                return false;
+            }
+            pPreloaded = &file;
+        }
+
         AssimpModelImporter loader(model, flags);
-        return loader.initModel(filename);
+        return loader.initModel(filename, *pPreloaded);
     }
 
     bool AssimpModelImporter::isUsedNode(const aiNode* pNode) const
@@ -677,6 +928,12 @@ namespace Falcor
             for (uint32_t i = 0; i < pScene->mNumAnimations; i++)
             {
                 Animation::UniquePtr pAnimation = createAnimation(pScene->mAnimations[i]);
+                if (is_set(mFlags, Model::LoadFlags::CompressAnimations))
+                {
+                    AnimationCompressor::Report report;
+                    pAnimation = AnimationCompressor::compress(*pAnimation, AnimationCompressor::Settings(), &report);
+                    logInfo("Compressed animation '" + pAnimation->getName() + "' of model " + mpPreloaded->fullpath + ". " + to_string(report));
+                }
                 pAnimCtrl->addAnimation(std::move(pAnimation));
             }
 
@@ -761,7 +1018,7 @@ namespace Falcor
         return BoundingBox::fromMinMax(boxMin, boxMax);
     }
 
-    Mesh::SharedPtr AssimpModelImporter::createMesh(const aiMesh* pAiMesh)
+    Mesh::SharedPtr AssimpModelImporter::createMesh(const aiMesh* pAiMesh, uint32_t aiMeshId)
     {
         uint32_t vertexCount = pAiMesh->mNumVertices;
         uint32_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
@@ -788,14 +1045,22 @@ namespace Falcor
         VertexIdsVec ids;
         if (pAiMesh->HasBones())
         {
-            loadBones(pAiMesh, weights, ids, vertexCount, mBoneNameToIdMap);
+            loadBones(pAiMesh, weights, ids, vertexCount, &mBoneNameToIdMap);
         }
 
         // Create corresponding vertex buffers
+        VertexQuantizer quantizer(boundingBox);
+        uint32_t vertexSize = 0;
         for (uint32_t i = 0; i < pLayout->getBufferCount(); i++)
         {
             const VertexBufferLayout* pVbLayout = pLayout->getBufferLayout(i).get();
-            pVBs[i] = createVertexBuffer(pAiMesh, pVbLayout, (uint8_t*)ids.data(), weights.data());
+            pVBs[i] = createVertexBuffer(pAiMesh, pVbLayout, (uint8_t*)ids.data(), weights.data(), quantizer);
+            vertexSize += pVbLayout->getStride();
+        }
+
+        if (is_set(mFlags, Model::LoadFlags::QuantizeVertices))
+        {
+            logInfo("Quantized mesh '" + std::string(pAiMesh->mName.C_Str()) + "' of model " + mpPreloaded->fullpath + " to " + std::to_string(vertexSize) + " bytes per vertex. " + to_string(quantizer.getError()));
         }
 
         Vao::Topology topology = Vao::Topology::TriangleList;
@@ -820,6 +1085,14 @@ namespace Falcor
 
         Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIB, indexCount, pLayout, topology, pMaterial, boundingBox, pAiMesh->HasBones());
 
+        if (aiMeshId < mpPreloaded->meshLods.size())
+        {
+            for (const auto& lod : mpPreloaded->meshLods[aiMeshId])
+            {
+                pMesh->addLod(createIndexBuffer(lod.indices), (uint32_t)lod.indices.size(), lod.error);
+            }
+        }
+
         if (generateTangentSpace)
         {
             aiMesh* pM = const_cast<aiMesh*>(pAiMesh);
@@ -831,7 +1104,11 @@ namespace Falcor
 
     Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh)
     {
-        std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
+        return createIndexBuffer(createIndexBufferData(pAiMesh));
+    }
+
+    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const std::vector<uint32_t>& indices)
+    {
         const uint32_t size = (uint32_t)(sizeof(uint32_t) * indices.size());
         Buffer::BindFlags bindFlags = Buffer::BindFlags::Index;
         if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
@@ -867,6 +1144,37 @@ namespace Falcor
         }
     }
 
+    /** Get the format of a vertex element. With Model::LoadFlags::QuantizeVertices, the element is packed unless that would lose too much precision.
+    */
+    ResourceFormat getElementFormat(const aiMesh* pAiMesh, uint32_t location, Model::LoadFlags flags)
+    {
+        if (is_set(flags, Model::LoadFlags::QuantizeVertices))
+        {
+            switch (location)
+            {
+            case VERTEX_POSITION_LOC:
+                return VertexQuantizer::kPositionFormat;
+            case VERTEX_NORMAL_LOC:
+            case VERTEX_BITANGENT_LOC:
+                return VertexQuantizer::kUnitVectorFormat;
+            case VERTEX_BONE_WEIGHT_LOC:
+                return VertexQuantizer::kBoneWeightFormat;
+            case VERTEX_DIFFUSE_COLOR_LOC:
+                if (VertexQuantizer::canPackColors((const uint8_t*)pAiMesh->mColors[0], sizeof(aiColor4D), pAiMesh->mNumVertices)) return VertexQuantizer::kColorFormat;
+                break;
+            case VERTEX_TEXCOORD_LOC:
+                if (VertexQuantizer::canPackTexCrds((const uint8_t*)pAiMesh->mTextureCoords[0], sizeof(aiVector3D), pAiMesh->mNumVertices)) return VertexQuantizer::kTexCrdFormat;
+                break;
+            case VERTEX_LIGHTMAP_UV_LOC:
+                if (VertexQuantizer::canPackTexCrds((const uint8_t*)pAiMesh->mTextureCoords[1], sizeof(aiVector3D), pAiMesh->mNumVertices)) return VertexQuantizer::kTexCrdFormat;
+                break;
+            default:
+                break;
+            }
+        }
+        return kLayoutData[location].format;
+    }
+
     VertexLayout::SharedPtr AssimpModelImporter::createVertexLayout(const aiMesh* pAiMesh)
     {
         static const uint32_t kMaxSupportedUVs = 2;
@@ -899,7 +1207,7 @@ namespace Falcor
             if (isElementUsed(pAiMesh, location))
             {
                 VertexBufferLayout::SharedPtr pVbLayout = VertexBufferLayout::create();
-                pVbLayout->addElement(kLayoutData[location].name, 0, kLayoutData[location].format, 1, location);
+                pVbLayout->addElement(kLayoutData[location].name, 0, getElementFormat(pAiMesh, location, mFlags), 1, location);
                 pLayout->addBufferLayout(bufferCount, pVbLayout);
                 bufferCount++;
             }
@@ -908,7 +1216,39 @@ namespace Falcor
         return pLayout;
     }
 
-    Buffer::SharedPtr AssimpModelImporter::createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights)
+    /** Pack a vertex element into the quantized format selected by getElementFormat()
+    */
+    void packVertexElement(const aiMesh* pAiMesh, uint32_t location, uint32_t vertexID, const vec4* pBoneWeights, VertexQuantizer& quantizer, uint8_t* pDst)
+    {
+        switch (location)
+        {
+        case VERTEX_POSITION_LOC:
+            quantizer.packPosition(*(const glm::vec3*)&pAiMesh->mVertices[vertexID], pDst);
+            break;
+        case VERTEX_NORMAL_LOC:
+            quantizer.packNormal(*(const glm::vec3*)&pAiMesh->mNormals[vertexID], pDst);
+            break;
+        case VERTEX_BITANGENT_LOC:
+            quantizer.packBitangent(*(const glm::vec3*)&pAiMesh->mBitangents[vertexID], pDst);
+            break;
+        case VERTEX_DIFFUSE_COLOR_LOC:
+            quantizer.packColor(*(const glm::vec4*)&pAiMesh->mColors[0][vertexID], pDst);
+            break;
+        case VERTEX_TEXCOORD_LOC:
+            quantizer.packTexCrd(glm::vec2(pAiMesh->mTextureCoords[0][vertexID].x, pAiMesh->mTextureCoords[0][vertexID].y), pDst);
+            break;
+        case VERTEX_LIGHTMAP_UV_LOC:
+            quantizer.packTexCrd(glm::vec2(pAiMesh->mTextureCoords[1][vertexID].x, pAiMesh->mTextureCoords[1][vertexID].y), pDst);
+            break;
+        case VERTEX_BONE_WEIGHT_LOC:
+            quantizer.packBoneWeights(pBoneWeights[vertexID], pDst);
+            break;
+        default:
+            should_not_get_here();
+        }
+    }
+
+    Buffer::SharedPtr AssimpModelImporter::createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights, VertexQuantizer& quantizer)
     {
         const uint32_t vertexStride = pLayout->getStride();
         std::vector<uint8_t> initData(vertexStride * pAiMesh->mNumVertices, 0);
@@ -923,6 +1263,12 @@ namespace Falcor
                 uint32_t location = pLayout->getElementShaderLocation(elementID);
                 uint8_t* pDst = pVertex + offset;
 
+                if (pLayout->getElementFormat(elementID) != kLayoutData[location].format)
+                {
+                    packVertexElement(pAiMesh, location, vertexID, pBoneWeights, quantizer, pDst);
+                    continue;
+                }
+
                 uint8_t* pSrc = nullptr;
                 uint32_t size = 0;
                 switch (location)
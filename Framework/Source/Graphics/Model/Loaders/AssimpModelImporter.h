@@ -30,9 +30,11 @@
 #include <unordered_set>
 #include <vector>
 #include "Graphics/Model/Loaders/ModelImporter.h"
+#include "Graphics/Model/Loaders/MeshSimplifier.h"
 #include "../AnimationController.h"
 #include "../Mesh.h"
 #include "../Model.h"
+#include "Utils/Bitmap.h"
 
 struct aiScene;
 struct aiNode;
@@ -40,11 +42,17 @@ struct aiAnimation;
 struct aiMesh;
 struct aiMaterial;
 
+namespace Assimp
+{
+    class Importer;
+}
+
 namespace Falcor
 {
     class Animation;
     class Buffer;
     class VertexBufferLayout;
+    class VertexQuantizer;
     class Texture;
 
     /** Implements model import functionality through ASSIMP.
@@ -53,13 +61,40 @@ namespace Falcor
     class AssimpModelImporter : public ModelImporter
     {
     public:
+        /** The ASSIMP scene and the decoded textures of a model file. Created by preload().
+        */
+        class PreloadedFile : public Model::PreloadedFile
+        {
+        public:
+            using BitmapMap = std::map<std::string, std::shared_ptr<const Bitmap>>;
+
+            PreloadedFile();
+            ~PreloadedFile();
+
+            std::string fullpath;
+            std::string folder;
+            std::string error;
+            std::unique_ptr<Assimp::Importer> pImporter;
+            const aiScene* pScene = nullptr;
+            BitmapMap bitmaps;  // Keyed by the texture path stored in the ASSIMP material. nullptr for images which are loaded later (DDS files)
+            std::vector<std::vector<MeshSimplifier::Lod>> meshLods;  // Indexed by the ASSIMP mesh ID. Empty unless Model::LoadFlags::GenerateLods is set
+        };
+
+        /** Read a model file and decode its textures without accessing the device. Can be called from any thread.
+            \param[in] filename Model's filename. Can include a full path or a relative path from a data directory
+            \param[in] flags Flags controlling model creation
+            \return The preloaded data, or nullptr if the file couldn't be read
+        */
+        static Model::PreloadedFile::SharedPtr preload(const std::string& filename, Model::LoadFlags flags);
+
         /** Load a model using ASSIMP
             \param[out] model Model object to load into
             \param[in] filename Model's filename. Can include a full path or a relative path from a data directory
             \param[in] flags Flags controlling model creation
+            \param[in] pPreloaded Optional data returned by preload(). If nullptr, the file will be read on the calling thread
             \return Whether import succeeded
         */
-        static bool import(Model& model, const std::string& filename, Model::LoadFlags flags);
+        static bool import(Model& model, const std::string& filename, Model::LoadFlags flags, const PreloadedFile* pPreloaded = nullptr);
 
     private:
 
@@ -69,7 +104,8 @@ namespace Falcor
         AssimpModelImporter(const AssimpModelImporter&) = delete;
         void operator=(const AssimpModelImporter&) = delete;
 
-        bool initModel(const std::string& filename);
+        static bool readFile(const std::string& filename, Model::LoadFlags flags, PreloadedFile& file);
+        bool initModel(const std::string& filename, const PreloadedFile& file);
         bool createDrawList(const aiScene* pScene);
         bool parseAiSceneNode(const aiNode* pCurrent, const aiScene* pScene, IdToMesh& aiToFalcorMesh);
         bool createAllMaterials(const aiScene* pScene, const std::string& modelFolder, bool isObjFile, bool useSrgb);
@@ -81,10 +117,11 @@ namespace Falcor
 
         Animation::UniquePtr createAnimation(const aiAnimation* pAiAnim);
 
-        Mesh::SharedPtr createMesh(const aiMesh* pAiMesh);
+        Mesh::SharedPtr createMesh(const aiMesh* pAiMesh, uint32_t aiMeshId);
         VertexLayout::SharedPtr createVertexLayout(const aiMesh* pAiMesh);
         Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh);
-        Buffer::SharedPtr createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights);
+        Buffer::SharedPtr createIndexBuffer(const std::vector<uint32_t>& indices);
+        Buffer::SharedPtr createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights, VertexQuantizer& quantizer);
         void loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, BasicMaterial* pMaterial, bool isObjFile, bool useSrgb);
         Material::SharedPtr createMaterial(const aiMaterial* pAiMaterial, const std::string& folder, bool isObjFile, bool useSrgb);
 
@@ -102,5 +139,6 @@ namespace Falcor
         std::vector<Bone> mBones;
         Model::LoadFlags mFlags;
         std::map<const std::string, Texture::SharedPtr> mTextureCache;
+        const PreloadedFile* mpPreloaded = nullptr;
     };
 }
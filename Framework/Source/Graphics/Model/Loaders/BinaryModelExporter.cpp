@@ -31,6 +31,7 @@
 #include "../Mesh.h"
 #include "API/VAO.h"
 #include "BinaryModelSpec.h"
+#include "VertexQuantizer.h"
 #include "API/Buffer.h"
 #include "API/Texture.h"
 #include "BinaryImage.hpp"
@@ -206,6 +207,12 @@ namespace Falcor
             }
 
             const auto& pVao = pMesh->getVao();
+            if(VertexQuantizer::isPackedLayout(pVao->getVertexLayout().get()))
+            {
+                error("Binary format doesn't support quantized vertices. Load the model without Model::LoadFlags::QuantizeVertices.");
+                return false;
+            }
+
             auto& submesh = mMeshes[pVao.get()];
             submesh.push_back(i);
         }
@@ -260,7 +267,14 @@ namespace Falcor
     {
         auto pVao = pMesh->getVao();
         const uint32_t vertexBufferCount = pMesh->getVao()->getVertexBuffersCount();
-        mStream << (int32_t)vertexBufferCount << (int32_t)pMesh->getVertexCount() << (int32_t)submeshCount;
+
+        // The file stores one attribute per element. A vertex buffer can hold several interleaved elements.
+        struct attribInfo
+        {
+            uint32_t          vbIndex;
+            uint32_t          offset;
+            uint32_t          size;
+        };
 
         struct vertexBufferInfo 
         {
@@ -270,27 +284,45 @@ namespace Falcor
         };
             
         std::vector<vertexBufferInfo> vbInfo(vertexBufferCount);
+        std::vector<attribInfo> attribs;
 
         for (uint32_t i = 0; i < vertexBufferCount; i++)
         {
             const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(i).get();
-            assert(pLayout->getElementCount() == 1);
-            AttribType type = getBinaryAttribType(pLayout->getElementName(0));
-            AttribFormat format = GetBinaryAttribFormat(pLayout->getElementFormat(0));
-            uint32_t channels = getFormatChannelCount(pLayout->getElementFormat(0));
-
-            if(type == AttribType_Max)
+            for (uint32_t e = 0; e < pLayout->getElementCount(); e++)
             {
-                error("Unsupported attribute Type");
-                return false;
+                attribInfo attrib;
+                attrib.vbIndex = i;
+                attrib.offset = pLayout->getElementOffset(e);
+                attrib.size = getFormatBytesPerBlock(pLayout->getElementFormat(e)) * pLayout->getElementArraySize(e);
+                attribs.push_back(attrib);
             }
+        }
+
+        mStream << (int32_t)attribs.size() << (int32_t)pMesh->getVertexCount() << (int32_t)submeshCount;
 
-            if(format == AttribFormat_Max)
+        for (uint32_t i = 0; i < vertexBufferCount; i++)
+        {
+            const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(i).get();
+            for (uint32_t e = 0; e < pLayout->getElementCount(); e++)
             {
-                error("Unsupported attribute format");
-                return false;
+                AttribType type = getBinaryAttribType(pLayout->getElementName(e));
+                AttribFormat format = GetBinaryAttribFormat(pLayout->getElementFormat(e));
+                uint32_t channels = getFormatChannelCount(pLayout->getElementFormat(e));
+
+                if(type == AttribType_Max)
+                {
+                    error("Unsupported attribute Type");
+                    return false;
+                }
+
+                if(format == AttribFormat_Max)
+                {
+                    error("Unsupported attribute format");
+                    return false;
+                }
+                mStream << (int32_t)type << (int32_t)format << (int32_t)channels;
             }
-            mStream << (int32_t)type << (int32_t)format << (int32_t)channels;
 
             vbInfo[i].pBuffer = pVao->getVertexBuffer(i);
             vbInfo[i].stride = pLayout->getStride();
@@ -300,10 +332,10 @@ namespace Falcor
         // Write the vertex buffer
         for (uint32_t i = 0; i < pMesh->getVertexCount(); ++i)
         {
-            for (auto& a : vbInfo)
+            for (const auto& a : attribs)
             { 			
-                mStream.write((void*)a.pData, a.stride);
-                a.pData += a.stride;
+                const vertexBufferInfo& vb = vbInfo[a.vbIndex];
+                mStream.write((void*)(vb.pData + (size_t)vb.stride * i + a.offset), a.size);
             }
         }
 
@@ -28,6 +28,9 @@
 #include "Framework.h"
 #include "BinaryModelImporter.h"
 #include "BinaryModelSpec.h"
+#include "TangentSpace.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include "../Model.h"
 #include "../Mesh.h"
 #include "Utils/Platform/OS.h"
@@ -36,6 +39,7 @@
 #include "API/Buffer.h"
 #include "glm/common.hpp"
 #include "BinaryImage.hpp"
+#include "Utils/MappedFileStream.h"
 #include "API/Formats.h"
 #include "API/Texture.h"
 #include "Graphics/Material/Material.h"
@@ -51,127 +55,19 @@ namespace Falcor
         uint32_t width  = 0;
         uint32_t height = 0;
         ResourceFormat format = ResourceFormat::Unknown;
-        std::vector<uint8_t> data;
+        const uint8_t* pData = nullptr;     // Points either into the file mapping or into 'data'
+        std::vector<uint8_t> data;          // Only used when the texels need to be converted
         std::string name;
     };
 
-    bool isSpecialFloat(float f)
+    /** Load an element from an interleaved vertex stream. The stream comes straight from the file, so it might not be aligned.
+    */
+    template<typename T>
+    static T loadVertexElement(const uint8_t* pStream, uint32_t stride, uint32_t index)
     {
-        uint32_t d = *(uint32_t*)&f;
-        // Check the exponent
-        d = (d >> 23) & 0xff;
-        return d == 0xff;
-    }
-
-    static vec3 projectNormalToBitangent(const vec3& normal)
-    {
-        vec3 bitangent;
-        if (abs(normal.x) > abs(normal.y))
-        {
-            bitangent = v3(normal.z, 0.f, -normal.x) / length(v2(normal.x, normal.z));
-        }
-        else
-        {
-            bitangent = v3(0.f, normal.z, -normal.y) / length(v2(normal.y, normal.z));
-        }
-        return normalize(bitangent);
-    }
-
-    static bool isInvalidVec(const vec3& v)
-    {
-        return isSpecialFloat(v.x) || isSpecialFloat(v.y) || isSpecialFloat(v.z);
-    }
-
-    template<typename posType>
-    void generateSubmeshTangentData(
-        const std::vector<uint32_t>& indices,
-        uint32_t vertexCount,
-        const posType* vertexPosData,
-        const glm::vec3* vertexNormalData,
-        const glm::vec2* texCrdData,
-        uint32_t texCrdCount,
-        glm::vec3* bitangentData)
-    {
-        std::memset(bitangentData, 0, vertexCount * sizeof(vec3));
-
-        // calculate the tangent and bitangent for every face
-        size_t primCount = indices.size() / 3;
-        for(size_t primID = 0; primID < primCount; primID++)
-        {
-            struct Data
-            {
-                posType position;
-                glm::vec3 normal;
-                glm::vec2 uv;
-            };
-            Data V[3];
-
-            // Get the data
-            for(uint32_t i = 0; i < 3; i++)
-            {
-                uint32_t index = indices[primID * 3 + i];
-                V[i].position = vertexPosData[index];
-                V[i].normal = vertexNormalData[index];
-                V[i].uv = texCrdData ? texCrdData[index * texCrdCount] : vec2(0);
-            }
-
-            // Position delta
-            posType posDelta[2];
-            posDelta[0] = V[1].position - V[0].position;
-            posDelta[1] = V[2].position - V[0].position;
-
-            // Texture offset
-            glm::vec2 s = V[1].uv - V[0].uv;
-            glm::vec2 t = V[2].uv - V[0].uv;
-
-            glm::vec3 tangent;
-            glm::vec3 bitangent;
-
-            // when t1, t2, t3 in same position in UV space, just use default UV direction.
-            if((s == glm::vec2(0, 0)) || (t == glm::vec2(0, 0)))
-            {
-                const glm::vec3 &normal = V[0].normal;
-                bitangent = projectNormalToBitangent(normal);
-                tangent = cross(bitangent, normal);
-            }
-            else
-            {
-                float dirCorrection = 1.0f / (s.x * t.y - s.y * t.x);
-
-                // tangent points in the direction where to positive X axis of the texture coord's would point in model space
-                // bitangent's points along the positive Y axis of the texture coord's, respectively
-                tangent   = (posDelta[0] * t.y - posDelta[1] * t.x) * dirCorrection;
-                bitangent = (posDelta[1] * s.x - posDelta[0] * s.y) * dirCorrection;
-            }
-
-            // store for every vertex of that face
-            for(uint32_t i = 0; i < 3; i++)
-            {
-                // project tangent and bitangent into the plane formed by the vertex' normal
-                glm::vec3 localTangent = tangent - V[i].normal * (glm::dot(tangent, V[i].normal));
-                localTangent = glm::normalize(localTangent);
-                glm::vec3 localBitangent = bitangent - V[i].normal * (glm::dot(bitangent, V[i].normal));
-                localBitangent = glm::normalize(localBitangent);
-                localBitangent = localBitangent - localTangent * (glm::dot(localBitangent, localTangent));
-                localBitangent = glm::normalize(localBitangent);
-
-                if (isInvalidVec(bitangent) == false)
-                {
-                    // and write it into the mesh
-                    uint32_t index = indices[primID * 3 + i];
-                    bitangentData[index] += normalize(localBitangent);
-                }
-            }
-        }
-
-        for (uint32_t v = 0; v < vertexCount; v++)
-        {
-            bitangentData[v] = normalize(bitangentData[v]);
-            if (isInvalidVec(bitangentData[v]))
-            {
-                bitangentData[v] = projectNormalToBitangent(vertexNormalData[v]);
-            }
-        }
+        T val;
+        std::memcpy(&val, pStream + (size_t)stride * index, sizeof(T));
+        return val;
     }
 
     static BasicMaterial::MapType getFalcorMapType(TextureType map)
@@ -351,17 +247,15 @@ namespace Falcor
         }
     }
 
-    std::string readString(BinaryFileStream& stream)
+    std::string readString(MappedFileStream& stream)
     {
         int32_t length;
         stream >> length;
-        std::vector<char> charVec(length + 1);
-        stream.read(&charVec[0], length);
-        charVec[length] = 0;
-        return std::string(charVec.data());
+        ConstSpan<char> chars = stream.readSpan<char>(length);
+        return std::string(chars.data(), chars.size());
     }
 
-    bool loadBinaryTextureData(BinaryFileStream& stream, const std::string& modelName, TextureData& data)
+    bool loadBinaryTextureData(MappedFileStream& stream, const std::string& modelName, TextureData& data)
     {
         // ImageHeader.
         char tag[9];
@@ -447,29 +341,36 @@ namespace Falcor
         {
             dataSize = bpp * texelCount;
         }
-        size_t storageSize = dataSize;
-        if(bpp == 3)
-            storageSize = 4 * texelCount;
-
-        data.data.resize(storageSize);
-        stream.read(data.data.data(), dataSize);
+        ConstSpan<uint8_t> texels = stream.readSpan<uint8_t>(dataSize);
+        if(stream.isFail())
+        {
+            std::string msg = "Error when loading model " + modelName + ".\nBinary image data is truncated.";
+            logError(msg);
+            return false;
+        }
 
-        // Convert 3-channel 8-bits RGB formats to 4-channel RGBX by adding padding
+        // Convert 3-channel 8-bits RGB formats to 4-channel RGBX by adding padding. Everything else is used in-place.
         if(bpp == 3)
         {
-            for(int32_t i=texelCount-1;i>=0;--i)
+            data.data.resize(4 * texelCount);
+            for(int32_t i = 0; i < texelCount; i++)
             {
-                data.data[i * 4 + 0] = data.data[i * 3 + 0];
-                data.data[i * 4 + 1] = data.data[i * 3 + 1];
-                data.data[i * 4 + 2] = data.data[i * 3 + 2];
+                data.data[i * 4 + 0] = texels[i * 3 + 0];
+                data.data[i * 4 + 1] = texels[i * 3 + 1];
+                data.data[i * 4 + 2] = texels[i * 3 + 2];
                 data.data[i * 4 + 3] = 0xff;
             }
+            data.pData = data.data.data();
+        }
+        else
+        {
+            data.pData = texels.data();
         }
 
         return true;
     }
 
-    bool importTextures(std::vector<TextureData>& textures, uint32_t textureCount, BinaryFileStream& stream, const std::string& modelName)
+    bool importTextures(std::vector<TextureData>& textures, uint32_t textureCount, MappedFileStream& stream, const std::string& modelName)
     {
         textures.assign(textureCount, TextureData());
 
@@ -489,7 +390,7 @@ namespace Falcor
         return success;
     }
 
-    BinaryModelImporter::BinaryModelImporter(const std::string& fullpath) : mModelName(fullpath), mStream(fullpath.c_str(), BinaryFileStream::Mode::Read)
+    BinaryModelImporter::BinaryModelImporter(const std::string& fullpath) : mModelName(fullpath), mStream(fullpath)
     {
     }
 
@@ -560,6 +461,12 @@ namespace Falcor
     
     bool BinaryModelImporter::importModel(Model& model, Model::LoadFlags flags)
     {
+        if(mStream.isFail())
+        {
+            logError("Error when loading model " + mModelName + ".\nCan't map the file.");
+            return false;
+        }
+
         // Format ID and version.
         char formatID[9];
         mStream.read(formatID, 8);
@@ -654,6 +561,8 @@ namespace Falcor
         };
         std::map<TexSignature, Texture::SharedPtr> textures;
         bool loadTexAsSrgb = !is_set(flags, Model::LoadFlags::AssumeLinearSpaceTextures);
+        bool optimizeMeshes = is_set(flags, Model::LoadFlags::OptimizeMeshes);
+        bool generateLods = is_set(flags, Model::LoadFlags::GenerateLods);
 
         // Load the meshes
         for(int meshIdx = 0; meshIdx < numMeshes; meshIdx++)
@@ -681,30 +590,20 @@ namespace Falcor
                 return false;
             }
 
-            Vao::BufferVec pVBs;
             VertexLayout::SharedPtr pLayout = VertexLayout::create();
-            
-            struct BufferData
-            {
-                std::vector<uint8_t> vec;
-                bool shouldSkip = false;
-                uint32_t elementSize = 0;
-            };
 
-            std::vector<BufferData> buffers;
-            pVBs.resize(numAttribs);
-            buffers.resize(numAttribs);
+            // The attributes are interleaved in the file. The vertex data is uploaded in-place as a single vertex buffer, attributes which Falcor doesn't use become padding.
+            VertexBufferLayout::SharedPtr pBufferLayout = VertexBufferLayout::create();
+            pLayout->addBufferLayout(0, pBufferLayout);
 
-            const uint32_t kInvalidBufferIndex = (uint32_t)-1;
-            uint32_t positionBufferIndex = kInvalidBufferIndex;
-            uint32_t normalBufferIndex = kInvalidBufferIndex;
-            uint32_t bitangentBufferIndex = kInvalidBufferIndex;
-            uint32_t texCoordBufferIndex = kInvalidBufferIndex;
+            uint32_t vertexStride = 0;
+            uint32_t positionOffset = kInvalidOffset;
+            uint32_t normalOffset = kInvalidOffset;
+            uint32_t bitangentOffset = kInvalidOffset;
+            uint32_t texCoordOffset = kInvalidOffset;
 
             for(int i = 0; i < numAttribs; i++)
             {
-                VertexBufferLayout::SharedPtr pBufferLayout = VertexBufferLayout::create();
-                pLayout->addBufferLayout(i, pBufferLayout);
                 int32_t type, format, length;
                 mStream >> type >> format >> length;
 
@@ -723,86 +622,73 @@ namespace Falcor
                     switch (shaderLocation)
                     {
                     case VERTEX_POSITION_LOC:
-                        positionBufferIndex = i;
+                        positionOffset = vertexStride;
                         assert(falcorFormat == ResourceFormat::RGB32Float || falcorFormat == ResourceFormat::RGBA32Float);
                         break;
                     case VERTEX_NORMAL_LOC:
-                        normalBufferIndex = i;
+                        normalOffset = vertexStride;
                         assert(falcorFormat == ResourceFormat::RGB32Float);
                         break;
                     case VERTEX_BITANGENT_LOC:
-                        bitangentBufferIndex = i;
+                        bitangentOffset = vertexStride;
                         assert(falcorFormat == ResourceFormat::RGB32Float);
                         break;
                     case VERTEX_TEXCOORD_LOC:
-                        texCoordBufferIndex = i;
+                        texCoordOffset = vertexStride;
                         break;
                     }
 
-                    buffers[i].elementSize = getFormatBytesPerBlock(falcorFormat);
+                    uint32_t elementSize = getFormatBytesPerBlock(falcorFormat);
                     if(shaderLocation != kUnusedShaderElement)
                     {
-                        pBufferLayout->addElement(falcorName, 0, falcorFormat, 1, shaderLocation);
-                        buffers[i].vec.resize(buffers[i].elementSize * numVertices);
+                        pBufferLayout->addElement(falcorName, vertexStride, falcorFormat, 1, shaderLocation);
                     }
                     else
                     {
-                        buffers[i].shouldSkip = true;
+                        pBufferLayout->addPadding(elementSize);
                     }
+                    vertexStride += elementSize;
                 }
             }
 
-            
+            if(positionOffset == kInvalidOffset)
+            {
+                std::string msg = "Error when loading model " + mModelName + ".\nMesh " + std::to_string(meshIdx) + " doesn't contain positions.";
+                logError(msg);
+                return false;
+            }
+
             // Check if we need to generate tangents  
             bool genTangentForMesh = false;
-            if(shouldGenerateTangents && (bitangentBufferIndex == kInvalidBufferIndex))
+            std::vector<glm::vec3> bitangents;
+            if(shouldGenerateTangents && (bitangentOffset == kInvalidOffset))
             {
-                if(normalBufferIndex == kInvalidBufferIndex)
+                if(normalOffset == kInvalidOffset)
                 {
                     logWarning("Can't generate tangent space for mesh " + std::to_string(meshIdx) + " when loading model " + mModelName + ".\nMesh doesn't contain normals coordinates\n");
                     genTangentForMesh = false;
                 }
                 else
                 {
-                    // Set the offsets
                     genTangentForMesh = true;
-                    bitangentBufferIndex = (uint32_t)pVBs.size();
-                    pVBs.resize(bitangentBufferIndex + 1);
-                    buffers.resize(bitangentBufferIndex + 1);
-                   
                     auto pBitangentLayout = VertexBufferLayout::create();
-                    pLayout->addBufferLayout(bitangentBufferIndex, pBitangentLayout);
+                    pLayout->addBufferLayout(1, pBitangentLayout);
                     pBitangentLayout->addElement(VERTEX_BITANGENT_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_BITANGENT_LOC);
-                    buffers[bitangentBufferIndex].vec.resize(sizeof(glm::vec3) * numVertices);
+                    bitangents.resize(numVertices);
                 }
             }
-            
 
-            // Read the data, one vertex at a time
-            for(int32_t i = 0; i < numVertices; i++)
+            // Upload the vertices straight from the mapping
+            ConstSpan<uint8_t> vertexData = mStream.readSpan<uint8_t>((uint64_t)numVertices * vertexStride);
+            if(mStream.isFail())
             {
-                for (int32_t attributes = 0; attributes < numAttribs; ++attributes)
-                {
-                    if (buffers[attributes].shouldSkip)
-                    {
-                        mStream.skip(buffers[attributes].elementSize);
-                    }
-                    else
-                    {
-                        uint32_t stride = pLayout->getBufferLayout(attributes)->getStride();
-                        uint8_t* pDest = buffers[attributes].vec.data() + stride * i;
-                        mStream.read(pDest, stride);
-                    }
-                }
+                std::string msg = "Error when loading model " + mModelName + ".\nVertex data is truncated.";
+                logError(msg);
+                return false;
             }
 
-            for (int32_t i = 0; i < numAttribs; ++i)
-            {
-                if(buffers[i].shouldSkip == false)
-                {
-                    pVBs[i] = Buffer::create(buffers[i].vec.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, buffers[i].vec.data());
-                }
-            }
+            // Optimized submeshes get their own copy of the vertices, so the shared buffer is only created once a submesh needs it
+            Buffer::SharedPtr pSharedVB;
 
             if(version <= 5)
             {
@@ -859,7 +745,7 @@ namespace Falcor
                         // Load the texture
                         TexSignature texSig;
                         texSig.format = getFormatFromMapType(loadTexAsSrgb, texData[texID].format, falcorType);
-                        texSig.pData = texData[texID].data.data();
+                        texSig.pData = texData[texID].pData;
                         // Check if we already created a matching texture
                         auto existingTex = textures.find(texSig);
                         if(existingTex != textures.end())
@@ -888,50 +774,75 @@ namespace Falcor
                     return false;
                 }
 
-                // create the index buffer
+                // create the index buffer straight from the mapping
                 uint32_t numIndices = numTriangles * 3;
-                std::vector<uint32_t> indices(numIndices);
-                uint32_t ibSize = 3 * numTriangles * sizeof(uint32_t);
-                mStream.read(&indices[0], ibSize);
-
-                auto pIB = Buffer::create(ibSize, Buffer::BindFlags::Index, Buffer::CpuAccess::None, indices.data());
-
-                // Generate tangent space data if needed
-                if(genTangentForMesh)
+                ConstSpan<uint32_t> indices = mStream.readSpan<uint32_t>(numIndices);
+                if(mStream.isFail())
                 {
-                    uint32_t texCrdCount = 0;
-                    glm::vec2* texCrd = nullptr;
-                    if(texCoordBufferIndex != kInvalidBufferIndex)
-                    {
-                        texCrdCount = pLayout->getBufferLayout(texCoordBufferIndex)->getStride() / sizeof(glm::vec2);
-                        texCrd = (glm::vec2*)buffers[texCoordBufferIndex].vec.data();
-                    }
-
-                    ResourceFormat posFormat = pLayout->getBufferLayout(positionBufferIndex)->getElementFormat(0);
+                    std::string Msg = "Error when loading model " + mModelName + ".\nIndex data is truncated.";
+                    logError(Msg);
+                    return false;
+                }
 
-                    if (posFormat == ResourceFormat::RGB32Float)
+                // Optimized submeshes use a compacted copy of the vertices they reference, in the order they first use them
+                const uint32_t* pIndices = indices.data();
+                const uint8_t* pVertices = vertexData.data();
+                uint32_t submeshVertexCount = numVertices;
+                MeshOptimizer::Result optimized;
+                std::vector<uint8_t> optimizedVertices;
+                Vao::BufferVec pVBs(genTangentForMesh ? 2 : 1);
+                if(optimizeMeshes && MeshOptimizer::optimize(indices.data(), indices.size(), numVertices, vertexData.data() + positionOffset, vertexStride, optimized))
+                {
+                    optimizedVertices.resize((size_t)optimized.vertexCount * vertexStride);
+                    MeshOptimizer::remapVertices(vertexData.data(), vertexStride, optimized.remap, optimizedVertices.data());
+                    pIndices = optimized.indices.data();
+                    pVertices = optimizedVertices.data();
+                    submeshVertexCount = optimized.vertexCount;
+                    pVBs[0] = Buffer::create(optimizedVertices.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, optimizedVertices.data());
+                    logInfo("Optimized mesh " + std::to_string(meshIdx) + ", submesh " + std::to_string(submesh) + " of model " + mModelName + ". " + to_string(optimized));
+                }
+                else
+                {
+                    if(optimizeMeshes)
                     {
-                        generateSubmeshTangentData<glm::vec3>(indices, numVertices, (glm::vec3*)buffers[positionBufferIndex].vec.data(), (glm::vec3*)buffers[normalBufferIndex].vec.data(), texCrd, texCrdCount, (glm::vec3*)buffers[bitangentBufferIndex].vec.data());
+                        logWarning("Can't optimize mesh " + std::to_string(meshIdx) + ", submesh " + std::to_string(submesh) + " of model " + mModelName + ". The index buffer isn't a valid triangle list.");
                     }
-                    else if (posFormat == ResourceFormat::RGBA32Float)
+                    if(pSharedVB == nullptr)
                     {
-                        generateSubmeshTangentData<glm::vec4>(indices, numVertices, (glm::vec4*)buffers[positionBufferIndex].vec.data(), (glm::vec3*)buffers[normalBufferIndex].vec.data(), texCrd, texCrdCount, (glm::vec3*)buffers[bitangentBufferIndex].vec.data());
+                        pSharedVB = Buffer::create(vertexData.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, vertexData.data());
                     }
+                    pVBs[0] = pSharedVB;
+                }
+
+                const uint8_t* pPositions = pVertices + positionOffset;
+                const uint8_t* pNormals = (normalOffset != kInvalidOffset) ? pVertices + normalOffset : nullptr;
+                const uint8_t* pTexCrd = (texCoordOffset != kInvalidOffset) ? pVertices + texCoordOffset : nullptr;
+
+                auto pIB = Buffer::create(numIndices * sizeof(uint32_t), Buffer::BindFlags::Index, Buffer::CpuAccess::None, pIndices);
 
-                    pVBs[bitangentBufferIndex] = Buffer::create(buffers[bitangentBufferIndex].vec.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, buffers[bitangentBufferIndex].vec.data());
+                // Generate tangent space data if needed
+                if(genTangentForMesh)
+                {
+                    TangentSpaceInput tangentInput;
+                    bitangents.resize(submeshVertexCount);
+                    tangentInput.pIndices = pIndices;
+                    tangentInput.indexCount = numIndices;
+                    tangentInput.vertexCount = submeshVertexCount;
+                    tangentInput.pPositions = pPositions;
+                    tangentInput.positionStride = vertexStride;
+                    tangentInput.pNormals = pNormals;
+                    tangentInput.normalStride = vertexStride;
+                    tangentInput.pTexCrd = pTexCrd;
+                    tangentInput.texCrdStride = vertexStride;
+                    generateBitangents(tangentInput, bitangents.data());
+                    pVBs[1] = Buffer::create(bitangents.size() * sizeof(glm::vec3), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, bitangents.data());
                 }
-                
 
                 // Calculate the bounding-box
                 glm::vec3 max, min;
                 for(uint32_t i = 0; i < numIndices; i++)
                 {
-                    uint32_t vertexID = indices[i];
-                    uint8_t* pVertex = (pLayout->getBufferLayout(positionBufferIndex)->getStride() * vertexID) + buffers[positionBufferIndex].vec.data();
-
-                    float* pPosition = (float*)pVertex;
-
-                    glm::vec3 xyz(pPosition[0], pPosition[1], pPosition[2]);
+                    glm::vec3 xyz = loadVertexElement<glm::vec3>(pPositions, vertexStride, pIndices[i]);
                     min = glm::min(min, xyz);
                     max = glm::max(max, xyz);
                 }
@@ -939,7 +850,33 @@ namespace Falcor
                 BoundingBox box = BoundingBox::fromMinMax(min, max);
 
                 // create the mesh
-                auto pMesh = Mesh::create(pVBs, numVertices, pIB, numIndices, pLayout, Vao::Topology::TriangleList, pMaterial, box, false);
+                auto pMesh = Mesh::create(pVBs, submeshVertexCount, pIB, numIndices, pLayout, Vao::Topology::TriangleList, pMaterial, box, false);
+
+                if(generateLods)
+                {
+                    MeshSimplifier::Input lodInput;
+                    lodInput.pIndices = pIndices;
+                    lodInput.indexCount = numIndices;
+                    lodInput.vertexCount = submeshVertexCount;
+                    lodInput.pPositions = pPositions;
+                    lodInput.positionStride = vertexStride;
+                    lodInput.pNormals = pNormals;
+                    lodInput.normalStride = vertexStride;
+
+                    std::vector<MeshSimplifier::Lod> lods;
+                    MeshSimplifier::generateLods(lodInput, MeshSimplifier::kImportLodCount, lods);
+                    std::vector<uint32_t> lodIndices;
+                    for(const auto& lod : lods)
+                    {
+                        lodIndices = lod.indices;
+                        if(optimizeMeshes)
+                        {
+                            MeshOptimizer::optimizeVertexCache(lod.indices.data(), lod.indices.size(), submeshVertexCount, lodIndices.data(), nullptr);
+                        }
+                        auto pLodIB = Buffer::create((uint32_t)(lodIndices.size() * sizeof(uint32_t)), Buffer::BindFlags::Index, Buffer::CpuAccess::None, lodIndices.data());
+                        pMesh->addLod(pLodIB, (uint32_t)lodIndices.size(), lod.error);
+                    }
+                }
 
                 if (version >= 6)
                 {
@@ -0,0 +1,367 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshOptimizer.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** FIFO vertex cache simulation. A vertex is cached if fewer than cacheSize misses happened since it was last loaded.
+        */
+        class FifoCache
+        {
+        public:
+            FifoCache(uint32_t vertexCount, uint32_t cacheSize) : mTimestamps(vertexCount, 0), mTime(cacheSize + 1), mCacheSize(cacheSize) {}
+
+            /** Process a vertex reference, returns true on a miss
+            */
+            bool access(uint32_t v)
+            {
+                if (mTime - mTimestamps[v] > mCacheSize)
+                {
+                    mTimestamps[v] = mTime++;
+                    return true;
+                }
+                return false;
+            }
+
+            /** Evict everything
+            */
+            void flush() { mTime += mCacheSize + 1; }
+
+        private:
+            std::vector<uint32_t> mTimestamps;
+            uint32_t mTime;
+            uint32_t mCacheSize;
+        };
+
+        /** Vertex to triangle adjacency in CSR form
+        */
+        struct Adjacency
+        {
+            std::vector<uint32_t> offsets;      // Triangles of vertex v are triangles[offsets[v]...offsets[v+1])
+            std::vector<uint32_t> triangles;
+
+            Adjacency(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount) : offsets(vertexCount + 1, 0), triangles(indexCount)
+            {
+                for (size_t i = 0; i < indexCount; i++) offsets[pIndices[i] + 1]++;
+                for (uint32_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+
+                std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indexCount; i++)
+                {
+                    triangles[fill[pIndices[i]]++] = (uint32_t)(i / 3);
+                }
+            }
+        };
+
+        vec3 loadPosition(const uint8_t* pPositions, uint32_t stride, uint32_t index)
+        {
+            vec3 p;
+            std::memcpy(&p, pPositions + (size_t)stride * index, sizeof(p));
+            return p;
+        }
+    }
+
+    VertexCacheStats MeshOptimizer::analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheStats stats;
+        if (indexCount < 3) return stats;
+
+        FifoCache cache(vertexCount, cacheSize);
+        std::vector<uint8_t> referenced(vertexCount, 0);
+        uint32_t misses = 0;
+        uint32_t referencedCount = 0;
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            uint32_t v = pIndices[i];
+            if (cache.access(v)) misses++;
+            if (referenced[v] == 0)
+            {
+                referenced[v] = 1;
+                referencedCount++;
+            }
+        }
+
+        stats.acmr = (float)misses / (float)(indexCount / 3);
+        stats.atvr = (float)misses / (float)referencedCount;
+        return stats;
+    }
+
+    void MeshOptimizer::optimizeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t* pResult, std::vector<uint32_t>* pClusters, uint32_t cacheSize)
+    {
+        assert(pIndices != pResult);
+        if (pClusters) pClusters->clear();
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0) return;
+
+        Adjacency adjacency(pIndices, indexCount, vertexCount);
+        std::vector<uint32_t> liveTriangles(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::vector<uint32_t> deadEnd;          // Recently referenced vertices, used to continue when the candidates run out
+        std::vector<uint32_t> candidates;
+        deadEnd.reserve(indexCount);
+
+        uint32_t time = cacheSize + 1;
+        uint32_t scanCursor = 0;                // Next vertex to consider when the dead-end stack is empty too
+        size_t outputIndex = 0;
+        int64_t fanVertex = 0;
+        if (pClusters) pClusters->push_back(0);
+
+        while (fanVertex >= 0)
+        {
+            // Emit all the remaining triangles around the fanning vertex
+            candidates.clear();
+            const uint32_t f = (uint32_t)fanVertex;
+            for (uint32_t a = adjacency.offsets[f]; a < adjacency.offsets[f + 1]; a++)
+            {
+                uint32_t t = adjacency.triangles[a];
+                if (emitted[t]) continue;
+                emitted[t] = 1;
+
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    uint32_t v = pIndices[t * 3 + c];
+                    pResult[outputIndex++] = v;
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    liveTriangles[v]--;
+                    if (time - cacheTime[v] > cacheSize)
+                    {
+                        cacheTime[v] = time++;
+                    }
+                }
+            }
+
+            // Pick the next fanning vertex among the candidates: the one that would stay in the cache longest while its remaining triangles are emitted
+            int64_t best = -1;
+            int64_t bestPriority = -1;
+            for (uint32_t v : candidates)
+            {
+                if (liveTriangles[v] == 0) continue;
+                int64_t priority = 0;
+                if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                {
+                    priority = time - cacheTime[v];
+                }
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    best = v;
+                }
+            }
+
+            if (best == -1)
+            {
+                // Dead end. Continue from the most recently referenced vertex which still has triangles, otherwise from the next vertex in input order.
+                while (deadEnd.empty() == false && best == -1)
+                {
+                    uint32_t v = deadEnd.back();
+                    deadEnd.pop_back();
+                    if (liveTriangles[v] > 0) best = v;
+                }
+                while (best == -1 && scanCursor < vertexCount)
+                {
+                    if (liveTriangles[scanCursor] > 0) best = scanCursor;
+                    scanCursor++;
+                }
+
+                // Restarting from a vertex which isn't in the cache starts a new cluster. The previous cluster can be empty when the first fanning vertex has no triangles, reuse it then.
+                if (best != -1 && pClusters && (time - cacheTime[(uint32_t)best] > cacheSize) && outputIndex < indexCount && outputIndex != pClusters->back())
+                {
+                    pClusters->push_back((uint32_t)outputIndex);
+                }
+            }
+            fanVertex = best;
+        }
+        assert(outputIndex == triangleCount * 3);
+    }
+
+    void MeshOptimizer::optimizeOverdraw(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, const uint8_t* pPositions, uint32_t positionStride, const std::vector<uint32_t>& clusters, float threshold, uint32_t cacheSize)
+    {
+        if (indexCount < 3 || clusters.empty()) return;
+
+        // Split the clusters into smaller pieces wherever the ACMR of the piece so far is within the threshold of the whole cluster's ACMR
+        std::vector<uint32_t> pieces;
+        FifoCache cache(vertexCount, cacheSize);
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            const uint32_t begin = clusters[c];
+            const uint32_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : (uint32_t)indexCount;
+
+            cache.flush();
+            uint32_t clusterMisses = 0;
+            for (uint32_t i = begin; i < end; i++)
+            {
+                clusterMisses += cache.access(pIndices[i]) ? 1 : 0;
+            }
+            const float maxAcmr = threshold * (float)clusterMisses / (float)((end - begin) / 3);
+
+            cache.flush();
+            pieces.push_back(begin);
+            uint32_t misses = 0;
+            uint32_t triangles = 0;
+            for (uint32_t i = begin; i < end; i += 3)
+            {
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    misses += cache.access(pIndices[i + k]) ? 1 : 0;
+                }
+                triangles++;
+
+                if ((i + 3 < end) && ((float)misses / (float)triangles <= maxAcmr))
+                {
+                    pieces.push_back(i + 3);
+                    cache.flush();
+                    misses = 0;
+                    triangles = 0;
+                }
+            }
+        }
+
+        // Sort the pieces by how much they face away from the mesh center. Pieces on the outside are drawn first and occlude the inner ones.
+        vec3 meshCentroid(0);
+        float meshArea = 0;
+        std::vector<float> sortKeys(pieces.size());
+        std::vector<vec3> centroids(pieces.size());
+        std::vector<vec3> normals(pieces.size());
+        for (size_t p = 0; p < pieces.size(); p++)
+        {
+            const uint32_t begin = pieces[p];
+            const uint32_t end = (p + 1 < pieces.size()) ? pieces[p + 1] : (uint32_t)indexCount;
+
+            vec3 centroid(0);
+            vec3 normal(0);
+            float area = 0;
+            for (uint32_t i = begin; i < end; i += 3)
+            {
+                vec3 p0 = loadPosition(pPositions, positionStride, pIndices[i]);
+                vec3 p1 = loadPosition(pPositions, positionStride, pIndices[i + 1]);
+                vec3 p2 = loadPosition(pPositions, positionStride, pIndices[i + 2]);
+                vec3 n = cross(p1 - p0, p2 - p0);
+                float a = length(n);
+                centroid += (p0 + p1 + p2) * (a / 3.0f);
+                normal += n;
+                area += a;
+            }
+            meshCentroid += centroid;
+            meshArea += area;
+            centroids[p] = (area > 0) ? centroid / area : vec3(0);
+            normals[p] = normal;
+        }
+        if (meshArea > 0) meshCentroid /= meshArea;
+
+        for (size_t p = 0; p < pieces.size(); p++)
+        {
+            float normalLength = length(normals[p]);
+            sortKeys[p] = (normalLength > 0) ? dot(centroids[p] - meshCentroid, normals[p] / normalLength) : 0.0f;
+        }
+
+        std::vector<uint32_t> order(pieces.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> source(pIndices, pIndices + indexCount);
+        size_t outputIndex = 0;
+        for (uint32_t p : order)
+        {
+            const uint32_t begin = pieces[p];
+            const uint32_t end = (p + 1 < pieces.size()) ? pieces[p + 1] : (uint32_t)indexCount;
+            std::memcpy(pIndices + outputIndex, source.data() + begin, (end - begin) * sizeof(uint32_t));
+            outputIndex += end - begin;
+        }
+    }
+
+    uint32_t MeshOptimizer::optimizeVertexFetch(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap)
+    {
+        remap.assign(vertexCount, uint32_t(kUnusedVertex));
+        uint32_t nextVertex = 0;
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            uint32_t& newIndex = remap[pIndices[i]];
+            if (newIndex == kUnusedVertex)
+            {
+                newIndex = nextVertex++;
+            }
+            pIndices[i] = newIndex;
+        }
+        return nextVertex;
+    }
+
+    void MeshOptimizer::remapVertices(const void* pSrc, uint32_t stride, const std::vector<uint32_t>& remap, void* pDst)
+    {
+        const uint8_t* pSrcBytes = (const uint8_t*)pSrc;
+        uint8_t* pDstBytes = (uint8_t*)pDst;
+        for (size_t v = 0; v < remap.size(); v++)
+        {
+            if (remap[v] != kUnusedVertex)
+            {
+                std::memcpy(pDstBytes + (size_t)remap[v] * stride, pSrcBytes + v * stride, stride);
+            }
+        }
+    }
+
+    bool MeshOptimizer::optimize(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, const uint8_t* pPositions, uint32_t positionStride, Result& result)
+    {
+        if ((indexCount % 3) != 0 || indexCount > UINT32_MAX) return false;
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            if (pIndices[i] >= vertexCount) return false;
+        }
+
+        result.before = analyzeVertexCache(pIndices, indexCount, vertexCount);
+
+        std::vector<uint32_t> clusters;
+        result.indices.resize(indexCount);
+        optimizeVertexCache(pIndices, indexCount, vertexCount, result.indices.data(), &clusters);
+        optimizeOverdraw(result.indices.data(), indexCount, vertexCount, pPositions, positionStride, clusters);
+        result.vertexCount = optimizeVertexFetch(result.indices.data(), indexCount, vertexCount, result.remap);
+
+        result.after = analyzeVertexCache(result.indices.data(), indexCount, result.vertexCount);
+        return true;
+    }
+
+    const std::string to_string(const MeshOptimizer::Result& result)
+    {
+        char str[128];
+        std::snprintf(str, sizeof(str), "ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", result.before.acmr, result.after.acmr, result.before.atvr, result.after.atvr);
+        return str;
+    }
+}
@@ -0,0 +1,120 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+    /** Post-transform vertex cache efficiency of a triangle list, measured by simulating a FIFO cache
+    */
+    struct VertexCacheStats
+    {
+        float acmr = 0;     ///< Average cache miss ratio - vertex shader invocations per triangle. Between 0.5 for large regular grids and 3
+        float atvr = 0;     ///< Average transform to vertex ratio - vertex shader invocations per referenced vertex. 1 is optimal
+    };
+
+    /** Import-time mesh optimization: triangle reordering for the post-transform vertex cache and for overdraw, followed by vertex reordering for fetch locality
+    */
+    class MeshOptimizer
+    {
+    public:
+        /** Size of the simulated FIFO vertex cache
+        */
+        static const uint32_t kCacheSize = 16;
+
+        /** How much worse than the vertex-cache-optimal order a cluster's ACMR may become to allow finer overdraw sorting
+        */
+        static constexpr float kOverdrawThreshold = 1.05f;
+
+        /** Value of remap table entries for vertices which aren't referenced by any triangle
+        */
+        static const uint32_t kUnusedVertex = uint32_t(-1);
+
+        /** Result of optimize()
+        */
+        struct Result
+        {
+            std::vector<uint32_t> indices;  ///< The optimized triangle list, indexing the remapped vertices
+            std::vector<uint32_t> remap;    ///< Maps every original vertex to its new location, or to kUnusedVertex if it was dropped
+            uint32_t vertexCount = 0;       ///< Number of vertices after remapping
+            VertexCacheStats before;        ///< Statistics of the original index order
+            VertexCacheStats after;         ///< Statistics of the optimized index order
+        };
+
+        /** Run the full pipeline on a triangle list: vertex cache reordering, overdraw-aware cluster ordering and vertex fetch remapping.
+            \param[in] pIndices Triangle list indices
+            \param[in] indexCount Number of indices. Must be a multiple of 3
+            \param[in] vertexCount Number of vertices
+            \param[in] pPositions float3 positions, used to order clusters by their facing
+            \param[in] positionStride Distance in bytes between consecutive positions
+            \param[out] result The optimized mesh. Apply result.remap to the vertex data with remapVertices()
+            \return false if the index buffer can't be optimized (it isn't a triangle list or references vertices out of range), otherwise true
+        */
+        static bool optimize(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, const uint8_t* pPositions, uint32_t positionStride, Result& result);
+
+        /** Simulate a FIFO vertex cache over a triangle list
+        */
+        static VertexCacheStats analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = kCacheSize);
+
+        /** Reorder triangles for vertex cache locality, using Tipsify ("Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", Sander et al. 2007).
+            \param[in] pIndices Triangle list indices
+            \param[in] indexCount Number of indices
+            \param[in] vertexCount Number of vertices
+            \param[out] pResult Receives the reordered indices. Must not alias pIndices
+            \param[out] pClusters Optional. Receives the first index of every cluster - the places where the algorithm couldn't continue from the cache contents
+        */
+        static void optimizeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, uint32_t* pResult, std::vector<uint32_t>* pClusters, uint32_t cacheSize = kCacheSize);
+
+        /** Reorder the clusters of a vertex-cache-optimized triangle list so that outward-facing clusters are drawn first.
+            Clusters are first split further, as long as the ACMR of the pieces stays within threshold of the whole cluster's.
+            \param[in,out] pIndices Triangle list indices, as returned by optimizeVertexCache()
+            \param[in] clusters Cluster start indices, as returned by optimizeVertexCache()
+        */
+        static void optimizeOverdraw(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, const uint8_t* pPositions, uint32_t positionStride, const std::vector<uint32_t>& clusters, float threshold = kOverdrawThreshold, uint32_t cacheSize = kCacheSize);
+
+        /** Number vertices in the order the triangle list first references them, and rewrite the indices accordingly.
+            \param[in,out] pIndices Triangle list indices
+            \param[out] remap Receives the new location of every vertex, or kUnusedVertex for vertices which aren't referenced
+            \return The number of referenced vertices
+        */
+        static uint32_t optimizeVertexFetch(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap);
+
+        /** Reorder a vertex stream according to a remap table. Unused vertices are dropped.
+            \param[in] pSrc Source vertices
+            \param[in] stride Size of a vertex in bytes
+            \param[in] remap The remap table
+            \param[out] pDst Destination. Must have room for the remapped vertex count and must not alias pSrc
+        */
+        static void remapVertices(const void* pSrc, uint32_t stride, const std::vector<uint32_t>& remap, void* pDst);
+    };
+
+    /** Format the before and after statistics of an optimization for logging
+    */
+    const std::string to_string(const MeshOptimizer::Result& result);
+}
@@ -0,0 +1,513 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshSimplifier.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace Falcor
+{
+    namespace
+    {
+        const float kMinNormalDot = 0.7f;           // Only collapse vertices whose normals are less than ~45 degrees apart
+        const float kMaxBoneWeightDelta = 0.25f;    // Maximum L1 distance between the bone weights of collapsed vertices
+        const float kMinFlipCos = 0.25f;            // Reject collapses which rotate a triangle by more than ~75 degrees
+        const double kBorderWeight = 10.0;          // Weight of the planes which keep open borders in place
+
+        /** Symmetric 4x4 matrix of the plane equations, plus the total weight of the planes
+        */
+        struct Quadric
+        {
+            double a2 = 0, ab = 0, ac = 0, ad = 0;
+            double b2 = 0, bc = 0, bd = 0;
+            double c2 = 0, cd = 0;
+            double d2 = 0;
+            double weight = 0;
+
+            Quadric() = default;
+            Quadric(const vec3& n, float d, double w)
+            {
+                const double a = n.x, b = n.y, c = n.z;
+                a2 = a * a * w; ab = a * b * w; ac = a * c * w; ad = a * d * w;
+                b2 = b * b * w; bc = b * c * w; bd = b * d * w;
+                c2 = c * c * w; cd = c * d * w;
+                d2 = (double)d * d * w;
+                weight = w;
+            }
+
+            Quadric& operator+=(const Quadric& q)
+            {
+                a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+                b2 += q.b2; bc += q.bc; bd += q.bd;
+                c2 += q.c2; cd += q.cd;
+                d2 += q.d2;
+                weight += q.weight;
+                return *this;
+            }
+
+            /** Weighted mean of the squared distances of p from the planes
+            */
+            double evaluate(const vec3& p) const
+            {
+                const double x = p.x, y = p.y, z = p.z;
+                double e = a2 * x * x + b2 * y * y + c2 * z * z + 2 * (ab * x * y + ac * x * z + bc * y * z) + 2 * (ad * x + bd * y + cd * z) + d2;
+                return (weight > 0) ? std::abs(e) / weight : 0;
+            }
+        };
+
+        enum class VertexKind : uint8_t
+        {
+            Manifold,   // Can collapse into any neighbor
+            Border,     // On an open border, can only collapse along it
+            Locked,     // Shares its position with other vertices, or is on a non-manifold or complex edge
+        };
+
+        struct Collapse
+        {
+            uint32_t from;
+            uint32_t to;
+            double cost;
+        };
+
+        uint64_t packEdge(uint32_t a, uint32_t b)
+        {
+            return (a < b) ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+        }
+
+        template<typename T>
+        T loadElement(const uint8_t* pStream, uint32_t stride, uint32_t index)
+        {
+            T val;
+            std::memcpy(&val, pStream + (size_t)stride * index, sizeof(T));
+            return val;
+        }
+
+        /** Pass-based edge collapse. Every pass evaluates all the edges, then performs the cheapest collapses which don't touch each other.
+            The quadrics are kept between calls to run(), so errors are always measured against the original mesh.
+        */
+        class Simplifier
+        {
+        public:
+            Simplifier(const MeshSimplifier::Input& input);
+
+            /** Simplify the current index buffer
+                \return The error of the most expensive collapse performed so far
+            */
+            float run(size_t targetIndexCount, float maxError);
+
+            const std::vector<uint32_t>& getIndices() const { return mIndices; }
+
+        private:
+            bool canCollapse(uint32_t from, uint32_t to, bool borderEdge) const;
+            bool flipsTriangles(uint32_t from, uint32_t to) const;
+            void buildAdjacency();
+
+            const MeshSimplifier::Input& mInput;
+            std::vector<uint32_t> mIndices;
+            std::vector<vec3> mPositions;
+            std::vector<uint32_t> mPositionIds;     // Vertices at the same position share an ID
+            std::vector<VertexKind> mKinds;
+            std::vector<Quadric> mQuadrics;
+            double mMaxCost = 0;
+
+            // Per-pass data
+            std::vector<uint32_t> mAdjacencyOffsets;
+            std::vector<uint32_t> mAdjacency;
+            std::vector<uint64_t> mPositionEdges;   // Sorted, with duplicates. An edge which appears once is on the border.
+        };
+
+        Simplifier::Simplifier(const MeshSimplifier::Input& input) : mInput(input)
+        {
+            const uint32_t vertexCount = input.vertexCount;
+            mPositions.resize(vertexCount);
+            for (uint32_t v = 0; v < vertexCount; v++)
+            {
+                mPositions[v] = loadElement<vec3>(input.pPositions, input.positionStride, v);
+            }
+
+            // Drop degenerate triangles
+            mIndices.reserve(input.indexCount);
+            for (size_t i = 0; i + 2 < input.indexCount; i += 3)
+            {
+                const uint32_t* pTri = input.pIndices + i;
+                if (pTri[0] != pTri[1] && pTri[1] != pTri[2] && pTri[0] != pTri[2])
+                {
+                    mIndices.insert(mIndices.end(), pTri, pTri + 3);
+                }
+            }
+
+            // Weld the positions
+            struct PositionKey
+            {
+                uint32_t bits[3];
+                bool operator==(const PositionKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+            };
+            struct PositionKeyHash
+            {
+                size_t operator()(const PositionKey& key) const { return (size_t)key.bits[0] * 73856093u ^ (size_t)key.bits[1] * 19349663u ^ (size_t)key.bits[2] * 83492791u; }
+            };
+            std::unordered_map<PositionKey, uint32_t, PositionKeyHash> positionMap;
+            positionMap.reserve(vertexCount);
+            std::vector<uint32_t> verticesPerPosition;
+            mPositionIds.resize(vertexCount);
+            for (uint32_t v = 0; v < vertexCount; v++)
+            {
+                PositionKey key;
+                std::memcpy(key.bits, &mPositions[v], sizeof(key.bits));
+                auto it = positionMap.emplace(key, (uint32_t)verticesPerPosition.size()).first;
+                if (it->second == verticesPerPosition.size()) verticesPerPosition.push_back(0);
+                mPositionIds[v] = it->second;
+                verticesPerPosition[it->second]++;
+            }
+
+            // Classify the vertices. Border and non-manifold edges are found in position space, so that seams don't look like borders.
+            buildAdjacency();
+            std::vector<uint32_t> borderEdgesPerPosition(verticesPerPosition.size(), 0);
+            std::vector<bool> lockedPositions(verticesPerPosition.size(), false);
+            for (size_t i = 0; i < mPositionEdges.size();)
+            {
+                size_t run = 1;
+                while (i + run < mPositionEdges.size() && mPositionEdges[i + run] == mPositionEdges[i]) run++;
+                uint32_t a = (uint32_t)(mPositionEdges[i] >> 32);
+                uint32_t b = (uint32_t)mPositionEdges[i];
+                if (run == 1)
+                {
+                    borderEdgesPerPosition[a]++;
+                    borderEdgesPerPosition[b]++;
+                }
+                else if (run > 2)
+                {
+                    lockedPositions[a] = lockedPositions[b] = true;
+                }
+                i += run;
+            }
+
+            mKinds.resize(vertexCount);
+            for (uint32_t v = 0; v < vertexCount; v++)
+            {
+                uint32_t p = mPositionIds[v];
+                if (lockedPositions[p] || verticesPerPosition[p] > 1 || borderEdgesPerPosition[p] > 2)
+                {
+                    mKinds[v] = VertexKind::Locked;
+                }
+                else
+                {
+                    mKinds[v] = (borderEdgesPerPosition[p] != 0) ? VertexKind::Border : VertexKind::Manifold;
+                }
+            }
+
+            // Area-weighted triangle planes, and planes perpendicular to the border edges to keep the borders in place
+            mQuadrics.resize(vertexCount);
+            for (size_t i = 0; i < mIndices.size(); i += 3)
+            {
+                const uint32_t* pTri = &mIndices[i];
+                vec3 n = cross(mPositions[pTri[1]] - mPositions[pTri[0]], mPositions[pTri[2]] - mPositions[pTri[0]]);
+                float length2 = dot(n, n);
+                if (length2 == 0) continue;
+                float area = std::sqrt(length2);
+                n = n / area;
+                Quadric q(n, -dot(n, mPositions[pTri[0]]), area * 0.5);
+                for (uint32_t c = 0; c < 3; c++) mQuadrics[pTri[c]] += q;
+
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    uint32_t a = pTri[c];
+                    uint32_t b = pTri[(c + 1) % 3];
+                    uint64_t edge = packEdge(mPositionIds[a], mPositionIds[b]);
+                    auto range = std::equal_range(mPositionEdges.begin(), mPositionEdges.end(), edge);
+                    if (range.second - range.first != 1) continue;
+
+                    vec3 edgeDir = mPositions[b] - mPositions[a];
+                    float edgeLength2 = dot(edgeDir, edgeDir);
+                    if (edgeLength2 == 0) continue;
+                    vec3 m = normalize(cross(edgeDir, n));
+                    Quadric border(m, -dot(m, mPositions[a]), edgeLength2 * kBorderWeight);
+                    mQuadrics[a] += border;
+                    mQuadrics[b] += border;
+                }
+            }
+        }
+
+        void Simplifier::buildAdjacency()
+        {
+            const uint32_t vertexCount = mInput.vertexCount;
+            mAdjacencyOffsets.assign(vertexCount + 1, 0);
+            for (uint32_t v : mIndices) mAdjacencyOffsets[v + 1]++;
+            for (uint32_t v = 0; v < vertexCount; v++) mAdjacencyOffsets[v + 1] += mAdjacencyOffsets[v];
+
+            mAdjacency.resize(mIndices.size());
+            std::vector<uint32_t> fill(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < mIndices.size(); i++)
+            {
+                mAdjacency[fill[mIndices[i]]++] = (uint32_t)(i / 3);
+            }
+
+            mPositionEdges.resize(mIndices.size());
+            for (size_t i = 0; i < mIndices.size(); i += 3)
+            {
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    mPositionEdges[i + c] = packEdge(mPositionIds[mIndices[i + c]], mPositionIds[mIndices[i + (c + 1) % 3]]);
+                }
+            }
+            std::sort(mPositionEdges.begin(), mPositionEdges.end());
+        }
+
+        bool Simplifier::canCollapse(uint32_t from, uint32_t to, bool borderEdge) const
+        {
+            switch (mKinds[from])
+            {
+            case VertexKind::Locked:
+                return false;
+            case VertexKind::Border:
+                if (borderEdge == false) return false;
+                break;
+            default:
+                break;
+            }
+
+            if (mInput.pNormals)
+            {
+                vec3 n0 = loadElement<vec3>(mInput.pNormals, mInput.normalStride, from);
+                vec3 n1 = loadElement<vec3>(mInput.pNormals, mInput.normalStride, to);
+                float lengths = std::sqrt(dot(n0, n0) * dot(n1, n1));
+                if (dot(n0, n1) < kMinNormalDot * lengths) return false;
+            }
+
+            if (mInput.pBoneIds)
+            {
+                uint8_t ids[2][4];
+                vec4 weights[2];
+                std::memcpy(ids[0], mInput.pBoneIds + (size_t)mInput.boneIdStride * from, 4);
+                std::memcpy(ids[1], mInput.pBoneIds + (size_t)mInput.boneIdStride * to, 4);
+                weights[0] = loadElement<vec4>(mInput.pBoneWeights, mInput.boneWeightStride, from);
+                weights[1] = loadElement<vec4>(mInput.pBoneWeights, mInput.boneWeightStride, to);
+
+                // L1 distance between the influences. Bones only one of the vertices uses count with their full weight.
+                float delta = 0;
+                for (uint32_t s = 0; s < 2; s++)
+                {
+                    const uint32_t o = 1 - s;
+                    for (uint32_t i = 0; i < 4; i++)
+                    {
+                        if (weights[s][i] == 0) continue;
+                        float other = 0;
+                        for (uint32_t j = 0; j < 4; j++)
+                        {
+                            if (ids[o][j] == ids[s][i]) other += weights[o][j];
+                        }
+                        // Shared bones are visited from both sides, so each side adds half of the difference
+                        delta += (other == 0) ? weights[s][i] : std::abs(weights[s][i] - other) * 0.5f;
+                    }
+                }
+                if (delta > kMaxBoneWeightDelta) return false;
+            }
+            return true;
+        }
+
+        bool Simplifier::flipsTriangles(uint32_t from, uint32_t to) const
+        {
+            for (uint32_t a = mAdjacencyOffsets[from]; a < mAdjacencyOffsets[from + 1]; a++)
+            {
+                const uint32_t* pTri = &mIndices[mAdjacency[a] * 3];
+                if (pTri[0] == to || pTri[1] == to || pTri[2] == to) continue;   // Removed by the collapse
+
+                vec3 p[3];
+                for (uint32_t c = 0; c < 3; c++) p[c] = mPositions[pTri[c]];
+                vec3 oldNormal = cross(p[1] - p[0], p[2] - p[0]);
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    if (pTri[c] == from) p[c] = mPositions[to];
+                }
+                vec3 newNormal = cross(p[1] - p[0], p[2] - p[0]);
+                float lengths = std::sqrt(dot(oldNormal, oldNormal) * dot(newNormal, newNormal));
+                if (dot(oldNormal, newNormal) <= kMinFlipCos * lengths) return true;
+            }
+            return false;
+        }
+
+        float Simplifier::run(size_t targetIndexCount, float maxError)
+        {
+            const double maxCost = (double)maxError * maxError;
+            std::vector<uint64_t> edges;
+            std::vector<Collapse> collapses;
+            std::vector<uint32_t> remap(mInput.vertexCount);
+            std::vector<uint8_t> touched(mInput.vertexCount);
+
+            while (mIndices.size() > targetIndexCount)
+            {
+                buildAdjacency();
+
+                // Find the cheapest direction of every edge
+                edges.resize(mIndices.size());
+                for (size_t i = 0; i < mIndices.size(); i += 3)
+                {
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        edges[i + c] = packEdge(mIndices[i + c], mIndices[i + (c + 1) % 3]);
+                    }
+                }
+                std::sort(edges.begin(), edges.end());
+                edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+                collapses.clear();
+                for (uint64_t edge : edges)
+                {
+                    const uint32_t v[2] = { (uint32_t)(edge >> 32), (uint32_t)edge };
+                    uint64_t positionEdge = packEdge(mPositionIds[v[0]], mPositionIds[v[1]]);
+                    auto range = std::equal_range(mPositionEdges.begin(), mPositionEdges.end(), positionEdge);
+                    const bool borderEdge = (range.second - range.first) == 1;
+
+                    Collapse best = { 0, 0, -1.0 };
+                    for (uint32_t d = 0; d < 2; d++)
+                    {
+                        uint32_t from = v[d];
+                        uint32_t to = v[1 - d];
+                        if (canCollapse(from, to, borderEdge) == false) continue;
+
+                        Quadric q = mQuadrics[from];
+                        q += mQuadrics[to];
+                        double cost = q.evaluate(mPositions[to]);
+                        if (best.cost < 0 || cost < best.cost) best = { from, to, cost };
+                    }
+                    if (best.cost >= 0 && best.cost <= maxCost) collapses.push_back(best);
+                }
+
+                std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+                {
+                    if (a.cost != b.cost) return a.cost < b.cost;
+                    return (a.from != b.from) ? (a.from < b.from) : (a.to < b.to);
+                });
+
+                // Perform the collapses in order. A collapse changes the triangles around its source vertex, so their vertices can't take part in another collapse in this pass.
+                for (uint32_t v = 0; v < mInput.vertexCount; v++) remap[v] = v;
+                std::fill(touched.begin(), touched.end(), 0);
+                size_t indexCount = mIndices.size();
+                uint32_t collapseCount = 0;
+                for (const Collapse& c : collapses)
+                {
+                    if (indexCount <= targetIndexCount) break;
+                    if (touched[c.from] || touched[c.to]) continue;
+                    if (flipsTriangles(c.from, c.to)) continue;
+
+                    for (uint32_t a = mAdjacencyOffsets[c.from]; a < mAdjacencyOffsets[c.from + 1]; a++)
+                    {
+                        const uint32_t* pTri = &mIndices[mAdjacency[a] * 3];
+                        if (pTri[0] == c.to || pTri[1] == c.to || pTri[2] == c.to) indexCount -= 3;
+                        for (uint32_t k = 0; k < 3; k++) touched[pTri[k]] = 1;
+                    }
+
+                    remap[c.from] = c.to;
+                    mQuadrics[c.to] += mQuadrics[c.from];
+                    mMaxCost = std::max(mMaxCost, c.cost);
+                    collapseCount++;
+                }
+
+                if (collapseCount == 0) break;
+
+                size_t writeIndex = 0;
+                for (size_t i = 0; i < mIndices.size(); i += 3)
+                {
+                    uint32_t a = remap[mIndices[i]];
+                    uint32_t b = remap[mIndices[i + 1]];
+                    uint32_t c = remap[mIndices[i + 2]];
+                    if (a != b && b != c && a != c)
+                    {
+                        mIndices[writeIndex++] = a;
+                        mIndices[writeIndex++] = b;
+                        mIndices[writeIndex++] = c;
+                    }
+                }
+                mIndices.resize(writeIndex);
+            }
+
+            return (float)std::sqrt(mMaxCost);
+        }
+
+        bool isValidInput(const MeshSimplifier::Input& input)
+        {
+            if (input.pPositions == nullptr || (input.pBoneIds && input.pBoneWeights == nullptr)) return false;
+            for (size_t i = 0; i < input.indexCount; i++)
+            {
+                if (input.pIndices[i] >= input.vertexCount) return false;
+            }
+            return true;
+        }
+    }
+
+    void MeshSimplifier::simplify(const Input& input, size_t targetIndexCount, float maxError, Lod& lod)
+    {
+        if (isValidInput(input) == false)
+        {
+            lod.indices.assign(input.pIndices, input.pIndices + input.indexCount);
+            lod.error = 0;
+            return;
+        }
+
+        Simplifier simplifier(input);
+        lod.error = simplifier.run(targetIndexCount, maxError);
+        lod.indices = simplifier.getIndices();
+    }
+
+    void MeshSimplifier::generateLods(const Input& input, uint32_t maxLodCount, std::vector<Lod>& lods)
+    {
+        lods.clear();
+        if (input.indexCount < 3 || isValidInput(input) == false) return;
+
+        vec3 boxMin = loadElement<vec3>(input.pPositions, input.positionStride, input.pIndices[0]);
+        vec3 boxMax = boxMin;
+        for (size_t i = 1; i < input.indexCount; i++)
+        {
+            vec3 p = loadElement<vec3>(input.pPositions, input.positionStride, input.pIndices[i]);
+            boxMin = min(boxMin, p);
+            boxMax = max(boxMax, p);
+        }
+        const float maxError = length(boxMax - boxMin) * kMaxRelativeLodError;
+
+        // Every LOD continues from the previous one, with the quadrics accumulated from the original mesh
+        Simplifier simplifier(input);
+        size_t indexCount = input.indexCount;
+        for (uint32_t i = 0; i < maxLodCount; i++)
+        {
+            size_t target = (size_t)(indexCount / 3 * kLodReduction) * 3;
+            float error = simplifier.run(target, maxError);
+
+            // Stop when the error bound doesn't allow a meaningful reduction anymore
+            const std::vector<uint32_t>& indices = simplifier.getIndices();
+            if (indices.empty() || indices.size() > indexCount - indexCount / 10) break;
+
+            lods.emplace_back();
+            lods.back().indices = indices;
+            lods.back().error = error;
+            indexCount = indices.size();
+        }
+    }
+}
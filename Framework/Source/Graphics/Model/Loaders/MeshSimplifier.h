@@ -0,0 +1,93 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+
+namespace Falcor
+{
+    /** Import-time mesh simplification by quadric error metric edge collapse ("Surface Simplification Using Quadric Error Metrics", Garland and Heckbert 1997).
+        Uses half-edge collapses, so the simplified index buffers reference a subset of the original vertices and share the mesh's vertex buffers. Attributes are never interpolated.
+        Vertices which share a position with other vertices (UV seams, hard normal edges) are locked, vertices on open borders only move along the border, and collapses are rejected if they flip triangles, bend the normals too much or change the bone influences.
+    */
+    class MeshSimplifier
+    {
+    public:
+        /** The mesh to simplify. The attribute streams are strided and don't have to be aligned.
+        */
+        struct Input
+        {
+            const uint32_t* pIndices = nullptr;     ///< Triangle list indices
+            size_t indexCount = 0;                  ///< Number of indices
+            uint32_t vertexCount = 0;               ///< Number of vertices
+            const uint8_t* pPositions = nullptr;    ///< float3 positions
+            uint32_t positionStride = 0;
+            const uint8_t* pNormals = nullptr;      ///< Optional float3 normals
+            uint32_t normalStride = 0;
+            const uint8_t* pBoneIds = nullptr;      ///< Optional 4 x uint8 bone IDs
+            uint32_t boneIdStride = 0;
+            const uint8_t* pBoneWeights = nullptr;  ///< Optional float4 bone weights. Required if pBoneIds is set
+            uint32_t boneWeightStride = 0;
+        };
+
+        /** A simplified index buffer
+        */
+        struct Lod
+        {
+            std::vector<uint32_t> indices;
+            float error = 0;                        ///< Estimated distance between the simplified and the original surface, in object space units
+        };
+
+        /** Factor by which each LOD reduces the triangle count of the previous one
+        */
+        static constexpr float kLodReduction = 0.5f;
+
+        /** Largest error a generated LOD may have, relative to the diagonal of the mesh's bounding-box
+        */
+        static constexpr float kMaxRelativeLodError = 0.05f;
+
+        /** Number of LODs the model importers generate per mesh, not including the original mesh
+        */
+        static constexpr uint32_t kImportLodCount = 6;
+
+        /** Simplify a mesh
+            \param[in] input The mesh
+            \param[in] targetIndexCount Stop once the index count drops to this value
+            \param[in] maxError Don't perform collapses with a larger error, in object space units
+            \param[out] lod The simplified index buffer and its error
+        */
+        static void simplify(const Input& input, size_t targetIndexCount, float maxError, Lod& lod);
+
+        /** Generate a chain of LODs. Each LOD simplifies the previous one to kLodReduction of its triangles.
+            Generation stops when a LOD can't be reduced significantly within the error bound, so fewer than maxLodCount LODs may be returned.
+            \param[in] input The mesh
+            \param[in] maxLodCount Maximum number of LODs to generate, not including the original mesh
+            \param[out] lods The LODs, from finest to coarsest. Errors are measured against the original mesh.
+        */
+        static void generateLods(const Input& input, uint32_t maxLodCount, std::vector<Lod>& lods);
+    };
+}
@@ -0,0 +1,372 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ModelCacheExporter.h"
+#include "Graphics/Model/Animation.h"
+#include "Graphics/Model/AnimationController.h"
+#include "API/Buffer.h"
+#include "API/Device.h"
+#include "API/Texture.h"
+#include "API/VertexLayout.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/Lz4.h"
+#include "Utils/TaskScheduler.h"
+#include <cstdio>
+
+namespace Falcor
+{
+    using namespace ModelCache;
+
+    bool ModelCacheExporter::exportToFile(const std::string& filename, const Model* pModel, Model::LoadFlags flags, int64_t sourceModifiedTime, bool compress)
+    {
+        ModelCacheExporter exporter(pModel);
+        if (exporter.writeMaterials() == false) return false;
+        if (exporter.writeMeshes() == false) return false;
+        if (exporter.readBackBuffers() == false) return false;
+        if (exporter.writeAnimation() == false) return false;
+        return exporter.writeFile(filename, flags, sourceModifiedTime, compress);
+    }
+
+    ModelCacheExporter::ModelCacheExporter(const Model* pModel) : mpModel(pModel)
+    {
+    }
+
+    int32_t ModelCacheExporter::addTexture(const Texture* pTexture)
+    {
+        if (pTexture == nullptr) return -1;
+
+        auto it = mTextureIds.find(pTexture);
+        if (it != mTextureIds.end()) return it->second;
+
+        if (pTexture->getType() != Texture::Type::Texture2D)
+        {
+            logWarning("Model cache only supports 2D textures. Texture '" + pTexture->getSourceFilename() + "' won't be cached.");
+            mTextureIds[pTexture] = -1;
+            return -1;
+        }
+
+        ChunkWriter writer;
+        writer << pTexture->getWidth() << pTexture->getHeight() << pTexture->getArraySize() << pTexture->getMipCount() << (uint32_t)pTexture->getFormat();
+        writer.writeString(pTexture->getSourceFilename());
+
+        // Store the whole mip-chain, so that loading doesn't have to generate it
+        RenderContext* pContext = gpDevice->getRenderContext().get();
+        for (uint32_t slice = 0; slice < pTexture->getArraySize(); slice++)
+        {
+            for (uint32_t mip = 0; mip < pTexture->getMipCount(); mip++)
+            {
+                std::vector<uint8_t> data = pContext->readTextureSubresource(pTexture, pTexture->getSubresourceIndex(slice, mip));
+                writer.write(data.data(), data.size());
+            }
+        }
+
+        int32_t id = (int32_t)mTextureIds.size();
+        mTextureIds[pTexture] = id;
+        mChunks.push_back({ ChunkType::Texture, writer.getData() });
+        return id;
+    }
+
+    uint32_t ModelCacheExporter::addBuffer(const Buffer* pBuffer)
+    {
+        if (pBuffer == nullptr) return kInvalidIndex;
+
+        auto it = mBufferIds.find(pBuffer);
+        if (it != mBufferIds.end()) return it->second;
+
+        // The contents are appended by readBackBuffers()
+        ChunkWriter writer;
+        writer << (uint32_t)pBuffer->getBindFlags();
+        mPendingBuffers.push_back({ pBuffer, mChunks.size() });
+
+        uint32_t id = (uint32_t)mBufferIds.size();
+        mBufferIds[pBuffer] = id;
+        mChunks.push_back({ ChunkType::Buffer, writer.getData() });
+        return id;
+    }
+
+    bool ModelCacheExporter::readBackBuffers()
+    {
+        if (mPendingBuffers.empty()) return true;
+
+        // Copy all the buffers into a single temporary staging buffer, so that reading them back takes one flush and doesn't leave a staging resource attached to each buffer
+        std::vector<uint64_t> offsets(mPendingBuffers.size());
+        uint64_t stagingSize = 0;
+        for (size_t i = 0; i < mPendingBuffers.size(); i++)
+        {
+            offsets[i] = stagingSize;
+            stagingSize += align_to(16, mPendingBuffers[i].pBuffer->getSize());
+        }
+
+        Buffer::SharedPtr pStaging = Buffer::create(stagingSize, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+        if (pStaging == nullptr)
+        {
+            logWarning("Model cache can't allocate a " + std::to_string(stagingSize) + " bytes staging buffer");
+            return false;
+        }
+
+        RenderContext* pContext = gpDevice->getRenderContext().get();
+        for (size_t i = 0; i < mPendingBuffers.size(); i++)
+        {
+            const Buffer* pBuffer = mPendingBuffers[i].pBuffer;
+            pContext->copyBufferRegion(pStaging.get(), offsets[i], pBuffer, 0, pBuffer->getSize());
+        }
+        pContext->flush(true);
+
+        const uint8_t* pData = (const uint8_t*)pStaging->map(Buffer::MapType::Read);
+        for (size_t i = 0; i < mPendingBuffers.size(); i++)
+        {
+            std::vector<uint8_t>& chunkData = mChunks[mPendingBuffers[i].chunkIndex].data;
+            const uint8_t* pBufferData = pData + offsets[i];
+            chunkData.insert(chunkData.end(), pBufferData, pBufferData + mPendingBuffers[i].pBuffer->getSize());
+        }
+        pStaging->unmap();
+        mPendingBuffers.clear();
+        return true;
+    }
+
+    bool ModelCacheExporter::writeMaterials()
+    {
+        ChunkWriter writer;
+        std::vector<const Material*> materials;
+        for (uint32_t meshID = 0; meshID < mpModel->getMeshCount(); meshID++)
+        {
+            const Material* pMaterial = mpModel->getMesh(meshID)->getMaterial().get();
+            if (mMaterialIds.emplace(pMaterial, (uint32_t)materials.size()).second)
+            {
+                materials.push_back(pMaterial);
+            }
+        }
+
+        writer << (uint32_t)materials.size();
+        for (const Material* pMaterial : materials)
+        {
+            writer.writeString(pMaterial->getName());
+            writer << pMaterial->getNumLayers();
+            for (uint32_t i = 0; i < pMaterial->getNumLayers(); i++)
+            {
+                Material::Layer layer = pMaterial->getLayer(i);
+                writer << (uint32_t)layer.type << (uint32_t)layer.ndf << (uint32_t)layer.blend;
+                writer << layer.albedo << layer.roughness << layer.extraParam << layer.pmf;
+                writer << addTexture(layer.pTexture.get());
+            }
+            writer << addTexture(pMaterial->getNormalMap().get());
+            writer << addTexture(pMaterial->getAlphaMap().get());
+            writer << addTexture(pMaterial->getAmbientOcclusionMap().get());
+            writer << addTexture(pMaterial->getHeightMap().get());
+            writer << pMaterial->getHeightModifiers() << pMaterial->getAlphaThreshold() << (uint32_t)(pMaterial->isDoubleSided() ? 1 : 0);
+        }
+
+        mChunks.push_back({ ChunkType::Materials, writer.getData() });
+        return true;
+    }
+
+    void ModelCacheExporter::writeVertexLayout(ChunkWriter& writer, const VertexLayout* pLayout)
+    {
+        writer << (uint32_t)pLayout->getBufferCount();
+        for (size_t b = 0; b < pLayout->getBufferCount(); b++)
+        {
+            const VertexBufferLayout* pBufferLayout = pLayout->getBufferLayout(b).get();
+            if (pBufferLayout == nullptr)
+            {
+                writer << (uint32_t)VertexBufferLayout::InputClass::PerVertexData << (uint32_t)0 << (uint32_t)0;
+                continue;
+            }
+
+            writer << (uint32_t)pBufferLayout->getInputClass() << pBufferLayout->getInstanceStepRate() << pBufferLayout->getElementCount();
+            for (uint32_t e = 0; e < pBufferLayout->getElementCount(); e++)
+            {
+                writer.writeString(pBufferLayout->getElementName(e));
+                writer << pBufferLayout->getElementOffset(e) << (uint32_t)pBufferLayout->getElementFormat(e) << pBufferLayout->getElementArraySize(e) << pBufferLayout->getElementShaderLocation(e);
+            }
+        }
+    }
+
+    bool ModelCacheExporter::writeMeshes()
+    {
+        // Layouts are usually shared between meshes. Keep them shared, so that the VAOs created for them are compatible.
+        std::unordered_map<const VertexLayout*, uint32_t> layoutIds;
+        ChunkWriter layoutWriter;
+        ChunkWriter meshWriter;
+        for (uint32_t meshID = 0; meshID < mpModel->getMeshCount(); meshID++)
+        {
+            const Mesh* pMesh = mpModel->getMesh(meshID).get();
+            const Vao* pVao = pMesh->getVao().get();
+            if (pVao->getIndexBuffer() == nullptr)
+            {
+                logWarning("Model cache only supports indexed meshes");
+                return false;
+            }
+
+            const VertexLayout* pLayout = pVao->getVertexLayout().get();
+            auto layoutIt = layoutIds.emplace(pLayout, (uint32_t)layoutIds.size());
+            if (layoutIt.second)
+            {
+                writeVertexLayout(layoutWriter, pLayout);
+            }
+
+            meshWriter << layoutIt.first->second << pVao->getVertexBuffersCount();
+            for (uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++)
+            {
+                meshWriter << addBuffer(pVao->getVertexBuffer(i).get());
+            }
+            meshWriter << addBuffer(pVao->getIndexBuffer().get()) << pMesh->getIndexCount() << pMesh->getVertexCount() << (uint32_t)pVao->getPrimitiveTopology();
+            meshWriter << mMaterialIds.at(pMesh->getMaterial().get()) << (uint32_t)(pMesh->hasBones() ? 1 : 0);
+            meshWriter << pMesh->getBoundingBox().center << pMesh->getBoundingBox().extent;
+
+            meshWriter << (pMesh->getLodCount() - 1);
+            for (uint32_t lod = 1; lod < pMesh->getLodCount(); lod++)
+            {
+                meshWriter << addBuffer(pMesh->getLodVao(lod)->getIndexBuffer().get()) << pMesh->getLodIndexCount(lod) << pMesh->getLodError(lod);
+            }
+
+            meshWriter << mpModel->getMeshInstanceCount(meshID);
+            for (uint32_t i = 0; i < mpModel->getMeshInstanceCount(meshID); i++)
+            {
+                meshWriter << mpModel->getMeshInstance(meshID, i)->getTransformMatrix();
+            }
+        }
+
+        ChunkWriter writer;
+        writer << (uint32_t)layoutIds.size();
+        writer.write(layoutWriter.getData().data(), layoutWriter.getData().size());
+        writer << mpModel->getMeshCount();
+        writer.write(meshWriter.getData().data(), meshWriter.getData().size());
+        mChunks.push_back({ ChunkType::Meshes, writer.getData() });
+        return true;
+    }
+
+    bool ModelCacheExporter::writeAnimation()
+    {
+        if (mpModel->hasBones() == false) return true;
+        const AnimationController* pController = mpModel->getAnimationController();
+
+        ChunkWriter writer;
+        writer << pController->getBoneCount();
+        for (const Bone& bone : pController->getBones())
+        {
+            writer << bone.parentID << bone.boneID;
+            writer.writeString(bone.name);
+            writer << bone.offset << bone.originalLocalTransform;
+        }
+
+        writer << pController->getAnimationCount();
+        for (uint32_t i = 0; i < pController->getAnimationCount(); i++)
+        {
+            const Animation* pAnimation = pController->getAnimation(i);
+            writer.writeString(pAnimation->getName());
+            writer << pAnimation->getDuration() << pAnimation->getTicksPerSecond();
+
+            // The keyframes are stored in their in-memory layout, loading them is a copy
+            const Animation::Keyframes& keyframes = pAnimation->getKeyframes();
+            writer.writeArray(keyframes.tracks);
+            writer.writeArray(keyframes.translationTimes);
+            writer.writeArray(keyframes.translationValues);
+            writer.writeArray(keyframes.rotationTimes);
+            writer.writeArray(keyframes.rotationValues);
+            writer.writeArray(keyframes.packedRotationValues);
+            writer.writeArray(keyframes.scalingTimes);
+            writer.writeArray(keyframes.scalingValues);
+        }
+
+        mChunks.push_back({ ChunkType::Animation, writer.getData() });
+        return true;
+    }
+
+    bool ModelCacheExporter::writeFile(const std::string& filename, Model::LoadFlags flags, int64_t sourceModifiedTime, bool compress)
+    {
+        // Compress the chunks in parallel, keeping the ones which don't get meaningfully smaller uncompressed
+        TaskScheduler::get()->parallelFor(0, mChunks.size(), [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                Chunk& chunk = mChunks[i];
+                chunk.size = chunk.data.size();
+                if (compress == false || chunk.data.empty()) continue;
+
+                std::vector<uint8_t> compressed(Lz4::getMaxCompressedSize(chunk.data.size()));
+                size_t compressedSize = Lz4::compress(chunk.data.data(), chunk.data.size(), compressed.data(), compressed.size());
+                if (compressedSize != 0 && compressedSize <= chunk.data.size() - chunk.data.size() / kMinCompressionGain)
+                {
+                    compressed.resize(compressedSize);
+                    chunk.data.swap(compressed);
+                    chunk.compression = Compression::Lz4;
+                }
+            }
+        }, 1);
+
+        auto align = [](uint64_t offset) { return (offset + kChunkAlignment - 1) & ~(kChunkAlignment - 1); };
+
+        FileHeader header = {};
+        std::memcpy(header.formatId, kFormatId, sizeof(kFormatId));
+        header.version = kVersion;
+        header.loadFlags = (uint32_t)flags;
+        header.sourceModifiedTime = sourceModifiedTime;
+        header.chunkCount = (uint32_t)mChunks.size();
+
+        std::vector<ChunkDesc> descs(mChunks.size());
+        uint64_t offset = align(sizeof(FileHeader) + descs.size() * sizeof(ChunkDesc));
+        for (size_t i = 0; i < mChunks.size(); i++)
+        {
+            descs[i] = { mChunks[i].type, mChunks[i].compression, offset, mChunks[i].data.size(), mChunks[i].size };
+            offset = align(offset + mChunks[i].data.size());
+        }
+
+        // Write into a temporary file and replace the old cache only when done, so that an interrupted export can't leave a partial cache
+        const std::string tempFilename = filename + ".tmp";
+        {
+            BinaryFileStream stream(tempFilename, BinaryFileStream::Mode::Write);
+            stream << header;
+            stream.write(descs.data(), descs.size() * sizeof(ChunkDesc));
+
+            const std::vector<uint8_t> padding(kChunkAlignment, 0);
+            uint64_t position = sizeof(FileHeader) + descs.size() * sizeof(ChunkDesc);
+            for (size_t i = 0; i < mChunks.size(); i++)
+            {
+                stream.write(padding.data(), descs[i].offset - position);
+                stream.write(mChunks[i].data.data(), mChunks[i].data.size());
+                position = descs[i].offset + descs[i].storedSize;
+            }
+
+            if (stream.isFail())
+            {
+                stream.remove();
+                logWarning("Can't write model cache file " + filename);
+                return false;
+            }
+        }
+
+        std::remove(filename.c_str());
+        if (std::rename(tempFilename.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(tempFilename.c_str());
+            logWarning("Can't write model cache file " + filename);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,92 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Graphics/Model/Model.h"
+#include "Graphics/Model/Loaders/ModelCacheSpec.h"
+
+namespace Falcor
+{
+    class Buffer;
+    class Texture;
+    class VertexLayout;
+
+    /** Writes the model cache format. See ModelCacheSpec.h.
+        Typically, the user should use Model::exportToCache() instead of this class. Model::createFromFile() writes the cache automatically.
+    */
+    class ModelCacheExporter
+    {
+    public:
+        /** Export a model into a cache file. Reads the model's buffers and textures back from the GPU.
+            \param[in] filename Full path of the cache file
+            \param[in] pModel The model to export
+            \param[in] flags The flags the model was loaded with. The cache is only used for loads with the same flags.
+            \param[in] sourceModifiedTime Modification time of the model file the cache is created from. Pass 0 for caches which are loaded directly.
+            \param[in] compress Compress the chunks with LZ4
+            \return Whether the export succeeded. Failed exports don't leave a file behind.
+        */
+        static bool exportToFile(const std::string& filename, const Model* pModel, Model::LoadFlags flags, int64_t sourceModifiedTime, bool compress);
+
+    private:
+        ModelCacheExporter(const Model* pModel);
+
+        struct Chunk
+        {
+            ModelCache::ChunkType type;
+            std::vector<uint8_t> data;
+            ModelCache::Compression compression = ModelCache::Compression::None;
+            uint64_t size = 0;      // Before compression
+        };
+
+        bool writeMaterials();
+        bool writeMeshes();
+        bool writeAnimation();
+        bool readBackBuffers();
+        bool writeFile(const std::string& filename, Model::LoadFlags flags, int64_t sourceModifiedTime, bool compress);
+
+        int32_t addTexture(const Texture* pTexture);
+        uint32_t addBuffer(const Buffer* pBuffer);
+        void writeVertexLayout(ModelCache::ChunkWriter& writer, const VertexLayout* pLayout);
+
+        const Model* mpModel;
+        std::vector<Chunk> mChunks;
+        std::unordered_map<const Texture*, int32_t> mTextureIds;
+        std::unordered_map<const Buffer*, uint32_t> mBufferIds;
+        std::unordered_map<const Material*, uint32_t> mMaterialIds;
+
+        // Buffers whose contents still need to be read back from the GPU
+        struct PendingBuffer
+        {
+            const Buffer* pBuffer;
+            size_t chunkIndex;
+        };
+        std::vector<PendingBuffer> mPendingBuffers;
+    };
+}
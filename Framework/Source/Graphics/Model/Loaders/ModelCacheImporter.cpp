@@ -0,0 +1,502 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ModelCacheImporter.h"
+#include "Graphics/Model/Animation.h"
+#include "Graphics/Model/AnimationController.h"
+#include "API/Buffer.h"
+#include "API/Texture.h"
+#include "API/VertexLayout.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/Lz4.h"
+#include "Utils/TaskScheduler.h"
+#include <atomic>
+
+namespace Falcor
+{
+    using namespace ModelCache;
+
+    namespace
+    {
+        bool isValidHeader(const FileHeader& header)
+        {
+            return (std::memcmp(header.formatId, kFormatId, sizeof(kFormatId)) == 0) && (header.version == kVersion);
+        }
+
+        bool isValidKeyRange(const Animation::KeyRange& range, size_t timeCount, size_t valueCount)
+        {
+            return (timeCount == valueCount) && (range.first <= timeCount) && (range.count <= timeCount - range.first);
+        }
+
+        /** Size of a texture's data, with all the subresources tightly packed
+        */
+        uint64_t getTextureDataSize(uint32_t width, uint32_t height, uint32_t arraySize, uint32_t mipCount, ResourceFormat format)
+        {
+            const uint32_t widthRatio = getFormatWidthCompressionRatio(format);
+            const uint32_t heightRatio = getFormatHeightCompressionRatio(format);
+            uint64_t size = 0;
+            for (uint32_t mip = 0; mip < mipCount; mip++)
+            {
+                uint64_t mipWidth = std::max(width >> mip, 1u);
+                uint64_t mipHeight = std::max(height >> mip, 1u);
+                size += ((mipWidth + widthRatio - 1) / widthRatio) * ((mipHeight + heightRatio - 1) / heightRatio) * getFormatBytesPerBlock(format);
+            }
+            return size * arraySize;
+        }
+    }
+
+    ChunkReader ModelCacheImporter::PreloadedFile::getChunkReader(uint32_t chunk) const
+    {
+        if (chunks[chunk].compression == Compression::None)
+        {
+            return ChunkReader(stream.getData() + chunks[chunk].offset, (size_t)chunks[chunk].size);
+        }
+        return ChunkReader(decompressed[chunk].data(), decompressed[chunk].size());
+    }
+
+    bool ModelCacheImporter::isUpToDate(const std::string& fullpath, Model::LoadFlags flags, int64_t sourceModifiedTime)
+    {
+        if (doesFileExist(fullpath) == false) return false;
+
+        BinaryFileStream stream(fullpath, BinaryFileStream::Mode::Read);
+        FileHeader header;
+        stream >> header;
+        return stream.isGood() && isValidHeader(header) && (header.loadFlags == (uint32_t)flags) && (header.sourceModifiedTime == sourceModifiedTime);
+    }
+
+    bool ModelCacheImporter::readFile(const std::string& fullpath, PreloadedFile& file)
+    {
+        file.fullpath = fullpath;
+        if (file.stream.open(fullpath) == false)
+        {
+            logWarning("Can't open model cache file " + fullpath);
+            return false;
+        }
+
+        FileHeader header;
+        file.stream >> header;
+        if (file.stream.isFail() || isValidHeader(header) == false)
+        {
+            logWarning("Model cache file " + fullpath + " has an unknown format or version");
+            return false;
+        }
+
+        // The chunk table has to fit in the file, don't trust the count for the allocation
+        if (header.chunkCount > (file.stream.getSize() - sizeof(FileHeader)) / sizeof(ChunkDesc))
+        {
+            logWarning("Model cache file " + fullpath + " is truncated or corrupt");
+            return false;
+        }
+
+        file.chunks.resize(header.chunkCount);
+        file.stream.read(file.chunks.data(), file.chunks.size() * sizeof(ChunkDesc));
+        bool valid = (file.stream.isFail() == false);
+        for (const ChunkDesc& chunk : file.chunks)
+        {
+            valid = valid && (chunk.offset <= file.stream.getSize()) && (chunk.storedSize <= file.stream.getSize() - chunk.offset);
+            valid = valid && ((chunk.compression == Compression::Lz4) || (chunk.compression == Compression::None && chunk.storedSize == chunk.size));
+        }
+        if (valid == false)
+        {
+            logWarning("Model cache file " + fullpath + " is truncated or corrupt");
+            return false;
+        }
+
+        // Decompress in parallel. The textures usually dominate, and are spread over many chunks.
+        file.decompressed.resize(file.chunks.size());
+        std::atomic<bool> decompressed(true);
+        const uint8_t* pFileData = file.stream.getData();
+        TaskScheduler::get()->parallelFor(0, file.chunks.size(), [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                const ChunkDesc& chunk = file.chunks[i];
+                if (chunk.compression != Compression::Lz4) continue;
+                file.decompressed[i].resize((size_t)chunk.size);
+                if (Lz4::decompress(pFileData + chunk.offset, (size_t)chunk.storedSize, file.decompressed[i].data(), file.decompressed[i].size()) == false)
+                {
+                    decompressed = false;
+                }
+            }
+        }, 1);
+
+        if (decompressed == false)
+        {
+            logWarning("Model cache file " + fullpath + " is corrupt");
+            return false;
+        }
+        return true;
+    }
+
+    Model::PreloadedFile::SharedPtr ModelCacheImporter::preload(const std::string& fullpath)
+    {
+        auto pFile = std::make_shared<PreloadedFile>();
+        if (readFile(fullpath, *pFile) == false)
+        {
+            return nullptr;
+        }
+        return pFile;
+    }
+
+    bool ModelCacheImporter::import(Model& model, const std::string& fullpath, const PreloadedFile* pPreloaded)
+    {
+        PreloadedFile file;
+        if (pPreloaded == nullptr)
+        {
+            if (readFile(fullpath, file) == false)
+            {
+                return false;
+            }
+            pPreloaded = &file;
+        }
+
+        ModelCacheImporter importer(model, *pPreloaded);
+        return importer.importModel();
+    }
+
+    ModelCacheImporter::ModelCacheImporter(Model& model, const PreloadedFile& file) : mModel(model), mFile(file)
+    {
+    }
+
+    bool ModelCacheImporter::importModel()
+    {
+        // The chunks reference textures and buffers by their order, create them first
+        for (uint32_t i = 0; i < (uint32_t)mFile.chunks.size(); i++)
+        {
+            switch (mFile.chunks[i].type)
+            {
+            case ChunkType::Texture:
+                if (createTexture(i) == false) return false;
+                break;
+            case ChunkType::Buffer:
+                if (createBuffer(i) == false) return false;
+                break;
+            default:
+                break;
+            }
+        }
+
+        uint32_t materialsChunk = kInvalidIndex;
+        uint32_t meshesChunk = kInvalidIndex;
+        uint32_t animationChunk = kInvalidIndex;
+        for (uint32_t i = 0; i < (uint32_t)mFile.chunks.size(); i++)
+        {
+            switch (mFile.chunks[i].type)
+            {
+            case ChunkType::Materials: materialsChunk = i; break;
+            case ChunkType::Meshes: meshesChunk = i; break;
+            case ChunkType::Animation: animationChunk = i; break;
+            default: break;
+            }
+        }
+
+        if (materialsChunk == kInvalidIndex || meshesChunk == kInvalidIndex)
+        {
+            logWarning("Model cache file " + mFile.fullpath + " is missing the materials or the meshes");
+            return false;
+        }
+
+        if (createMaterials(materialsChunk) == false) return false;
+        if (createMeshes(meshesChunk) == false) return false;
+        if (animationChunk != kInvalidIndex && createAnimationController(animationChunk) == false) return false;
+        return true;
+    }
+
+    bool ModelCacheImporter::createTexture(uint32_t chunk)
+    {
+        ChunkReader reader = mFile.getChunkReader(chunk);
+        uint32_t width, height, arraySize, mipCount, format;
+        reader >> width >> height >> arraySize >> mipCount >> format;
+        std::string sourceFilename = reader.readString();
+
+        const uint64_t size = getTextureDataSize(width, height, arraySize, mipCount, (ResourceFormat)format);
+        if (reader.isFail() || width == 0 || height == 0 || arraySize == 0 || mipCount == 0 || format >= (uint32_t)ResourceFormat::Count || size != reader.getRemainingSize())
+        {
+            logWarning("Model cache file " + mFile.fullpath + " has a corrupt texture");
+            return false;
+        }
+
+        // The mip-chain is stored, don't let the texture generate it
+        Texture::SharedPtr pTexture = Texture::create2D(width, height, (ResourceFormat)format, arraySize, mipCount, reader.readBytes((size_t)size));
+        if (pTexture == nullptr) return false;
+        pTexture->setSourceFilename(sourceFilename);
+        mTextures.push_back(pTexture);
+        return true;
+    }
+
+    bool ModelCacheImporter::createBuffer(uint32_t chunk)
+    {
+        ChunkReader reader = mFile.getChunkReader(chunk);
+        uint32_t bindFlags;
+        reader >> bindFlags;
+        size_t size = reader.getRemainingSize();
+        if (reader.isFail() || size == 0)
+        {
+            logWarning("Model cache file " + mFile.fullpath + " has a corrupt buffer");
+            return false;
+        }
+
+        Buffer::SharedPtr pBuffer = Buffer::create(size, (Resource::BindFlags)bindFlags, Buffer::CpuAccess::None, reader.readBytes(size));
+        if (pBuffer == nullptr) return false;
+        mBuffers.push_back(pBuffer);
+        return true;
+    }
+
+    const Texture::SharedPtr& ModelCacheImporter::getTexture(int32_t id) const
+    {
+        static const Texture::SharedPtr kNull;
+        return (id >= 0 && id < (int32_t)mTextures.size()) ? mTextures[id] : kNull;
+    }
+
+    const Buffer::SharedPtr& ModelCacheImporter::getBuffer(uint32_t id) const
+    {
+        static const Buffer::SharedPtr kNull;
+        return (id < mBuffers.size()) ? mBuffers[id] : kNull;
+    }
+
+    bool ModelCacheImporter::createMaterials(uint32_t chunk)
+    {
+        ChunkReader reader = mFile.getChunkReader(chunk);
+        uint32_t materialCount = 0;
+        reader >> materialCount;
+        for (uint32_t m = 0; (m < materialCount) && (reader.isFail() == false); m++)
+        {
+            auto pMaterial = Material::create(reader.readString());
+
+            uint32_t layerCount = 0;
+            reader >> layerCount;
+            for (uint32_t i = 0; (i < layerCount) && (reader.isFail() == false); i++)
+            {
+                Material::Layer layer;
+                uint32_t type, ndf, blend;
+                int32_t texture;
+                reader >> type >> ndf >> blend;
+                reader >> layer.albedo >> layer.roughness >> layer.extraParam >> layer.pmf >> texture;
+                layer.type = (Material::Layer::Type)type;
+                layer.ndf = (Material::Layer::NDF)ndf;
+                layer.blend = (Material::Layer::Blend)blend;
+                layer.pTexture = getTexture(texture);
+                pMaterial->addLayer(layer);
+            }
+
+            int32_t normalMap, alphaMap, aoMap, heightMap;
+            glm::vec2 heightModifiers;
+            float alphaThreshold;
+            uint32_t doubleSided;
+            reader >> normalMap >> alphaMap >> aoMap >> heightMap >> heightModifiers >> alphaThreshold >> doubleSided;
+
+            Texture::SharedPtr pNormalMap = getTexture(normalMap);
+            pMaterial->setNormalMap(pNormalMap);
+            pMaterial->setAlphaMap(getTexture(alphaMap));
+            pMaterial->setAmbientOcclusionMap(getTexture(aoMap));
+            pMaterial->setHeightMap(getTexture(heightMap));
+            pMaterial->setHeightModifiers(heightModifiers);
+            pMaterial->setAlphaThreshold(alphaThreshold);
+            pMaterial->setDoubleSided(doubleSided != 0);
+            mMaterials.push_back(checkForExistingMaterial(pMaterial));
+        }
+
+        if (reader.isFail())
+        {
+            logWarning("Model cache file " + mFile.fullpath + " has corrupt materials");
+            return false;
+        }
+        return true;
+    }
+
+    bool ModelCacheImporter::createMeshes(uint32_t chunk)
+    {
+        ChunkReader reader = mFile.getChunkReader(chunk);
+
+        std::vector<VertexLayout::SharedPtr> layouts;
+        uint32_t layoutCount = 0;
+        reader >> layoutCount;
+        for (uint32_t l = 0; (l < layoutCount) && (reader.isFail() == false); l++)
+        {
+            VertexLayout::SharedPtr pLayout = VertexLayout::create();
+            uint32_t bufferCount = 0;
+            reader >> bufferCount;
+            for (uint32_t b = 0; (b < bufferCount) && (reader.isFail() == false); b++)
+            {
+                uint32_t inputClass, stepRate, elementCount;
+                reader >> inputClass >> stepRate >> elementCount;
+                if (elementCount == 0) continue;
+
+                VertexBufferLayout::SharedPtr pBufferLayout = VertexBufferLayout::create();
+                pBufferLayout->setInputClass((VertexBufferLayout::InputClass)inputClass, stepRate);
+                for (uint32_t e = 0; (e < elementCount) && (reader.isFail() == false); e++)
+                {
+                    std::string name = reader.readString();
+                    uint32_t offset, format, arraySize, shaderLocation;
+                    reader >> offset >> format >> arraySize >> shaderLocation;
+                    pBufferLayout->addElement(name, offset, (ResourceFormat)format, arraySize, shaderLocation);
+                }
+                pLayout->addBufferLayout(b, pBufferLayout);
+            }
+            layouts.push_back(pLayout);
+        }
+
+        // Any corrupt mesh fails the whole import, so that the model is loaded from the source asset instead
+        bool valid = true;
+        uint32_t meshCount = 0;
+        reader >> meshCount;
+        for (uint32_t m = 0; (m < meshCount) && valid && (reader.isFail() == false); m++)
+        {
+            uint32_t layoutId, vertexBufferCount;
+            reader >> layoutId >> vertexBufferCount;
+            if (vertexBufferCount > reader.getRemainingSize() / sizeof(uint32_t))
+            {
+                valid = false;
+                break;
+            }
+
+            Vao::BufferVec vertexBuffers(vertexBufferCount);
+            for (auto& pBuffer : vertexBuffers)
+            {
+                uint32_t id;
+                reader >> id;
+                pBuffer = getBuffer(id);
+            }
+
+            uint32_t indexBufferId, indexCount, vertexCount, topology, materialId, hasBones;
+            BoundingBox boundingBox;
+            reader >> indexBufferId >> indexCount >> vertexCount >> topology >> materialId >> hasBones;
+            reader >> boundingBox.center >> boundingBox.extent;
+            if (reader.isFail() || layoutId >= layouts.size() || materialId >= mMaterials.size() || getBuffer(indexBufferId) == nullptr)
+            {
+                valid = false;
+                break;
+            }
+
+            Mesh::SharedPtr pMesh = Mesh::create(vertexBuffers, vertexCount, getBuffer(indexBufferId), indexCount, layouts[layoutId], (Vao::Topology)topology, mMaterials[materialId], boundingBox, hasBones != 0);
+
+            uint32_t lodCount = 0;
+            reader >> lodCount;
+            for (uint32_t lod = 0; (lod < lodCount) && (reader.isFail() == false); lod++)
+            {
+                uint32_t lodIndexBufferId, lodIndexCount;
+                float error;
+                reader >> lodIndexBufferId >> lodIndexCount >> error;
+                if (getBuffer(lodIndexBufferId) == nullptr)
+                {
+                    valid = false;
+                    break;
+                }
+                pMesh->addLod(getBuffer(lodIndexBufferId), lodIndexCount, error);
+            }
+
+            uint32_t instanceCount = 0;
+            reader >> instanceCount;
+            for (uint32_t i = 0; (i < instanceCount) && (reader.isFail() == false); i++)
+            {
+                glm::mat4 transform;
+                reader >> transform;
+                mModel.addMeshInstance(pMesh, transform);
+            }
+        }
+
+        if ((valid == false) || reader.isFail() || mModel.getMeshCount() == 0)
+        {
+            logWarning("Model cache file " + mFile.fullpath + " has corrupt meshes");
+            return false;
+        }
+        return true;
+    }
+
+    bool ModelCacheImporter::createAnimationController(uint32_t chunk)
+    {
+        ChunkReader reader = mFile.getChunkReader(chunk);
+
+        uint32_t boneCount = 0;
+        reader >> boneCount;
+        std::vector<Bone> bones;
+        for (uint32_t b = 0; (b < boneCount) && (reader.isFail() == false); b++)
+        {
+            Bone bone;
+            reader >> bone.parentID >> bone.boneID;
+            bone.name = reader.readString();
+            reader >> bone.offset >> bone.originalLocalTransform;
+            bone.localTransform = bone.originalLocalTransform;
+            bone.globalTransform = glm::mat4();
+            bones.push_back(bone);
+        }
+
+        // Bones are looked up by their parent's index
+        for (uint32_t b = 0; b < bones.size(); b++)
+        {
+            const uint32_t parentID = bones[b].parentID;
+            if ((parentID != AnimationController::kInvalidBoneID) && ((parentID >= bones.size()) || (parentID == b)))
+            {
+                logWarning("Model cache file " + mFile.fullpath + " has a corrupt skeleton");
+                return false;
+            }
+        }
+        auto pController = AnimationController::create(bones);
+
+        uint32_t animationCount = 0;
+        reader >> animationCount;
+        for (uint32_t a = 0; (a < animationCount) && (reader.isFail() == false); a++)
+        {
+            std::string name = reader.readString();
+            float duration, ticksPerSecond;
+            reader >> duration >> ticksPerSecond;
+
+            Animation::Keyframes keyframes;
+            reader.readArray(keyframes.tracks);
+            reader.readArray(keyframes.translationTimes);
+            reader.readArray(keyframes.translationValues);
+            reader.readArray(keyframes.rotationTimes);
+            reader.readArray(keyframes.rotationValues);
+            reader.readArray(keyframes.packedRotationValues);
+            reader.readArray(keyframes.scalingTimes);
+            reader.readArray(keyframes.scalingValues);
+
+            for (const Animation::Track& track : keyframes.tracks)
+            {
+                bool valid = (track.boneID < boneCount) && (keyframes.rotationValues.empty() || keyframes.packedRotationValues.empty());
+                valid = valid && isValidKeyRange(track.translation, keyframes.translationTimes.size(), keyframes.translationValues.size());
+                valid = valid && isValidKeyRange(track.rotation, keyframes.rotationTimes.size(), keyframes.rotationValues.size() + keyframes.packedRotationValues.size());
+                valid = valid && isValidKeyRange(track.scaling, keyframes.scalingTimes.size(), keyframes.scalingValues.size());
+                if (valid == false)
+                {
+                    logWarning("Model cache file " + mFile.fullpath + " has a corrupt animation");
+                    return false;
+                }
+            }
+            pController->addAnimation(Animation::create(name, std::move(keyframes), duration, ticksPerSecond));
+        }
+
+        if (reader.isFail())
+        {
+            logWarning("Model cache file " + mFile.fullpath + " has a corrupt skeleton");
+            return false;
+        }
+        mModel.setAnimationController(std::move(pController));
+        return true;
+    }
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "Graphics/Model/Model.h"
+#include "Graphics/Model/Loaders/ModelImporter.h"
+#include "Graphics/Model/Loaders/ModelCacheSpec.h"
+#include "Utils/MappedFileStream.h"
+
+namespace Falcor
+{
+    class Buffer;
+    class Texture;
+
+    /** Loads the model cache format. See ModelCacheSpec.h.
+        Typically, the user should use Model::createFromFile() to load a model instead of this class.
+    */
+    class ModelCacheImporter : public ModelImporter
+    {
+    public:
+        /** The mapped cache file, with its compressed chunks already decompressed. Created by preload().
+        */
+        class PreloadedFile : public Model::PreloadedFile
+        {
+        public:
+            std::string fullpath;
+            MappedFileStream stream;
+            std::vector<ModelCache::ChunkDesc> chunks;
+            std::vector<std::vector<uint8_t>> decompressed;     // Indexed by chunk. Empty for uncompressed chunks, which are read from the mapping.
+
+            ModelCache::ChunkReader getChunkReader(uint32_t chunk) const;
+        };
+
+        /** Check if a cache file exists, matches this version of the format, and was created from the current version of its source file with the same flags
+            \param[in] fullpath Full path of the cache file
+            \param[in] flags The flags the model is being loaded with
+            \param[in] sourceModifiedTime Modification time of the source model file
+        */
+        static bool isUpToDate(const std::string& fullpath, Model::LoadFlags flags, int64_t sourceModifiedTime);
+
+        /** Map a cache file and decompress its chunks without accessing the device. Can be called from any thread.
+            \param[in] fullpath Full path of the cache file
+            \return The preloaded data, or nullptr if the file couldn't be read
+        */
+        static Model::PreloadedFile::SharedPtr preload(const std::string& fullpath);
+
+        /** Load a model from a cache file
+            \param[out] model Model object to load into
+            \param[in] fullpath Full path of the cache file
+            \param[in] pPreloaded Optional data returned by preload(). If nullptr, the file will be read on the calling thread
+            \return Whether import succeeded
+        */
+        static bool import(Model& model, const std::string& fullpath, const PreloadedFile* pPreloaded = nullptr);
+
+    private:
+        ModelCacheImporter(Model& model, const PreloadedFile& file);
+
+        static bool readFile(const std::string& fullpath, PreloadedFile& file);
+        bool importModel();
+        bool createTexture(uint32_t chunk);
+        bool createBuffer(uint32_t chunk);
+        bool createMaterials(uint32_t chunk);
+        bool createMeshes(uint32_t chunk);
+        bool createAnimationController(uint32_t chunk);
+
+        const Texture::SharedPtr& getTexture(int32_t id) const;
+        const Buffer::SharedPtr& getBuffer(uint32_t id) const;
+
+        Model& mModel;
+        const PreloadedFile& mFile;
+        std::vector<Texture::SharedPtr> mTextures;
+        std::vector<Buffer::SharedPtr> mBuffers;
+        std::vector<Material::SharedPtr> mMaterials;
+    };
+}
@@ -0,0 +1,271 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstring>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------
+/*
+
+Model cache file format v3 (.fscache)
+-------------------------------------
+
+- A snapshot of a model after import: the final vertex and index buffers, the LODs, materials, pre-mipped textures, bones and animations.
+  Loading it only creates the resources, nothing is processed per-vertex or per-texel.
+- All values are little-endian. Strings are a uint32 length followed by the characters, without a terminator.
+- Every chunk starts at a multiple of kChunkAlignment, so uncompressed chunks can be uploaded straight from the memory mapping.
+- Chunks are stored LZ4-compressed (see Utils/Lz4.h) when that makes them meaningfully smaller.
+- Chunks reference each other by index: textures and buffers by their index among the chunks of the same type, materials and layouts by their index in the Materials and Meshes chunks.
+
+File
+0       8       char    formatID            ("FSCache\0")
+8       4       uint    formatVersion       (kVersion)
+12      4       uint    loadFlags           (the Model::LoadFlags the model was imported with)
+16      8       int64   sourceModifiedTime  (modification time of the source model file, 0 for explicit exports)
+24      4       uint    chunkCount
+28      4       uint    reserved
+32      n*32    array   ChunkDesc           (chunkCount)
+
+ChunkDesc
+0       4       uint    type                (ChunkType)
+4       4       uint    compression         (Compression)
+8       8       uint64  offset              (from the start of the file)
+16      8       uint64  storedSize          (size in the file)
+24      8       uint64  size                (size after decompression)
+
+Texture chunk
+0       4       uint    width
+4       4       uint    height
+8       4       uint    arraySize
+12      4       uint    mipCount
+16      4       uint    format              (ResourceFormat)
+20      ?       string  sourceFilename
+?       ?       bytes   data                (all subresources, in subresource index order, tightly packed)
+
+Buffer chunk
+0       4       uint    bindFlags           (Resource::BindFlags)
+4       ?       bytes   data
+
+Materials chunk
+0       4       uint    materialCount
+4       ?       array   Material
+
+Material
+0       ?       string  name
+?       4       uint    layerCount
+?       n*?     array   Layer               (layerCount)
+?       4       int     normalMap           (texture index, -1 if none)
+?       4       int     alphaMap
+?       4       int     ambientOcclusionMap
+?       4       int     heightMap
+?       8       float2  heightModifiers
+?       4       float   alphaThreshold
+?       4       uint    doubleSided
+
+Layer
+0       4       uint    type, ndf, blend    (Material::Layer enums, one uint each)
+12      48      float4  albedo, roughness, extraParam
+60      4       float   pmf
+64      4       int     texture             (texture index, -1 if none)
+
+Meshes chunk
+0       4       uint    layoutCount
+4       ?       array   VertexLayout        (layoutCount)
+?       4       uint    meshCount
+?       ?       array   Mesh                (meshCount)
+
+VertexLayout
+0       4       uint    bufferCount
+4       ?       array   VertexBufferLayout  (bufferCount)
+
+VertexBufferLayout
+0       4       uint    inputClass, instanceStepRate, elementCount
+12      ?       array   Element             (elementCount: name string, then offset, format, arraySize, shaderLocation as uint)
+
+Mesh
+0       4       uint    layout              (layout index)
+4       4       uint    vertexBufferCount
+8       n*4     uint    vertexBuffers       (buffer indices, kInvalidIndex for empty slots)
+?       4       uint    indexBuffer, indexCount, vertexCount, topology, material, hasBones
+?       24      float3  boundingBoxCenter, boundingBoxExtent
+?       4       uint    lodCount            (not including LOD 0)
+?       n*12    array   Lod                 (index buffer index, index count, float error)
+?       4       uint    instanceCount
+?       n*64    float   instanceTransforms  (column-major 4x4 matrices)
+
+Animation chunk (only present if the model has bones)
+0       4       uint    boneCount
+4       ?       array   Bone                (parentID, boneID, name, offset matrix, bind pose local transform)
+?       4       uint    animationCount
+?       ?       array   Animation           (name, duration, ticksPerSecond, then the arrays of Animation::Keyframes in declaration order, each a uint count and the raw elements)
+
+*/
+//------------------------------------------------------------------------
+
+namespace Falcor
+{
+    namespace ModelCache
+    {
+        const char kFormatId[8] = { 'F', 'S', 'C', 'a', 'c', 'h', 'e', '\0' };
+        const uint32_t kVersion = 3;   // v2: SoA animation keyframes, v3: packed rotation keys
+        const uint64_t kChunkAlignment = 4096;
+        const uint32_t kInvalidIndex = uint32_t(-1);
+        const char kExtension[] = ".fscache";
+
+        /** Chunks are only compressed if that saves at least 1/kMinCompressionGain of their size
+        */
+        const uint64_t kMinCompressionGain = 8;
+
+        enum class ChunkType : uint32_t
+        {
+            Texture,
+            Buffer,
+            Materials,
+            Meshes,
+            Animation,
+        };
+
+        enum class Compression : uint32_t
+        {
+            None,
+            Lz4,
+        };
+
+        struct FileHeader
+        {
+            char formatId[8];
+            uint32_t version;
+            uint32_t loadFlags;
+            int64_t sourceModifiedTime;
+            uint32_t chunkCount;
+            uint32_t reserved;
+        };
+
+        struct ChunkDesc
+        {
+            ChunkType type;
+            Compression compression;
+            uint64_t offset;
+            uint64_t storedSize;
+            uint64_t size;
+        };
+
+        /** Serializes the contents of a chunk into memory
+        */
+        class ChunkWriter
+        {
+        public:
+            void write(const void* pData, size_t size)
+            {
+                const uint8_t* pBytes = (const uint8_t*)pData;
+                mData.insert(mData.end(), pBytes, pBytes + size);
+            }
+
+            template<typename T>
+            ChunkWriter& operator<<(const T& val) { write(&val, sizeof(T)); return *this; }
+
+            void writeString(const std::string& str)
+            {
+                *this << (uint32_t)str.size();
+                write(str.data(), str.size());
+            }
+
+            template<typename T>
+            void writeArray(const std::vector<T>& vec)
+            {
+                *this << (uint32_t)vec.size();
+                write(vec.data(), vec.size() * sizeof(T));
+            }
+
+            const std::vector<uint8_t>& getData() const { return mData; }
+
+        private:
+            std::vector<uint8_t> mData;
+        };
+
+        /** Reads the contents of a chunk. Reads past the end of the chunk return zeros and set the fail bit.
+        */
+        class ChunkReader
+        {
+        public:
+            ChunkReader(const uint8_t* pData, size_t size) : mpData(pData), mSize(size) {}
+
+            /** Get a pointer to the next size bytes and skip them
+                \return nullptr if the chunk is too short
+            */
+            const uint8_t* readBytes(size_t size)
+            {
+                if (mFail || size > mSize - mOffset)
+                {
+                    mFail = true;
+                    return nullptr;
+                }
+                const uint8_t* pData = mpData + mOffset;
+                mOffset += size;
+                return pData;
+            }
+
+            template<typename T>
+            ChunkReader& operator>>(T& val)
+            {
+                const uint8_t* pData = readBytes(sizeof(T));
+                if (pData) std::memcpy(&val, pData, sizeof(T));
+                else std::memset(&val, 0, sizeof(T));
+                return *this;
+            }
+
+            std::string readString()
+            {
+                uint32_t length = 0;
+                *this >> length;
+                const uint8_t* pData = readBytes(length);
+                return pData ? std::string((const char*)pData, length) : std::string();
+            }
+
+            template<typename T>
+            void readArray(std::vector<T>& vec)
+            {
+                uint32_t count = 0;
+                *this >> count;
+                const uint8_t* pData = (count <= getRemainingSize() / sizeof(T)) ? readBytes(count * sizeof(T)) : readBytes(getRemainingSize() + 1);
+                vec.resize(pData ? count : 0);
+                if (pData) std::memcpy(vec.data(), pData, count * sizeof(T));
+            }
+
+            size_t getRemainingSize() const { return mSize - mOffset; }
+            bool isFail() const { return mFail; }
+
+        private:
+            const uint8_t* mpData;
+            size_t mSize;
+            size_t mOffset = 0;
+            bool mFail = false;
+        };
+    }
+}
@@ -0,0 +1,407 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TangentSpace.h"
+#include "Utils/TaskScheduler.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FALCOR_TANGENT_SPACE_SIMD
+#elif defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FALCOR_TANGENT_SPACE_SIMD
+#endif
+
+namespace Falcor
+{
+    namespace
+    {
+        // The frame math is written once against these operations, and instantiated for both the SIMD type and float.
+        // When SIMD is available every corner goes through the SIMD instantiation, see accumulateCorners(). The scalar one is only used by builds without SIMD.
+        template<typename V> V load(const float* p);
+        template<> inline float load<float>(const float* p) { return *p; }
+        inline void store(float* p, float v) { *p = v; }
+        template<typename V> V splat(float f);
+        template<> inline float splat<float>(float f) { return f; }
+        inline float add(float a, float b) { return a + b; }
+        inline float sub(float a, float b) { return a - b; }
+        inline float mul(float a, float b) { return a * b; }
+        inline float div(float a, float b) { return a / b; }
+        inline float sqrt(float a) { return std::sqrt(a); }
+        inline uint32_t finiteMask(float a) { return ((a - a) == 0.0f) ? 1 : 0; }
+
+#if defined(__AVX2__)
+        using SimdFloat = __m256;
+        const uint32_t kSimdWidth = 8;
+        template<> inline SimdFloat load<SimdFloat>(const float* p) { return _mm256_loadu_ps(p); }
+        inline void store(float* p, SimdFloat v) { _mm256_storeu_ps(p, v); }
+        inline SimdFloat add(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a, b); }
+        inline SimdFloat sub(SimdFloat a, SimdFloat b) { return _mm256_sub_ps(a, b); }
+        inline SimdFloat mul(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a, b); }
+        inline SimdFloat div(SimdFloat a, SimdFloat b) { return _mm256_div_ps(a, b); }
+        inline SimdFloat sqrt(SimdFloat a) { return _mm256_sqrt_ps(a); }
+        template<> inline SimdFloat splat<SimdFloat>(float f) { return _mm256_set1_ps(f); }
+        inline uint32_t finiteMask(SimdFloat a) { return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_sub_ps(a, a), _mm256_setzero_ps(), _CMP_EQ_OQ)); }
+#elif defined(FALCOR_TANGENT_SPACE_SIMD)
+        using SimdFloat = __m128;
+        const uint32_t kSimdWidth = 4;
+        template<> inline SimdFloat load<SimdFloat>(const float* p) { return _mm_loadu_ps(p); }
+        inline void store(float* p, SimdFloat v) { _mm_storeu_ps(p, v); }
+        inline SimdFloat add(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+        inline SimdFloat sub(SimdFloat a, SimdFloat b) { return _mm_sub_ps(a, b); }
+        inline SimdFloat mul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+        inline SimdFloat div(SimdFloat a, SimdFloat b) { return _mm_div_ps(a, b); }
+        inline SimdFloat sqrt(SimdFloat a) { return _mm_sqrt_ps(a); }
+        template<> inline SimdFloat splat<SimdFloat>(float f) { return _mm_set1_ps(f); }
+        inline uint32_t finiteMask(SimdFloat a) { return (uint32_t)_mm_movemask_ps(_mm_cmpeq_ps(_mm_sub_ps(a, a), _mm_setzero_ps())); }
+#else
+        const uint32_t kSimdWidth = 1;
+#endif
+
+        // Number of corners which go through the frame math together
+        const uint32_t kBatchSize = 32;
+        static_assert(kBatchSize % kSimdWidth == 0, "The batch size must be a multiple of the SIMD width");
+
+        // Meshes are only split across threads when they have at least this many vertices per task
+        const uint32_t kMinVerticesPerRange = 1 << 12;
+        const uint32_t kMaxRangeCount = 256;
+        const size_t kMinCornersPerChunk = 1 << 16;
+        const size_t kMaxChunkCount = 256;
+
+        template<typename T>
+        T loadElement(const uint8_t* pStream, uint32_t stride, uint32_t index)
+        {
+            T val;
+            std::memcpy(&val, pStream + (size_t)stride * index, sizeof(T));
+            return val;
+        }
+
+        bool isInvalidVec(const vec3& v)
+        {
+            return (finiteMask(v.x) & finiteMask(v.y) & finiteMask(v.z)) == 0;
+        }
+
+        vec3 projectNormalToBitangent(const vec3& normal)
+        {
+            vec3 bitangent;
+            if (std::abs(normal.x) > std::abs(normal.y))
+            {
+                bitangent = vec3(normal.z, 0.f, -normal.x) / length(vec2(normal.x, normal.z));
+            }
+            else
+            {
+                bitangent = vec3(0.f, normal.z, -normal.y) / length(vec2(normal.y, normal.z));
+            }
+            return normalize(bitangent);
+        }
+
+        /** A batch of triangle corners in SoA layout. Every corner carries its triangle's data, so the frame math doesn't need to look anything up.
+        */
+        struct CornerBatch
+        {
+            float e1[3][kBatchSize];    // Position deltas
+            float e2[3][kBatchSize];
+            float s[2][kBatchSize];     // Texture coordinate deltas
+            float t[2][kBatchSize];
+            float n[3][kBatchSize];     // Normal of the corner's vertex
+            float b[3][kBatchSize];     // Output bitangent, projected onto the plane of the normal
+            bool finite[kBatchSize];    // Whether the triangle's bitangent is finite
+            uint32_t vertex[kBatchSize];
+            bool valid[kBatchSize];
+        };
+
+        void gatherCorner(const TangentSpaceInput& input, uint32_t corner, CornerBatch& batch, uint32_t lane)
+        {
+            const uint32_t* pTriangle = input.pIndices + (corner - corner % 3);
+            const uint32_t index[3] = { pTriangle[0], pTriangle[1], pTriangle[2] };
+            batch.vertex[lane] = input.pIndices[corner];
+            batch.valid[lane] = (index[0] < input.vertexCount) && (index[1] < input.vertexCount) && (index[2] < input.vertexCount);
+            if (batch.valid[lane] == false)
+            {
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    batch.e1[c][lane] = batch.e2[c][lane] = batch.n[c][lane] = 0;
+                }
+                batch.s[0][lane] = batch.s[1][lane] = batch.t[0][lane] = batch.t[1][lane] = 0;
+                return;
+            }
+
+            vec3 p0 = loadElement<vec3>(input.pPositions, input.positionStride, index[0]);
+            vec3 e1 = loadElement<vec3>(input.pPositions, input.positionStride, index[1]) - p0;
+            vec3 e2 = loadElement<vec3>(input.pPositions, input.positionStride, index[2]) - p0;
+            vec3 n = loadElement<vec3>(input.pNormals, input.normalStride, batch.vertex[lane]);
+
+            vec2 s(0);
+            vec2 t(0);
+            if (input.pTexCrd)
+            {
+                vec2 uv0 = loadElement<vec2>(input.pTexCrd, input.texCrdStride, index[0]);
+                s = loadElement<vec2>(input.pTexCrd, input.texCrdStride, index[1]) - uv0;
+                t = loadElement<vec2>(input.pTexCrd, input.texCrdStride, index[2]) - uv0;
+            }
+
+            // When the texture coordinates collapse, use a default frame around the first normal.
+            // Passing it as the position deltas with unit texture deltas makes the frame math reproduce it exactly.
+            if ((s == vec2(0, 0)) || (t == vec2(0, 0)))
+            {
+                vec3 n0 = loadElement<vec3>(input.pNormals, input.normalStride, index[0]);
+                e2 = projectNormalToBitangent(n0);
+                e1 = cross(e2, n0);
+                s = vec2(1, 0);
+                t = vec2(0, 1);
+            }
+
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                batch.e1[c][lane] = e1[c];
+                batch.e2[c][lane] = e2[c];
+                batch.n[c][lane] = n[c];
+            }
+            batch.s[0][lane] = s.x;
+            batch.s[1][lane] = s.y;
+            batch.t[0][lane] = t.x;
+            batch.t[1][lane] = t.y;
+        }
+
+        template<typename V>
+        V dot3(const V a[3], const V b[3])
+        {
+            return add(add(mul(a[0], b[0]), mul(a[1], b[1])), mul(a[2], b[2]));
+        }
+
+        template<typename V>
+        void normalize3(V v[3])
+        {
+            V invLength = div(splat<V>(1.0f), sqrt(dot3(v, v)));
+            for (uint32_t c = 0; c < 3; c++) v[c] = mul(v[c], invLength);
+        }
+
+        /** Compute the bitangents of kWidth corners starting at lane 'first'
+        */
+        template<typename V, uint32_t kWidth>
+        void computeFrames(CornerBatch& batch, uint32_t first)
+        {
+            V e1[3], e2[3], n[3];
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                e1[c] = load<V>(&batch.e1[c][first]);
+                e2[c] = load<V>(&batch.e2[c][first]);
+                n[c] = load<V>(&batch.n[c][first]);
+            }
+            V sx = load<V>(&batch.s[0][first]);
+            V sy = load<V>(&batch.s[1][first]);
+            V tx = load<V>(&batch.t[0][first]);
+            V ty = load<V>(&batch.t[1][first]);
+
+            // The tangent points along the positive U axis of the texture coordinates in model space, the bitangent along the positive V axis
+            V dirCorrection = div(splat<V>(1.0f), sub(mul(sx, ty), mul(sy, tx)));
+            V tangent[3], bitangent[3];
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                tangent[c] = mul(sub(mul(e1[c], ty), mul(e2[c], tx)), dirCorrection);
+                bitangent[c] = mul(sub(mul(e2[c], sx), mul(e1[c], sy)), dirCorrection);
+            }
+            uint32_t finite = finiteMask(bitangent[0]) & finiteMask(bitangent[1]) & finiteMask(bitangent[2]);
+            for (uint32_t i = 0; i < kWidth; i++)
+            {
+                batch.finite[first + i] = ((finite >> i) & 1) != 0;
+            }
+
+            // Project the tangent and bitangent onto the plane formed by the vertex normal and orthogonalize them
+            V tDotN = dot3(tangent, n);
+            V bDotN = dot3(bitangent, n);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                tangent[c] = sub(tangent[c], mul(n[c], tDotN));
+                bitangent[c] = sub(bitangent[c], mul(n[c], bDotN));
+            }
+            normalize3(tangent);
+            normalize3(bitangent);
+            V bDotT = dot3(bitangent, tangent);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                bitangent[c] = sub(bitangent[c], mul(tangent[c], bDotT));
+            }
+            normalize3(bitangent);
+
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                store(&batch.b[c][first], bitangent[c]);
+            }
+        }
+
+        /** Accumulate the bitangents of a list of corners. Corners are processed in order, so the caller controls the summation order.
+            \param[in] pCorners The corner IDs. If this is nullptr, the corners [firstCorner, firstCorner + count) are used.
+        */
+        void accumulateCorners(const TangentSpaceInput& input, const uint32_t* pCorners, size_t firstCorner, size_t count, vec3* pBitangents)
+        {
+            CornerBatch batch;
+            for (size_t batchStart = 0; batchStart < count; batchStart += kBatchSize)
+            {
+                const uint32_t batchCount = (uint32_t)std::min<size_t>(kBatchSize, count - batchStart);
+                for (uint32_t lane = 0; lane < batchCount; lane++)
+                {
+                    size_t i = batchStart + lane;
+                    gatherCorner(input, pCorners ? pCorners[i] : (uint32_t)(firstCorner + i), batch, lane);
+                }
+
+                uint32_t lane = 0;
+#ifdef FALCOR_TANGENT_SPACE_SIMD
+                // Pad the batch to whole SIMD vectors instead of finishing it with the scalar path.
+                // How corners are split into batches depends on the thread count, and the compiler may contract the scalar path differently (FMA, /fp:fast).
+                // Running every corner through the same instructions keeps the result independent of both.
+                const uint32_t paddedCount = (batchCount + kSimdWidth - 1) / kSimdWidth * kSimdWidth;
+                for (uint32_t pad = batchCount; pad < paddedCount; pad++)
+                {
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        batch.e1[c][pad] = batch.e2[c][pad] = batch.n[c][pad] = 0;
+                    }
+                    batch.s[0][pad] = batch.s[1][pad] = batch.t[0][pad] = batch.t[1][pad] = 0;
+                }
+                for (; lane < paddedCount; lane += kSimdWidth)
+                {
+                    computeFrames<SimdFloat, kSimdWidth>(batch, lane);
+                }
+#else
+                for (; lane < batchCount; lane++)
+                {
+                    computeFrames<float, 1>(batch, lane);
+                }
+#endif
+
+                for (lane = 0; lane < batchCount; lane++)
+                {
+                    if (batch.valid[lane] && batch.finite[lane])
+                    {
+                        pBitangents[batch.vertex[lane]] += vec3(batch.b[0][lane], batch.b[1][lane], batch.b[2][lane]);
+                    }
+                }
+            }
+        }
+
+        void finalizeBitangents(const TangentSpaceInput& input, uint32_t firstVertex, uint32_t lastVertex, vec3* pBitangents)
+        {
+            for (uint32_t v = firstVertex; v < lastVertex; v++)
+            {
+                pBitangents[v] = normalize(pBitangents[v]);
+                if (isInvalidVec(pBitangents[v]))
+                {
+                    pBitangents[v] = projectNormalToBitangent(loadElement<vec3>(input.pNormals, input.normalStride, v));
+                }
+            }
+        }
+    }
+
+    void generateBitangents(const TangentSpaceInput& input, glm::vec3* pBitangents)
+    {
+        assert(input.indexCount <= UINT32_MAX);
+        const uint32_t vertexCount = input.vertexCount;
+        const size_t cornerCount = input.indexCount - input.indexCount % 3;
+
+        // Every task owns a range of vertices, and only accumulates the corners which reference them. This makes the accumulation conflict-free without atomics.
+        TaskScheduler* pScheduler = TaskScheduler::get();
+        const uint32_t rangeCount = std::min({ vertexCount / kMinVerticesPerRange, kMaxRangeCount, pScheduler->getThreadCount() * 4 });
+        if (rangeCount <= 1)
+        {
+            std::memset(pBitangents, 0, vertexCount * sizeof(vec3));
+            accumulateCorners(input, nullptr, 0, cornerCount, pBitangents);
+            finalizeBitangents(input, 0, vertexCount, pBitangents);
+            return;
+        }
+        const uint32_t rangeSize = (vertexCount + rangeCount - 1) / rangeCount;
+
+        // Bucket the corners by vertex range. The index buffer is split into chunks, and each chunk counts and then scatters its corners.
+        // Buckets are filled chunk after chunk, so every bucket lists its corners in index-buffer order.
+        const size_t chunkCount = std::max<size_t>(1, std::min(cornerCount / kMinCornersPerChunk, kMaxChunkCount));
+        const size_t chunkSize = (cornerCount + chunkCount - 1) / chunkCount;
+        std::vector<size_t> chunkOffsets(chunkCount * rangeCount, 0);
+
+        pScheduler->parallelFor(0, chunkCount, [&](size_t begin, size_t end)
+        {
+            for (size_t chunk = begin; chunk < end; chunk++)
+            {
+                size_t* pCounts = chunkOffsets.data() + chunk * rangeCount;
+                size_t last = std::min(cornerCount, (chunk + 1) * chunkSize);
+                for (size_t corner = chunk * chunkSize; corner < last; corner++)
+                {
+                    uint32_t v = input.pIndices[corner];
+                    if (v < vertexCount) pCounts[v / rangeSize]++;
+                }
+            }
+        }, 1);
+
+        std::vector<size_t> rangeOffsets(rangeCount + 1);
+        size_t offset = 0;
+        for (uint32_t range = 0; range < rangeCount; range++)
+        {
+            rangeOffsets[range] = offset;
+            for (size_t chunk = 0; chunk < chunkCount; chunk++)
+            {
+                size_t count = chunkOffsets[chunk * rangeCount + range];
+                chunkOffsets[chunk * rangeCount + range] = offset;
+                offset += count;
+            }
+        }
+        rangeOffsets[rangeCount] = offset;
+
+        std::vector<uint32_t> buckets(offset);
+        pScheduler->parallelFor(0, chunkCount, [&](size_t begin, size_t end)
+        {
+            for (size_t chunk = begin; chunk < end; chunk++)
+            {
+                size_t* pOffsets = chunkOffsets.data() + chunk * rangeCount;
+                size_t last = std::min(cornerCount, (chunk + 1) * chunkSize);
+                for (size_t corner = chunk * chunkSize; corner < last; corner++)
+                {
+                    uint32_t v = input.pIndices[corner];
+                    if (v < vertexCount) buckets[pOffsets[v / rangeSize]++] = (uint32_t)corner;
+                }
+            }
+        }, 1);
+
+        pScheduler->parallelFor(0, rangeCount, [&](size_t begin, size_t end)
+        {
+            for (size_t range = begin; range < end; range++)
+            {
+                uint32_t firstVertex = (uint32_t)range * rangeSize;
+                uint32_t lastVertex = std::min(vertexCount, firstVertex + rangeSize);
+                if (firstVertex >= lastVertex) continue;
+
+                std::memset(pBitangents + firstVertex, 0, (lastVertex - firstVertex) * sizeof(vec3));
+                accumulateCorners(input, buckets.data() + rangeOffsets[range], 0, rangeOffsets[range + 1] - rangeOffsets[range], pBitangents);
+                finalizeBitangents(input, firstVertex, lastVertex, pBitangents);
+            }
+        }, 1);
+    }
+}
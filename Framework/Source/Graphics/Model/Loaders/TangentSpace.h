@@ -0,0 +1,54 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+
+namespace Falcor
+{
+    /** Input of generateBitangents(). Vertex attributes are strided streams, so they can point straight into interleaved or memory-mapped vertex data. The elements don't have to be aligned.
+    */
+    struct TangentSpaceInput
+    {
+        const uint32_t* pIndices = nullptr;     ///< Triangle list indices
+        size_t indexCount = 0;                  ///< Number of indices
+        uint32_t vertexCount = 0;               ///< Number of vertices
+        const uint8_t* pPositions = nullptr;    ///< float3 positions
+        uint32_t positionStride = 0;
+        const uint8_t* pNormals = nullptr;      ///< float3 normals
+        uint32_t normalStride = 0;
+        const uint8_t* pTexCrd = nullptr;       ///< float2 texture coordinates. Optional, without them every triangle uses a frame derived from its normal
+        uint32_t texCrdStride = 0;
+    };
+
+    /** Generate per-vertex bitangents for an indexed triangle list.
+        Each triangle's tangent frame is projected onto the plane of each of its vertex normals, and the results are averaged per vertex. Triangles with degenerate texture coordinates use a frame derived from the normal of their first vertex, and triangles which reference vertices outside of the vertex range are ignored.
+        The work runs in parallel on the TaskScheduler. Every vertex accumulates its triangles in index-buffer order, so the result doesn't depend on the number of threads.
+        \param[in] input The mesh data
+        \param[out] pBitangents Receives input.vertexCount bitangents
+    */
+    void generateBitangents(const TangentSpaceInput& input, glm::vec3* pBitangents);
+}
@@ -0,0 +1,308 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "VertexQuantizer.h"
+#include "API/VertexLayout.h"
+#include "Data/VertexAttrib.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace Falcor
+{
+    namespace
+    {
+        float signNotZero(float f)
+        {
+            return (f >= 0) ? 1.0f : -1.0f;
+        }
+
+        float snorm16ToFloat(int16_t v)
+        {
+            return std::max(v / 32767.0f, -1.0f);
+        }
+
+        float angleDegrees(const glm::vec3& a, const glm::vec3& b)
+        {
+            // acos() of the dot product is too imprecise for the small angles we measure
+            return glm::degrees(std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+        }
+    }
+
+    VertexQuantizer::VertexQuantizer(const BoundingBox& boundingBox)
+    {
+        getPositionDequantization(boundingBox, mScale, mOffset);
+    }
+
+    void VertexQuantizer::getPositionDequantization(const BoundingBox& boundingBox, glm::vec3& scale, glm::vec3& offset)
+    {
+        scale = boundingBox.extent * 2.0f;
+        offset = boundingBox.center - boundingBox.extent;
+    }
+
+    void VertexQuantizer::packPosition(const glm::vec3& position, uint8_t* pDst)
+    {
+        uint16_t packed[4];
+        glm::vec3 decoded;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            // Flat axes are stored as 0, the offset alone restores them
+            float normalized = (mScale[i] > 0) ? (position[i] - mOffset[i]) / mScale[i] : 0.0f;
+            packed[i] = (uint16_t)std::lround(glm::clamp(normalized, 0.0f, 1.0f) * 65535.0f);
+            decoded[i] = packed[i] / 65535.0f * mScale[i] + mOffset[i];
+        }
+        packed[3] = 65535; // w = 1
+
+        mError.position = std::max(mError.position, glm::length(decoded - position));
+        std::memcpy(pDst, packed, sizeof(packed));
+    }
+
+    void VertexQuantizer::packUnitVector(const glm::vec3& v, uint8_t* pDst, float& maxError)
+    {
+        int16_t packed[2] = { 0, 0 };
+        float length = glm::length(v);
+        if (length > 0)
+        {
+            glm::vec3 n = v / length;
+            glm::vec2 e = encodeOctahedral(n) * 32767.0f;
+
+            // Rounding each component independently isn't always the closest encoding, try the 4 neighbors
+            float bestDot = -2;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                int16_t candidate[2];
+                candidate[0] = (int16_t)glm::clamp((i & 1) ? std::ceil(e.x) : std::floor(e.x), -32767.0f, 32767.0f);
+                candidate[1] = (int16_t)glm::clamp((i & 2) ? std::ceil(e.y) : std::floor(e.y), -32767.0f, 32767.0f);
+                float d = glm::dot(decodeOctahedral(glm::vec2(snorm16ToFloat(candidate[0]), snorm16ToFloat(candidate[1]))), n);
+                if (d > bestDot)
+                {
+                    bestDot = d;
+                    packed[0] = candidate[0];
+                    packed[1] = candidate[1];
+                }
+            }
+            maxError = std::max(maxError, angleDegrees(decodeOctahedral(glm::vec2(snorm16ToFloat(packed[0]), snorm16ToFloat(packed[1]))), n));
+        }
+        std::memcpy(pDst, packed, sizeof(packed));
+    }
+
+    void VertexQuantizer::packTexCrd(const glm::vec2& texCrd, uint8_t* pDst)
+    {
+        uint16_t packed[2] = { floatToHalf(texCrd.x), floatToHalf(texCrd.y) };
+        mError.texCrd = std::max(mError.texCrd, std::max(std::abs(halfToFloat(packed[0]) - texCrd.x), std::abs(halfToFloat(packed[1]) - texCrd.y)));
+        std::memcpy(pDst, packed, sizeof(packed));
+    }
+
+    void VertexQuantizer::packBoneWeights(const glm::vec4& weights, uint8_t* pDst)
+    {
+        // Round each weight, then give the rounding difference to the largest weight, so that the total is preserved
+        int32_t packed[4];
+        int32_t sum = 0;
+        uint32_t largest = 0;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            packed[i] = (int32_t)std::lround(glm::clamp(weights[i], 0.0f, 1.0f) * 255.0f);
+            sum += packed[i];
+            largest = (weights[i] > weights[largest]) ? i : largest;
+        }
+        const int32_t target = (int32_t)std::lround(glm::clamp(weights.x + weights.y + weights.z + weights.w, 0.0f, 1.0f) * 255.0f);
+        packed[largest] = glm::clamp(packed[largest] + target - sum, 0, 255);
+
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            pDst[i] = (uint8_t)packed[i];
+            mError.boneWeight = std::max(mError.boneWeight, std::abs(packed[i] / 255.0f - weights[i]));
+        }
+    }
+
+    void VertexQuantizer::packColor(const glm::vec4& color, uint8_t* pDst)
+    {
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            pDst[i] = (uint8_t)std::lround(glm::clamp(color[i], 0.0f, 1.0f) * 255.0f);
+            mError.color = std::max(mError.color, std::abs(pDst[i] / 255.0f - color[i]));
+        }
+    }
+
+    bool VertexQuantizer::canPackTexCrds(const uint8_t* pTexCrd, uint32_t stride, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float uv[2];
+            std::memcpy(uv, pTexCrd + (size_t)i * stride, sizeof(uv));
+            for (float f : uv)
+            {
+                if ((std::isfinite(f) == false) || std::abs(halfToFloat(floatToHalf(f)) - f) > kMaxTexCrdError) return false;
+            }
+        }
+        return true;
+    }
+
+    bool VertexQuantizer::canPackColors(const uint8_t* pColors, uint32_t stride, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float color[4];
+            std::memcpy(color, pColors + (size_t)i * stride, sizeof(color));
+            for (float f : color)
+            {
+                if ((f >= 0 && f <= 1) == false) return false;
+            }
+        }
+        return true;
+    }
+
+    bool VertexQuantizer::isPackedLayout(const VertexLayout* pLayout)
+    {
+        for (size_t b = 0; b < pLayout->getBufferCount(); b++)
+        {
+            const VertexBufferLayout* pBufferLayout = pLayout->getBufferLayout(b).get();
+            if (pBufferLayout == nullptr) continue;
+
+            for (uint32_t e = 0; e < pBufferLayout->getElementCount(); e++)
+            {
+                const ResourceFormat format = pBufferLayout->getElementFormat(e);
+                switch (pBufferLayout->getElementShaderLocation(e))
+                {
+                case VERTEX_POSITION_LOC:
+                    if (format == kPositionFormat) return true;
+                    break;
+                case VERTEX_NORMAL_LOC:
+                case VERTEX_BITANGENT_LOC:
+                    if (format == kUnitVectorFormat) return true;
+                    break;
+                case VERTEX_TEXCOORD_LOC:
+                case VERTEX_LIGHTMAP_UV_LOC:
+                    if (format == kTexCrdFormat) return true;
+                    break;
+                case VERTEX_BONE_WEIGHT_LOC:
+                    if (format == kBoneWeightFormat) return true;
+                    break;
+                case VERTEX_DIFFUSE_COLOR_LOC:
+                    if (format == kColorFormat) return true;
+                    break;
+                }
+            }
+        }
+        return false;
+    }
+
+    glm::vec2 VertexQuantizer::encodeOctahedral(const glm::vec3& v)
+    {
+        // Project onto the octahedron, then fold the lower hemisphere over the diagonals
+        glm::vec2 p = glm::vec2(v.x, v.y) / (std::abs(v.x) + std::abs(v.y) + std::abs(v.z));
+        if (v.z < 0)
+        {
+            p = glm::vec2((1.0f - std::abs(p.y)) * signNotZero(p.x), (1.0f - std::abs(p.x)) * signNotZero(p.y));
+        }
+        return p;
+    }
+
+    glm::vec3 VertexQuantizer::decodeOctahedral(const glm::vec2& e)
+    {
+        glm::vec3 v(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        float t = std::max(-v.z, 0.0f);
+        v.x += (v.x >= 0) ? -t : t;
+        v.y += (v.y >= 0) ? -t : t;
+        return glm::normalize(v);
+    }
+
+    uint16_t VertexQuantizer::floatToHalf(float f)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(f));
+        const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+        const uint32_t absBits = bits & 0x7FFFFFFF;
+
+        if (absBits >= 0x7F800000)
+        {
+            // Inf stays Inf, NaN stays NaN
+            return sign | ((absBits > 0x7F800000) ? 0x7E00 : 0x7C00);
+        }
+        if (absBits >= 0x477FF000)
+        {
+            // Rounds to a value above the largest half
+            return sign | 0x7C00;
+        }
+        if (absBits < 0x38800000)
+        {
+            // Denormal. Shift the mantissa with its implicit bit into place, rounding to nearest even
+            if (absBits < 0x33000000) return sign;
+            const uint32_t shift = 126 - (absBits >> 23);
+            const uint32_t mantissa = (absBits & 0x007FFFFF) | 0x00800000;
+            uint32_t half = mantissa >> shift;
+            const uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1))) half++;
+            return sign | (uint16_t)half;
+        }
+
+        // Normal. Rebias the exponent and round the mantissa to nearest even. A carry correctly bumps the exponent.
+        uint32_t half = ((absBits - 0x38000000) >> 13);
+        const uint32_t remainder = absBits & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+        return sign | (uint16_t)half;
+    }
+
+    float VertexQuantizer::halfToFloat(uint16_t h)
+    {
+        const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+        const uint32_t exponent = (h >> 10) & 0x1F;
+        const uint32_t mantissa = h & 0x3FF;
+
+        uint32_t bits;
+        if (exponent == 0)
+        {
+            // Zero or denormal
+            float f = std::ldexp((float)mantissa, -24);
+            std::memcpy(&bits, &f, sizeof(f));
+            bits |= sign;
+        }
+        else if (exponent == 31)
+        {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    const std::string to_string(const VertexQuantizer::Error& error)
+    {
+        char str[192];
+        std::snprintf(str, sizeof(str), "Max error: position %g, normal %.3g deg, bitangent %.3g deg, texcoord %g, bone weight %g, color %g", error.position, error.normal, error.bitangent, error.texCrd, error.boneWeight, error.color);
+        return str;
+    }
+}
@@ -0,0 +1,150 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "API/Formats.h"
+#include "Utils/AABB.h"
+
+namespace Falcor
+{
+    class VertexLayout;
+
+    /** Packs vertex attributes into the compact formats used with Model::LoadFlags::QuantizeVertices, and measures the error the packing introduces.
+        The shader side of the formats is in DefaultVS.slang and Data/VertexAttrib.h. VertexLayout::addVertexAttribDclToProg() detects packed layouts by their formats.
+    */
+    class VertexQuantizer
+    {
+    public:
+        static const ResourceFormat kPositionFormat = ResourceFormat::RGBA16Unorm;      ///< Positions, normalized to the mesh's bounding-box. See getPositionDequantization()
+        static const ResourceFormat kUnitVectorFormat = ResourceFormat::RG16Snorm;      ///< Normals and bitangents, octahedral encoding
+        static const ResourceFormat kTexCrdFormat = ResourceFormat::RG16Float;          ///< Texture coordinates
+        static const ResourceFormat kBoneWeightFormat = ResourceFormat::RGBA8Unorm;     ///< Bone weights, rounded so that they still sum to 1
+        static const ResourceFormat kColorFormat = ResourceFormat::RGBA8Unorm;          ///< Vertex colors in the [0, 1] range
+
+        /** Texture coordinates whose half-float error would be larger than this (texture coordinates outside of [-2, 2]) are kept as floats
+        */
+        static constexpr float kMaxTexCrdError = 1.0f / 2048;
+
+        /** The largest error introduced into each attribute of a mesh
+        */
+        struct Error
+        {
+            float position = 0;     ///< Distance, in model space
+            float normal = 0;       ///< Angle, in degrees
+            float bitangent = 0;    ///< Angle, in degrees
+            float texCrd = 0;       ///< Largest difference of a coordinate
+            float boneWeight = 0;   ///< Largest difference of a weight
+            float color = 0;        ///< Largest difference of a channel
+        };
+
+        /** Constructor
+            \param[in] boundingBox Bounding-box of the mesh's positions
+        */
+        VertexQuantizer(const BoundingBox& boundingBox);
+
+        /** Pack a position into kPositionFormat
+        */
+        void packPosition(const glm::vec3& position, uint8_t* pDst);
+
+        /** Pack a normal into kUnitVectorFormat. Doesn't need to be normalized.
+        */
+        void packNormal(const glm::vec3& normal, uint8_t* pDst) { packUnitVector(normal, pDst, mError.normal); }
+
+        /** Pack a bitangent into kUnitVectorFormat. Doesn't need to be normalized.
+        */
+        void packBitangent(const glm::vec3& bitangent, uint8_t* pDst) { packUnitVector(bitangent, pDst, mError.bitangent); }
+
+        /** Pack texture coordinates into kTexCrdFormat
+        */
+        void packTexCrd(const glm::vec2& texCrd, uint8_t* pDst);
+
+        /** Pack bone weights into kBoneWeightFormat
+        */
+        void packBoneWeights(const glm::vec4& weights, uint8_t* pDst);
+
+        /** Pack a color into kColorFormat
+        */
+        void packColor(const glm::vec4& color, uint8_t* pDst);
+
+        /** Get the largest errors of all the attributes packed so far
+        */
+        const Error& getError() const { return mError; }
+
+        /** Check if texture coordinates can be packed within kMaxTexCrdError
+            \param[in] pTexCrd The first texture coordinate. Only the first two components are read.
+            \param[in] stride Distance in bytes between consecutive texture coordinates
+            \param[in] count Number of texture coordinates
+        */
+        static bool canPackTexCrds(const uint8_t* pTexCrd, uint32_t stride, uint32_t count);
+
+        /** Check if colors can be packed, which requires all channels to be in [0, 1]
+            \param[in] pColors The first RGBA color
+            \param[in] stride Distance in bytes between consecutive colors
+            \param[in] count Number of colors
+        */
+        static bool canPackColors(const uint8_t* pColors, uint32_t stride, uint32_t count);
+
+        /** Get the transform that maps a packed position back to model space: position = packed * scale + offset
+        */
+        static void getPositionDequantization(const BoundingBox& boundingBox, glm::vec3& scale, glm::vec3& offset);
+
+        /** Check if a vertex layout uses any of the packed formats. Exporters which only handle float attributes use this to reject a mesh.
+        */
+        static bool isPackedLayout(const VertexLayout* pLayout);
+
+        /** Octahedral encoding of a unit vector, in [-1, 1]^2 ("A Survey of Efficient Representations for Independent Unit Vectors", Cigolle et al. 2014)
+        */
+        static glm::vec2 encodeOctahedral(const glm::vec3& v);
+
+        /** Inverse of encodeOctahedral(). Matches decodeOctahedralUnitVector() in VertexAttrib.h.
+        */
+        static glm::vec3 decodeOctahedral(const glm::vec2& e);
+
+        /** Convert a float to a half-float, rounding to nearest
+        */
+        static uint16_t floatToHalf(float f);
+
+        /** Convert a half-float to a float
+        */
+        static float halfToFloat(uint16_t h);
+
+    private:
+        void packUnitVector(const glm::vec3& v, uint8_t* pDst, float& maxError);
+
+        glm::vec3 mScale;
+        glm::vec3 mOffset;
+        Error mError;
+    };
+
+    /** Format the errors for logging
+    */
+    const std::string to_string(const VertexQuantizer::Error& error);
+}
@@ -90,6 +90,24 @@ namespace Falcor
         mPrimitiveCount = mIndexCount / VertsPerPrim;
 
         mpVao = Vao::create(topology, pLayout, vertexBuffers, pIndexBuffer, ResourceFormat::R32Uint);
+        mLods.push_back({ mpVao, mIndexCount, 0 });
+    }
+
+    void Mesh::addLod(const Buffer::SharedPtr& pIndexBuffer, uint32_t indexCount, float error)
+    {
+        if (error < mLods.back().error)
+        {
+            logWarning("Mesh::addLod() - LODs must be added from finest to coarsest. Clamping the error to the previous LOD's error.");
+            error = mLods.back().error;
+        }
+
+        Vao::BufferVec vertexBuffers(mpVao->getVertexBuffersCount());
+        for (uint32_t i = 0; i < mpVao->getVertexBuffersCount(); i++)
+        {
+            vertexBuffers[i] = mpVao->getVertexBuffer(i);
+        }
+        Vao::SharedPtr pVao = Vao::create(mpVao->getPrimitiveTopology(), mpVao->getVertexLayout(), vertexBuffers, pIndexBuffer, ResourceFormat::R32Uint);
+        mLods.push_back({ pVao, indexCount, error });
     }
 
     void Mesh::resetGlobalIdCounter()
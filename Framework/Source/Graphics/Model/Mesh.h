@@ -112,6 +112,29 @@ namespace Falcor
         */
         const Vao::SharedPtr& getVao() const { return mpVao; }
 
+        /** Get the number of levels-of-detail, including the original mesh (LOD 0)
+        */
+        uint32_t getLodCount() const { return (uint32_t)mLods.size(); }
+
+        /** Get the vertex array object of a level-of-detail. The LODs share the mesh's vertex buffers and only have their own index buffer.
+        */
+        const Vao::SharedPtr& getLodVao(uint32_t lod) const { assert(lod < mLods.size()); return mLods[lod].pVao; }
+
+        /** Get the number of indices of a level-of-detail. Use this value when drawing the LOD.
+        */
+        uint32_t getLodIndexCount(uint32_t lod) const { assert(lod < mLods.size()); return mLods[lod].indexCount; }
+
+        /** Get the geometric error of a level-of-detail, in object space units. LOD 0 has no error.
+        */
+        float getLodError(uint32_t lod) const { assert(lod < mLods.size()); return mLods[lod].error; }
+
+        /** Add a coarser level-of-detail. LODs must be added from finest to coarsest.
+            \param[in] pIndexBuffer The LOD's index buffer. Indexes the mesh's vertex buffers and uses the mesh's topology.
+            \param[in] indexCount Number of indices in the index buffer
+            \param[in] error The LOD's geometric error, in object space units
+        */
+        void addLod(const Buffer::SharedPtr& pIndexBuffer, uint32_t indexCount, float error);
+
         /** Get global mesh ID
         */
         const uint32_t getId() const { return mId; }
@@ -148,5 +171,13 @@ namespace Falcor
         Material::SharedPtr mpMaterial;
         BoundingBox mBoundingBox;
         Vao::SharedPtr mpVao;
+
+        struct Lod
+        {
+            Vao::SharedPtr pVao;
+            uint32_t indexCount;
+            float error;
+        };
+        std::vector<Lod> mLods;
     };
 }
\ No newline at end of file
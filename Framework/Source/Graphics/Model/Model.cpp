@@ -30,6 +30,8 @@
 #include "Loaders/AssimpModelImporter.h"
 #include "Loaders/BinaryModelImporter.h"
 #include "Loaders/BinaryModelExporter.h"
+#include "Loaders/ModelCacheImporter.h"
+#include "Loaders/ModelCacheExporter.h"
 #include "Utils/Platform/OS.h"
 #include "Mesh.h"
 #include "glm/geometric.hpp"
@@ -41,13 +43,14 @@
 #include "Utils/StringUtils.h"
 #include "Graphics/Camera/Camera.h"
 #include "API/VAO.h"
+#include "Utils/CpuProfiler.h"
 #include <set>
 
 namespace Falcor
 {
 
     uint32_t Model::sModelCounter = 0;
-    const char* Model::kSupportedFileFormatsStr = "Supported Formats\0*.obj;*.bin;*.dae;*.x;*.md5mesh;*.ply;*.fbx;*.3ds;*.blend;*.ase;*.ifc;*.xgl;*.zgl;*.dxf;*.lwo;*.lws;*.lxo;*.stl;*.x;*.ac;*.ms3d;*.cob;*.scn;*.3d;*.mdl;*.mdl2;*.pk3;*.smd;*.vta;*.raw;*.ter\0\0";
+    const char* Model::kSupportedFileFormatsStr = "Supported Formats\0*.obj;*.bin;*.fscache;*.dae;*.x;*.md5mesh;*.ply;*.fbx;*.3ds;*.blend;*.ase;*.ifc;*.xgl;*.zgl;*.dxf;*.lwo;*.lws;*.lxo;*.stl;*.x;*.ac;*.ms3d;*.cob;*.scn;*.3d;*.mdl;*.mdl2;*.pk3;*.smd;*.vta;*.raw;*.ter\0\0";
 
     // Method to sort meshes
     bool compareMeshes(const Mesh::SharedPtr& p1, const Mesh::SharedPtr& p2)
@@ -86,22 +89,102 @@ namespace Falcor
 
     Model::~Model() = default;
 
-    Model::SharedPtr Model::createFromFile(const char* filename, LoadFlags flags)
+    /** Get the path of the cache file for a model, if loading through the cache is enabled and the cache is usable
+        \param[in] filename The model's filename
+        \param[in] flags The load flags
+        \param[out] cachePath The cache file for the model. Empty if the model shouldn't be cached
+        \param[out] sourceModifiedTime Modification time of the model file
+        \return Whether the cache file is up-to-date
+    */
+    static bool findModelCache(const std::string& filename, Model::LoadFlags flags, std::string& cachePath, int64_t& sourceModifiedTime)
     {
-        SharedPtr pModel = SharedPtr(new Model());
-        bool res;
+        cachePath.clear();
+        std::string fullpath;
+        if(is_set(flags, Model::LoadFlags::DontUseModelCache) || hasSuffix(filename, ModelCache::kExtension, false) || findFileInDataDirectories(filename, fullpath) == false)
+        {
+            return false;
+        }
+
+        cachePath = fullpath + ModelCache::kExtension;
+        sourceModifiedTime = (int64_t)getFileModifiedTime(fullpath);
+        return ModelCacheImporter::isUpToDate(cachePath, flags, sourceModifiedTime);
+    }
+
+    Model::PreloadedFile::SharedPtr Model::preloadFile(const char* filename, LoadFlags flags)
+    {
+        PROFILE_CPU(preloadModelFile);
+        std::string cachePath;
+        int64_t sourceModifiedTime;
+        if(findModelCache(filename, flags, cachePath, sourceModifiedTime))
+        {
+            return ModelCacheImporter::preload(cachePath);
+        }
+        else if(hasSuffix(filename, ModelCache::kExtension, false))
+        {
+            std::string fullpath;
+            return findFileInDataDirectories(filename, fullpath) ? ModelCacheImporter::preload(fullpath) : nullptr;
+        }
+
+        // Binary files are memory-mapped and uploaded in-place, there's nothing to do ahead of time
         if(hasSuffix(filename, ".bin", false))
         {
-            res = BinaryModelImporter::import(*pModel, filename, flags);
+            return nullptr;
         }
-        else
+        return AssimpModelImporter::preload(filename, flags);
+    }
+
+    Model::SharedPtr Model::createFromFile(const char* filename, LoadFlags flags, const PreloadedFile* pPreloaded)
+    {
+        SharedPtr pModel = SharedPtr(new Model());
+        bool res = false;
+        bool cached = false;
+
+        std::string cachePath;
+        int64_t sourceModifiedTime = 0;
+        const ModelCacheImporter::PreloadedFile* pPreloadedCache = dynamic_cast<const ModelCacheImporter::PreloadedFile*>(pPreloaded);
+        if(hasSuffix(filename, ModelCache::kExtension, false))
         {
-            res = AssimpModelImporter::import(*pModel, filename, flags);
+            std::string fullpath;
+            if(findFileInDataDirectories(filename, fullpath))
+            {
+                res = ModelCacheImporter::import(*pModel, fullpath, pPreloadedCache);
+            }
+            else
+            {
+                logError("Can't find model file " + std::string(filename));
+            }
+        }
+        else if(findModelCache(filename, flags, cachePath, sourceModifiedTime) || pPreloadedCache)
+        {
+            res = ModelCacheImporter::import(*pModel, pPreloadedCache ? pPreloadedCache->fullpath : cachePath, pPreloadedCache);
+            cached = res;
+            if(res == false)
+            {
+                // Fall back to the source file, and replace the broken cache
+                pModel = SharedPtr(new Model());
+                pPreloaded = nullptr;
+            }
+        }
+
+        if(res == false && hasSuffix(filename, ModelCache::kExtension, false) == false)
+        {
+            if(hasSuffix(filename, ".bin", false))
+            {
+                res = BinaryModelImporter::import(*pModel, filename, flags);
+            }
+            else
+            {
+                res = AssimpModelImporter::import(*pModel, filename, flags, dynamic_cast<const AssimpModelImporter::PreloadedFile*>(pPreloaded));
+            }
         }
 
         if(res)
         {
             pModel->calculateModelProperties();
+            if(cached == false && cachePath.empty() == false)
+            {
+                ModelCacheExporter::exportToFile(cachePath, pModel.get(), flags, sourceModifiedTime, true);
+            }
             pModel->setFilename(filename);
 
             std::string name = getFilenameFromPath(filename);
@@ -132,6 +215,16 @@ namespace Falcor
         BinaryModelExporter::exportToFile(filename, this);
     }
 
+    bool Model::exportToCache(const std::string& filename, bool compress) const
+    {
+        if(hasSuffix(filename, ModelCache::kExtension, false) == false)
+        {
+            logWarning("Exporting model to cache file, but extension is not '" + std::string(ModelCache::kExtension) + "'. The file will be loaded with the wrong importer");
+        }
+
+        return ModelCacheExporter::exportToFile(filename, this, LoadFlags::None, 0, compress);
+    }
+
     void Model::calculateModelProperties()
     {
         mVertexCount = 0;
@@ -259,10 +352,10 @@ namespace Falcor
         }
     }
 
-    void Model::setActiveAnimation(uint32_t animationID)
+    void Model::setActiveAnimation(uint32_t animationID, float fadeDuration)
     {
         assert(animationID < getAnimationsCount() || animationID == AnimationController::kBindPoseAnimationId);
-        mpAnimationController->setActiveAnimation(animationID);
+        mpAnimationController->setActiveAnimation(animationID, fadeDuration);
     }
 
     bool Model::hasBones() const
@@ -321,6 +414,7 @@ namespace Falcor
         }
 
         mMeshes[meshID].push_back(MeshInstance::create(pMesh, baseTransform));
+        ObjectInstanceVersion::increment();
     }
 
     void Model::sortMeshes()
@@ -332,6 +426,7 @@ namespace Falcor
         };
         
         std::sort(mMeshes.begin(), mMeshes.end(), matSortPred);
+        ObjectInstanceVersion::increment();
     }
 
     template<typename T>
@@ -387,6 +482,7 @@ namespace Falcor
         auto pred = [](MeshInstanceList& meshInstances) { return meshInstances.size() == 0; };
         auto meshesEnd = std::remove_if(mMeshes.begin(), mMeshes.end(), pred);
         mMeshes.erase(meshesEnd, mMeshes.end());
+        ObjectInstanceVersion::increment();
 
         calculateModelProperties();
     }
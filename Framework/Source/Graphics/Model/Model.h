@@ -65,11 +65,37 @@ namespace Falcor
             AssumeLinearSpaceTextures   = 0x4,    ///< By default, textures representing colors (diffuse/specular) are interpreted as sRGB data. Use this flag to force linear space for color textures.
             DontMergeMeshes             = 0x8,    ///< Preserve the original list of meshes in the scene, don't merge meshes with the same material
             BuffersAsShaderResource     = 0x10,   ///< Generate the VBs and IB with the shader-resource-view bind flag
+            OptimizeMeshes              = 0x20,   ///< Reorder triangles for the post-transform vertex cache and for overdraw, and vertices for fetch locality. Unreferenced vertices are dropped
+            GenerateLods                = 0x40,   ///< Generate a chain of simplified index buffers for every triangle mesh. The renderer selects a LOD based on the mesh's projected error
+            DontUseModelCache           = 0x80,   ///< Always import from the source file. By default, the imported model is saved to '<filename>.fscache' and later loads use that cache while it's newer than the source file
+            QuantizeVertices            = 0x100,  ///< Store vertices in compact formats: positions as 16-bit values relative to the mesh's bounding-box, octahedral 16-bit normals and bitangents, half-float texture coordinates and 8-bit bone weights and colors. Only applies to models imported with ASSIMP
+            CompressAnimations          = 0x200,  ///< Remove animation keys which interpolation reproduces within a small error and quantize the rotations. See AnimationCompressor. Only applies to models imported with ASSIMP
+            StreamTextures              = 0x400,  ///< Don't read the texture files. Materials get placeholder textures, which a TextureStreamer loads once the model is added to it
+            CompressTextures            = 0x800,  ///< Generate the textures' mip-chains on the CPU and block-compress them. The results are cached in DDS files next to the images, see TextureProcessor::compressTextureFile()
         };
 
+        /** Data read from a model file by preloadFile(), before any GPU resources were created
+        */
+        class PreloadedFile
+        {
+        public:
+            using SharedPtr = std::shared_ptr<PreloadedFile>;
+            virtual ~PreloadedFile() = default;
+        };
+
+        /** Run the CPU-only part of loading a model file: reading and parsing the file and decoding its textures. Doesn't access the device, so it can be called from any thread.
+            \param[in] filename Model's filename. Can include a full path or a relative path from a data directory
+            \param[in] flags Flags controlling model creation. Must match the flags passed to createFromFile()
+            \return Data to pass to createFromFile(), or nullptr if the format doesn't support preloading or the file couldn't be read. In that case createFromFile() will do all the work
+        */
+        static PreloadedFile::SharedPtr preloadFile(const char* filename, LoadFlags flags = LoadFlags::None);
+
         /** Create a new model from file
+            \param[in] filename Model's filename. Can include a full path or a relative path from a data directory
+            \param[in] flags Flags controlling model creation
+            \param[in] pPreloaded Optional data returned by preloadFile() for the same file
         */
-        static SharedPtr createFromFile(const char* filename, LoadFlags flags = LoadFlags::None);
+        static SharedPtr createFromFile(const char* filename, LoadFlags flags = LoadFlags::None, const PreloadedFile* pPreloaded = nullptr);
 
         static SharedPtr create();
 
@@ -81,6 +107,14 @@ namespace Falcor
         */
         void exportToBinaryFile(const std::string& filename);
 
+        /** Export the model to a model cache file (.fscache). The file can be loaded with createFromFile().
+            Models imported from other formats are cached automatically, see LoadFlags::DontUseModelCache.
+            \param[in] filename Cache file to write
+            \param[in] compress Whether to LZ4-compress the file's chunks
+            \return Whether the export succeeded
+        */
+        bool exportToCache(const std::string& filename, bool compress = true) const;
+
         /** Get the model radius, calculated based on bounding box size.
         */
         float getRadius() const { return mRadius; }
@@ -172,8 +206,10 @@ namespace Falcor
         void setBindPose();
         
         /** Turn animation on and select active animation. Changing the active animation will cause the new animation to play from the beginning.
+            \param[in] animationID The animation
+            \param[in] fadeDuration Length of the cross-fade from the current animation, in seconds. 0 switches immediately.
         */
-        void setActiveAnimation(uint32_t animationID);
+        void setActiveAnimation(uint32_t animationID, float fadeDuration = 0);
 
         /** Get the active animation.
         */
@@ -183,6 +219,10 @@ namespace Falcor
         */
         void setAnimationController(AnimationController::UniquePtr pAnimController);
 
+        /** Get the animation controller of the model. nullptr if the model has no bones.
+        */
+        const AnimationController* getAnimationController() const { return mpAnimationController.get(); }
+
         /** Check if the model has bones.
         */
         bool hasBones() const;
@@ -34,12 +34,29 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/euler_angles.hpp"
 #include "Utils/Math/FalcorMath.h"
+#include <atomic>
 
 namespace Falcor
 {
     class SceneRenderer;
     class Model;
 
+    /** Global version of all the object instances. It is incremented whenever the transform of any instance is modified, and when mesh instances are added to or removed from a model.
+        Systems which track many instances, like SceneBvh, compare it against the last value they saw to skip checking every instance when nothing changed.
+    */
+    class ObjectInstanceVersion
+    {
+    public:
+        static uint32_t get() { return counter().load(std::memory_order_relaxed); }
+        static void increment() { counter().fetch_add(1, std::memory_order_relaxed); }
+    private:
+        static std::atomic<uint32_t>& counter()
+        {
+            static std::atomic<uint32_t> sVersion{ 0 };
+            return sVersion;
+        }
+    };
+
     /** Handles transformations for Mesh and Model instances. Primary transform is stored in the "Base" transform. An additional "Movable"
         transform is applied after the Base transform can be set through the IMovableObject interface. This is currently used by paths.
     */
@@ -127,7 +144,7 @@ namespace Falcor
             }
 
             mBase.translation = translation;
-            mBase.matrixDirty = true;
+            setBaseDirty();
         };
 
         /** Gets the position/translation of the instance
@@ -138,7 +155,7 @@ namespace Falcor
         /** Sets scale of the instance
             \param[in] scaling Instance scale
         */
-        void setScaling(const glm::vec3& scaling) { mBase.scale = scaling; mBase.matrixDirty = true; }
+        void setScaling(const glm::vec3& scaling) { mBase.scale = scaling; setBaseDirty(); }
 
         /** Gets scale of the instance
             \return Scale of the instance
@@ -157,7 +174,7 @@ namespace Falcor
             mBase.up = rotMtx[1];
             mBase.target = mBase.translation + rotMtx[2]; // position + forward
 
-            mBase.matrixDirty = true;
+            setBaseDirty();
         }
 
         /** Gets rotation for the instance
@@ -175,11 +192,11 @@ namespace Falcor
 
         /** Sets the up vector orientation
         */
-        void setUpVector(const glm::vec3& up) { mBase.up = glm::normalize(up); mBase.matrixDirty = true; }
+        void setUpVector(const glm::vec3& up) { mBase.up = glm::normalize(up); setBaseDirty(); }
 
         /** Sets the look-at target
         */
-        void setTarget(const glm::vec3& target) { mBase.target = target; mBase.matrixDirty = true; }
+        void setTarget(const glm::vec3& target) { mBase.target = target; setBaseDirty(); }
 
         /** Gets the up vector of the instance
             \return Up vector
@@ -215,6 +232,15 @@ namespace Falcor
             return mBoundingBox;
         }
 
+        /** Gets a counter which is incremented every time the transform matrix and bounding box are recalculated.
+            Can be used to detect changes without comparing matrices.
+        */
+        uint32_t getTransformVersion() const
+        {
+            updateInstanceProperties();
+            return mTransformVersion;
+        }
+
         /** IMovableObject interface
         */
         virtual void move(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up) override
@@ -224,6 +250,7 @@ namespace Falcor
             mMovable.up = up;
             mMovable.scale = glm::vec3(1.0f);
             mMovable.matrixDirty = true;
+            ObjectInstanceVersion::increment();
         }
 
         SharedPtr shared_from_this()
@@ -236,6 +263,11 @@ namespace Falcor
             return inherit_shared_from_this < IMovableObject, ObjectInstance>::shared_from_this();
         }
     private:
+        void setBaseDirty()
+        {
+            mBase.matrixDirty = true;
+            ObjectInstanceVersion::increment();
+        }
 
         void updateInstanceProperties() const
         {
@@ -258,6 +290,7 @@ namespace Falcor
                 mPrevFinalTransformMatrix = mPrevMovable.matrix * mBase.matrix;
 
                 mBoundingBox = mpObject->getBoundingBox().transform(mFinalTransformMatrix);
+                mTransformVersion++;
             }
         }
 
@@ -334,5 +367,6 @@ namespace Falcor
         mutable glm::mat4 mFinalTransformMatrix;
         mutable glm::mat4 mPrevFinalTransformMatrix;
         mutable BoundingBox mBoundingBox;
+        mutable uint32_t mTransformVersion = 0;
     };
 }
@@ -38,6 +38,7 @@
 #include "API/Sampler.h"
 #include "API/RenderContext.h"
 #include "Utils/StringUtils.h"
+#include "Graphics/Program/ShaderCache.h"
 
 namespace Falcor
 {
@@ -259,9 +260,13 @@ namespace Falcor
         return slangSession;
     }
 
+    // The builtins are part of every compilation, so they are part of the shader cache key
+    static std::string gSlangBuiltinsKey;
+
     void loadSlangBuiltins(char const* name, char const* text)
     {
         spAddBuiltins(getSlangSession(), name, text);
+        gSlangBuiltinsKey += std::string(name) + ":" + std::to_string(ShaderCache::hashData(text, strlen(text))) + "\n";
     }
 
     static const char* getSlangTargetString(ShaderType type)
@@ -288,10 +293,82 @@ namespace Falcor
         }
     }
 
+    std::string Program::getShaderCacheKey() const
+    {
+#ifdef FALCOR_VK
+        std::string key = "Target: SPIRV\n";
+#else
+        std::string key = "Target: DXBC\n";
+#ifdef _DEBUG
+        key += "Debug\n";
+#endif
+#endif
+        key += "Compiler flags: " + std::to_string((uint32_t)mDesc.getCompilerFlags()) + "\n";
+        key += gSlangBuiltinsKey;
+
+        // The search paths decide which files the includes resolve to
+        for (const auto& path : getDataDirectoriesList())
+        {
+            key += "Search path: " + path + "\n";
+        }
+
+        for (uint32_t i = 0; i < kShaderCount; i++)
+        {
+            if (mDesc.mEntryPoints[i].isValid())
+            {
+                key += std::string(getSlangTargetString(ShaderType(i))) + " " + mDesc.mEntryPoints[i].name + " " + std::to_string(mDesc.mEntryPoints[i].sourceIndex) + "\n";
+            }
+        }
+
+        for (const auto& source : mDesc.mSources)
+        {
+            if (source.kind == Desc::Source::Kind::File)
+            {
+                std::string fullpath;
+                findFileInDataDirectories(source.value, fullpath);
+                key += "File: " + fullpath + " " + std::to_string(ShaderCache::getFileHash(fullpath)) + "\n";
+            }
+            else
+            {
+                key += "String: " + std::to_string(ShaderCache::hashData(source.value.data(), source.value.size())) + "\n";
+            }
+        }
+
+        for (const auto& define : mDefineList)
+        {
+            key += "#define " + define.first + " " + define.second + "\n";
+        }
+        return key;
+    }
+
     ProgramVersion::SharedPtr Program::preprocessAndCreateProgramVersion(std::string& log) const
     {
         mFileTimeMap.clear();
 
+        // Intermediates are only produced by Slang, so don't use the cache when they are requested
+        std::string cacheKey;
+        if (ShaderCache::isEnabled() && is_set(mDesc.getCompilerFlags(), Shader::CompilerFlags::DumpIntermediates) == false)
+        {
+            cacheKey = getShaderCacheKey();
+            ShaderCache::Entry entry;
+            if (ShaderCache::load(cacheKey, entry))
+            {
+                mPreprocessedReflector = entry.pReflector;
+                for (const auto& dep : entry.dependencies)
+                {
+                    mFileTimeMap[dep] = getFileModifiedTime(dep);
+                }
+
+                ProgramVersion::SharedPtr pVersion = createProgramVersion(log, entry.shaderBlob);
+                if (pVersion) return pVersion;
+
+                // The runtime rejected the cached code. Recompile, which will also replace the entry
+                logWarning("Failed to create a program from the shader cache, recompiling.\n" + log);
+                log.clear();
+                mFileTimeMap.clear();
+            }
+        }
+
         // Run all of the shaders through Slang, so that we can get final code,
         // reflection data, etc.
         //
@@ -456,18 +533,44 @@ namespace Falcor
         mPreprocessedReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), log);
 
         // Extract list of files referenced, for dependency-tracking purposes
+        std::vector<std::string> dependencies;
         int depFileCount = spGetDependencyFileCount(slangRequest);
         for(int ii = 0; ii < depFileCount; ++ii)
         {
             std::string depFilePath = spGetDependencyFilePath(slangRequest, ii);
             mFileTimeMap[depFilePath] = getFileModifiedTime(depFilePath);
+            dependencies.push_back(depFilePath);
         }
 
         spDestroyCompileRequest(slangRequest);
 
         // Now that we've preprocessed things, dispatch to the actual program creation logic,
         // which may vary in subclasses of `Program`
-        return createProgramVersion(log, shaderBlob);
+        ProgramVersion::SharedPtr pVersion = createProgramVersion(log, shaderBlob);
+
+        if (pVersion && cacheKey.size())
+        {
+            ShaderCache::Entry entry;
+            entry.pReflector = mPreprocessedReflector;
+            entry.dependencies = std::move(dependencies);
+            for (uint32_t i = 0; i < kShaderCount; i++)
+            {
+                const Shader* pShader = pVersion->getShader(ShaderType(i));
+                if (pShader == nullptr) continue;
+#ifdef FALCOR_D3D
+                // Store the DXBC rather than the HLSL, so that a cache hit skips the HLSL compiler as well
+                ID3DBlobPtr pD3DBlob = pShader->getD3DBlob();
+                const uint8_t* pCode = (const uint8_t*)pD3DBlob->GetBufferPointer();
+                entry.shaderBlob[i].data.assign(pCode, pCode + pD3DBlob->GetBufferSize());
+                entry.shaderBlob[i].type = Shader::Blob::Type::Bytecode;
+#else
+                entry.shaderBlob[i] = shaderBlob[i];
+#endif
+            }
+            ShaderCache::store(cacheKey, entry);
+        }
+
+        return pVersion;
     }
 
     ProgramVersion::SharedPtr Program::createProgramVersion(std::string& log, const Shader::Blob shaderBlob[kShaderCount]) const
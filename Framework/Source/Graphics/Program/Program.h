@@ -242,6 +242,7 @@ namespace Falcor
         mutable ProgramVersion::SharedConstPtr mpActiveProgram = nullptr;
 
         std::string getProgramDescString() const;
+        std::string getShaderCacheKey() const;
         static std::vector<Program*> sPrograms;
 
         using string_time_map = std::unordered_map<std::string, time_t>;
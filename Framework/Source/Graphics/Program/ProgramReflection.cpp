@@ -27,6 +27,7 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "ProgramReflection.h"
+#include <cstring>
 #include "Utils/StringUtils.h"
 using namespace slang;
 
@@ -629,7 +630,6 @@ namespace Falcor
 
     ProgramReflection::ProgramReflection(slang::ShaderReflection* pSlangReflector, std::string& log)
     {
-        ParameterBlockReflection::SharedPtr pDefaultBlock = ParameterBlockReflection::create("");
         for (uint32_t i = 0; i < pSlangReflector->getParameterCount(); i++)
         {
             VariableLayoutReflection* pSlangLayout = pSlangReflector->getParameterByIndex(i);
@@ -638,36 +638,16 @@ namespace Falcor
             // In GLSL, the varying (in/out) variables are reflected as globals. Ignore them, we will reflect them later
             if (pVar->getType()->unwrapArray()->asResourceType() == nullptr) continue;
 
+            TopLevelResource resource;
+            resource.pVar = pVar;
             if (pSlangLayout->getType()->unwrapArray()->getKind() == TypeReflection::Kind::ParameterBlock)
             {
-                std::string name = std::string(pSlangLayout->getName());
-                ParameterBlockReflection::SharedPtr pBlock = ParameterBlockReflection::create(name);
-                pBlock->addResource(pVar);
-                pBlock->finalize();
-                addParameterBlock(pBlock);
-            }
-            else
-            {
-                pDefaultBlock->addResource(pVar);
+                resource.blockName = std::string(pSlangLayout->getName());
             }
+            mTopLevelResources.push_back(resource);
         }
 
-        pDefaultBlock->finalize();
-        addParameterBlock(pDefaultBlock);
-
-        if (pDefaultBlock->isEmpty() == false)
-        {            
-            // Initialize the map from the default-block resources to the global resources
-            for (const auto& res : mpDefaultBlock->getResourceVec())
-            {
-                const auto& loc = mpDefaultBlock->getResourceBinding(res.name);
-                ResourceBinding bind;
-                bind.regIndex = res.regIndex;
-                bind.regSpace = res.regSpace;
-                bind.type = getBindTypeFromSetType(res.setType);
-                mResourceBindMap[bind] = loc;
-            }
-        }
+        createParameterBlocks();
 
         // Reflect per-stage parameters
         SlangUInt entryPointCount = pSlangReflector->getEntryPointCount();
@@ -703,6 +683,42 @@ namespace Falcor
         }
     }
 
+    void ProgramReflection::createParameterBlocks()
+    {
+        ParameterBlockReflection::SharedPtr pDefaultBlock = ParameterBlockReflection::create("");
+        for (const auto& resource : mTopLevelResources)
+        {
+            if (resource.blockName.size())
+            {
+                ParameterBlockReflection::SharedPtr pBlock = ParameterBlockReflection::create(resource.blockName);
+                pBlock->addResource(resource.pVar);
+                pBlock->finalize();
+                addParameterBlock(pBlock);
+            }
+            else
+            {
+                pDefaultBlock->addResource(resource.pVar);
+            }
+        }
+
+        pDefaultBlock->finalize();
+        addParameterBlock(pDefaultBlock);
+
+        if (pDefaultBlock->isEmpty() == false)
+        {            
+            // Initialize the map from the default-block resources to the global resources
+            for (const auto& res : mpDefaultBlock->getResourceVec())
+            {
+                const auto& loc = mpDefaultBlock->getResourceBinding(res.name);
+                ResourceBinding bind;
+                bind.regIndex = res.regIndex;
+                bind.regSpace = res.regSpace;
+                bind.type = getBindTypeFromSetType(res.setType);
+                mResourceBindMap[bind] = loc;
+            }
+        }
+    }
+
     void ProgramReflection::addParameterBlock(const ParameterBlockReflection::SharedConstPtr& pBlock)
     {
         assert(mParameterBlocksIndices.find(pBlock->getName()) == mParameterBlocksIndices.end());
@@ -1354,4 +1370,276 @@ namespace Falcor
         const auto& offsetIt = mOffsetDescMap.find(offset);
         return (offsetIt == mOffsetDescMap.end()) ? empty : offsetIt->second;
     }
+
+    // Serialization. The format is private to the shader cache, which versions it. Types are written by value.
+    namespace
+    {
+        enum class SerializedType : uint8_t
+        {
+            Null,
+            Basic,
+            Struct,
+            Array,
+            Resource
+        };
+
+        class ReflectionWriter
+        {
+        public:
+            ReflectionWriter(std::vector<uint8_t>& data) : mData(data) {}
+
+            template<typename T>
+            void write(const T& val)
+            {
+                const uint8_t* pVal = (const uint8_t*)&val;
+                mData.insert(mData.end(), pVal, pVal + sizeof(T));
+            }
+
+            void writeString(const std::string& str)
+            {
+                write((uint32_t)str.size());
+                mData.insert(mData.end(), str.begin(), str.end());
+            }
+
+            void writeType(const ReflectionType* pType)
+            {
+                if (pType == nullptr)
+                {
+                    write(SerializedType::Null);
+                }
+                else if (const ReflectionBasicType* pBasic = pType->asBasicType())
+                {
+                    write(SerializedType::Basic);
+                    write((uint64_t)pBasic->getOffset());
+                    write(pBasic->getType());
+                    write(pBasic->isRowMajor());
+                    write((uint64_t)pBasic->getSize());
+                }
+                else if (const ReflectionStructType* pStruct = pType->asStructType())
+                {
+                    write(SerializedType::Struct);
+                    write((uint64_t)pStruct->getOffset());
+                    write((uint64_t)pStruct->getSize());
+                    writeString(pStruct->getName());
+                    write(pStruct->getMemberCount());
+                    for (const auto& pMember : *pStruct) writeVar(pMember.get());
+                }
+                else if (const ReflectionArrayType* pArray = pType->asArrayType())
+                {
+                    write(SerializedType::Array);
+                    write((uint64_t)pArray->getOffset());
+                    write(pArray->getArraySize());
+                    write(pArray->getArrayStride());
+                    writeType(pArray->getType().get());
+                }
+                else
+                {
+                    const ReflectionResourceType* pResource = pType->asResourceType();
+                    assert(pResource);
+                    write(SerializedType::Resource);
+                    write(pResource->getType());
+                    write(pResource->getDimensions());
+                    write(pResource->getStructuredBufferType());
+                    write(pResource->getReturnType());
+                    write(pResource->getShaderAccess());
+                    writeType(pResource->getStructType().get());
+                }
+            }
+
+            void writeVar(const ReflectionVar* pVar)
+            {
+                writeString(pVar->getName());
+                write((uint64_t)pVar->getOffset());
+                write(pVar->getDescOffset());
+                write(pVar->getRegisterSpace());
+                writeType(pVar->getType().get());
+            }
+
+            void writeVariableMap(const ProgramReflection::VariableMap& varMap)
+            {
+                write((uint32_t)varMap.size());
+                for (const auto& v : varMap)
+                {
+                    writeString(v.first);
+                    write(v.second.bindLocation);
+                    writeString(v.second.semanticName);
+                    write(v.second.type);
+                }
+            }
+
+        private:
+            std::vector<uint8_t>& mData;
+        };
+
+        class ReflectionReader
+        {
+        public:
+            ReflectionReader(const uint8_t* pData, size_t size) : mpData(pData), mSize(size) {}
+
+            bool isFail() const { return mFail; }
+
+            template<typename T>
+            T read()
+            {
+                T val = T();
+                if (mFail || mSize - mOffset < sizeof(T))
+                {
+                    mFail = true;
+                    return val;
+                }
+                std::memcpy(&val, mpData + mOffset, sizeof(T));
+                mOffset += sizeof(T);
+                return val;
+            }
+
+            std::string readString()
+            {
+                uint32_t length = read<uint32_t>();
+                if (mFail || mSize - mOffset < length)
+                {
+                    mFail = true;
+                    return std::string();
+                }
+                std::string str((const char*)mpData + mOffset, length);
+                mOffset += length;
+                return str;
+            }
+
+            ReflectionType::SharedPtr readType()
+            {
+                switch (read<SerializedType>())
+                {
+                case SerializedType::Null:
+                    return nullptr;
+                case SerializedType::Basic:
+                {
+                    size_t offset = (size_t)read<uint64_t>();
+                    ReflectionBasicType::Type type = read<ReflectionBasicType::Type>();
+                    bool isRowMajor = read<bool>();
+                    size_t size = (size_t)read<uint64_t>();
+                    return ReflectionBasicType::create(offset, type, isRowMajor, size);
+                }
+                case SerializedType::Struct:
+                {
+                    size_t offset = (size_t)read<uint64_t>();
+                    size_t size = (size_t)read<uint64_t>();
+                    std::string name = readString();
+                    uint32_t memberCount = read<uint32_t>();
+                    ReflectionStructType::SharedPtr pStruct = ReflectionStructType::create(offset, size, name);
+                    for (uint32_t i = 0; i < memberCount && !mFail; i++)
+                    {
+                        ReflectionVar::SharedPtr pVar = readVar();
+                        if (pVar) pStruct->addMember(pVar);
+                    }
+                    return pStruct;
+                }
+                case SerializedType::Array:
+                {
+                    size_t offset = (size_t)read<uint64_t>();
+                    uint32_t arraySize = read<uint32_t>();
+                    uint32_t arrayStride = read<uint32_t>();
+                    ReflectionType::SharedPtr pType = readType();
+                    if (pType == nullptr)
+                    {
+                        mFail = true;
+                        return nullptr;
+                    }
+                    return ReflectionArrayType::create(offset, arraySize, arrayStride, pType);
+                }
+                case SerializedType::Resource:
+                {
+                    ReflectionResourceType::Type type = read<ReflectionResourceType::Type>();
+                    ReflectionResourceType::Dimensions dims = read<ReflectionResourceType::Dimensions>();
+                    ReflectionResourceType::StructuredType structuredType = read<ReflectionResourceType::StructuredType>();
+                    ReflectionResourceType::ReturnType retType = read<ReflectionResourceType::ReturnType>();
+                    ReflectionResourceType::ShaderAccess shaderAccess = read<ReflectionResourceType::ShaderAccess>();
+                    ReflectionResourceType::SharedPtr pResource = ReflectionResourceType::create(type, dims, structuredType, retType, shaderAccess);
+                    ReflectionType::SharedPtr pStructType = readType();
+                    if (pStructType) pResource->setStructType(pStructType);
+                    return pResource;
+                }
+                default:
+                    mFail = true;
+                    return nullptr;
+                }
+            }
+
+            ReflectionVar::SharedPtr readVar()
+            {
+                std::string name = readString();
+                size_t offset = (size_t)read<uint64_t>();
+                uint32_t descOffset = read<uint32_t>();
+                uint32_t regSpace = read<uint32_t>();
+                ReflectionType::SharedPtr pType = readType();
+                if (mFail || pType == nullptr)
+                {
+                    mFail = true;
+                    return nullptr;
+                }
+                return ReflectionVar::create(name, pType, offset, descOffset, regSpace);
+            }
+
+            void readVariableMap(ProgramReflection::VariableMap& varMap)
+            {
+                uint32_t count = read<uint32_t>();
+                for (uint32_t i = 0; i < count && !mFail; i++)
+                {
+                    std::string name = readString();
+                    ProgramReflection::ShaderVariable& var = varMap[name];
+                    var.bindLocation = read<uint32_t>();
+                    var.semanticName = readString();
+                    var.type = read<ReflectionBasicType::Type>();
+                }
+            }
+
+        private:
+            const uint8_t* mpData;
+            size_t mSize;
+            size_t mOffset = 0;
+            bool mFail = false;
+        };
+    }
+
+    void ProgramReflection::serialize(std::vector<uint8_t>& data) const
+    {
+        ReflectionWriter writer(data);
+        writer.write((uint32_t)mTopLevelResources.size());
+        for (const auto& resource : mTopLevelResources)
+        {
+            writer.writeString(resource.blockName);
+            writer.writeVar(resource.pVar.get());
+        }
+
+        writer.write(mThreadGroupSize);
+        writer.write(mIsSampleFrequency);
+        writer.writeVariableMap(mPsOut);
+        writer.writeVariableMap(mVertAttr);
+        writer.writeVariableMap(mVertAttrBySemantic);
+    }
+
+    ProgramReflection::SharedPtr ProgramReflection::deserialize(const uint8_t* pData, size_t size)
+    {
+        SharedPtr pReflection = SharedPtr(new ProgramReflection());
+        ReflectionReader reader(pData, size);
+
+        uint32_t resourceCount = reader.read<uint32_t>();
+        for (uint32_t i = 0; i < resourceCount && !reader.isFail(); i++)
+        {
+            TopLevelResource resource;
+            resource.blockName = reader.readString();
+            resource.pVar = reader.readVar();
+            if (resource.pVar == nullptr || resource.pVar->getType()->unwrapArray()->asResourceType() == nullptr) return nullptr;
+            pReflection->mTopLevelResources.push_back(resource);
+        }
+
+        pReflection->mThreadGroupSize = reader.read<uvec3>();
+        pReflection->mIsSampleFrequency = reader.read<bool>();
+        reader.readVariableMap(pReflection->mPsOut);
+        reader.readVariableMap(pReflection->mVertAttr);
+        reader.readVariableMap(pReflection->mVertAttrBySemantic);
+        if (reader.isFail()) return nullptr;
+
+        pReflection->createParameterBlocks();
+        return pReflection;
+    }
 }
@@ -82,6 +82,10 @@ namespace Falcor
         */
         virtual size_t getSize() const = 0;
 
+        /** Get the offset of the object relative to the parent
+        */
+        size_t getOffset() const { return mOffset; }
+
         // Helper functions
         virtual std::shared_ptr<const ReflectionVar> findMemberInternal(const std::string& name, size_t strPos, size_t offset, uint32_t regIndex, uint32_t regSpace, uint32_t descOffset) const = 0;
 
@@ -563,6 +567,15 @@ namespace Falcor
         */
         static SharedPtr create(slang::ShaderReflection* pSlangReflector ,std::string& log);
 
+        /** Serialize the reflection data into a byte array, so that it can be recreated without running the shader compiler
+        */
+        void serialize(std::vector<uint8_t>& data) const;
+
+        /** Create a new object from data written by serialize()
+            \return A new object, or nullptr if the data is malformed
+        */
+        static SharedPtr deserialize(const uint8_t* pData, size_t size);
+
         /** Get the index of a parameter block
         */
         uint32_t getParameterBlockIndex(const std::string& name) const;
@@ -622,8 +635,17 @@ namespace Falcor
         const ParameterBlockReflection::BindLocation translateRegisterIndicesToBindLocation(uint32_t regSpace, uint32_t baseRegIndex, BindType type) const { return mResourceBindMap.at({regSpace, baseRegIndex, type}); }
 
     private:
+        ProgramReflection() = default;
         ProgramReflection(slang::ShaderReflection* pSlangReflector, std::string& log);
         void addParameterBlock(const ParameterBlockReflection::SharedConstPtr& pBlock);
+        void createParameterBlocks();
+
+        struct TopLevelResource
+        {
+            std::string blockName;              ///> The name of the parameter block containing the resource. Empty for the default block
+            ReflectionVar::SharedConstPtr pVar; ///> The resource variable
+        };
+        std::vector<TopLevelResource> mTopLevelResources;   // The global resources, in declaration order. Parameter blocks are created from this list
 
         std::vector<ParameterBlockReflection::SharedConstPtr> mpParameterBlocks;
         std::unordered_map<std::string, size_t> mParameterBlocksIndices;
@@ -0,0 +1,270 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ShaderCache.h"
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#include "Utils/BinaryFileStream.h"
+#include "Utils/MappedFileStream.h"
+#include "Utils/Platform/OS.h"
+
+namespace Falcor
+{
+    // Bump whenever the file layout, the reflection serialization or the key generation changes
+    static const uint32_t kCacheVersion = 1;
+    static const uint32_t kCacheMagic = 0x48435346; // 'FSCH'
+
+    static bool gCacheEnabled = true;
+    static std::string gCacheDirectory;
+
+    // Programs can be created from several threads, so the counters and the file hashes are shared between them
+    static struct
+    {
+        std::atomic<uint32_t> hits{ 0 };
+        std::atomic<uint32_t> misses{ 0 };
+        std::atomic<uint32_t> stores{ 0 };
+    } gStats;
+
+    struct FileHash
+    {
+        time_t modifiedTime = 0;
+        uint64_t hash = 0;
+    };
+    static std::unordered_map<std::string, FileHash> gFileHashes;
+    static std::mutex gFileHashesMutex;
+
+    static std::string getEntryFilename(const std::string& key)
+    {
+        char name[17];
+        snprintf(name, sizeof(name), "%016llx", (unsigned long long)ShaderCache::hashData(key.data(), key.size()));
+        return ShaderCache::getDirectory() + "/" + name + ".shader";
+    }
+
+    static std::string readString(MappedFileStream& stream)
+    {
+        uint32_t length = 0;
+        stream >> length;
+        ConstSpan<char> chars = stream.readSpan<char>(length);
+        return std::string(chars.begin(), chars.end());
+    }
+
+    static void writeString(BinaryFileStream& stream, const std::string& str)
+    {
+        stream << (uint32_t)str.size();
+        stream.write(str.data(), str.size());
+    }
+
+    uint64_t ShaderCache::hashData(const void* pData, size_t size)
+    {
+        // 64-bit FNV-1a
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= pBytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    void ShaderCache::setEnabled(bool enabled)
+    {
+        gCacheEnabled = enabled;
+    }
+
+    bool ShaderCache::isEnabled()
+    {
+        return gCacheEnabled;
+    }
+
+    void ShaderCache::setDirectory(const std::string& directory)
+    {
+        gCacheDirectory = directory;
+    }
+
+    const std::string& ShaderCache::getDirectory()
+    {
+        if (gCacheDirectory.empty())
+        {
+            gCacheDirectory = getExecutableDirectory() + "/ShaderCache";
+        }
+        return gCacheDirectory;
+    }
+
+    uint64_t ShaderCache::getFileHash(const std::string& fullpath)
+    {
+        time_t modifiedTime = getFileModifiedTime(fullpath);
+        if (modifiedTime == 0) return 0;
+
+        {
+            std::lock_guard<std::mutex> lock(gFileHashesMutex);
+            auto it = gFileHashes.find(fullpath);
+            if (it != gFileHashes.end() && it->second.modifiedTime == modifiedTime) return it->second.hash;
+        }
+
+        // Hash outside the lock. If two threads hash the same file, they store the same result.
+        std::string content;
+        if (readFileToString(fullpath, content) == false) return 0;
+        FileHash fileHash;
+        fileHash.hash = ShaderCache::hashData(content.data(), content.size());
+        fileHash.modifiedTime = modifiedTime;
+
+        std::lock_guard<std::mutex> lock(gFileHashesMutex);
+        gFileHashes[fullpath] = fileHash;
+        return fileHash.hash;
+    }
+
+    bool ShaderCache::load(const std::string& key, Entry& entry)
+    {
+        // A missing entry is the common case on a cold cache. Check for it first, opening the stream would report an error.
+        const std::string filename = getEntryFilename(key);
+        MappedFileStream stream;
+        if (doesFileExist(filename) == false || stream.open(filename) == false)
+        {
+            gStats.misses++;
+            return false;
+        }
+
+        uint32_t magic = 0, version = 0;
+        stream >> magic >> version;
+        if (magic != kCacheMagic || version != kCacheVersion || readString(stream) != key)
+        {
+            gStats.misses++;
+            return false;
+        }
+
+        // Validate the dependencies
+        uint32_t depCount = 0;
+        stream >> depCount;
+        entry.dependencies.clear();
+        for (uint32_t i = 0; i < depCount; i++)
+        {
+            std::string path = readString(stream);
+            uint64_t hash = 0;
+            stream >> hash;
+            if (stream.isFail() || getFileHash(path) != hash)
+            {
+                gStats.misses++;
+                return false;
+            }
+            entry.dependencies.push_back(path);
+        }
+
+        // Reflection
+        uint64_t reflectionSize = 0;
+        stream >> reflectionSize;
+        ConstSpan<uint8_t> reflection = stream.readSpan<uint8_t>(reflectionSize);
+        entry.pReflector = stream.isFail() ? nullptr : ProgramReflection::deserialize(reflection.data(), reflection.size());
+
+        // Shaders
+        for (uint32_t i = 0; i < kShaderCount; i++)
+        {
+            uint32_t type = 0;
+            uint64_t size = 0;
+            stream >> type >> size;
+            ConstSpan<uint8_t> data = stream.readSpan<uint8_t>(size);
+            entry.shaderBlob[i].type = (Shader::Blob::Type)type;
+            entry.shaderBlob[i].data.assign(data.begin(), data.end());
+        }
+
+        if (stream.isFail() || entry.pReflector == nullptr)
+        {
+            logWarning("Shader cache entry '" + filename + "' is corrupted. Ignoring it.");
+            gStats.misses++;
+            return false;
+        }
+
+        gStats.hits++;
+        return true;
+    }
+
+    void ShaderCache::store(const std::string& key, const Entry& entry)
+    {
+        const std::string& directory = getDirectory();
+        if (isDirectoryExists(directory) == false && createDirectory(directory) == false)
+        {
+            logWarning("Can't create the shader cache directory '" + directory + "'. Disabling the shader cache.");
+            gCacheEnabled = false;
+            return;
+        }
+
+        std::vector<uint8_t> reflection;
+        entry.pReflector->serialize(reflection);
+
+        // Write to a temporary file first, so that other processes never see a partially written entry
+        const std::string filename = getEntryFilename(key);
+        const std::string tempFilename = filename + ".tmp";
+        {
+            BinaryFileStream stream(tempFilename, BinaryFileStream::Mode::Write);
+            stream << kCacheMagic << kCacheVersion;
+            writeString(stream, key);
+
+            stream << (uint32_t)entry.dependencies.size();
+            for (const auto& dep : entry.dependencies)
+            {
+                writeString(stream, dep);
+                stream << getFileHash(dep);
+            }
+
+            stream << (uint64_t)reflection.size();
+            stream.write(reflection.data(), reflection.size());
+
+            for (uint32_t i = 0; i < kShaderCount; i++)
+            {
+                stream << (uint32_t)entry.shaderBlob[i].type << (uint64_t)entry.shaderBlob[i].data.size();
+                stream.write(entry.shaderBlob[i].data.data(), entry.shaderBlob[i].data.size());
+            }
+
+            if (stream.isFail())
+            {
+                logWarning("Failed to write shader cache entry '" + filename + "'");
+                stream.remove();
+                return;
+            }
+        }
+
+        std::remove(filename.c_str());
+        if (std::rename(tempFilename.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(tempFilename.c_str());
+            return;
+        }
+        gStats.stores++;
+    }
+
+    ShaderCache::Stats ShaderCache::getStats()
+    {
+        Stats stats;
+        stats.hits = gStats.hits.load();
+        stats.misses = gStats.misses.load();
+        stats.stores = gStats.stores.load();
+        return stats;
+    }
+}
@@ -0,0 +1,107 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "API/Shader.h"
+#include "Graphics/Program/ProgramReflection.h"
+
+namespace Falcor
+{
+    /** Persistent on-disk cache of compiled programs.
+        Each entry holds the final shader bytecode for every stage and the serialized program reflection, so a hit skips both Slang and the downstream compiler.
+        Entries are addressed by a key which the program builds from the compilation inputs (sources, defines, target and compiler flags).
+        The files the compiler touched are stored with a hash of their content. An entry is only used if all of them are unchanged.
+    */
+    class ShaderCache
+    {
+    public:
+        static const uint32_t kShaderCount = (uint32_t)ShaderType::Count;
+
+        /** The data stored for a single program version
+        */
+        struct Entry
+        {
+            Shader::Blob shaderBlob[kShaderCount];      ///< Per-stage bytecode. Unused stages are empty
+            ProgramReflection::SharedPtr pReflector;    ///< The program reflection
+            std::vector<std::string> dependencies;      ///< Full paths of all the files the compiler read
+        };
+
+        /** Cache statistics for the current process
+        */
+        struct Stats
+        {
+            uint32_t hits = 0;          ///< Number of entries which were found and were up-to-date
+            uint32_t misses = 0;        ///< Number of lookups which required a compilation
+            uint32_t stores = 0;        ///< Number of entries written to disk
+        };
+
+        /** Enable or disable the cache. The cache is enabled by default
+        */
+        static void setEnabled(bool enabled);
+
+        /** Check if the cache is enabled
+        */
+        static bool isEnabled();
+
+        /** Set the directory where the cache files are stored. The default is a 'ShaderCache' folder next to the executable
+        */
+        static void setDirectory(const std::string& directory);
+
+        /** Get the cache directory
+        */
+        static const std::string& getDirectory();
+
+        /** Hash a block of memory. The result is stable across runs and platforms
+        */
+        static uint64_t hashData(const void* pData, size_t size);
+
+        /** Get a hash of a file's content. The result is cached for as long as the file's modification time doesn't change.
+            \param[in] fullpath The full path to the file
+            \return The hash, or 0 if the file can't be read
+        */
+        static uint64_t getFileHash(const std::string& fullpath);
+
+        /** Look up an entry
+            \param[in] key The key the entry was stored with
+            \param[out] entry On success, the cached data
+            \return true if an up-to-date entry was found, otherwise false
+        */
+        static bool load(const std::string& key, Entry& entry);
+
+        /** Write an entry into the cache. Existing entries with the same key are replaced.
+            \param[in] key The key identifying the entry
+            \param[in] entry The data to store
+        */
+        static void store(const std::string& key, const Entry& entry);
+
+        /** Get a snapshot of the statistics
+        */
+        static Stats getStats();
+    };
+}
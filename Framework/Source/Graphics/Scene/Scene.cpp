@@ -129,10 +129,24 @@ namespace Falcor
             }
         }
 
+        // Evaluate the poses of all the animated instances in one batch
+        mPosesToEvaluate.clear();
         for (uint32_t i = 0; i < mModels.size(); i++)
         {
-            mModels[i][0]->getObject()->animate(currentTime);
+            const AnimationController* pController = getModel(i)->getAnimationController();
+            if (pController == nullptr) continue;
+
+            for (auto& pose : mInstancePoses[i])
+            {
+                // Instances start with an empty pose, and the model's controller might have been replaced since the last update
+                if (pose.pController != pController)
+                {
+                    pose = pController->createPose();
+                }
+                mPosesToEvaluate.push_back(&pose);
+            }
         }
+        AnimationController::evaluatePoses(mPosesToEvaluate.data(), mPosesToEvaluate.size(), currentTime);
 
         mExtentsDirty = mExtentsDirty || changed;
 
@@ -156,14 +170,18 @@ namespace Falcor
 
         // Delete entire vector of instances
         mModels.erase(mModels.begin() + modelID);
+        mInstancePoses.erase(mInstancePoses.begin() + modelID);
 
         mExtentsDirty = true;
+        mBvhDirty = true;
     }
 
     void Scene::deleteAllModels()
     {
         mModels.clear();
+        mInstancePoses.clear();
         mExtentsDirty = true;
+        mBvhDirty = true;
     }
 
     uint32_t Scene::getModelInstanceCount(uint32_t modelID) const
@@ -180,6 +198,8 @@ namespace Falcor
 
     void Scene::addModelInstance(const ModelInstance::SharedPtr& pInstance)
     {
+        mBvhDirty = true;
+
         // Checking for existing instance list for model
         for (uint32_t modelID = 0; modelID < (uint32_t)mModels.size(); modelID++)
         {
@@ -187,6 +207,7 @@ namespace Falcor
             if (getModel(modelID) == pInstance->getObject())
             {
                 mModels[modelID].push_back(pInstance);
+                mInstancePoses[modelID].emplace_back();
                 return;
             }
         }
@@ -194,6 +215,7 @@ namespace Falcor
         // If not found, add a new list
         mModels.emplace_back();
         mModels.back().push_back(pInstance);
+        mInstancePoses.emplace_back(1);
         mExtentsDirty = true;
     }
 
@@ -213,10 +235,12 @@ namespace Falcor
         {
             //  Erase the instance.
             instances.erase(instances.begin() + instanceID);
+            mInstancePoses[modelID].erase(mInstancePoses[modelID].begin() + instanceID);
         }
 
         //  Extents will be dirty in either case.
         mExtentsDirty = true;
+        mBvhDirty = true;
     }
 
     const Scene::UserVariable& Scene::getUserVariable(const std::string& name) const
@@ -315,6 +339,7 @@ namespace Falcor
 #define merge(name_) name_.insert(name_.end(), pFrom->name_.begin(), pFrom->name_.end());
 
         merge(mModels);
+        merge(mInstancePoses);
         merge(mpLights);
         merge(mpPaths);
         merge(mpMaterials);
@@ -322,6 +347,20 @@ namespace Falcor
 #undef merge
         mUserVars.insert(pFrom->mUserVars.begin(), pFrom->mUserVars.end());
         mExtentsDirty = true;
+        mBvhDirty = true;
+    }
+
+    const SceneBvh* Scene::getBvh()
+    {
+        if (mpBvh == nullptr)
+        {
+            mpBvh = SceneBvh::create();
+        }
+
+        // The BVH only looks at the instances when an instance changed since its last update, so adding or removing model instances has to force a rebuild
+        mpBvh->update(this, mBvhDirty);
+        mBvhDirty = false;
+        return mpBvh.get();
     }
 
     void Scene::createAreaLights()
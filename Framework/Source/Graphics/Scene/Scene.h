@@ -37,6 +37,7 @@
 #include "Graphics/Paths/ObjectPath.h"
 #include "Graphics/Model/ObjectInstance.h"
 #include "Graphics/Material/MaterialHistory.h"
+#include "Graphics/Scene/SceneBvh.h"
 
 namespace Falcor
 {
@@ -99,7 +100,8 @@ namespace Falcor
         {
 			None                =   0x0,
 			GenerateAreaLights  =   0x1,    ///< Create area light(s) for meshes that have emissive material
-            StoreMaterialHistory =  0x2     ///< Store history of overridden mesh materials
+            StoreMaterialHistory =  0x2,    ///< Store history of overridden mesh materials
+            ParallelLoad        =   0x4     ///< Read model files, decode textures and parse include files on worker threads. Objects are still added to the scene in file order
         };
 
         static Scene::SharedPtr loadFromFile(const std::string& filename, Model::LoadFlags modelLoadFlags = Model::LoadFlags::None, Scene::LoadFlags sceneLoadFlags = LoadFlags::None);
@@ -121,6 +123,12 @@ namespace Falcor
         const ModelInstance::SharedPtr& getModelInstance(uint32_t modelID, uint32_t instanceID) const { return mModels[modelID][instanceID]; };
         void deleteModelInstance(uint32_t modelID, uint32_t instanceID);
 
+        /** Get the animation state of a model instance. Every instance of an animated model has its own pose, which is evaluated by update().
+            Set the pose's animationID and timeOffset to make instances play different animations.
+        */
+        AnimationController::Pose& getModelInstancePose(uint32_t modelID, uint32_t instanceID) { return mInstancePoses[modelID][instanceID]; }
+        const AnimationController::Pose& getModelInstancePose(uint32_t modelID, uint32_t instanceID) const { return mInstancePoses[modelID][instanceID]; }
+
         // Light sources
         uint32_t addLight(const Light::SharedPtr& pLight);
         void deleteLight(uint32_t lightID);
@@ -199,6 +207,10 @@ namespace Falcor
         */
         void deleteAreaLights();
 
+        /** Get the bounding volume hierarchy over the scene's mesh instances. It is refit or rebuilt as needed before being returned.
+        */
+        const SceneBvh* getBvh();
+
         /** Bind a sampler to all the scene's global materials
         */
         void bindSamplerToMaterials(Sampler::SharedPtr pSampler);
@@ -219,6 +231,8 @@ namespace Falcor
         uint32_t mId;
 
         std::vector<ModelInstanceList> mModels;
+        std::vector<std::vector<AnimationController::Pose>> mInstancePoses;     // Matches mModels
+        std::vector<AnimationController::Pose*> mPosesToEvaluate;
         std::vector<Light::SharedPtr> mpLights;
         std::vector<Material::SharedPtr> mpMaterials;
         std::vector<Camera::SharedPtr> mCameras;
@@ -237,6 +251,9 @@ namespace Falcor
 
         bool mExtentsDirty = true;
 
+        SceneBvh::SharedPtr mpBvh;
+        bool mBvhDirty = true;
+
         using string_uservar_map = std::map<const std::string, UserVariable>;
         string_uservar_map mUserVars;
         static const UserVariable kInvalidVar;
@@ -0,0 +1,307 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SceneBvh.h"
+#include <algorithm>
+#include <numeric>
+#include <cfloat>
+#include "Scene.h"
+#include "Graphics/Camera/Camera.h"
+
+namespace Falcor
+{
+    SceneBvh::SharedPtr SceneBvh::create()
+    {
+        return SharedPtr(new SceneBvh());
+    }
+
+    void SceneBvh::update(const Scene* pScene, bool forceRebuild)
+    {
+        // Nothing moved and no mesh instance was added or removed since the last update, no need to look at the instances.
+        // Scenes report adding and removing model instances through forceRebuild.
+        const uint32_t instanceVersion = ObjectInstanceVersion::get();
+        if (forceRebuild == false && mIsBuilt && instanceVersion == mInstanceVersion) return;
+
+        if (forceRebuild || refit(pScene) == false)
+        {
+            build(pScene);
+        }
+        mInstanceVersion = instanceVersion;
+        mIsBuilt = true;
+    }
+
+    void SceneBvh::computeLeafBounds(Node& node) const
+    {
+        node.min = glm::vec3(FLT_MAX);
+        node.max = glm::vec3(-FLT_MAX);
+        for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+        {
+            const BoundingBox& box = mItems[mItemOrder[i]].box;
+            node.min = glm::min(node.min, box.getMinPos());
+            node.max = glm::max(node.max, box.getMaxPos());
+        }
+    }
+
+    bool SceneBvh::refit(const Scene* pScene)
+    {
+        std::vector<uint32_t> changedLeaves;
+        uint32_t itemIndex = 0;
+
+        // Walk the scene in item order. Any difference in the instances means the structure changed and the tree needs to be rebuilt.
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const Scene::ModelInstance* pModelInstance = pScene->getModelInstance(modelID, instanceID).get();
+                const uint32_t modelInstanceVersion = pModelInstance->getTransformVersion();
+
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID).get();
+                        if (itemIndex >= mItems.size()) return false;
+
+                        Item& item = mItems[itemIndex++];
+                        if (item.pModelInstance != pModelInstance || item.pMeshInstance != pMeshInstance) return false;
+
+                        const uint32_t meshInstanceVersion = pMeshInstance->getTransformVersion();
+                        if (item.modelInstanceVersion != modelInstanceVersion || item.meshInstanceVersion != meshInstanceVersion)
+                        {
+                            item.box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
+                            item.modelInstanceVersion = modelInstanceVersion;
+                            item.meshInstanceVersion = meshInstanceVersion;
+                            changedLeaves.push_back(item.leaf);
+                        }
+                    }
+                }
+            }
+        }
+
+        if (itemIndex != mItems.size()) return false;
+
+        // Refit the changed leaves and their ancestors. Stop climbing once a node's bounds don't change.
+        for (uint32_t leaf : changedLeaves)
+        {
+            Node& node = mNodes[leaf];
+            const glm::vec3 oldMin = node.min;
+            const glm::vec3 oldMax = node.max;
+            computeLeafBounds(node);
+            if (oldMin == node.min && oldMax == node.max) continue;
+
+            uint32_t parent = node.parent;
+            while (parent != kInvalidIndex)
+            {
+                Node& parentNode = mNodes[parent];
+                const Node& left = mNodes[parentNode.leftChild];
+                const Node& right = mNodes[parentNode.leftChild + 1];
+                const glm::vec3 newMin = glm::min(left.min, right.min);
+                const glm::vec3 newMax = glm::max(left.max, right.max);
+                if (newMin == parentNode.min && newMax == parentNode.max) break;
+
+                parentNode.min = newMin;
+                parentNode.max = newMax;
+                parent = parentNode.parent;
+            }
+        }
+        return true;
+    }
+
+    void SceneBvh::build(const Scene* pScene)
+    {
+        mItems.clear();
+        mNodes.clear();
+        mModelFirstInstance.clear();
+        mInstanceFirstItem.clear();
+        mModelFirstMesh.clear();
+        mMeshItemOffset.clear();
+
+        BoundingBoxArray modelBoxes;
+        BoundingBoxArray worldBoxes;
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+
+            // All the instances of a model share the mesh layout, so the model-space boxes are transformed by each instance in one batch
+            mModelFirstInstance.push_back((uint32_t)mInstanceFirstItem.size());
+            mModelFirstMesh.push_back((uint32_t)mMeshItemOffset.size());
+            modelBoxes.clear();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                mMeshItemOffset.push_back((uint32_t)modelBoxes.size());
+                for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                {
+                    modelBoxes.push_back(pModel->getMeshInstance(meshID, meshInstanceID)->getBoundingBox());
+                }
+            }
+
+            for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const Scene::ModelInstance* pModelInstance = pScene->getModelInstance(modelID, instanceID).get();
+                mInstanceFirstItem.push_back((uint32_t)mItems.size());
+                modelBoxes.transform(pModelInstance->getTransformMatrix(), worldBoxes);
+
+                uint32_t box = 0;
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        Item item;
+                        item.pModelInstance = pModelInstance;
+                        item.pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID).get();
+                        item.modelInstanceVersion = pModelInstance->getTransformVersion();
+                        item.meshInstanceVersion = item.pMeshInstance->getTransformVersion();
+                        item.box = worldBoxes.get(box++);
+                        mItems.push_back(item);
+                    }
+                }
+            }
+        }
+
+        mItemOrder.resize(mItems.size());
+        std::iota(mItemOrder.begin(), mItemOrder.end(), 0);
+
+        if (mItems.size())
+        {
+            mNodes.reserve(2 * (mItems.size() / kMaxItemsPerLeaf + 1));
+            mNodes.emplace_back();
+            buildNode(0, 0, (uint32_t)mItems.size());
+        }
+    }
+
+    void SceneBvh::buildNode(uint32_t nodeIndex, uint32_t firstItem, uint32_t itemCount)
+    {
+        mNodes[nodeIndex].firstItem = firstItem;
+        mNodes[nodeIndex].itemCount = itemCount;
+        computeLeafBounds(mNodes[nodeIndex]);
+
+        // Split along the longest axis of the item centers, at the median
+        glm::vec3 centerMin(FLT_MAX);
+        glm::vec3 centerMax(-FLT_MAX);
+        for (uint32_t i = firstItem; i < firstItem + itemCount; i++)
+        {
+            centerMin = glm::min(centerMin, mItems[mItemOrder[i]].box.center);
+            centerMax = glm::max(centerMax, mItems[mItemOrder[i]].box.center);
+        }
+        const glm::vec3 centerExtent = centerMax - centerMin;
+        uint32_t axis = (centerExtent.x > centerExtent.y) ? 0 : 1;
+        axis = (centerExtent.z > centerExtent[axis]) ? 2 : axis;
+
+        // Items which can't be separated stay in the same leaf
+        if (itemCount <= kMaxItemsPerLeaf || centerExtent[axis] <= 0)
+        {
+            for (uint32_t i = firstItem; i < firstItem + itemCount; i++)
+            {
+                mItems[mItemOrder[i]].leaf = nodeIndex;
+            }
+            return;
+        }
+
+        const uint32_t leftCount = itemCount / 2;
+        auto first = mItemOrder.begin() + firstItem;
+        std::nth_element(first, first + leftCount, first + itemCount, [this, axis](uint32_t a, uint32_t b)
+        {
+            return mItems[a].box.center[axis] < mItems[b].box.center[axis];
+        });
+
+        const uint32_t leftChild = (uint32_t)mNodes.size();
+        mNodes.emplace_back();
+        mNodes.emplace_back();
+        mNodes[nodeIndex].leftChild = leftChild;
+        mNodes[leftChild].parent = nodeIndex;
+        mNodes[leftChild + 1].parent = nodeIndex;
+
+        buildNode(leftChild, firstItem, leftCount);
+        buildNode(leftChild + 1, firstItem + leftCount, itemCount - leftCount);
+    }
+
+    uint32_t SceneBvh::cull(const Camera* pCamera, std::vector<uint8_t>& visibility) const
+    {
+        visibility.assign(mItems.size(), 0);
+        if (mNodes.empty()) return 0;
+
+        struct StackEntry
+        {
+            uint32_t node;
+            uint32_t planeMask;     // The frustum planes the node's parent intersects
+        };
+        std::vector<StackEntry> stack;
+        stack.reserve(64);
+        stack.push_back({ 0, Camera::kAllFrustumPlanes });
+
+        // Items of leaves which intersect the frustum's boundary are collected and tested in one batch at the end
+        mCandidateItems.clear();
+        mCandidateBoxes.clear();
+
+        uint32_t visibleCount = 0;
+        while (stack.size())
+        {
+            const StackEntry entry = stack.back();
+            stack.pop_back();
+
+            const Node& node = mNodes[entry.node];
+            uint32_t planeMask = entry.planeMask;
+            if (pCamera->isObjectCulled(BoundingBox::fromMinMax(node.min, node.max), planeMask)) continue;
+
+            if (planeMask == 0)
+            {
+                // Fully inside the frustum, accept the entire subtree
+                for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+                {
+                    visibility[mItemOrder[i]] = 1;
+                }
+                visibleCount += node.itemCount;
+            }
+            else if (node.isLeaf())
+            {
+                for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+                {
+                    mCandidateItems.push_back(mItemOrder[i]);
+                    mCandidateBoxes.push_back(mItems[mItemOrder[i]].box);
+                }
+            }
+            else
+            {
+                stack.push_back({ node.leftChild + 1, planeMask });
+                stack.push_back({ node.leftChild, planeMask });
+            }
+        }
+
+        if (mCandidateItems.size())
+        {
+            visibleCount += (uint32_t)pCamera->cullBoundingBoxes(mCandidateBoxes, mVisibleCandidates);
+            for (uint32_t candidate : mVisibleCandidates)
+            {
+                visibility[mCandidateItems[candidate]] = 1;
+            }
+        }
+
+        return visibleCount;
+    }
+}
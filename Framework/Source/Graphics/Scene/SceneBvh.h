@@ -0,0 +1,137 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "Utils/AABB.h"
+#include "Utils/BoundingBoxArray.h"
+#include "Graphics/Model/Model.h"
+#include "Graphics/Model/ObjectInstance.h"
+
+namespace Falcor
+{
+    class Scene;
+    class Camera;
+
+    /** Bounding volume hierarchy over the mesh instances of a scene, used for frustum culling.
+        Each mesh instance of each model instance is an item. Items are numbered in scene order (model, model instance, mesh, mesh instance), which is the order SceneRenderer draws them in.
+        When instance transforms change only the affected nodes are refit. The tree is rebuilt when instances are added or removed. Frames in which no instance changed skip the update, see ObjectInstanceVersion.
+    */
+    class SceneBvh
+    {
+    public:
+        using SharedPtr = std::shared_ptr<SceneBvh>;
+        using SharedConstPtr = std::shared_ptr<const SceneBvh>;
+
+        /** Create an empty BVH. Call update() to build it
+        */
+        static SharedPtr create();
+
+        /** Bring the BVH up-to-date with the scene. The tree is rebuilt if the scene's instances changed since the last call, otherwise nodes containing instances whose transform changed are refit.
+            \param[in] pScene The scene
+            \param[in] forceRebuild Rebuild the tree even if the scene's structure didn't change. Refitting degrades the tree quality when objects move a lot, rebuilding restores it
+        */
+        void update(const Scene* pScene, bool forceRebuild = false);
+
+        /** Get the index of the item representing the first instance of a mesh in a model instance. Instance N of the mesh is item getItemIndex() + N.
+        */
+        uint32_t getItemIndex(uint32_t modelID, uint32_t modelInstanceID, uint32_t meshID) const
+        {
+            return mInstanceFirstItem[mModelFirstInstance[modelID] + modelInstanceID] + mMeshItemOffset[mModelFirstMesh[modelID] + meshID];
+        }
+
+        /** Get the total number of items
+        */
+        uint32_t getItemCount() const { return (uint32_t)mItems.size(); }
+
+        /** Get the number of nodes in the tree
+        */
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+
+        /** Get the world-space bounding box of an item
+        */
+        const BoundingBox& getItemBoundingBox(uint32_t itemIndex) const { return mItems[itemIndex].box; }
+
+        /** Frustum-cull all the items. Subtrees outside the frustum are skipped and subtrees fully inside it are accepted without testing the items. The items of leaves which intersect the frustum's boundary are tested in a single Camera#cullBoundingBoxes() batch.
+            Uses scratch memory owned by the BVH, so concurrent calls on the same BVH are not allowed.
+            \param[in] pCamera The camera to cull against
+            \param[out] visibility Per-item result, indexed by item index. 1 if the item is inside or intersects the frustum, otherwise 0
+            \return The number of visible items
+        */
+        uint32_t cull(const Camera* pCamera, std::vector<uint8_t>& visibility) const;
+
+    private:
+        SceneBvh() = default;
+
+        static const uint32_t kInvalidIndex = (uint32_t)-1;
+        static const uint32_t kMaxItemsPerLeaf = 4;
+
+        struct Item
+        {
+            const ObjectInstance<Model>* pModelInstance = nullptr;
+            const Model::MeshInstance* pMeshInstance = nullptr;
+            uint32_t modelInstanceVersion = 0;
+            uint32_t meshInstanceVersion = 0;
+            uint32_t leaf = kInvalidIndex;      // The leaf node containing the item
+            BoundingBox box;                    // World-space bounding box
+        };
+
+        struct Node
+        {
+            glm::vec3 min;
+            uint32_t firstItem = 0;             // Index into mItemOrder. A node's items are contiguous
+            glm::vec3 max;
+            uint32_t itemCount = 0;
+            uint32_t leftChild = kInvalidIndex; // The right child is always leftChild + 1. kInvalidIndex for leaves
+            uint32_t parent = kInvalidIndex;
+
+            bool isLeaf() const { return leftChild == kInvalidIndex; }
+        };
+
+        bool refit(const Scene* pScene);
+        void build(const Scene* pScene);
+        void buildNode(uint32_t nodeIndex, uint32_t firstItem, uint32_t itemCount);
+        void computeLeafBounds(Node& node) const;
+
+        std::vector<Item> mItems;               // In scene order
+        std::vector<uint32_t> mItemOrder;       // Item indices, ordered by the tree
+        std::vector<Node> mNodes;               // Node 0 is the root. Children are always stored after their parent
+        uint32_t mInstanceVersion = 0;          // ObjectInstanceVersion at the last update
+        bool mIsBuilt = false;
+
+        // Scratch space for cull(), kept across calls to avoid reallocating every frame
+        mutable std::vector<uint32_t> mCandidateItems;
+        mutable BoundingBoxArray mCandidateBoxes;
+        mutable std::vector<uint32_t> mVisibleCandidates;
+
+        // Item lookup tables
+        std::vector<uint32_t> mModelFirstInstance;  // [modelID] -> index into mInstanceFirstItem
+        std::vector<uint32_t> mInstanceFirstItem;   // [model instance] -> the instance's first item
+        std::vector<uint32_t> mModelFirstMesh;      // [modelID] -> index into mMeshItemOffset
+        std::vector<uint32_t> mMeshItemOffset;      // [mesh] -> offset of the mesh's first item relative to the model instance's first item
+    };
+}
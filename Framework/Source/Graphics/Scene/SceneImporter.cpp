@@ -37,6 +37,9 @@
 #include <fstream>
 #include <algorithm>
 #include "Graphics/TextureHelper.h"
+#include "Graphics/TextureStreamer.h"
+#include "Graphics/TextureProcessor.h"
+#include "Utils/TaskScheduler.h"
 
 #define SCENE_IMPORTER
 #include "SceneExportImportCommon.h"
@@ -190,12 +193,24 @@ namespace Falcor
         }
 
         // Load the model
-        std::string file =  mDirectory + '/' + modelFile.GetString();
-        if (doesFileExist(file) == false)
+        std::string file = getModelPath(modelFile.GetString());
+        Model::SharedPtr pModel;
+        auto preloaded = mPreloadedModels.find(file);
+        if (preloaded != mPreloadedModels.end())
+        {
+            TaskScheduler::get()->waitForFuture(preloaded->second.data);
+            pModel = Model::createFromFile(file.c_str(), mModelLoadFlags, preloaded->second.data.get().get());
+
+            // Release the CPU-side copy once the last model using it was created
+            if (--preloaded->second.pendingUses == 0)
+            {
+                mPreloadedModels.erase(preloaded);
+            }
+        }
+        else
         {
-            file = modelFile.GetString();
+            pModel = Model::createFromFile(file.c_str(), mModelLoadFlags);
         }
-        auto pModel = Model::createFromFile(file.c_str(), mModelLoadFlags);
         if(pModel == nullptr)
         {
             return error("Could not load model: " + file);
@@ -454,22 +469,42 @@ namespace Falcor
         return true;
     }
 
-    bool SceneImporter::createMaterialTexture(const rapidjson::Value& jsonValue, Texture::SharedPtr& pTexture, bool isSrgb)
+    bool SceneImporter::createMaterialTexture(const rapidjson::Value& jsonValue, Texture::SharedPtr& pTexture, bool isSrgb, bool isNormalMap)
     {
         if(jsonValue.IsString() == false)
         {
             return error("Material texture should be a string");
         }
 
-        std::string filename = jsonValue.GetString();
-        // Check if the file exists relative to the scene file
-        std::string fullpath = mDirectory + "/" + filename;
-        if(doesFileExist(fullpath))
+        std::string filename = getTexturePath(jsonValue.GetString());
+        const bool compress = is_set(mModelLoadFlags, Model::LoadFlags::CompressTextures);
+
+        std::shared_ptr<const Bitmap> pBitmap;
+        auto preloaded = mPreloadedBitmaps.find(filename);
+        if (preloaded != mPreloadedBitmaps.end())
         {
-            filename = fullpath;
+            TaskScheduler::get()->waitForFuture(preloaded->second);
+            pBitmap = preloaded->second.get();
         }
 
-        pTexture = createTextureFromFile(filename, true, isSrgb);
+        if (is_set(mModelLoadFlags, Model::LoadFlags::StreamTextures))
+        {
+            // Stream the compressed file if there is one. Normal maps stay flat until the streamer loads them.
+            std::string ddsFilename;
+            if (compress && TextureProcessor::compressTextureFile(filename, isSrgb, isNormalMap, ddsFilename))
+            {
+                filename = ddsFilename;
+            }
+            pTexture = TextureStreamer::createPlaceholderTexture(filename, isSrgb, isNormalMap ? glm::vec4(0.5f, 0.5f, 1, 1) : glm::vec4(1));
+        }
+        else if (compress)
+        {
+            pTexture = createCompressedTextureFromFile(filename, isSrgb, isNormalMap);
+        }
+        else
+        {
+            pTexture = pBitmap ? createTextureFromBitmap(pBitmap.get(), filename, true, isSrgb) : createTextureFromFile(filename, true, isSrgb);
+        }
         if (pTexture == nullptr)
         {
             return error("Could not load texture: " + filename);
@@ -609,7 +644,7 @@ namespace Falcor
             else if(key == SceneKeys::kMaterialNormal)
             {
                 Texture::SharedPtr pTexture;
-                if (createMaterialTexture(value, pTexture, false))
+                if (createMaterialTexture(value, pTexture, false, true))
                 {
                     pMaterial->setNormalMap(pTexture);
                 }
@@ -1166,6 +1201,11 @@ namespace Falcor
     }
 
     bool SceneImporter::load(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
+    {
+        return readFile(filename, modelLoadFlags, sceneLoadFlags) && finishLoad();
+    }
+
+    bool SceneImporter::readFile(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
     {
         std::string fullpath;
         mFilename = filename;
@@ -1195,26 +1235,154 @@ namespace Falcor
                 return error(std::string("JSON Parse error in line ") + std::to_string(line) + ". " + rapidjson::GetParseError_En(mJDoc.GetParseError()));
             }
 
-            if(topLevelLoop() == false)
+            if(is_set(mSceneLoadFlags, Scene::LoadFlags::ParallelLoad))
             {
-                return false;
+                prefetchResources();
             }
 
-            if(is_set(mSceneLoadFlags, Scene::LoadFlags::GenerateAreaLights))
+            return true;
+        }
+        else
+        {
+            return error("File not found.");
+        }
+    }
+
+    bool SceneImporter::finishLoad()
+    {
+        if(topLevelLoop() == false)
+        {
+            return false;
+        }
+
+        if(is_set(mSceneLoadFlags, Scene::LoadFlags::GenerateAreaLights))
+        {
+            mScene.createAreaLights();
+        }
+
+        if (is_set(mSceneLoadFlags, Scene::LoadFlags::StoreMaterialHistory) == false)
+        {
+            mScene.deleteMaterialHistory();
+        }
+
+        return true;
+    }
+
+    std::string SceneImporter::getModelPath(const std::string& filename) const
+    {
+        std::string file = mDirectory + '/' + filename;
+        if (doesFileExist(file) == false)
+        {
+            file = filename;
+        }
+        return file;
+    }
+
+    std::string SceneImporter::getTexturePath(const std::string& filename) const
+    {
+        // Check if the file exists relative to the scene file
+        std::string fullpath = mDirectory + "/" + filename;
+        return doesFileExist(fullpath) ? fullpath : filename;
+    }
+
+    void SceneImporter::prefetchTexture(const rapidjson::Value& jsonValue, bool isSrgb, bool isNormalMap)
+    {
+        // Invalid values are reported when the section is parsed
+        if (jsonValue.IsString() == false) return;
+
+        // Streamed textures are read later, by the TextureStreamer
+        const bool compress = is_set(mModelLoadFlags, Model::LoadFlags::CompressTextures);
+        if (is_set(mModelLoadFlags, Model::LoadFlags::StreamTextures) && (compress == false)) return;
+
+        std::string filename = getTexturePath(jsonValue.GetString());
+        if (mPreloadedBitmaps.count(filename)) return;
+
+        mPreloadedBitmaps[filename] = TaskScheduler::get()->async([filename, isSrgb, isNormalMap, compress]()
+        {
+            // Compressed textures are loaded from the DDS cache, the task only fills it
+            if (compress)
             {
-                mScene.createAreaLights();
+                std::string ddsFilename;
+                TextureProcessor::compressTextureFile(filename, isSrgb, isNormalMap, ddsFilename);
+                return std::shared_ptr<const Bitmap>();
             }
+            return std::shared_ptr<const Bitmap>(loadTextureBitmapFromFile(filename));
+        }).share();
+    }
+
+    void SceneImporter::prefetchResources()
+    {
+        TaskScheduler* pScheduler = TaskScheduler::get();
 
-            if (is_set(mSceneLoadFlags, Scene::LoadFlags::StoreMaterialHistory) == false)
+        // Material textures
+        const auto& materials = mJDoc.FindMember(SceneKeys::kMaterials);
+        if (materials != mJDoc.MemberEnd() && materials->value.IsArray())
+        {
+            for (const auto& jsonMaterial : materials->value.GetArray())
             {
-                mScene.deleteMaterialHistory();
+                if (jsonMaterial.IsObject() == false) continue;
+                for (auto it = jsonMaterial.MemberBegin(); it != jsonMaterial.MemberEnd(); it++)
+                {
+                    std::string key(it->name.GetString());
+                    if (key == SceneKeys::kMaterialAlpha || key == SceneKeys::kMaterialHeight)
+                    {
+                        prefetchTexture(it->value, false);
+                    }
+                    else if (key == SceneKeys::kMaterialNormal)
+                    {
+                        prefetchTexture(it->value, false, true);
+                    }
+                    else if (key == SceneKeys::kMaterialAO)
+                    {
+                        prefetchTexture(it->value, true);
+                    }
+                    else if (key == SceneKeys::kMaterialLayers && it->value.IsArray())
+                    {
+                        for (const auto& jsonLayer : it->value.GetArray())
+                        {
+                            if (jsonLayer.IsObject() && jsonLayer.HasMember(SceneKeys::kMaterialTexture))
+                            {
+                                prefetchTexture(jsonLayer[SceneKeys::kMaterialTexture], true);
+                            }
+                        }
+                    }
+                }
             }
+        }
 
-            return true;
+        // Models
+        const auto& models = mJDoc.FindMember(SceneKeys::kModels);
+        if (models != mJDoc.MemberEnd() && models->value.IsArray())
+        {
+            for (const auto& jsonModel : models->value.GetArray())
+            {
+                if (jsonModel.IsObject() == false || jsonModel.HasMember(SceneKeys::kFilename) == false || jsonModel[SceneKeys::kFilename].IsString() == false) continue;
+
+                std::string file = getModelPath(jsonModel[SceneKeys::kFilename].GetString());
+                PreloadedModel& model = mPreloadedModels[file];
+                if (model.pendingUses++ == 0)
+                {
+                    Model::LoadFlags flags = mModelLoadFlags;
+                    model.data = pScheduler->async([file, flags]() { return Model::preloadFile(file.c_str(), flags); }).share();
+                }
+            }
         }
-        else
+
+        // Include files. Each one gets its own importer, which starts prefetching its own resources right away.
+        const auto& includes = mJDoc.FindMember(SceneKeys::kInclude);
+        if (includes != mJDoc.MemberEnd() && includes->value.IsArray())
         {
-            return error("File not found.");
+            for (const auto& jsonInclude : includes->value.GetArray())
+            {
+                std::string fullpath;
+                if (jsonInclude.IsString() == false || findIncludeFile(jsonInclude.GetString(), fullpath) == false) continue;
+                if (mPreloadedIncludes.count(fullpath)) continue;
+
+                PreloadedInclude& include = mPreloadedIncludes[fullpath];
+                include.pScene = Scene::create();
+                include.pImporter = std::unique_ptr<SceneImporter>(new SceneImporter(*include.pScene));
+                include.isValid = include.pImporter->readFile(fullpath, mModelLoadFlags, mSceneLoadFlags);
+            }
         }
     }
 
@@ -1383,21 +1551,44 @@ namespace Falcor
         return true;
     }
 
-    bool SceneImporter::loadIncludeFile(const std::string& include)
+    bool SceneImporter::findIncludeFile(const std::string& include, std::string& fullpath) const
     {
-        // Find the file
-        std::string fullpath = mDirectory + '/' + include;
+        fullpath = mDirectory + '/' + include;
         if(doesFileExist(fullpath) == false)
         {
             // Look in the data directories
-            if(findFileInDataDirectories(include, fullpath) == false)
+            return findFileInDataDirectories(include, fullpath);
+        }
+        return true;
+    }
+
+    bool SceneImporter::loadIncludeFile(const std::string& include)
+    {
+        // Find the file
+        std::string fullpath;
+        if(findIncludeFile(include, fullpath) == false)
+        {
+            return error("Can't find include file " + include);
+        }
+
+        Scene::SharedPtr pScene;
+        auto preloaded = mPreloadedIncludes.find(fullpath);
+        if(preloaded != mPreloadedIncludes.end())
+        {
+            // The file was already parsed and its resources are being loaded. Finish it on this thread.
+            pScene = preloaded->second.pScene;
+            if(preloaded->second.isValid)
             {
-                return error("Can't find include file " + include);
+                preloaded->second.pImporter->finishLoad();
             }
+            mPreloadedIncludes.erase(preloaded);
+        }
+        else
+        {
+            pScene = Scene::create();
+            SceneImporter::loadScene(*pScene, fullpath, mModelLoadFlags, mSceneLoadFlags);
         }
 
-        Scene::SharedPtr pScene = Scene::create();
-        SceneImporter::loadScene(*pScene, fullpath, mModelLoadFlags, mSceneLoadFlags);
         if(pScene == nullptr)
         {
             return false;
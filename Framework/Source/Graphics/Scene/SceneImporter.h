@@ -27,8 +27,10 @@
 ***************************************************************************/
 #pragma once
 #include <string>
+#include <future>
 #include "Externals/RapidJson/include/rapidjson/document.h"
 #include "Graphics/Material/Material.h"
+#include "Utils/Bitmap.h"
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
@@ -45,6 +47,8 @@ namespace Falcor
 
         SceneImporter(Scene& scene) : mScene(scene) {}
         bool load(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags);
+        bool readFile(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags);
+        bool finishLoad();
 
         bool parseVersion(const rapidjson::Value& jsonVal);
         bool parseModels(const rapidjson::Value& jsonVal);
@@ -63,6 +67,14 @@ namespace Falcor
         bool topLevelLoop();
 
         bool loadIncludeFile(const std::string& Include);
+        bool findIncludeFile(const std::string& include, std::string& fullpath) const;
+        std::string getModelPath(const std::string& filename) const;
+        std::string getTexturePath(const std::string& filename) const;
+
+        // Parallel loading. The CPU-side work for models, textures and include files is started on worker threads as soon as the file is parsed.
+        // The sections are then processed in order on the calling thread, which picks up the results.
+        void prefetchResources();
+        void prefetchTexture(const rapidjson::Value& jsonValue, bool isSrgb, bool isNormalMap = false);
 
         bool createModel(const rapidjson::Value& jsonModel);
         bool setMaterialOverrides(const rapidjson::Value& jsonVal, const Model::SharedPtr& pModel);
@@ -81,7 +93,7 @@ namespace Falcor
         bool createMaterialLayerNDF(const rapidjson::Value& jsonValue, Material::Layer& layerOut);
         bool createMaterialLayerBlend(const rapidjson::Value& jsonValue, Material::Layer& layerOut);
 
-        bool createMaterialTexture(const rapidjson::Value& jsonValue, Texture::SharedPtr& pTexture, bool isSrgb);
+        bool createMaterialTexture(const rapidjson::Value& jsonValue, Texture::SharedPtr& pTexture, bool isSrgb, bool isNormalMap = false);
 
         bool error(const std::string& msg);
 
@@ -99,6 +111,23 @@ namespace Falcor
         bool isNameDuplicate(const std::string& name, const ObjectMap& objectMap, const std::string& objectType) const;
         IMovableObject::SharedPtr getMovableObject(const std::string& type, const std::string& name) const;
 
+        struct PreloadedModel
+        {
+            std::shared_future<Model::PreloadedFile::SharedPtr> data;
+            uint32_t pendingUses = 0;
+        };
+
+        struct PreloadedInclude
+        {
+            Scene::SharedPtr pScene;
+            std::unique_ptr<SceneImporter> pImporter;
+            bool isValid = false;
+        };
+
+        std::map<std::string, PreloadedModel> mPreloadedModels;
+        std::map<std::string, std::shared_future<std::shared_ptr<const Bitmap>>> mPreloadedBitmaps;
+        std::map<std::string, PreloadedInclude> mPreloadedIncludes;
+
         ObjectMap mInstanceMap;
         ObjectMap mCameraMap;
         ObjectMap mLightMap;
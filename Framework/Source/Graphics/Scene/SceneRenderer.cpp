@@ -37,9 +37,49 @@
 #include "API/Device.h"
 #include "glm/matrix.hpp"
 #include "Graphics/Material/MaterialSystem.h"
+#include "Graphics/Model/Loaders/VertexQuantizer.h"
+#include "Utils/TaskScheduler.h"
+#include "Utils/RadixSort.h"
+#include "Utils/CpuProfiler.h"
+#include <algorithm>
+#include <unordered_map>
 
 namespace Falcor
 {
+    namespace
+    {
+        // Draw key layout, from the most significant bit: program variant (1), material desc (10), material (18), VAO (19), depth (16).
+        // Fields which overflow are clamped. The order is still valid, some state changes just won't be grouped.
+        const uint32_t kDrawKeyDepthBits = 16;
+        const uint32_t kDrawKeyVaoBits = 19;
+        const uint32_t kDrawKeyMaterialBits = 18;
+        const uint32_t kDrawKeyDescBits = 10;
+        const uint64_t kDrawKeyDepthMask = (uint64_t(1) << kDrawKeyDepthBits) - 1;
+        const uint64_t kDrawKeyMaxVaoRank = (uint64_t(1) << kDrawKeyVaoBits) - 1;
+        const uint64_t kDrawKeyMaxMaterialRank = (uint64_t(1) << kDrawKeyMaterialBits) - 1;
+        const uint64_t kDrawKeyMaxDescRank = (uint64_t(1) << kDrawKeyDescBits) - 1;
+
+        uint64_t packDrawKeyField(uint64_t value, uint32_t bits, uint32_t shift)
+        {
+            return std::min(value, (uint64_t(1) << bits) - 1) << shift;
+        }
+
+        uint64_t packDrawKey(uint64_t programVariant, uint64_t descRank, uint64_t materialRank, uint64_t vaoRank, uint64_t depth)
+        {
+            uint32_t shift = 0;
+            uint64_t key = packDrawKeyField(depth, kDrawKeyDepthBits, shift);
+            shift += kDrawKeyDepthBits;
+            key |= packDrawKeyField(vaoRank, kDrawKeyVaoBits, shift);
+            shift += kDrawKeyVaoBits;
+            key |= packDrawKeyField(materialRank, kDrawKeyMaterialBits, shift);
+            shift += kDrawKeyMaterialBits;
+            key |= packDrawKeyField(descRank, kDrawKeyDescBits, shift);
+            shift += kDrawKeyDescBits;
+            key |= packDrawKeyField(programVariant, 1, shift);
+            return key;
+        }
+    }
+
     size_t SceneRenderer::sBonesOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sBonesInvTransposeOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sCameraDataOffset = ConstantBuffer::kInvalidOffset;
@@ -48,7 +88,10 @@ namespace Falcor
     size_t SceneRenderer::sPrevWorldMatOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sWorldInvTransposeMatOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sMeshIdOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sPositionDequantScaleOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sPositionDequantOffsetOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sDrawIDOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sMaterialIndexOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightCountOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightArrayOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sAmbientLightOffset = ConstantBuffer::kInvalidOffset;
@@ -57,6 +100,7 @@ namespace Falcor
     const char* SceneRenderer::kPerFrameCbName = "InternalPerFrameCB";
     const char* SceneRenderer::kPerMeshCbName = "InternalPerMeshCB";
     const char* SceneRenderer::kBoneCbName = "InternalBoneCB";
+    const char* SceneRenderer::kMaterialTableName = "gMaterialTable";
 
     SceneRenderer::SharedPtr SceneRenderer::create(const Scene::SharedPtr& pScene)
     {
@@ -88,6 +132,8 @@ namespace Falcor
                 sWorldMatOffset = pType->findMember("gWorldMat[0]")->getOffset();
                 sWorldInvTransposeMatOffset = pType->findMember("gWorldInvTransposeMat[0]")->getOffset();
                 sMeshIdOffset = pType->findMember("gMeshId")->getOffset();
+                sPositionDequantScaleOffset = pType->findMember("gPositionDequantScale")->getOffset();
+                sPositionDequantOffsetOffset = pType->findMember("gPositionDequantOffset")->getOffset();
                 sDrawIDOffset = pType->findMember("gDrawId[0]")->getOffset();
                 sPrevWorldMatOffset = pType->findMember("gPrevWorldMat[0]")->getOffset();
             }
@@ -143,32 +189,45 @@ namespace Falcor
         }
     }
 
+    void SceneRenderer::setBoneMatrices(const CurrentWorkingData& currentData, const glm::mat4* pBoneMatrices, const glm::mat4* pBoneInvTransposeMatrices, uint32_t boneCount)
+    {
+        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kBoneCbName).get();
+        if (pCB != nullptr)
+        {
+            if (sBonesOffset == ConstantBuffer::kInvalidOffset || sBonesInvTransposeOffset == ConstantBuffer::kInvalidOffset)
+            {
+                sBonesOffset = pCB->getVariableOffset("gBoneMat[0]");
+                sBonesInvTransposeOffset = pCB->getVariableOffset("gInvTransposeBoneMat[0]");
+            }
+
+            assert(boneCount <= MAX_BONES);
+            pCB->setVariableArray(sBonesOffset, pBoneMatrices, boneCount);
+            pCB->setVariableArray(sBonesInvTransposeOffset, pBoneInvTransposeMatrices, boneCount);
+        }
+    }
+
     bool SceneRenderer::setPerModelData(const CurrentWorkingData& currentData)
     {
         const Model* pModel = currentData.pModel;
 
-        // Set bones
+        // Set the model's own pose. Scenes which were updated override it with the pose of each instance.
         if (pModel->hasBones())
         {
-            ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kBoneCbName).get();
-            if (pCB != nullptr)
-            {
-                if (sBonesOffset == ConstantBuffer::kInvalidOffset || sBonesInvTransposeOffset == ConstantBuffer::kInvalidOffset)
-                {
-                    sBonesOffset = pCB->getVariableOffset("gBoneMat[0]");
-                    sBonesInvTransposeOffset = pCB->getVariableOffset("gInvTransposeBoneMat[0]");
-                }
-
-                assert(pModel->getBoneCount() <= MAX_BONES);
-                pCB->setVariableArray(sBonesOffset, pModel->getBoneMatrices(), pModel->getBoneCount());
-                pCB->setVariableArray(sWorldInvTransposeMatOffset, pModel->getBoneInvTransposeMatrices(), pModel->getBoneCount());
-            }
+            setBoneMatrices(currentData, pModel->getBoneMatrices(), pModel->getBoneInvTransposeMatrices(), pModel->getBoneCount());
         }
         return true;
     }
 
     bool SceneRenderer::setPerModelInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t instanceID)
     {
+        if (currentData.pModel->hasBones())
+        {
+            const AnimationController::Pose& pose = mpScene->getModelInstancePose(currentData.modelID, instanceID);
+            if (pose.boneTransforms.empty() == false)
+            {
+                setBoneMatrices(currentData, pose.boneTransforms.data(), pose.boneInvTransposeTransforms.data(), (uint32_t)pose.boneTransforms.size());
+            }
+        }
         return true;
     }
 
@@ -186,24 +245,48 @@ namespace Falcor
 
             assert(drawInstanceID == 0); // We don't support instanced skinned models
 
-            glm::mat4 worldMat = pModelInstance->getTransformMatrix();
-            glm::mat4 prevWorldMat = pModelInstance->getPrevTransformMatrix();
-
-            if (pMesh->hasBones() == false)
+            // The matrices were computed when the draw packets were collected. Compute them here if the hook was called from outside submitDrawPackets().
+            const DrawPacket* pPacket = currentData.pDrawPacket;
+            DrawPacket packet;
+            if (pPacket == nullptr)
             {
-                worldMat = worldMat * pMeshInstance->getTransformMatrix();
-                prevWorldMat = prevWorldMat * pMeshInstance->getPrevTransformMatrix();
+                packet.pMeshInstance = pMeshInstance;
+                packet.worldMat = pModelInstance->getTransformMatrix();
+                packet.prevWorldMat = pModelInstance->getPrevTransformMatrix();
+                if (pMesh->hasBones() == false)
+                {
+                    packet.worldMat = packet.worldMat * pMeshInstance->getTransformMatrix();
+                    packet.prevWorldMat = packet.prevWorldMat * pMeshInstance->getPrevTransformMatrix();
+                }
+                packet.worldInvTransposeMat = transpose(inverse(glm::mat3(packet.worldMat)));
+                pPacket = &packet;
             }
-
-            glm::mat3x4 worldInvTransposeMat = transpose(inverse(glm::mat3(worldMat)));
+            assert(pPacket->pMeshInstance == pMeshInstance);
 
             assert(drawInstanceID < sWorldMatArraySize);
-            pCB->setBlob(&worldMat, sWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
-            pCB->setBlob(&worldInvTransposeMat, sWorldInvTransposeMatOffset + drawInstanceID * sizeof(glm::mat3x4), sizeof(glm::mat3x4)); // HLSL uses column-major and packing rules require 16B alignment, hence use glm:mat3x4
-            pCB->setBlob(&prevWorldMat, sPrevWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
+            pCB->setBlob(&pPacket->worldMat, sWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
+            pCB->setBlob(&pPacket->worldInvTransposeMat, sWorldInvTransposeMatOffset + drawInstanceID * sizeof(glm::mat3x4), sizeof(glm::mat3x4)); // HLSL uses column-major and packing rules require 16B alignment, hence use glm:mat3x4
+            pCB->setBlob(&pPacket->prevWorldMat, sPrevWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
 
             // Set mesh id
             pCB->setVariable(sMeshIdOffset, pMesh->getId());
+
+            // Quantized positions are relative to the bounding-box. Unused by meshes with float positions.
+            glm::vec3 dequantScale, dequantOffset;
+            VertexQuantizer::getPositionDequantization(pMesh->getBoundingBox(), dequantScale, dequantOffset);
+            pCB->setVariable(sPositionDequantScaleOffset, dequantScale);
+            pCB->setVariable(sPositionDequantOffsetOffset, dequantOffset);
+
+            // The material indices are packed 4 per vector
+            if (currentData.bindlessMaterials)
+            {
+                if (sMaterialIndexOffset == ConstantBuffer::kInvalidOffset)
+                {
+                    sMaterialIndexOffset = pCB->getVariableOffset("gMaterialIndex[0]");
+                }
+                uint32_t materialIndex = mpMaterialTable->getMaterialIndex(pMesh->getMaterial().get());
+                pCB->setBlob(&materialIndex, sMaterialIndexOffset + drawInstanceID * sizeof(uint32_t), sizeof(uint32_t));
+            }
         }
 
         return true;
@@ -221,27 +304,57 @@ namespace Falcor
         currentData.pContext->drawIndexedInstanced(indexCount, instanceCount, 0, 0, 0);
     }
 
-    void SceneRenderer::draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount)
+    void SceneRenderer::draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t lod, uint32_t instanceCount)
     {
         currentData.pMaterial = pMesh->getMaterial().get();
-        // Bind material
-        if(mpLastMaterial != pMesh->getMaterial().get())
+
+        // Bind material. The hooks are allowed to replace the vars, in which case it needs to be bound again
+        updateCurrentVars(currentData);
+        const GraphicsVars* pVars = currentData.pVars;
+        if (currentData.bindlessMaterials)
+        {
+            // The table holds all the materials, so it's only bound when the vars change
+            if (mpLastMaterialVars != pVars)
+            {
+                currentData.pVars->setParameterBlock(kMaterialTableName, mpMaterialTable->getParameterBlock());
+                mpLastMaterialVars = pVars;
+                mDrawStats.materialChanges++;
+            }
+        }
+        else if((mpLastMaterial != currentData.pMaterial) || (mpLastMaterialVars != pVars))
         {
             if (setPerMaterialData(currentData, currentData.pMaterial) == false)
             {
                 return;
             }
-            mpLastMaterial = pMesh->getMaterial().get();
+            mpLastMaterial = currentData.pMaterial;
+            mpLastMaterialVars = pVars;
+            mDrawStats.materialChanges++;
+        }
 
-            if(mCompileMaterialWithProgram)
+        // Materials with the same desc compile to the same program, only patch it when the desc changes
+        if(mCompileMaterialWithProgram && (currentData.bindlessMaterials == false))
+        {
+            Program* pProgram = currentData.pState->getProgram().get();
+            uint64_t descIdentifier = mpLastMaterial->getDescIdentifier();
+            if ((pProgram != mpPatchedProgram) || (descIdentifier != mPatchedDescIdentifier))
             {
-                MaterialSystem::patchProgram(currentData.pState->getProgram().get(), mpLastMaterial);
+                MaterialSystem::patchProgram(pProgram, mpLastMaterial);
+                if (std::find(mPatchedPrograms.begin(), mPatchedPrograms.end(), pProgram) == mPatchedPrograms.end())
+                {
+                    mPatchedPrograms.push_back(pProgram);
+                }
+                mpPatchedProgram = pProgram;
+                mPatchedDescIdentifier = descIdentifier;
+                mDrawStats.programChanges++;
             }
         }
 
-        executeDraw(currentData, pMesh->getIndexCount(), instanceCount);
+        uint32_t indexCount = pMesh->getLodIndexCount(lod);
+        executeDraw(currentData, indexCount, instanceCount);
         postFlushDraw(currentData);
-        currentData.pState->getProgram()->removeDefine("_MS_STATIC_MATERIAL_DESC");
+        mDrawStats.drawCalls++;
+        mDrawStats.primitives += (uint32_t)((uint64_t)pMesh->getPrimitiveCount() * indexCount / std::max(pMesh->getIndexCount(), 1u)) * instanceCount;
     }
 
     void SceneRenderer::postFlushDraw(const CurrentWorkingData& currentData)
@@ -249,76 +362,367 @@ namespace Falcor
 
     }
 
-    void SceneRenderer::renderMeshInstances(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t meshID)
+    float SceneRenderer::getPixelsPerUnit(const Mesh* pMesh, const glm::mat4& worldMat) const
     {
-        const Model* pModel = currentData.pModel;
-        const Mesh* pMesh = pModel->getMesh(meshID).get();
+        if (mLodPixelScale == 0) return 0;
 
-        if (setPerMeshData(currentData, pMesh))
+        // Object-space sizes are scaled by the largest axis scale of the transform
+        glm::mat3 mat(worldMat);
+        float scale = std::sqrt(std::max({ glm::dot(mat[0], mat[0]), glm::dot(mat[1], mat[1]), glm::dot(mat[2], mat[2]) }));
+        float pixelsPerUnit = mLodPixelScale * scale;
+        if (mLodPerspective)
         {
-            Program* pProgram = currentData.pState->getProgram().get();
-            if (pMesh->hasBones())
-            {
-                pProgram->addDefine("_VERTEX_BLENDING");
-            }
+            // Use the distance to the closest point of the bounding sphere
+            BoundingBox box = pMesh->getBoundingBox().transform(worldMat);
+            float distance = glm::length(box.center - mLodViewPos) - glm::length(box.extent);
+            pixelsPerUnit /= std::max(distance, mLodNearZ);
+        }
+        return pixelsPerUnit;
+    }
 
-            // Bind VAO and set topology
-            currentData.pState->setVao(pMesh->getVao());
+    uint32_t SceneRenderer::selectLod(const Mesh* pMesh, float pixelsPerUnit) const
+    {
+        if ((mLodEnabled == false) || (pixelsPerUnit == 0) || (pMesh->getLodCount() == 1)) return 0;
 
-            uint32_t activeInstances = 0;
+        // The errors grow with the LOD index
+        uint32_t lod = 0;
+        while ((lod + 1 < pMesh->getLodCount()) && (pMesh->getLodError(lod + 1) * pixelsPerUnit <= mLodErrorThreshold))
+        {
+            lod++;
+        }
+        return lod;
+    }
+
+    void SceneRenderer::collectDrawPackets(uint32_t drawListIndex)
+    {
+        PROFILE_CPU(collectDrawPackets);
+        // Called from worker threads. Only reads scene data, the lazily-updated instance transforms and material descs were resolved by collectDrawLists()
+        DrawList& drawList = mDrawLists[drawListIndex];
+        drawList.packets.clear();
+
+        const Model* pModel = mpScene->getModel(drawList.modelID).get();
+        const Scene::ModelInstance* pModelInstance = mpScene->getModelInstance(drawList.modelID, drawList.modelInstanceID).get();
+        const glm::mat4& instanceMat = pModelInstance->getTransformMatrix();
+        const glm::mat4& prevInstanceMat = pModelInstance->getPrevTransformMatrix();
+        const std::vector<uint64_t>& meshStateKeys = mMeshStateKeys[drawList.modelID];
+
+        for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+        {
+            const Mesh* pMesh = pModel->getMesh(meshID).get();
+            const bool hasBones = pMesh->hasBones();
+
+            // The culling results for this mesh's instances
+            const uint8_t* pVisibility = nullptr;
+            if (mpCullingBvh)
+            {
+                pVisibility = mMeshInstanceVisibility.data() + mpCullingBvh->getItemIndex(drawList.modelID, drawList.modelInstanceID, meshID);
+            }
 
             const uint32_t instanceCount = pModel->getMeshInstanceCount(meshID);
             for (uint32_t instanceID = 0; instanceID < instanceCount; instanceID++)
             {
+                if (pVisibility && (pVisibility[instanceID] == 0)) continue;
+
                 const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, instanceID).get();
-                BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
+                if (pMeshInstance->isVisible() == false) continue;
+
+                drawList.packets.emplace_back();
+                DrawPacket& packet = drawList.packets.back();
+                packet.sortKey = meshStateKeys[meshID] | drawList.depthKey;
+                packet.pMeshInstance = pMeshInstance;
+                packet.drawListIndex = drawListIndex;
+                packet.meshID = meshID;
+                packet.worldMat = instanceMat;
+                packet.prevWorldMat = prevInstanceMat;
+                if (hasBones == false)
+                {
+                    packet.worldMat = packet.worldMat * pMeshInstance->getTransformMatrix();
+                    packet.prevWorldMat = packet.prevWorldMat * pMeshInstance->getPrevTransformMatrix();
+                }
+                packet.worldInvTransposeMat = transpose(inverse(glm::mat3(packet.worldMat)));
 
-                if ((mCullEnabled == false) || (currentData.pCamera->isObjectCulled(box) == false))
+                // The LOD and the resolution of the streamed textures are both selected by the mesh instance's size on screen
+                float pixelsPerUnit = (mpTextureStreamer || (mLodEnabled && pMesh->getLodCount() > 1)) ? getPixelsPerUnit(pMesh, packet.worldMat) : 0;
+                packet.screenSize = pixelsPerUnit * 2 * glm::length(pMesh->getBoundingBox().extent);
+
+                // The LODs of a mesh have consecutive VAO ranks
+                packet.lod = selectLod(pMesh, pixelsPerUnit);
+                packet.sortKey += packDrawKey(0, 0, 0, packet.lod, 0);
+            }
+        }
+    }
+
+    void SceneRenderer::collectDrawLists(const CurrentWorkingData& currentData)
+    {
+        PROFILE_CPU(collectDrawLists);
+        const uint32_t modelCount = mpScene->getModelCount();
+        mMeshStateKeys.resize(modelCount);
+
+        // Ranks are assigned in the order the states first appear in, so that the fields stay small
+        std::unordered_map<uint64_t, uint64_t> descRanks;
+        std::unordered_map<const Material*, uint64_t> materialRanks;
+        std::unordered_map<const Vao*, uint64_t> vaoRanks;
+        uint64_t vaoRankCount = 0;
+
+        // Depth is measured along the view direction, between the near and far planes
+        glm::vec3 viewPos;
+        glm::vec3 viewDir;
+        float nearZ = 0;
+        float depthRange = 1;
+        if (currentData.pCamera)
+        {
+            viewPos = currentData.pCamera->getPosition();
+            viewDir = glm::normalize(currentData.pCamera->getTarget() - viewPos);
+            nearZ = currentData.pCamera->getNearPlane();
+            depthRange = std::max(currentData.pCamera->getFarPlane() - nearZ, 1e-6f);
+        }
+
+        // Errors are projected with the camera's vertical scale. For perspective projections it's divided by the distance.
+        mLodPixelScale = 0;
+        if (currentData.pCamera)
+        {
+            const glm::mat4& proj = currentData.pCamera->getProjMatrix();
+            mLodPixelScale = currentData.pState->getViewport(0).height * 0.5f * std::abs(proj[1][1]);
+            mLodPerspective = (proj[2][3] != 0);
+            mLodViewPos = viewPos;
+            mLodNearZ = std::max(nearZ, 1e-6f);
+        }
+
+        uint32_t drawListCount = 0;
+        for (uint32_t modelID = 0; modelID < modelCount; modelID++)
+        {
+            const Model* pModel = mpScene->getModel(modelID).get();
+
+            std::vector<uint64_t>& meshStateKeys = mMeshStateKeys[modelID];
+            meshStateKeys.resize(pModel->getMeshCount());
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                const Material* pMaterial = pMesh->getMaterial().get();
+
+                // Getting the desc identifier finalizes the material, which isn't thread-safe
+                // The table is filled whenever bindless materials are enabled, since the hooks can switch to vars which use it
+                if (mBindlessMaterials)
+                {
+                    mpMaterialTable->addMaterial(pMesh->getMaterial());
+                }
+
+                // Bindless materials don't cause state changes, so they don't take part in the sort
+                uint64_t descRank = 0;
+                uint64_t materialRank = 0;
+                if (currentData.bindlessMaterials == false)
+                {
+                    descRank = descRanks.emplace(pMaterial->getDescIdentifier(), descRanks.size()).first->second;
+                    materialRank = materialRanks.emplace(pMaterial, materialRanks.size()).first->second;
+                }
+                auto vaoRankIt = vaoRanks.emplace(pMesh->getVao().get(), vaoRankCount);
+                if (vaoRankIt.second)
                 {
-                    if (pMeshInstance->isVisible())
+                    // Reserve ranks for the LODs, keeping them below the largest rank the key can hold
+                    vaoRankCount += pMesh->getLodCount();
+                    vaoRankIt.first->second = std::min(vaoRankIt.first->second, kDrawKeyMaxVaoRank - (pMesh->getLodCount() - 1));
+                }
+                uint64_t vaoRank = vaoRankIt.first->second;
+                meshStateKeys[meshID] = packDrawKey(pMesh->hasBones() ? 1 : 0, descRank, materialRank, vaoRank, 0);
+
+                // Mesh instances are shared between the model instances. Resolve their cached transforms here, before the worker threads read them
+                for (uint32_t instanceID = 0; instanceID < pModel->getMeshInstanceCount(meshID); instanceID++)
+                {
+                    pModel->getMeshInstance(meshID, instanceID)->getTransformMatrix();
+                }
+            }
+
+            for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const Scene::ModelInstance* pInstance = mpScene->getModelInstance(modelID, instanceID).get();
+                if (pInstance->isVisible())
+                {
+                    if (drawListCount == mDrawLists.size()) mDrawLists.emplace_back();
+                    DrawList& drawList = mDrawLists[drawListCount];
+                    drawList.modelID = modelID;
+                    drawList.modelInstanceID = instanceID;
+                    drawList.depthKey = 0;
+                    if (currentData.pCamera)
                     {
-                        if (setPerMeshInstanceData(currentData, pModelInstance, pMeshInstance, activeInstances))
-                        {
-                            currentData.drawID++;
-                            activeInstances++;
-
-                            if (activeInstances == mMaxInstanceCount)
-                            {
-                                // DISABLED_FOR_D3D12
-                                //pContext->setProgram(currentData.pProgram->getActiveProgramVersion());
-                                draw(currentData, pMesh, activeInstances);
-                                activeInstances = 0;
-                            }
-                        }
+                        float depth = (glm::dot(pInstance->getBoundingBox().center - viewPos, viewDir) - nearZ) / depthRange;
+                        drawList.depthKey = packDrawKey(0, 0, 0, 0, (uint64_t)(glm::clamp(depth, 0.0f, 1.0f) * float(kDrawKeyDepthMask)));
                     }
+                    drawListCount++;
                 }
             }
-            if(activeInstances != 0)
+        }
+
+        // All 64 bits of the key are in use, so a field can't simply be widened. Let the user know once that the sort stopped grouping some of the state changes.
+        if (mDrawKeyOverflowReported == false && (vaoRankCount > kDrawKeyMaxVaoRank + 1 || materialRanks.size() > kDrawKeyMaxMaterialRank + 1 || descRanks.size() > kDrawKeyMaxDescRank + 1))
+        {
+            logWarning("SceneRenderer: the scene has more VAOs (" + std::to_string(vaoRankCount) + " including LODs), materials (" + std::to_string(materialRanks.size()) + ") or material descs (" + std::to_string(descRanks.size()) +
+                ") than the draw key can tell apart. The draw order is still valid, but some state changes won't be grouped.");
+            mDrawKeyOverflowReported = true;
+        }
+
+        // Collect the packets in parallel. Don't shrink mDrawLists, so that the packet vectors keep their capacity between passes
+        TaskScheduler::get()->parallelFor(0, drawListCount, [this](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
             {
-                draw(currentData, pMesh, activeInstances);
+                collectDrawPackets((uint32_t)i);
             }
+        });
 
-            // Restore the program state
-            if (pMesh->hasBones())
+        // Build the submission order
+        mSortKeys.clear();
+        mSortedPackets.clear();
+        for (uint32_t i = 0; i < drawListCount; i++)
+        {
+            for (const DrawPacket& packet : mDrawLists[i].packets)
             {
-                pProgram->removeDefine("_VERTEX_BLENDING");
+                mSortKeys.push_back(packet.sortKey);
+                mSortedPackets.push_back(&packet);
             }
         }
+
+        if (mSortDraws)
+        {
+            radixSort(mSortKeys, mSortedPackets, mTempSortKeys, mTempSortedPackets);
+        }
     }
 
-    void SceneRenderer::renderModelInstance(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance)
+    void SceneRenderer::submitDrawPackets(CurrentWorkingData& currentData)
     {
-        mpLastMaterial = nullptr;
+        PROFILE_CPU(submitDrawPackets);
+        // Each hook is called whenever the object it's responsible for changes between consecutive packets
+        uint32_t modelID = uint32_t(-1);
+        const DrawList* pDrawList = nullptr;
+        const Scene::ModelInstance* pModelInstance = nullptr;
+        const Mesh* pMesh = nullptr;
+        uint32_t lod = 0;
+        bool modelValid = false;
+        bool modelInstanceValid = false;
+        bool meshValid = false;
+        Program* pVertexBlendingProgram = nullptr;
+        uint32_t activeInstances = 0;
+
+        for (const DrawPacket* pPacket : mSortedPackets)
+        {
+            const DrawList& drawList = mDrawLists[pPacket->drawListIndex];
+            const bool modelChanged = (drawList.modelID != modelID);
+            const bool modelInstanceChanged = modelChanged || (&drawList != pDrawList);
+            const Mesh* pPacketMesh = mpScene->getModel(drawList.modelID)->getMesh(pPacket->meshID).get();
+            const bool meshChanged = modelInstanceChanged || (pPacketMesh != pMesh);
+            const bool lodChanged = meshChanged || (pPacket->lod != lod);
+
+            // Instances can only be batched together while the rest of the state stays the same
+            if (lodChanged && activeInstances != 0)
+            {
+                draw(currentData, pMesh, lod, activeInstances);
+                activeInstances = 0;
+            }
+
+            if (modelChanged)
+            {
+                modelID = drawList.modelID;
+                currentData.pModel = mpScene->getModel(modelID).get();
+                currentData.modelID = modelID;
+                modelValid = setPerModelData(currentData);
+                updateCurrentVars(currentData);
+                mDrawStats.modelChanges++;
+            }
+            if (modelValid == false) continue;
+
+            if (modelInstanceChanged)
+            {
+                pDrawList = &drawList;
+                pModelInstance = mpScene->getModelInstance(modelID, drawList.modelInstanceID).get();
+                currentData.modelInstanceID = drawList.modelInstanceID;
+                modelInstanceValid = setPerModelInstanceData(currentData, pModelInstance, drawList.modelInstanceID);
+                updateCurrentVars(currentData);
+                mDrawStats.modelInstanceChanges++;
+            }
+            if (modelInstanceValid == false) continue;
+
+            if (meshChanged)
+            {
+                pMesh = pPacketMesh;
+                meshValid = setPerMeshData(currentData, pMesh);
+                updateCurrentVars(currentData);
+                if (meshValid)
+                {
+                    // The program might have been replaced by one of the hooks
+                    Program* pProgram = currentData.pState->getProgram().get();
+                    if (pVertexBlendingProgram && ((pVertexBlendingProgram != pProgram) || (pMesh->hasBones() == false)))
+                    {
+                        pVertexBlendingProgram->removeDefine("_VERTEX_BLENDING");
+                        pVertexBlendingProgram = nullptr;
+                        mDrawStats.programChanges++;
+                    }
+                    if (pMesh->hasBones() && (pVertexBlendingProgram == nullptr))
+                    {
+                        pProgram->addDefine("_VERTEX_BLENDING");
+                        pVertexBlendingProgram = pProgram;
+                        mDrawStats.programChanges++;
+                    }
+
+                }
+            }
+            if (meshValid == false) continue;
+
+            if (mpTextureStreamer)
+            {
+                mpTextureStreamer->reportMaterialUsage(pMesh->getMaterial().get(), pPacket->screenSize);
+            }
+
+            // Bind VAO and set topology. The LODs only differ by their index buffer, so the per-mesh data stays the same.
+            if (lodChanged)
+            {
+                lod = pPacket->lod;
+                const Vao::SharedPtr& pVao = pMesh->getLodVao(lod);
+                if (currentData.pState->getVao() != pVao)
+                {
+                    currentData.pState->setVao(pVao);
+                    mDrawStats.vaoChanges++;
+                }
+            }
+
+            currentData.pDrawPacket = pPacket;
+            if (setPerMeshInstanceData(currentData, pModelInstance, pPacket->pMeshInstance, activeInstances))
+            {
+                currentData.drawID++;
+                activeInstances++;
+                mDrawStats.meshInstances++;
+
+                if (activeInstances == mMaxInstanceCount)
+                {
+                    draw(currentData, pMesh, lod, activeInstances);
+                    activeInstances = 0;
+                }
+            }
+            currentData.pDrawPacket = nullptr;
+        }
 
-        // Loop over the meshes
-        for (uint32_t meshID = 0; meshID < pModelInstance->getObject()->getMeshCount(); meshID++)
+        if (activeInstances != 0)
         {
-            renderMeshInstances(currentData, pModelInstance, meshID);
+            draw(currentData, pMesh, lod, activeInstances);
         }
+
+        // Restore the program state
+        if (pVertexBlendingProgram)
+        {
+            pVertexBlendingProgram->removeDefine("_VERTEX_BLENDING");
+        }
+        for (Program* pProgram : mPatchedPrograms)
+        {
+            pProgram->removeDefine("_MS_STATIC_MATERIAL_DESC");
+        }
+        mPatchedPrograms.clear();
+        mpPatchedProgram = nullptr;
     }
 
     bool SceneRenderer::update(double currentTime)
     {
+        if (mpTextureStreamer)
+        {
+            mpTextureStreamer->update();
+        }
         return mpScene->update(currentTime, mpCameraController.get());
     }
 
@@ -329,27 +733,30 @@ namespace Falcor
 
     void SceneRenderer::renderScene(CurrentWorkingData& currentData)
     {
+        mDrawStats = DrawStats();
+        mpLastMaterial = nullptr;
+        mpLastMaterialVars = nullptr;
+
         setPerFrameData(currentData);
 
-        for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        // Cull all the mesh instances up-front using the scene's BVH
+        currentData.pBvh = nullptr;
+        if (mCullEnabled && currentData.pCamera)
         {
-            currentData.pModel = mpScene->getModel(modelID).get();
+            currentData.pBvh = mpScene->getBvh();
+            currentData.pBvh->cull(currentData.pCamera, mMeshInstanceVisibility);
+        }
+        mpCullingBvh = currentData.pBvh;
 
-            if (setPerModelData(currentData))
-            {
-                for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
-                {
-                    const auto pInstance = mpScene->getModelInstance(modelID, instanceID).get();
-                    if (pInstance->isVisible())
-                    {
-                        if (setPerModelInstanceData(currentData, pInstance, instanceID))
-                        {
-                            renderModelInstance(currentData, pInstance);
-                        }
-                    }
-                }
-            }
+        currentData.bindlessMaterials = usesMaterialTable(currentData.pVars);
+
+        // Collect and sort the visible mesh instances on all threads, then submit them from this one
+        collectDrawLists(currentData);
+        if (mBindlessMaterials)
+        {
+            mpMaterialTable->update();
         }
+        submitDrawPackets(currentData);
     }
 
     void SceneRenderer::renderScene(RenderContext* pContext, Camera* pCamera)
@@ -367,6 +774,32 @@ namespace Falcor
         renderScene(currentData);
     }
 
+    bool SceneRenderer::usesMaterialTable(const GraphicsVars* pVars) const
+    {
+        // Bindless materials are only used with programs which declare the table
+        return mBindlessMaterials && (pVars->getReflection()->getParameterBlockIndex(kMaterialTableName) != ProgramReflection::kInvalidLocation);
+    }
+
+    void SceneRenderer::updateCurrentVars(CurrentWorkingData& currentData) const
+    {
+        // The hooks can replace the context's vars. Everything after them has to go into the new vars, and whether materials are bindless depends on their program.
+        GraphicsVars* pVars = currentData.pContext->getGraphicsVars().get();
+        if (pVars != currentData.pVars)
+        {
+            currentData.pVars = pVars;
+            currentData.bindlessMaterials = usesMaterialTable(pVars);
+        }
+    }
+
+    void SceneRenderer::setBindlessMaterialState(bool enable)
+    {
+        mBindlessMaterials = enable;
+        if (enable && (mpMaterialTable == nullptr))
+        {
+            mpMaterialTable = MaterialTable::create();
+        }
+    }
+
     void SceneRenderer::setCameraControllerType(CameraControllerType type)
     {
         switch(type)
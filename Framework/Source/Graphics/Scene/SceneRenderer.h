@@ -33,6 +33,8 @@
 #include "Utils/CpuTimer.h"
 #include "API/ConstantBuffer.h"
 #include "Utils/DebugDrawer.h"
+#include "Graphics/TextureStreamer.h"
+#include "Graphics/Material/MaterialTable.h"
 
 namespace Falcor
 {
@@ -42,6 +44,7 @@ namespace Falcor
     class Material;
     class Mesh;
     class Camera;
+    class Program;
 
     class SceneRenderer
     {
@@ -81,6 +84,56 @@ namespace Falcor
         */
         void setMaxInstanceCount(uint32_t instanceCount) { mMaxInstanceCount = instanceCount; }
 
+        /** Enable/disable sorting the draws to minimize state changes. When disabled, mesh instances are drawn in scene order.
+            Draws are sorted by program variant, material desc, material, VAO and then front-to-back by model instance.
+        */
+        void setDrawSortState(bool enable) { mSortDraws = enable; }
+
+        /** Enable/disable level-of-detail selection. When enabled, every mesh instance is drawn with the coarsest LOD whose projected error is below the threshold.
+        */
+        void setLodState(bool enable) { mLodEnabled = enable; }
+
+        /** Set the largest error a LOD may have on screen, in pixels
+        */
+        void setLodErrorThreshold(float pixels) { mLodErrorThreshold = pixels; }
+
+        /** Set the streamer which loads the scene's textures. The renderer reports the size on screen of every mesh instance it draws to it, and update() applies the streamed textures.
+            \param[in] pStreamer The texture streamer, or nullptr to stop reporting
+        */
+        void setTextureStreamer(const TextureStreamer::SharedPtr& pStreamer) { mpTextureStreamer = pStreamer; }
+
+        /** Get the texture streamer
+        */
+        const TextureStreamer::SharedPtr& getTextureStreamer() const { return mpTextureStreamer; }
+
+        /** Enable/disable bindless materials. When enabled, the materials are bound once through a MaterialTable instead of one by one, and each instance fetches its material by index.
+            Materials no longer affect the draw order, and static material compilation is skipped since the material can change between the instances of a draw.
+            Only applies to programs compiled with _MS_BINDLESS_MATERIALS, which use getBindlessMaterial() instead of gMaterial. Other programs still bind the materials one by one.
+        */
+        void setBindlessMaterialState(bool enable);
+
+        /** Get the material table used in bindless mode. Materials are added the first time they are drawn, clear the table after removing materials from the scene.
+        */
+        const MaterialTable::SharedPtr& getMaterialTable() const { return mpMaterialTable; }
+
+        /** State-change counters of a single renderScene() call
+        */
+        struct DrawStats
+        {
+            uint32_t drawCalls = 0;             ///< Number of draw calls
+            uint32_t meshInstances = 0;         ///< Number of mesh instances drawn
+            uint32_t primitives = 0;            ///< Number of primitives drawn, after LOD selection
+            uint32_t materialChanges = 0;       ///< Number of times a material, or the material table in bindless mode, was bound
+            uint32_t programChanges = 0;        ///< Number of times the program's defines were changed, either for the material desc or for vertex blending
+            uint32_t vaoChanges = 0;            ///< Number of times the VAO was changed
+            uint32_t modelChanges = 0;          ///< Number of times the per-model data was set
+            uint32_t modelInstanceChanges = 0;  ///< Number of times the per-model-instance data was set
+        };
+
+        /** Get the state-change counters of the last renderScene() call
+        */
+        const DrawStats& getDrawStats() const { return mDrawStats; }
+
         enum class CameraControllerType
         {
             FirstPerson,
@@ -98,6 +151,31 @@ namespace Falcor
 
     protected:
 
+        /** A single mesh instance which passed culling, with its world matrices already computed
+        */
+        struct DrawPacket
+        {
+            uint64_t sortKey = 0;
+            const Model::MeshInstance* pMeshInstance = nullptr;
+            uint32_t drawListIndex = 0;
+            uint32_t meshID = 0;
+            uint32_t lod = 0;
+            float screenSize = 0;   // Diameter of the mesh's bounding sphere in pixels. Only computed when it's needed
+            glm::mat4 worldMat;
+            glm::mat4 prevWorldMat;
+            glm::mat3x4 worldInvTransposeMat;
+        };
+
+        /** The draw packets of a single model instance, in mesh order
+        */
+        struct DrawList
+        {
+            uint32_t modelID = 0;
+            uint32_t modelInstanceID = 0;
+            uint64_t depthKey = 0;
+            std::vector<DrawPacket> packets;
+        };
+
         struct CurrentWorkingData
         {
             RenderContext* pContext = nullptr;
@@ -108,6 +186,11 @@ namespace Falcor
             const Material* pMaterial = nullptr;
 
             uint32_t drawID; // Zero-based mesh instance draw order/ID. Resets at the beginning of renderScene, and increments per mesh instance drawn.
+            uint32_t modelID = 0;
+            uint32_t modelInstanceID = 0;
+            const SceneBvh* pBvh = nullptr; // Used to look up the culling results. nullptr if culling is disabled
+            const DrawPacket* pDrawPacket = nullptr; // The mesh instance being drawn. Set by the renderer around setPerMeshInstanceData(), nullptr everywhere else
+            bool bindlessMaterials = false; // Set when bindless materials are enabled and pVars declares the material table
         };
 
         SceneRenderer(const Scene::SharedPtr& pScene);
@@ -117,6 +200,7 @@ namespace Falcor
         static const char* kPerFrameCbName;
         static const char* kPerMeshCbName;
         static const char* kBoneCbName;
+        static const char* kMaterialTableName;
 
         static size_t sBonesOffset;
         static size_t sBonesInvTransposeOffset;
@@ -129,10 +213,19 @@ namespace Falcor
         static size_t sPrevWorldMatOffset;
         static size_t sWorldInvTransposeMatOffset;
         static size_t sMeshIdOffset;
+        static size_t sPositionDequantScaleOffset;
+        static size_t sPositionDequantOffsetOffset;
         static size_t sDrawIDOffset;
+        static size_t sMaterialIndexOffset;
 
         static void updateVariableOffsets(const ProgramReflection* pReflector);
 
+        /** Hooks which set the shader data of each level of the draw loop. Returning false from a hook skips everything below that level.
+            Draws are submitted from the culled and sorted draw packets, so:
+            - A model, model instance or mesh without any mesh instance which passed culling doesn't get its hook called. Don't rely on setPerMeshData() being called for every mesh of a model.
+            - A hook is called whenever the next draw differs from the previous one at its level or above. When sorting is enabled the same model or mesh can be visited several times per frame, and consecutive draws of the same mesh in the same model instance share a single setPerMeshData() call.
+            - setPerMeshInstanceData() finds the world matrices the renderer already computed in currentData.pDrawPacket. Overrides which call it from anywhere else should leave pDrawPacket as nullptr, the matrices are then computed from the instances.
+        */
         virtual void setPerFrameData(const CurrentWorkingData& currentData);
         virtual bool setPerModelData(const CurrentWorkingData& currentData);
         virtual bool setPerModelInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t instanceID);
@@ -142,18 +235,48 @@ namespace Falcor
         virtual void executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount);
         virtual void postFlushDraw(const CurrentWorkingData& currentData);
 
-        void renderModelInstance(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance);
-        void renderMeshInstances(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t meshID);
-        void draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount);
+        void collectDrawLists(const CurrentWorkingData& currentData);
+        void collectDrawPackets(uint32_t drawListIndex);
+        void submitDrawPackets(CurrentWorkingData& currentData);
+        float getPixelsPerUnit(const Mesh* pMesh, const glm::mat4& worldMat) const;
+        uint32_t selectLod(const Mesh* pMesh, float pixelsPerUnit) const;
+        void draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t lod, uint32_t instanceCount);
+        bool usesMaterialTable(const GraphicsVars* pVars) const;
+        void updateCurrentVars(CurrentWorkingData& currentData) const;
 
         void renderScene(CurrentWorkingData& currentData);
+        void setBoneMatrices(const CurrentWorkingData& currentData, const glm::mat4* pBoneMatrices, const glm::mat4* pBoneInvTransposeMatrices, uint32_t boneCount);
 
         CameraControllerType mCamControllerType = CameraControllerType::SixDof;
         CameraController::SharedPtr mpCameraController;
 
         uint32_t mMaxInstanceCount = 64;
         const Material* mpLastMaterial = nullptr;
+        const GraphicsVars* mpLastMaterialVars = nullptr;
+        Program* mpPatchedProgram = nullptr;            // The program and material desc of the last MaterialSystem::patchProgram() call
+        uint64_t mPatchedDescIdentifier = 0;
+        std::vector<Program*> mPatchedPrograms;         // Programs to remove the material desc define from at the end of the pass
         bool mCullEnabled = true;
+        std::vector<uint8_t> mMeshInstanceVisibility; // Culling results for the current pass, indexed by SceneBvh item index
+        const SceneBvh* mpCullingBvh = nullptr;
+        std::vector<DrawList> mDrawLists;               // One per visible model instance, in scene order. Reused between passes to avoid reallocating the packets
+        std::vector<std::vector<uint64_t>> mMeshStateKeys; // Per model and mesh, the draw key without the depth
+        bool mDrawKeyOverflowReported = false;             // Set once a warning about draw key fields overflowing was logged
+        std::vector<uint64_t> mSortKeys;
+        std::vector<uint64_t> mTempSortKeys;
+        std::vector<const DrawPacket*> mSortedPackets;  // Submission order
+        std::vector<const DrawPacket*> mTempSortedPackets;
+        bool mSortDraws = true;
+        bool mLodEnabled = true;
+        float mLodErrorThreshold = 1.0f;
+        float mLodPixelScale = 0;                       // Converts object-space errors to pixels, at a distance of 1 for perspective projections. 0 if there's no camera
+        bool mLodPerspective = true;
+        glm::vec3 mLodViewPos;
+        float mLodNearZ = 0;
+        DrawStats mDrawStats;
         bool mCompileMaterialWithProgram = true;
+        TextureStreamer::SharedPtr mpTextureStreamer;
+        bool mBindlessMaterials = false;
+        MaterialTable::SharedPtr mpMaterialTable;
     };
 }
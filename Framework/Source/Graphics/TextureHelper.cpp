@@ -27,11 +27,13 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "TextureHelper.h"
+#include "TextureProcessor.h"
 #include "API/Texture.h"
 #include "Utils/Bitmap.h"
 #include "Utils/DDSHeader.h"
 #include "Utils/BinaryFileStream.h"
 #include "Utils/StringUtils.h"
+#include "Utils/CpuProfiler.h"
 #include <cstring>
 
 static const bool kTopDown = true;
@@ -574,7 +576,7 @@ namespace Falcor
             ddsData.hasDX10Header = false;
         }
 
-        uint32_t dataSize = stream.getRemainingStreamSize();
+        size_t dataSize = (size_t)stream.getRemainingStreamSize();
         ddsData.data.resize(dataSize);
         stream.read(ddsData.data.data(), dataSize);
     }
@@ -676,10 +678,12 @@ namespace Falcor
             format = linearToSrgbFormat(format);
         }
 
+        // Files which store their mip-chain are uploaded as is
+        uint32_t storedMipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
         uint32_t mipLevels;
-        if (generateMips == false || isCompressedFormat(format))
+        if (generateMips == false || isCompressedFormat(format) || storedMipLevels > 1)
         {
-            mipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
+            mipLevels = storedMipLevels;
         }
         else
         {
@@ -710,21 +714,187 @@ namespace Falcor
             return createTextureFromDDSFile(filename, generateMipLevels, loadAsSrgb, bindFlags);
         }
 
-        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
-        Texture::SharedPtr pTex;
+        Bitmap::UniqueConstPtr pBitmap = loadTextureBitmapFromFile(filename);
+        return pBitmap ? createTextureFromBitmap(pBitmap.get(), filename, generateMipLevels, loadAsSrgb, bindFlags) : nullptr;
+    }
+#undef no_srgb
 
-        if(pBitmap)
+    Texture::SharedPtr createCompressedTextureFromFile(const std::string& filename, bool loadAsSrgb, bool isNormalMap, Texture::BindFlags bindFlags)
+    {
+        std::string ddsFilename;
+        if (hasSuffix(filename, ".dds") || (TextureProcessor::compressTextureFile(filename, loadAsSrgb, isNormalMap, ddsFilename) == false))
         {
-            ResourceFormat texFormat = pBitmap->getFormat();
-            if(loadAsSrgb)
-            {
-                texFormat = linearToSrgbFormat(texFormat);
-            }
+            return createTextureFromFile(filename, true, loadAsSrgb, bindFlags);
+        }
 
-            pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
-            pTex->setSourceFilename(stripDataDirectories(filename));
+        Texture::SharedPtr pTex = createTextureFromDDSFile(ddsFilename, false, false, bindFlags);
+        if (pTex)
+        {
+            pTex->setSourceFilename(stripDataDirectories(ddsFilename));
         }
         return pTex;
     }
-#undef no_srgb
+
+    Bitmap::UniqueConstPtr loadTextureBitmapFromFile(const std::string& filename)
+    {
+        PROFILE_CPU(loadTextureBitmap);
+        if (hasSuffix(filename, ".dds"))
+        {
+            return nullptr;
+        }
+        return Bitmap::createFromFile(filename, kTopDown);
+    }
+
+    Texture::SharedPtr createTextureFromBitmap(const Bitmap* pBitmap, const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    {
+        ResourceFormat texFormat = pBitmap->getFormat();
+        if(loadAsSrgb)
+        {
+            texFormat = linearToSrgbFormat(texFormat);
+        }
+
+        Texture::SharedPtr pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
+        pTex->setSourceFilename(stripDataDirectories(filename));
+        return pTex;
+    }
+
+    uint64_t getTextureMipChainSize(ResourceFormat format, uint32_t width, uint32_t height, uint32_t firstMip, uint32_t mipCount)
+    {
+        const uint32_t widthRatio = getFormatWidthCompressionRatio(format);
+        const uint32_t heightRatio = getFormatHeightCompressionRatio(format);
+        uint64_t size = 0;
+        for (uint32_t mip = firstMip; mip < firstMip + mipCount; mip++)
+        {
+            uint64_t mipWidth = std::max(width >> mip, 1u);
+            uint64_t mipHeight = std::max(height >> mip, 1u);
+            size += ((mipWidth + widthRatio - 1) / widthRatio) * ((mipHeight + heightRatio - 1) / heightRatio) * getFormatBytesPerBlock(format);
+        }
+        return size;
+    }
+
+    bool isValidTextureTopMip(ResourceFormat format, uint32_t width, uint32_t height, uint32_t mip)
+    {
+        uint32_t mipWidth = std::max(width >> mip, 1u);
+        uint32_t mipHeight = std::max(height >> mip, 1u);
+        return (mipWidth % getFormatWidthCompressionRatio(format) == 0) && (mipHeight % getFormatHeightCompressionRatio(format) == 0);
+    }
+
+    static uint32_t getFullMipCount(uint32_t width, uint32_t height)
+    {
+        uint32_t size = std::max(width, height);
+        uint32_t mipCount = 1;
+        while (size > 1)
+        {
+            size >>= 1;
+            mipCount++;
+        }
+        return mipCount;
+    }
+
+    /** Box-filter the mip-chain of an uncompressed image and store the levels from mipData.firstMip on
+        \param[in] pLevel0 The image's largest mip level
+    */
+    static bool generateMipChain(const uint8_t* pLevel0, TextureMipData& mipData)
+    {
+        TextureProcessor::Settings settings;
+        settings.mipFilter = TextureProcessor::MipFilter::Box;
+        settings.compression = TextureProcessor::Compression::None;
+        settings.firstMip = mipData.firstMip;
+        return TextureProcessor::process(pLevel0, mipData.width, mipData.height, mipData.format, settings, mipData);
+    }
+
+    /** Select the first mip level no larger than maxSize which a texture can still be created from
+    */
+    static uint32_t selectFirstMip(const TextureMipData& mipData, uint32_t maxSize)
+    {
+        uint32_t firstMip = 0;
+        while ((firstMip + 1 < mipData.mipCount) && (std::max(mipData.width >> firstMip, mipData.height >> firstMip) > maxSize) && isValidTextureTopMip(mipData.format, mipData.width, mipData.height, firstMip + 1))
+        {
+            firstMip++;
+        }
+        return firstMip;
+    }
+
+    static bool loadDdsMips(const std::string& filename, bool loadAsSrgb, uint32_t maxSize, TextureMipData& mipData)
+    {
+        DdsData ddsData;
+        loadDDSDataFromFile(filename, ddsData);
+        if (ddsData.data.empty())
+        {
+            return false;
+        }
+
+        bool is2D;
+        if (ddsData.hasDX10Header)
+        {
+            is2D = (ddsData.dx10Header.resourceDimension == DXResourceDimension::RESOURCE_DIMENSION_TEXTURE2D) && (ddsData.dx10Header.arraySize == 1) && ((ddsData.dx10Header.miscFlag & DdsHeaderDX10::kCubeMapMask) == 0);
+        }
+        else
+        {
+            is2D = ((ddsData.header.flags & DdsHeader::kDepthMask) == 0) && ((ddsData.header.caps[1] & DdsHeader::kCaps2CubeMapMask) == 0);
+        }
+        if (is2D == false)
+        {
+            logWarning("loadTextureMipsFromFile() - " + filename + " is not a 2D texture");
+            return false;
+        }
+
+        ResourceFormat format = getDdsResourceFormat(ddsData);
+        if (format == ResourceFormat::Unknown)
+        {
+            logWarning("loadTextureMipsFromFile() - " + filename + " has an unsupported format");
+            return false;
+        }
+        format = convertBgrxFormatToBgra(ddsData, format);
+        mipData.format = loadAsSrgb ? linearToSrgbFormat(format) : format;
+        mipData.width = ddsData.header.width;
+        mipData.height = ddsData.header.height;
+
+        uint32_t storedMipCount = (ddsData.header.flags & DdsHeader::kMipCountMask) ? std::max(ddsData.header.mipCount, 1u) : 1;
+        storedMipCount = std::min(storedMipCount, getFullMipCount(mipData.width, mipData.height));
+        if (ddsData.data.size() < getTextureMipChainSize(mipData.format, mipData.width, mipData.height, 0, storedMipCount))
+        {
+            logWarning("loadTextureMipsFromFile() - " + filename + " is truncated");
+            return false;
+        }
+        flipData(ddsData, mipData.format, mipData.width, mipData.height, 1, storedMipCount);
+
+        // Generate the missing levels if the format allows it
+        mipData.mipCount = ((storedMipCount == 1) && TextureProcessor::isSupportedFormat(mipData.format)) ? getFullMipCount(mipData.width, mipData.height) : storedMipCount;
+        mipData.firstMip = selectFirstMip(mipData, maxSize);
+        if (mipData.mipCount != storedMipCount)
+        {
+            return generateMipChain(ddsData.data.data(), mipData);
+        }
+        else
+        {
+            size_t offset = (size_t)getTextureMipChainSize(mipData.format, mipData.width, mipData.height, 0, mipData.firstMip);
+            size_t size = (size_t)getTextureMipChainSize(mipData.format, mipData.width, mipData.height, mipData.firstMip, mipData.mipCount - mipData.firstMip);
+            mipData.data.assign(ddsData.data.begin() + offset, ddsData.data.begin() + offset + size);
+        }
+        return true;
+    }
+
+    bool loadTextureMipsFromFile(const std::string& filename, bool loadAsSrgb, uint32_t maxSize, TextureMipData& mipData)
+    {
+        PROFILE_CPU(loadTextureMips);
+        mipData = TextureMipData();
+        if (hasSuffix(filename, ".dds"))
+        {
+            return loadDdsMips(filename, loadAsSrgb, maxSize, mipData);
+        }
+
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
+        if (pBitmap == nullptr)
+        {
+            return false;
+        }
+
+        mipData.format = loadAsSrgb ? linearToSrgbFormat(pBitmap->getFormat()) : pBitmap->getFormat();
+        mipData.width = pBitmap->getWidth();
+        mipData.height = pBitmap->getHeight();
+        mipData.mipCount = TextureProcessor::isSupportedFormat(mipData.format) ? getFullMipCount(mipData.width, mipData.height) : 1;
+        mipData.firstMip = selectFirstMip(mipData, maxSize);
+        return generateMipChain(pBitmap->getData(), mipData);
+    }
 }
@@ -27,7 +27,9 @@
 ***************************************************************************/
 #pragma once
 #include <string>
+#include <vector>
 #include "API/Texture.h"
+#include "Utils/Bitmap.h"
 namespace Falcor
 {
     /*!
@@ -43,5 +45,71 @@ namespace Falcor
     */
     Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
 
+    /** Create a block-compressed texture from an image file. The image is processed by TextureProcessor::compressTextureFile(), which caches the result in a DDS file next to it.
+        Falls back to createTextureFromFile() if the image can't be processed.
+        The texture's source filename is the cached DDS file, so reloading the texture (for example by the TextureStreamer) keeps the compressed format.
+        \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory
+        \param[in] loadAsSrgb Whether the image holds sRGB colors
+        \param[in] isNormalMap Whether the image holds a tangent-space normal map. Normal maps are compressed to BC5, which only stores the X and Y components.
+        \param[in] bindFlags The bind flags to create the texture with
+    */
+    Texture::SharedPtr createCompressedTextureFromFile(const std::string& filename, bool loadAsSrgb, bool isNormalMap, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
+
+    /** Decode an image file into system memory without creating a texture. This doesn't access the device, so it can be called from worker threads.
+        DDS files are not decoded, createTextureFromFile() reads them directly.
+        \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory
+        \return The decoded image, or nullptr if the file is a DDS file or loading failed
+    */
+    Bitmap::UniqueConstPtr loadTextureBitmapFromFile(const std::string& filename);
+
+    /** Create a new texture object from an image decoded by loadTextureBitmapFromFile(). Must be called from the thread which owns the device.
+        \param[in] pBitmap The decoded image
+        \param[in] filename The file the image was loaded from. Stored as the texture's source filename
+        \param[in] generateMipLevels Whether the mip-chain should be generated
+        \param[in] loadAsSrgb Load the texture using sRGB format. Only valid for 3 or 4 component textures.
+        \param[in] bindFlags The bind flags to create the texture with
+    */
+    Texture::SharedPtr createTextureFromBitmap(const Bitmap* pBitmap, const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
+
+    /** The mip levels of a 2D image, decoded into system memory by loadTextureMipsFromFile()
+    */
+    struct TextureMipData
+    {
+        ResourceFormat format = ResourceFormat::Unknown;
+        uint32_t width = 0;         ///< Width of the image's largest mip level
+        uint32_t height = 0;        ///< Height of the image's largest mip level
+        uint32_t mipCount = 0;      ///< Number of mip levels in the image's mip-chain
+        uint32_t firstMip = 0;      ///< The first mip level stored in data
+        std::vector<uint8_t> data;  ///< Mip levels firstMip to mipCount-1, tightly packed
+    };
+
+    /** Decode the low-resolution end of a 2D image's mip-chain. This doesn't access the device, so it can be called from worker threads.
+        DDS files are read directly and keep their stored mip levels. For other images, and for uncompressed DDS files without mip levels, the mip-chain is generated by TextureProcessor with a box filter.
+        Cube-maps, volumes and texture arrays are not supported.
+        \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory
+        \param[in] loadAsSrgb Load the texture using sRGB format. Only valid for 3 or 4 component textures.
+        \param[in] maxSize The largest width or height the first returned mip level may have. Block-compressed images return a larger level if the smaller ones are not a multiple of the block size.
+        \param[out] mipData The decoded mip levels
+        \return true if the image was loaded, otherwise false
+    */
+    bool loadTextureMipsFromFile(const std::string& filename, bool loadAsSrgb, uint32_t maxSize, TextureMipData& mipData);
+
+    /** Check if a 2D texture can be created from a mip level of a larger image. The dimensions of block-compressed textures must be a multiple of the block size.
+        \param[in] format The image format
+        \param[in] width Width of the image's largest mip level
+        \param[in] height Height of the image's largest mip level
+        \param[in] mip The mip level which will become the texture's largest one
+    */
+    bool isValidTextureTopMip(ResourceFormat format, uint32_t width, uint32_t height, uint32_t mip);
+
+    /** Get the size in bytes of a range of a 2D texture's mip levels, tightly packed
+        \param[in] format The texture format
+        \param[in] width Width of the largest mip level
+        \param[in] height Height of the largest mip level
+        \param[in] firstMip The first mip level in the range
+        \param[in] mipCount Number of mip levels in the range
+    */
+    uint64_t getTextureMipChainSize(ResourceFormat format, uint32_t width, uint32_t height, uint32_t firstMip, uint32_t mipCount);
+
     /*! @} */
 }
\ No newline at end of file
@@ -0,0 +1,664 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureProcessor.h"
+#include "Utils/Bitmap.h"
+#include "Utils/BlockCompression.h"
+#include "Utils/DDSHeader.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/StringUtils.h"
+#include "Utils/TaskScheduler.h"
+#include "Utils/CpuProfiler.h"
+#include "glm/gtc/packing.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace Falcor
+{
+    using namespace DdsHelper;
+
+    namespace
+    {
+        const uint32_t kDdsMagicNumber = 0x20534444;
+        const float kKaiserRadius = 3;  // In destination texels
+        const float kKaiserAlpha = 4;
+
+        /** How the channels of the formats the CPU mip generation supports are stored
+        */
+        enum class TexelEncoding
+        {
+            Unsupported,
+            Unorm8,
+            Float16,
+            Float32,
+        };
+
+        TexelEncoding getTexelEncoding(ResourceFormat format)
+        {
+            switch (format)
+            {
+            case ResourceFormat::R8Unorm:
+            case ResourceFormat::RG8Unorm:
+            case ResourceFormat::RGBA8Unorm:
+            case ResourceFormat::RGBA8UnormSrgb:
+            case ResourceFormat::BGRA8Unorm:
+            case ResourceFormat::BGRA8UnormSrgb:
+            case ResourceFormat::BGRX8Unorm:
+            case ResourceFormat::BGRX8UnormSrgb:
+                return TexelEncoding::Unorm8;
+            case ResourceFormat::R16Float:
+            case ResourceFormat::RG16Float:
+            case ResourceFormat::RGB16Float:
+            case ResourceFormat::RGBA16Float:
+                return TexelEncoding::Float16;
+            case ResourceFormat::R32Float:
+            case ResourceFormat::RG32Float:
+            case ResourceFormat::RGB32Float:
+            case ResourceFormat::RGBA32Float:
+                return TexelEncoding::Float32;
+            default:
+                return TexelEncoding::Unsupported;
+            }
+        }
+
+        bool isBgrFormat(ResourceFormat format)
+        {
+            switch (format)
+            {
+            case ResourceFormat::BGRA8Unorm:
+            case ResourceFormat::BGRA8UnormSrgb:
+            case ResourceFormat::BGRX8Unorm:
+            case ResourceFormat::BGRX8UnormSrgb:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool isBgrxFormat(ResourceFormat format)
+        {
+            return (format == ResourceFormat::BGRX8Unorm) || (format == ResourceFormat::BGRX8UnormSrgb);
+        }
+
+        float srgbToLinear(float value)
+        {
+            return (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float linearToSrgb(float value)
+        {
+            value = glm::clamp(value, 0.0f, 1.0f);
+            return (value <= 0.0031308f) ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        }
+
+        const float* getSrgbToLinearTable()
+        {
+            static const std::vector<float> table = []()
+            {
+                std::vector<float> t(256);
+                for (uint32_t i = 0; i < 256; i++) t[i] = srgbToLinear(i / 255.0f);
+                return t;
+            }();
+            return table.data();
+        }
+
+        float decodeTexelChannel(const uint8_t* pData, size_t index, TexelEncoding encoding)
+        {
+            switch (encoding)
+            {
+            case TexelEncoding::Unorm8:
+                return pData[index] * (1.0f / 255.0f);
+            case TexelEncoding::Float16:
+            {
+                uint16_t value;
+                std::memcpy(&value, pData + index * sizeof(uint16_t), sizeof(value));
+                return glm::unpackHalf1x16(value);
+            }
+            case TexelEncoding::Float32:
+            {
+                float value;
+                std::memcpy(&value, pData + index * sizeof(float), sizeof(value));
+                return value;
+            }
+            default:
+                should_not_get_here();
+                return 0;
+            }
+        }
+
+        void encodeTexelChannel(float value, TexelEncoding encoding, uint8_t* pData, size_t index)
+        {
+            switch (encoding)
+            {
+            case TexelEncoding::Unorm8:
+                pData[index] = (uint8_t)(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+                break;
+            case TexelEncoding::Float16:
+            {
+                uint16_t half = glm::packHalf1x16(value);
+                std::memcpy(pData + index * sizeof(uint16_t), &half, sizeof(half));
+                break;
+            }
+            case TexelEncoding::Float32:
+                std::memcpy(pData + index * sizeof(float), &value, sizeof(value));
+                break;
+            default:
+                should_not_get_here();
+            }
+        }
+
+        /** Reads the channels of the source image, converting sRGB colors to linear space
+        */
+        struct SourceFetch
+        {
+            const uint8_t* pData;
+            TexelEncoding encoding;
+            uint32_t channelCount;
+            const float* pSrgbTable;    // nullptr if the image is linear
+
+            float operator()(size_t index) const
+            {
+                if (pSrgbTable && (index % channelCount) < 3)
+                {
+                    return pSrgbTable[pData[index]];
+                }
+                return decodeTexelChannel(pData, index, encoding);
+            }
+        };
+
+        /** Box-filter a mip level into the next one. The last row and column of odd-sized levels are clamped.
+            \param[in] fetch Returns a channel of the source level, given its index
+        */
+        template<typename Fetch>
+        void downsampleBox(uint32_t srcWidth, uint32_t srcHeight, uint32_t channelCount, const Fetch& fetch, std::vector<float>& dst)
+        {
+            const uint32_t width = std::max(srcWidth >> 1, 1u);
+            const uint32_t height = std::max(srcHeight >> 1, 1u);
+            dst.resize((size_t)width * height * channelCount);
+            TaskScheduler::get()->parallelFor(0, height, [&](size_t begin, size_t end)
+            {
+                for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++)
+                {
+                    const size_t row0 = (size_t)std::min(2 * y, srcHeight - 1) * srcWidth;
+                    const size_t row1 = (size_t)std::min(2 * y + 1, srcHeight - 1) * srcWidth;
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        const size_t x0 = std::min(2 * x, srcWidth - 1);
+                        const size_t x1 = std::min(2 * x + 1, srcWidth - 1);
+                        for (uint32_t c = 0; c < channelCount; c++)
+                        {
+                            float sum = fetch((row0 + x0) * channelCount + c) + fetch((row0 + x1) * channelCount + c) + fetch((row1 + x0) * channelCount + c) + fetch((row1 + x1) * channelCount + c);
+                            dst[((size_t)y * width + x) * channelCount + c] = sum * 0.25f;
+                        }
+                    }
+                }
+            });
+        }
+
+        float besselI0(float x)
+        {
+            float sum = 1;
+            float term = 1;
+            for (uint32_t k = 1; k < 32; k++)
+            {
+                float f = x / (2.0f * k);
+                term *= f * f;
+                sum += term;
+                if (term < sum * 1e-8f) break;
+            }
+            return sum;
+        }
+
+        float kaiserSinc(float t)
+        {
+            t = std::abs(t);
+            if (t >= kKaiserRadius) return 0;
+            float sinc = (t < 1e-5f) ? 1.0f : std::sin((float)M_PI * t) / ((float)M_PI * t);
+            float r = t / kKaiserRadius;
+            return sinc * besselI0(kKaiserAlpha * std::sqrt(1 - r * r)) / besselI0(kKaiserAlpha);
+        }
+
+        /** The normalized filter taps of each destination texel along one axis
+        */
+        struct FilterTaps
+        {
+            uint32_t tapCount;
+            std::vector<int32_t> first;     // The first source texel of each destination texel. Can be outside the source, the fetches are clamped.
+            std::vector<float> weights;     // tapCount weights per destination texel
+        };
+
+        FilterTaps computeKaiserTaps(uint32_t srcSize, uint32_t dstSize)
+        {
+            const float scale = (float)srcSize / dstSize;
+            const float support = kKaiserRadius * scale;
+            FilterTaps taps;
+            taps.tapCount = (uint32_t)std::ceil(2 * support) + 1;
+            taps.first.resize(dstSize);
+            taps.weights.resize((size_t)dstSize * taps.tapCount);
+            for (uint32_t x = 0; x < dstSize; x++)
+            {
+                const float center = (x + 0.5f) * scale;
+                taps.first[x] = (int32_t)std::floor(center - support);
+                float* pWeights = &taps.weights[(size_t)x * taps.tapCount];
+                float sum = 0;
+                for (uint32_t k = 0; k < taps.tapCount; k++)
+                {
+                    pWeights[k] = kaiserSinc((taps.first[x] + k + 0.5f - center) / scale);
+                    sum += pWeights[k];
+                }
+                for (uint32_t k = 0; k < taps.tapCount; k++) pWeights[k] /= sum;
+            }
+            return taps;
+        }
+
+        /** Filter a mip level into the next one with a Kaiser-windowed sinc. The edges are clamped.
+            Each destination row is filtered vertically into a temporary row and then horizontally, so only one source-sized row is kept per thread.
+            \param[in] fetch Returns a channel of the source level, given its index
+        */
+        template<typename Fetch>
+        void downsampleKaiser(uint32_t srcWidth, uint32_t srcHeight, uint32_t channelCount, const Fetch& fetch, std::vector<float>& dst)
+        {
+            const uint32_t width = std::max(srcWidth >> 1, 1u);
+            const uint32_t height = std::max(srcHeight >> 1, 1u);
+            const FilterTaps horizontal = computeKaiserTaps(srcWidth, width);
+            const FilterTaps vertical = computeKaiserTaps(srcHeight, height);
+            dst.resize((size_t)width * height * channelCount);
+            TaskScheduler::get()->parallelFor(0, height, [&](size_t begin, size_t end)
+            {
+                std::vector<float> row((size_t)srcWidth * channelCount);
+                for (uint32_t y = (uint32_t)begin; y < (uint32_t)end; y++)
+                {
+                    std::fill(row.begin(), row.end(), 0.0f);
+                    const float* pWeights = &vertical.weights[(size_t)y * vertical.tapCount];
+                    for (uint32_t k = 0; k < vertical.tapCount; k++)
+                    {
+                        if (pWeights[k] == 0) continue;
+                        const size_t srcRow = (size_t)glm::clamp(vertical.first[y] + (int32_t)k, 0, (int32_t)srcHeight - 1) * srcWidth * channelCount;
+                        for (size_t i = 0; i < row.size(); i++)
+                        {
+                            row[i] += pWeights[k] * fetch(srcRow + i);
+                        }
+                    }
+
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        const float* pRowWeights = &horizontal.weights[(size_t)x * horizontal.tapCount];
+                        float* pDst = &dst[((size_t)y * width + x) * channelCount];
+                        for (uint32_t c = 0; c < channelCount; c++) pDst[c] = 0;
+                        for (uint32_t k = 0; k < horizontal.tapCount; k++)
+                        {
+                            const size_t srcX = (size_t)glm::clamp(horizontal.first[x] + (int32_t)k, 0, (int32_t)srcWidth - 1);
+                            for (uint32_t c = 0; c < channelCount; c++)
+                            {
+                                pDst[c] += pRowWeights[k] * row[srcX * channelCount + c];
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        /** Rescale the XYZ channels of each texel of a normal map to unit length
+        */
+        void renormalize(std::vector<float>& level, uint32_t channelCount)
+        {
+            for (size_t i = 0; i < level.size(); i += channelCount)
+            {
+                glm::vec3 n = glm::vec3(level[i], level[i + 1], level[i + 2]) * 2.0f - 1.0f;
+                float length = glm::length(n);
+                n = (length > 0) ? n / length : glm::vec3(0, 0, 1);
+                for (uint32_t c = 0; c < 3; c++) level[i + c] = n[c] * 0.5f + 0.5f;
+            }
+        }
+
+        /** Convert a mip level to RGBA8 for the block encoders. Missing color channels are 0 and missing alpha is opaque.
+        */
+        template<typename Fetch>
+        void packRgba8(size_t texelCount, ResourceFormat format, bool isSrgb, const Fetch& fetch, std::vector<uint8_t>& rgba)
+        {
+            const uint32_t channelCount = getFormatChannelCount(format);
+            const bool isBgr = isBgrFormat(format);
+            const bool hasAlpha = (channelCount == 4) && (isBgrxFormat(format) == false);
+            rgba.resize(texelCount * 4);
+            for (size_t t = 0; t < texelCount; t++)
+            {
+                uint8_t* pTexel = &rgba[t * 4];
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    uint32_t srcChannel = (isBgr && c != 1) ? 2 - c : c;
+                    float value = (srcChannel < channelCount) ? fetch(t * channelCount + srcChannel) : 0.0f;
+                    encodeTexelChannel(isSrgb ? linearToSrgb(value) : value, TexelEncoding::Unorm8, pTexel, c);
+                }
+                if (hasAlpha) encodeTexelChannel(fetch(t * channelCount + 3), TexelEncoding::Unorm8, pTexel, 3);
+                else pTexel[3] = 255;
+            }
+        }
+
+        bool hasTransparentTexels(const uint8_t* pData, size_t texelCount, ResourceFormat format)
+        {
+            if ((getFormatChannelCount(format) != 4) || isBgrxFormat(format)) return false;
+            for (size_t t = 0; t < texelCount; t++)
+            {
+                if (pData[t * 4 + 3] != 255) return true;
+            }
+            return false;
+        }
+
+        /** Choose the block-compressed format to encode an image in
+            \return The compressed format, or ResourceFormat::Unknown if the image should stay uncompressed
+        */
+        ResourceFormat selectCompressedFormat(const uint8_t* pData, uint32_t width, uint32_t height, ResourceFormat format, const TextureProcessor::Settings& settings)
+        {
+            using Compression = TextureProcessor::Compression;
+            Compression compression = settings.compression;
+            if (compression == Compression::None) return ResourceFormat::Unknown;
+
+            const bool isAuto = (compression == Compression::Auto);
+            if (getTexelEncoding(format) != TexelEncoding::Unorm8)
+            {
+                if (isAuto == false) logWarning("TextureProcessor - only 8-bit unorm images can be compressed. Format " + to_string(format) + " will stay uncompressed.");
+                return ResourceFormat::Unknown;
+            }
+
+            if (isAuto)
+            {
+                const uint32_t channelCount = getFormatChannelCount(format);
+                if (channelCount == 1) compression = Compression::BC4;
+                else if (settings.isNormalMap || channelCount == 2) compression = Compression::BC5;
+                else if (hasTransparentTexels(pData, (size_t)width * height, format)) compression = Compression::BC7;
+                else compression = Compression::BC1;
+            }
+
+            ResourceFormat compressed;
+            switch (compression)
+            {
+            case Compression::BC1:
+                compressed = ResourceFormat::BC1Unorm;
+                break;
+            case Compression::BC3:
+                compressed = ResourceFormat::BC3Unorm;
+                break;
+            case Compression::BC4:
+                compressed = ResourceFormat::BC4Unorm;
+                break;
+            case Compression::BC5:
+                compressed = ResourceFormat::BC5Unorm;
+                break;
+            case Compression::BC7:
+                compressed = ResourceFormat::BC7Unorm;
+                break;
+            default:
+                should_not_get_here();
+                return ResourceFormat::Unknown;
+            }
+            if (isSrgbFormat(format) && (settings.isNormalMap == false))
+            {
+                compressed = linearToSrgbFormat(compressed);
+            }
+
+            if (isValidTextureTopMip(compressed, width, height, settings.firstMip) == false)
+            {
+                if (isAuto == false) logWarning("TextureProcessor - a " + std::to_string(width) + "x" + std::to_string(height) + " image can't be block-compressed. It will stay uncompressed.");
+                return ResourceFormat::Unknown;
+            }
+            return compressed;
+        }
+
+        DXFormat getDxgiFormat(ResourceFormat format)
+        {
+            switch (format)
+            {
+            case ResourceFormat::R8Unorm: return FORMAT_R8_UNORM;
+            case ResourceFormat::RG8Unorm: return FORMAT_R8G8_UNORM;
+            case ResourceFormat::RGBA8Unorm: return FORMAT_R8G8B8A8_UNORM;
+            case ResourceFormat::RGBA8UnormSrgb: return FORMAT_R8G8B8A8_UNORM_SRGB;
+            case ResourceFormat::BGRA8Unorm: return FORMAT_B8G8R8A8_UNORM;
+            case ResourceFormat::BGRA8UnormSrgb: return FORMAT_B8G8R8A8_UNORM_SRGB;
+            case ResourceFormat::BGRX8Unorm: return FORMAT_B8G8R8X8_UNORM;
+            case ResourceFormat::BGRX8UnormSrgb: return FORMAT_B8G8R8X8_UNORM_SRGB;
+            case ResourceFormat::R16Float: return FORMAT_R16_FLOAT;
+            case ResourceFormat::RG16Float: return FORMAT_R16G16_FLOAT;
+            case ResourceFormat::RGBA16Float: return FORMAT_R16G16B16A16_FLOAT;
+            case ResourceFormat::R32Float: return FORMAT_R32_FLOAT;
+            case ResourceFormat::RG32Float: return FORMAT_R32G32_FLOAT;
+            case ResourceFormat::RGB32Float: return FORMAT_R32G32B32_FLOAT;
+            case ResourceFormat::RGBA32Float: return FORMAT_R32G32B32A32_FLOAT;
+            case ResourceFormat::BC1Unorm: return FORMAT_BC1_UNORM;
+            case ResourceFormat::BC1UnormSrgb: return FORMAT_BC1_UNORM_SRGB;
+            case ResourceFormat::BC3Unorm: return FORMAT_BC3_UNORM;
+            case ResourceFormat::BC3UnormSrgb: return FORMAT_BC3_UNORM_SRGB;
+            case ResourceFormat::BC4Unorm: return FORMAT_BC4_UNORM;
+            case ResourceFormat::BC5Unorm: return FORMAT_BC5_UNORM;
+            case ResourceFormat::BC7Unorm: return FORMAT_BC7_UNORM;
+            case ResourceFormat::BC7UnormSrgb: return FORMAT_BC7_UNORM_SRGB;
+            default: return FORMAT_UNKNOWN;
+            }
+        }
+
+        uint32_t getFullMipCount(uint32_t width, uint32_t height)
+        {
+            uint32_t size = std::max(width, height);
+            uint32_t mipCount = 1;
+            while (size > 1)
+            {
+                size >>= 1;
+                mipCount++;
+            }
+            return mipCount;
+        }
+    }
+
+    bool TextureProcessor::isSupportedFormat(ResourceFormat format)
+    {
+        return getTexelEncoding(format) != TexelEncoding::Unsupported;
+    }
+
+    bool TextureProcessor::process(const uint8_t* pData, uint32_t width, uint32_t height, ResourceFormat format, const Settings& settings, TextureMipData& mipData)
+    {
+        PROFILE_CPU(processTexture);
+        const TexelEncoding encoding = getTexelEncoding(format);
+        const uint32_t channelCount = getFormatChannelCount(format);
+        const bool isSrgb = isSrgbFormat(format) && (settings.isNormalMap == false);
+        const bool renormalizeLevels = settings.isNormalMap && (channelCount >= 3);
+
+        mipData = TextureMipData();
+        mipData.width = width;
+        mipData.height = height;
+        mipData.mipCount = (encoding != TexelEncoding::Unsupported) ? getFullMipCount(width, height) : 1;
+        if (settings.firstMip >= mipData.mipCount)
+        {
+            logError("TextureProcessor::process() - mip " + std::to_string(settings.firstMip) + " is outside the " + std::to_string(mipData.mipCount) + " levels of the image");
+            return false;
+        }
+        mipData.firstMip = settings.firstMip;
+
+        const ResourceFormat compressedFormat = selectCompressedFormat(pData, width, height, format, settings);
+        const bool compress = (compressedFormat != ResourceFormat::Unknown);
+        mipData.format = compress ? compressedFormat : (settings.isNormalMap ? srgbToLinearFormat(format) : format);
+        // BC4 and BC5 have no sRGB variants. Their channels are stored linearly.
+        const bool encodeSrgb = isSrgb && (compress == false || isSrgbFormat(compressedFormat));
+
+        mipData.data.resize((size_t)getTextureMipChainSize(mipData.format, width, height, mipData.firstMip, mipData.mipCount - mipData.firstMip));
+        uint8_t* pDst = mipData.data.data();
+        const SourceFetch sourceFetch = { pData, encoding, channelCount, (isSrgb && encoding == TexelEncoding::Unorm8) ? getSrgbToLinearTable() : nullptr };
+
+        std::vector<uint8_t> rgba;
+        auto storeLevel = [&](uint32_t mip, const auto& fetch)
+        {
+            const uint32_t mipWidth = std::max(width >> mip, 1u);
+            const uint32_t mipHeight = std::max(height >> mip, 1u);
+            const size_t texelCount = (size_t)mipWidth * mipHeight;
+            if (compress)
+            {
+                packRgba8(texelCount, format, encodeSrgb, fetch, rgba);
+                BlockCompression::compress(compressedFormat, rgba.data(), mipWidth, mipHeight, pDst);
+            }
+            else
+            {
+                for (size_t i = 0; i < texelCount * channelCount; i++)
+                {
+                    float value = fetch(i);
+                    encodeTexelChannel((encodeSrgb && (i % channelCount) < 3) ? linearToSrgb(value) : value, encoding, pDst, i);
+                }
+            }
+            pDst += (size_t)getTextureMipChainSize(mipData.format, width, height, mip, 1);
+        };
+
+        if (mipData.firstMip == 0)
+        {
+            if (compress)
+            {
+                storeLevel(0, sourceFetch);
+            }
+            else
+            {
+                size_t size = (size_t)getTextureMipChainSize(format, width, height, 0, 1);
+                std::memcpy(pDst, pData, size);
+                pDst += size;
+            }
+        }
+
+        // Each level is filtered from the previous one, which is kept in floats to avoid accumulating quantization errors
+        std::vector<float> level;
+        std::vector<float> nextLevel;
+        auto levelFetch = [&](size_t i) { return level[i]; };
+        for (uint32_t mip = 1; mip < mipData.mipCount; mip++)
+        {
+            const uint32_t srcWidth = std::max(width >> (mip - 1), 1u);
+            const uint32_t srcHeight = std::max(height >> (mip - 1), 1u);
+            if (settings.mipFilter == MipFilter::Kaiser)
+            {
+                if (mip == 1) downsampleKaiser(srcWidth, srcHeight, channelCount, sourceFetch, nextLevel);
+                else downsampleKaiser(srcWidth, srcHeight, channelCount, levelFetch, nextLevel);
+            }
+            else
+            {
+                if (mip == 1) downsampleBox(srcWidth, srcHeight, channelCount, sourceFetch, nextLevel);
+                else downsampleBox(srcWidth, srcHeight, channelCount, levelFetch, nextLevel);
+            }
+            level.swap(nextLevel);
+            if (renormalizeLevels) renormalize(level, channelCount);
+
+            if (mip >= mipData.firstMip)
+            {
+                storeLevel(mip, levelFetch);
+            }
+        }
+        return true;
+    }
+
+    bool TextureProcessor::saveDds(const std::string& filename, const TextureMipData& mipData)
+    {
+        DXFormat dxgiFormat = getDxgiFormat(mipData.format);
+        if (dxgiFormat == FORMAT_UNKNOWN)
+        {
+            logError("TextureProcessor::saveDds() - format " + to_string(mipData.format) + " can't be written to a DDS file");
+            return false;
+        }
+        if (mipData.firstMip != 0)
+        {
+            logError("TextureProcessor::saveDds() - the mip-chain doesn't start at level 0");
+            return false;
+        }
+
+        DdsHeader header = {};
+        header.headerSize = sizeof(DdsHeader);
+        header.flags = DdsHeader::kCapsMask | DdsHeader::kHeightMask | DdsHeader::kWidthMask | DdsHeader::kPixelFormatMask | DdsHeader::kMipCountMask;
+        header.height = mipData.height;
+        header.width = mipData.width;
+        if (isCompressedFormat(mipData.format))
+        {
+            header.flags |= DdsHeader::kLinearSizeMask;
+            header.linearSize = (uint32_t)getTextureMipChainSize(mipData.format, mipData.width, mipData.height, 0, 1);
+        }
+        else
+        {
+            header.flags |= DdsHeader::kPitchMask;
+            header.pitch = mipData.width * getFormatBytesPerBlock(mipData.format);
+        }
+        header.mipCount = mipData.mipCount;
+        header.pixelFormat.structSize = sizeof(DdsHeader::PixelFormat);
+        header.pixelFormat.flags = DdsHeader::PixelFormat::kFourCCFlag;
+        header.pixelFormat.fourCC = 0x30315844; // "DX10"
+        header.caps[0] = DdsHeader::kCapsTextureMask;
+        if (mipData.mipCount > 1)
+        {
+            header.caps[0] |= DdsHeader::kCapsComplexMask | DdsHeader::kCapsMipMapMask;
+        }
+
+        DdsHeaderDX10 dx10Header = {};
+        dx10Header.dxgiFormat = dxgiFormat;
+        dx10Header.resourceDimension = RESOURCE_DIMENSION_TEXTURE2D;
+        dx10Header.arraySize = 1;
+
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+        stream << kDdsMagicNumber << header << dx10Header;
+        stream.write(mipData.data.data(), mipData.data.size());
+        if (stream.isGood() == false)
+        {
+            logError("TextureProcessor::saveDds() - can't write " + filename);
+            stream.remove();
+            return false;
+        }
+        return true;
+    }
+
+    bool TextureProcessor::compressTextureFile(const std::string& filename, bool isSrgb, bool isNormalMap, std::string& ddsFilename)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            logError("Can't find texture file " + filename);
+            return false;
+        }
+
+        const char* suffix = isNormalMap ? ".normal.dds" : (isSrgb ? ".srgb.dds" : ".linear.dds");
+        ddsFilename = fullpath + suffix;
+        if (doesFileExist(ddsFilename) && (getFileModifiedTime(ddsFilename) >= getFileModifiedTime(fullpath)))
+        {
+            return true;
+        }
+
+        PROFILE_CPU(compressTextureFile);
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(fullpath, true);
+        if (pBitmap == nullptr)
+        {
+            return false;
+        }
+
+        Settings settings;
+        settings.isNormalMap = isNormalMap;
+        ResourceFormat format = isSrgb ? linearToSrgbFormat(pBitmap->getFormat()) : pBitmap->getFormat();
+        TextureMipData mipData;
+        if (process(pBitmap->getData(), pBitmap->getWidth(), pBitmap->getHeight(), format, settings, mipData) == false)
+        {
+            return false;
+        }
+        return saveDds(ddsFilename, mipData);
+    }
+}
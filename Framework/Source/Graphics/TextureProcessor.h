@@ -0,0 +1,102 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include "Graphics/TextureHelper.h"
+
+namespace Falcor
+{
+    /** CPU texture processing for the import pipeline: mip-chain generation, normal-map renormalization and block compression.
+        The results can be written to DDS files, which later loads upload without any processing.
+    */
+    class TextureProcessor
+    {
+    public:
+        /** The filter used to generate the mip-chain
+        */
+        enum class MipFilter
+        {
+            Box,        ///< 2x2 average of the previous level
+            Kaiser,     ///< Kaiser-windowed sinc. Sharper than the box filter, and doesn't alias as much.
+        };
+
+        /** The block-compressed format to encode the mip-chain in
+        */
+        enum class Compression
+        {
+            None,       ///< Keep the source format
+            BC1,        ///< RGB, 4 bits per texel
+            BC3,        ///< RGBA, 8 bits per texel
+            BC4,        ///< R, 4 bits per texel
+            BC5,        ///< RG, 8 bits per texel
+            BC7,        ///< RGBA, 8 bits per texel. Higher quality than BC3, slower to encode.
+            Auto,       ///< BC5 for normal maps, BC4 for single-channel images, BC7 for images with transparent texels, otherwise BC1
+        };
+
+        struct Settings
+        {
+            MipFilter mipFilter = MipFilter::Kaiser;
+            Compression compression = Compression::Auto;
+            bool isNormalMap = false;   ///< Renormalize the generated levels. Normal maps are always filtered in linear space.
+            uint32_t firstMip = 0;      ///< The first mip level to store in the result
+        };
+
+        /** Check if the mip-chain of an image in a format can be generated
+        */
+        static bool isSupportedFormat(ResourceFormat format);
+
+        /** Generate the mip-chain of a 2D image and encode it.
+            sRGB images are filtered in linear space. Formats isSupportedFormat() rejects only return the first level. Only 8-bit unorm images are compressed, and only if their size is a multiple of the block size.
+            \param[in] pData The image's largest mip level, tightly packed and top row first
+            \param[in] width The image width
+            \param[in] height The image height
+            \param[in] format The image format
+            \param[in] settings The processing settings
+            \param[out] mipData The processed mip levels, from settings.firstMip on
+            \return true if the image was processed, otherwise false
+        */
+        static bool process(const uint8_t* pData, uint32_t width, uint32_t height, ResourceFormat format, const Settings& settings, TextureMipData& mipData);
+
+        /** Write a mip-chain to a DDS file
+            \param[in] filename The full path of the file to write
+            \param[in] mipData The mip levels. Must start at level 0.
+            \return true if the file was written, otherwise false
+        */
+        static bool saveDds(const std::string& filename, const TextureMipData& mipData);
+
+        /** Process an image file with the default settings and cache the result in a DDS file next to it. The cached file is reused as long as it's newer than the image.
+            This doesn't access the device, so it can be called from worker threads.
+            \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory
+            \param[in] isSrgb Whether the image holds sRGB colors
+            \param[in] isNormalMap Whether the image holds a tangent-space normal map
+            \param[out] ddsFilename The full path of the DDS file
+            \return true if the DDS file is ready, otherwise false
+        */
+        static bool compressTextureFile(const std::string& filename, bool isSrgb, bool isNormalMap, std::string& ddsFilename);
+    };
+}
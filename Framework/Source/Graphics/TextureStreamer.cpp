@@ -0,0 +1,461 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureStreamer.h"
+#include "API/Device.h"
+#include "API/RenderContext.h"
+#include "Graphics/Scene/Scene.h"
+#include "Graphics/Model/Model.h"
+#include "Utils/CpuProfiler.h"
+#include <algorithm>
+#include <limits>
+
+namespace Falcor
+{
+    namespace
+    {
+        enum MaterialSlotType : uint32_t
+        {
+            kNormalMapSlot = MatMaxLayers,
+            kAlphaMapSlot,
+            kAmbientOcclusionMapSlot,
+            kHeightMapSlot,
+            kMaterialSlotCount
+        };
+
+        Texture::SharedPtr getMaterialTexture(const Material* pMaterial, uint32_t slot)
+        {
+            switch (slot)
+            {
+            case kNormalMapSlot:
+                return pMaterial->getNormalMap();
+            case kAlphaMapSlot:
+                return pMaterial->getAlphaMap();
+            case kAmbientOcclusionMapSlot:
+                return pMaterial->getAmbientOcclusionMap();
+            case kHeightMapSlot:
+                return pMaterial->getHeightMap();
+            default:
+                return (slot < pMaterial->getNumLayers()) ? pMaterial->getLayer(slot).pTexture : nullptr;
+            }
+        }
+
+        void setMaterialTexture(Material* pMaterial, uint32_t slot, Texture::SharedPtr pTexture)
+        {
+            switch (slot)
+            {
+            case kNormalMapSlot:
+                pMaterial->setNormalMap(pTexture);
+                break;
+            case kAlphaMapSlot:
+                pMaterial->setAlphaMap(pTexture);
+                break;
+            case kAmbientOcclusionMapSlot:
+                pMaterial->setAmbientOcclusionMap(pTexture);
+                break;
+            case kHeightMapSlot:
+                pMaterial->setHeightMap(pTexture);
+                break;
+            default:
+                pMaterial->setLayerTexture(slot, pTexture);
+            }
+        }
+
+        uint32_t getMipSize(uint32_t width, uint32_t height, uint32_t mip)
+        {
+            return std::max(std::max(width >> mip, height >> mip), 1u);
+        }
+    }
+
+    TextureStreamer::SharedPtr TextureStreamer::create(uint64_t budget)
+    {
+        return SharedPtr(new TextureStreamer(budget));
+    }
+
+    TextureStreamer::TextureStreamer(uint64_t budget) : mBudget(budget)
+    {
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        // The loads write into this object
+        TaskScheduler::get()->wait(mLoadGroup);
+    }
+
+    Texture::SharedPtr TextureStreamer::createPlaceholderTexture(const std::string& filename, bool loadAsSrgb, const glm::vec4& color)
+    {
+        uint8_t texel[4];
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            texel[c] = (uint8_t)(glm::clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+        Texture::SharedPtr pTexture = Texture::create2D(1, 1, loadAsSrgb ? ResourceFormat::RGBA8UnormSrgb : ResourceFormat::RGBA8Unorm, 1, 1, texel);
+        if (pTexture)
+        {
+            pTexture->setSourceFilename(stripDataDirectories(filename));
+        }
+        return pTexture;
+    }
+
+    uint32_t TextureStreamer::getTextureID(const Texture::SharedPtr& pTexture)
+    {
+        const bool loadAsSrgb = isSrgbFormat(pTexture->getFormat());
+        auto key = std::make_pair(pTexture->getSourceFilename(), loadAsSrgb);
+        auto it = mTextureIDs.find(key);
+        if (it != mTextureIDs.end())
+        {
+            return it->second;
+        }
+
+        uint32_t id = (uint32_t)mTextures.size();
+        mTextureIDs[key] = id;
+        mTextures.emplace_back();
+        StreamedTexture& texture = mTextures.back();
+        texture.filename = pTexture->getSourceFilename();
+        texture.loadAsSrgb = loadAsSrgb;
+        texture.pTexture = pTexture;
+
+        // 1x1 textures are placeholders. Anything else is already resident, and can be evicted by copying its lower mip levels.
+        if ((pTexture->getWidth() > 1) || (pTexture->getHeight() > 1))
+        {
+            texture.format = pTexture->getFormat();
+            texture.width = pTexture->getWidth();
+            texture.height = pTexture->getHeight();
+            texture.mipCount = pTexture->getMipCount();
+            texture.tailMip = getTailMip(texture);
+            setResidentTexture(texture, pTexture, 0);
+        }
+        return id;
+    }
+
+    void TextureStreamer::addMaterial(const Material::SharedPtr& pMaterial)
+    {
+        if (mMaterials.count(pMaterial.get())) return;
+
+        MaterialRecord& record = mMaterials[pMaterial.get()];
+        record.pMaterial = pMaterial;
+        for (uint32_t slot = 0; slot < kMaterialSlotCount; slot++)
+        {
+            Texture::SharedPtr pTexture = getMaterialTexture(pMaterial.get(), slot);
+            if ((pTexture == nullptr) || pTexture->getSourceFilename().empty()) continue;
+            if ((pTexture->getType() != Texture::Type::Texture2D) || (pTexture->getArraySize() != 1)) continue;
+
+            uint32_t id = getTextureID(pTexture);
+            StreamedTexture& texture = mTextures[id];
+            texture.slots.push_back({ pMaterial.get(), slot });
+            if (std::find(record.textures.begin(), record.textures.end(), id) == record.textures.end())
+            {
+                record.textures.push_back(id);
+            }
+
+            // Materials which loaded the same image separately share the streamed texture
+            if (texture.pTexture != pTexture)
+            {
+                setMaterialTexture(pMaterial.get(), slot, texture.pTexture);
+            }
+        }
+    }
+
+    void TextureStreamer::addModel(const Model* pModel)
+    {
+        for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+        {
+            const Material::SharedPtr& pMaterial = pModel->getMesh(meshID)->getMaterial();
+            if (pMaterial)
+            {
+                addMaterial(pMaterial);
+            }
+        }
+    }
+
+    void TextureStreamer::addScene(const Scene* pScene)
+    {
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            addModel(pScene->getModel(modelID).get());
+        }
+    }
+
+    void TextureStreamer::reportMaterialUsage(const Material* pMaterial, float screenSize)
+    {
+        if (pMaterial != mpLastReportedMaterial)
+        {
+            auto it = mMaterials.find(pMaterial);
+            mpLastReportedRecord = (it != mMaterials.end()) ? &it->second : nullptr;
+            mpLastReportedMaterial = pMaterial;
+        }
+
+        if (mpLastReportedRecord)
+        {
+            mpLastReportedRecord->screenSize = std::max(mpLastReportedRecord->screenSize, screenSize);
+            mpLastReportedRecord->used = true;
+        }
+    }
+
+    uint32_t TextureStreamer::getTailMip(const StreamedTexture& texture) const
+    {
+        uint32_t mip = 0;
+        while ((mip + 1 < texture.mipCount) && (getMipSize(texture.width, texture.height, mip) > mTailSize) && isValidTextureTopMip(texture.format, texture.width, texture.height, mip + 1))
+        {
+            mip++;
+        }
+        return mip;
+    }
+
+    uint32_t TextureStreamer::getDesiredMip(const StreamedTexture& texture) const
+    {
+        // Select the smallest level which still has a texel per pixel. The levels above the tail are all valid top levels.
+        const float size = texture.requestedSize * mResolutionScale;
+        uint32_t mip = texture.tailMip;
+        while ((mip > 0) && ((float)getMipSize(texture.width, texture.height, mip) < size))
+        {
+            mip--;
+        }
+        return mip;
+    }
+
+    void TextureStreamer::setResidentTexture(StreamedTexture& texture, const Texture::SharedPtr& pTexture, uint32_t residentMip)
+    {
+        pTexture->setSourceFilename(texture.filename);
+        mResidentBytes -= texture.residentSize;
+        texture.residentSize = getTextureMipChainSize(texture.format, texture.width, texture.height, residentMip, texture.mipCount - residentMip);
+        mResidentBytes += texture.residentSize;
+        texture.residentMip = residentMip;
+
+        if (texture.pTexture != pTexture)
+        {
+            texture.pTexture = pTexture;
+            for (const MaterialSlot& slot : texture.slots)
+            {
+                setMaterialTexture(slot.pMaterial, slot.slot, pTexture);
+            }
+        }
+    }
+
+    void TextureStreamer::dropMips(StreamedTexture& texture, uint32_t firstMip)
+    {
+        // The remaining levels are already on the GPU, copy them instead of reading the file again
+        const uint32_t mipOffset = firstMip - texture.residentMip;
+        Texture::SharedPtr pTexture = Texture::create2D(std::max(texture.width >> firstMip, 1u), std::max(texture.height >> firstMip, 1u), texture.format, 1, texture.mipCount - firstMip);
+        if (pTexture == nullptr) return;
+
+        RenderContext* pContext = gpDevice->getRenderContext().get();
+        for (uint32_t mip = 0; mip < pTexture->getMipCount(); mip++)
+        {
+            pContext->copySubresource(pTexture.get(), pTexture->getSubresourceIndex(0, mip), texture.pTexture.get(), texture.pTexture->getSubresourceIndex(0, mip + mipOffset));
+        }
+        setResidentTexture(texture, pTexture, firstMip);
+    }
+
+    bool TextureStreamer::makeRoom(uint64_t size)
+    {
+        while (mResidentBytes + mReservedBytes + size > mBudget)
+        {
+            if (mNextEviction == mEvictionOrder.size()) return false;
+
+            StreamedTexture& texture = mTextures[mEvictionOrder[mNextEviction++]];
+            if (texture.loadPending || (texture.residentMip >= texture.tailMip)) continue;
+            dropMips(texture, texture.tailMip);
+            mStats.evictionCount++;
+        }
+        return true;
+    }
+
+    void TextureStreamer::requestLoad(uint32_t textureID, uint32_t maxSize, uint64_t reservedSize)
+    {
+        StreamedTexture& texture = mTextures[textureID];
+        texture.loadPending = true;
+        mPendingLoads++;
+        mReservedBytes += reservedSize;
+
+        std::string filename = texture.filename;
+        bool loadAsSrgb = texture.loadAsSrgb;
+        TaskScheduler::get()->run([this, textureID, reservedSize, filename, loadAsSrgb, maxSize]()
+        {
+            LoadResult result;
+            result.textureID = textureID;
+            result.reservedSize = reservedSize;
+            result.success = loadTextureMipsFromFile(filename, loadAsSrgb, maxSize, result.mipData);
+
+            std::lock_guard<std::mutex> lock(mCompletedLoadsMutex);
+            mCompletedLoads.push_back(std::move(result));
+        }, &mLoadGroup);
+    }
+
+    void TextureStreamer::processCompletedLoads()
+    {
+        std::vector<LoadResult> results;
+        {
+            std::lock_guard<std::mutex> lock(mCompletedLoadsMutex);
+            results.swap(mCompletedLoads);
+        }
+
+        for (LoadResult& result : results)
+        {
+            StreamedTexture& texture = mTextures[result.textureID];
+            texture.loadPending = false;
+            mPendingLoads--;
+            mReservedBytes -= result.reservedSize;
+
+            if (result.success == false)
+            {
+                // The loader reported the error. Keep whatever the materials use now, and don't try again.
+                texture.loadFailed = true;
+                continue;
+            }
+
+            // The file is the reference for the mip-chain. It only differs from a texture which was loaded at full resolution if the texture was created without mip levels.
+            const TextureMipData& data = result.mipData;
+            const bool sameChain = (texture.format == data.format) && (texture.width == data.width) && (texture.height == data.height) && (texture.mipCount == data.mipCount);
+            if (sameChain && (texture.residentMip != kNotResident) && (data.firstMip >= texture.residentMip)) continue;
+
+            Texture::SharedPtr pTexture = Texture::create2D(std::max(data.width >> data.firstMip, 1u), std::max(data.height >> data.firstMip, 1u), data.format, 1, data.mipCount - data.firstMip, data.data.data());
+            if (pTexture == nullptr)
+            {
+                texture.loadFailed = true;
+                continue;
+            }
+
+            texture.format = data.format;
+            texture.width = data.width;
+            texture.height = data.height;
+            texture.mipCount = data.mipCount;
+            texture.tailMip = getTailMip(texture);
+            setResidentTexture(texture, pTexture, data.firstMip);
+            mStats.loadCount++;
+            mStats.loadedBytes += data.data.size();
+        }
+    }
+
+    void TextureStreamer::applyUsage()
+    {
+        for (StreamedTexture& texture : mTextures)
+        {
+            texture.requestedSize = 0;
+        }
+
+        for (auto& it : mMaterials)
+        {
+            MaterialRecord& record = it.second;
+            if (record.used == false) continue;
+
+            for (uint32_t id : record.textures)
+            {
+                StreamedTexture& texture = mTextures[id];
+                texture.requestedSize = std::max(texture.requestedSize, record.screenSize);
+                texture.lastUsedFrame = mFrame;
+            }
+            record.screenSize = 0;
+            record.used = false;
+        }
+    }
+
+    void TextureStreamer::scheduleLoads()
+    {
+        // Textures without their mip tail come first. The others are ordered by how much larger than their resident level they appear on screen.
+        struct Candidate
+        {
+            uint32_t textureID;
+            float priority;
+        };
+        std::vector<Candidate> candidates;
+        for (uint32_t id = 0; id < (uint32_t)mTextures.size(); id++)
+        {
+            const StreamedTexture& texture = mTextures[id];
+            if (texture.loadPending || texture.loadFailed) continue;
+
+            if (texture.residentMip == kNotResident)
+            {
+                candidates.push_back({ id, std::numeric_limits<float>::max() });
+            }
+            else if ((texture.requestedSize > 0) && (getDesiredMip(texture) < texture.residentMip))
+            {
+                candidates.push_back({ id, texture.requestedSize * mResolutionScale / (float)getMipSize(texture.width, texture.height, texture.residentMip) });
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.priority > b.priority; });
+
+        // Only textures which weren't used in the last frame are evicted, the least-recently used first
+        mEvictionOrder.clear();
+        mNextEviction = 0;
+        for (uint32_t id = 0; id < (uint32_t)mTextures.size(); id++)
+        {
+            const StreamedTexture& texture = mTextures[id];
+            if ((texture.lastUsedFrame < mFrame) && (texture.residentMip < texture.tailMip))
+            {
+                mEvictionOrder.push_back(id);
+            }
+        }
+        std::sort(mEvictionOrder.begin(), mEvictionOrder.end(), [this](uint32_t a, uint32_t b) { return mTextures[a].lastUsedFrame < mTextures[b].lastUsedFrame; });
+
+        for (const Candidate& candidate : candidates)
+        {
+            if (mPendingLoads >= mMaxPendingLoads) break;
+
+            StreamedTexture& texture = mTextures[candidate.textureID];
+            if (texture.residentMip == kNotResident)
+            {
+                // The image's size isn't known yet, the loader selects the tail
+                requestLoad(candidate.textureID, mTailSize, 0);
+                continue;
+            }
+
+            // Lower the resolution until the growth fits in the budget
+            for (uint32_t mip = getDesiredMip(texture); mip < texture.residentMip; mip++)
+            {
+                uint64_t growth = getTextureMipChainSize(texture.format, texture.width, texture.height, mip, texture.residentMip - mip);
+                if (makeRoom(growth))
+                {
+                    requestLoad(candidate.textureID, getMipSize(texture.width, texture.height, mip), growth);
+                    break;
+                }
+            }
+        }
+
+        // The budget might have been lowered, or exceeded by textures which were added at full resolution
+        makeRoom(0);
+    }
+
+    void TextureStreamer::update()
+    {
+        PROFILE_CPU(updateTextureStreaming);
+        mFrame++;
+        processCompletedLoads();
+        applyUsage();
+        scheduleLoads();
+
+        mStats.textureCount = (uint32_t)mTextures.size();
+        mStats.residentCount = 0;
+        for (const StreamedTexture& texture : mTextures)
+        {
+            if (texture.residentMip != kNotResident) mStats.residentCount++;
+        }
+        mStats.pendingLoads = mPendingLoads;
+        mStats.residentBytes = mResidentBytes;
+    }
+}
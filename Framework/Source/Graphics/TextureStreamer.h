@@ -0,0 +1,211 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "API/Texture.h"
+#include "Graphics/Material/Material.h"
+#include "Graphics/TextureHelper.h"
+#include "Utils/TaskScheduler.h"
+
+namespace Falcor
+{
+    class Scene;
+    class Model;
+
+    /** Streams the mip levels of material textures from their source files.
+        Each texture starts with its low-resolution mip tail, which is loaded on worker threads. Higher levels are loaded once the renderer reports that a material covers enough of the screen to use them.
+        When the resident mip levels exceed the memory budget, the least-recently used textures drop back to their mip tail.
+        Mip levels can't be made resident individually, so a texture changes resolution by being replaced with a new texture holding a different part of the mip-chain. The streamer sets the new texture into the materials which use the image.
+        All the functions must be called from the thread which owns the device.
+    */
+    class TextureStreamer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<TextureStreamer>;
+        using SharedConstPtr = std::shared_ptr<const TextureStreamer>;
+
+        static const uint64_t kDefaultBudget = 512ull * 1024 * 1024;
+
+        /** Create a new streamer
+            \param[in] budget The memory the resident mip levels may use, in bytes. The mip tails are always resident, even if they exceed the budget.
+        */
+        static SharedPtr create(uint64_t budget = kDefaultBudget);
+        ~TextureStreamer();
+
+        /** Create a placeholder for a texture that will be streamed. Used by Model::LoadFlags::StreamTextures, so that loading a model doesn't read its images.
+            The placeholder is a single texel with the given color, and is replaced once the image's mip tail is loaded.
+            \param[in] filename The image file. Stored as the texture's source filename
+            \param[in] loadAsSrgb Whether the image will be loaded using an sRGB format
+            \param[in] color The texel color
+        */
+        static Texture::SharedPtr createPlaceholderTexture(const std::string& filename, bool loadAsSrgb, const glm::vec4& color);
+
+        /** Stream a material's textures. Textures without a source filename, and textures which aren't 2D, are left as they are.
+            Textures created by createPlaceholderTexture() (or any 1x1 texture) are loaded from their mip tail on. Other textures are initially resident at their full resolution.
+        */
+        void addMaterial(const Material::SharedPtr& pMaterial);
+
+        /** Stream the textures of all the materials of a model
+        */
+        void addModel(const Model* pModel);
+
+        /** Stream the textures of all the materials in a scene
+        */
+        void addScene(const Scene* pScene);
+
+        /** Report that a material was used for rendering. Called by the SceneRenderer for every mesh instance it draws.
+            \param[in] pMaterial The material. Ignored if it wasn't added to the streamer
+            \param[in] screenSize The size of the mesh instance on screen, in pixels. Textures are streamed in up to the first mip level which isn't smaller than that.
+        */
+        void reportMaterialUsage(const Material* pMaterial, float screenSize);
+
+        /** Apply the completed loads and the usage reported since the last call, start new loads and evict textures to stay within the budget. Call once per frame.
+        */
+        void update();
+
+        /** Set the memory the resident mip levels may use, in bytes
+        */
+        void setBudget(uint64_t budget) { mBudget = budget; }
+
+        /** Get the memory the resident mip levels may use, in bytes
+        */
+        uint64_t getBudget() const { return mBudget; }
+
+        /** Set the size of the mip tail. Textures are first loaded from the largest mip level no wider or taller than this size, and are never evicted below it.
+        */
+        void setTailSize(uint32_t size) { mTailSize = std::max(size, 1u); }
+
+        /** Set the largest number of loads running on worker threads at the same time
+        */
+        void setMaxPendingLoads(uint32_t count) { mMaxPendingLoads = std::max(count, 1u); }
+
+        /** Set the number of texels a texture needs per pixel the mesh instance covers on screen. Values above 1 compensate for meshes which tile their textures.
+        */
+        void setResolutionScale(float scale) { mResolutionScale = scale; }
+
+        struct Stats
+        {
+            uint32_t textureCount = 0;      ///< Number of streamed images
+            uint32_t residentCount = 0;     ///< Number of images which have at least their mip tail resident
+            uint32_t pendingLoads = 0;      ///< Number of loads running on worker threads
+            uint64_t residentBytes = 0;     ///< Memory used by the resident mip levels
+            uint64_t loadCount = 0;         ///< Number of loads completed since the streamer was created
+            uint64_t loadedBytes = 0;       ///< Size of the mip levels loaded since the streamer was created
+            uint64_t evictionCount = 0;     ///< Number of times a texture dropped to its mip tail to stay within the budget
+        };
+
+        /** Get the streaming statistics, updated by update()
+        */
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        TextureStreamer(uint64_t budget);
+
+        static const uint32_t kNotResident = uint32_t(-1);
+
+        /** A texture slot of a material. Layer textures come first, followed by the normal, alpha, ambient occlusion and height maps.
+        */
+        struct MaterialSlot
+        {
+            Material* pMaterial = nullptr;
+            uint32_t slot = 0;
+        };
+
+        struct StreamedTexture
+        {
+            std::string filename;
+            bool loadAsSrgb = false;
+            Texture::SharedPtr pTexture;        ///< The texture the materials use
+            std::vector<MaterialSlot> slots;
+            ResourceFormat format = ResourceFormat::Unknown;
+            uint32_t width = 0;                 ///< Size of the image's largest mip level. 0 until the first load completed
+            uint32_t height = 0;
+            uint32_t mipCount = 0;
+            uint32_t tailMip = 0;               ///< The mip level streaming starts at and evictions stop at
+            uint32_t residentMip = kNotResident; ///< The image mip level which is the texture's largest one
+            uint64_t residentSize = 0;
+            float requestedSize = 0;            ///< The largest screen size reported in the last frame, 0 if the texture wasn't used
+            uint64_t lastUsedFrame = 0;
+            bool loadPending = false;
+            bool loadFailed = false;
+        };
+
+        struct MaterialRecord
+        {
+            Material::SharedPtr pMaterial;
+            std::vector<uint32_t> textures;
+            float screenSize = 0;
+            bool used = false;
+        };
+
+        struct LoadResult
+        {
+            uint32_t textureID = 0;
+            uint64_t reservedSize = 0;
+            bool success = false;
+            TextureMipData mipData;
+        };
+
+        uint32_t getTextureID(const Texture::SharedPtr& pTexture);
+        uint32_t getDesiredMip(const StreamedTexture& texture) const;
+        uint32_t getTailMip(const StreamedTexture& texture) const;
+        void setResidentTexture(StreamedTexture& texture, const Texture::SharedPtr& pTexture, uint32_t residentMip);
+        void dropMips(StreamedTexture& texture, uint32_t firstMip);
+        bool makeRoom(uint64_t size);
+        void requestLoad(uint32_t textureID, uint32_t maxSize, uint64_t reservedSize);
+        void processCompletedLoads();
+        void applyUsage();
+        void scheduleLoads();
+
+        std::vector<StreamedTexture> mTextures;
+        std::map<std::pair<std::string, bool>, uint32_t> mTextureIDs;   // Keyed by the source filename and whether it's loaded as sRGB
+        std::unordered_map<const Material*, MaterialRecord> mMaterials;
+        const Material* mpLastReportedMaterial = nullptr;               // Consecutive draws usually share the material, cache the lookup
+        MaterialRecord* mpLastReportedRecord = nullptr;
+
+        uint64_t mBudget;
+        uint32_t mTailSize = 64;
+        uint32_t mMaxPendingLoads = 4;
+        float mResolutionScale = 1;
+        uint64_t mFrame = 0;
+        uint64_t mResidentBytes = 0;
+        uint64_t mReservedBytes = 0;                                     // Growth of the textures with pending loads
+        uint32_t mPendingLoads = 0;
+        std::vector<uint32_t> mEvictionOrder;                           // Textures which can be evicted this frame, least-recently used first
+        size_t mNextEviction = 0;
+        Stats mStats;
+
+        // Written by the worker threads
+        std::mutex mCompletedLoadsMutex;
+        std::vector<LoadResult> mCompletedLoads;
+        TaskScheduler::TaskGroup mLoadGroup;
+    };
+}
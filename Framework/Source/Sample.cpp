@@ -36,6 +36,8 @@
 #include "VR/OpenVR/VRSystem.h"
 #include "Utils/Platform/ProgressBar.h"
 #include "Utils/StringUtils.h"
+#include "Utils/CpuProfiler.h"
+#include "Utils/TaskScheduler.h"
 #include <sstream>
 #include <iomanip>
 
@@ -88,6 +90,12 @@ namespace Falcor
                 {
                     initVideoCapture();
                 }
+#if _PROFILING_ENABLED
+                else if (keyEvent.mods.isShiftDown && keyEvent.key == KeyboardEvent::Key::P)
+                {
+                    toggleCpuTrace();
+                }
+#endif
                 else if (!keyEvent.mods.isAltDown && !keyEvent.mods.isCtrlDown && !keyEvent.mods.isShiftDown)
                 {
                     switch (keyEvent.key)
@@ -157,6 +165,9 @@ namespace Falcor
 
         VRSystem::cleanup();
 
+        // Finish the background work before the device goes away
+        TaskScheduler::shutdown();
+
         mpGui.reset();
         mpDefaultPipelineState.reset();
         mpDefaultFBO.reset();
@@ -177,6 +188,9 @@ namespace Falcor
         Logger::init();
         Logger::showBoxOnError(config.showMessageBoxOnError);
 
+        // Start the task scheduler. This thread becomes its main thread.
+        TaskScheduler::init();
+
         // Create the window
         mpWindow = Window::create(config.windowDesc, this);
         if (mpWindow == nullptr)
@@ -292,7 +306,8 @@ namespace Falcor
             "  'Z'       - Zoom in on a pixel\n"
             "  'MouseWheel' - Change level of zoom\n"
 #if _PROFILING_ENABLED
-            "  'P'       - Enable profiling\n";
+            "  'P'       - Enable profiling\n"
+            "  'Shift+P' - Start\\stop CPU trace recording\n";
 #else
             ;
 #endif
@@ -543,6 +558,25 @@ namespace Falcor
         mFixedTimeDelta = mVideoCapture.sampleTimeDelta;
     }
 
+    void Sample::toggleCpuTrace()
+    {
+        if (CpuProfiler::isEnabled() == false)
+        {
+            CpuProfiler::clear();
+            CpuProfiler::setEnabled(true);
+            logInfo("CPU trace recording started");
+        }
+        else
+        {
+            CpuProfiler::setEnabled(false);
+            std::string filename = getExecutableDirectory() + "/CpuTrace.json";
+            if (CpuProfiler::exportChromeTrace(filename))
+            {
+                logInfo("CPU trace saved to " + filename);
+            }
+        }
+    }
+
     void Sample::captureVideoFrame()
     {
         if (mVideoCapture.pVideoCapture)
@@ -212,6 +212,7 @@ namespace Falcor
         void startVideoCapture();
         void endVideoCapture();
         void captureVideoFrame();
+        void toggleCpuTrace();
         void renderGUI();
 
         bool mVsyncOn = false;
@@ -88,7 +88,7 @@ namespace Falcor
         /** Skip data in an input stream. Advances file stream without reading.
             \param[in] count Bytes to skip
         */
-        void skip(uint32_t count)
+        void skip(uint64_t count)
         {
             mStream.ignore(count);
         }
@@ -107,13 +107,13 @@ namespace Falcor
         /** Calculates amount of remaining data in the file.
             \return Number of bytes remaining in the stream
         */
-        uint32_t getRemainingStreamSize()
+        uint64_t getRemainingStreamSize()
         {	
             std::streamoff currentPos = mStream.tellg();
             mStream.seekg(0, mStream.end);
             std::streamoff length = mStream.tellg();
             mStream.seekg(currentPos);
-            return (uint32_t)(length - currentPos); 
+            return (uint64_t)(length - currentPos); 
         }
 
         /** Checks for validity of the stream
@@ -0,0 +1,588 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BlockCompression.h"
+#include "Utils/TaskScheduler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FALCOR_BLOCK_COMPRESSION_SIMD
+#endif
+
+namespace Falcor
+{
+    namespace
+    {
+#ifdef FALCOR_BLOCK_COMPRESSION_SIMD
+        using SimdFloat = __m128;
+        const uint32_t kSimdWidth = 4;
+        inline SimdFloat load(const float* p) { return _mm_loadu_ps(p); }
+        inline void store(float* p, SimdFloat v) { _mm_storeu_ps(p, v); }
+        inline SimdFloat splat(float f) { return _mm_set1_ps(f); }
+        inline SimdFloat add(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+        inline SimdFloat sub(SimdFloat a, SimdFloat b) { return _mm_sub_ps(a, b); }
+        inline SimdFloat mul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+        inline SimdFloat minimum(SimdFloat a, SimdFloat b) { return _mm_min_ps(a, b); }
+        inline SimdFloat lessThan(SimdFloat a, SimdFloat b) { return _mm_cmplt_ps(a, b); }
+        inline SimdFloat select(SimdFloat mask, SimdFloat a, SimdFloat b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#else
+        using SimdFloat = float;
+        const uint32_t kSimdWidth = 1;
+        inline SimdFloat load(const float* p) { return *p; }
+        inline void store(float* p, SimdFloat v) { *p = v; }
+        inline SimdFloat splat(float f) { return f; }
+        inline SimdFloat add(SimdFloat a, SimdFloat b) { return a + b; }
+        inline SimdFloat sub(SimdFloat a, SimdFloat b) { return a - b; }
+        inline SimdFloat mul(SimdFloat a, SimdFloat b) { return a * b; }
+        inline SimdFloat minimum(SimdFloat a, SimdFloat b) { return std::min(a, b); }
+        inline bool lessThan(SimdFloat a, SimdFloat b) { return a < b; }
+        inline SimdFloat select(bool mask, SimdFloat a, SimdFloat b) { return mask ? a : b; }
+#endif
+
+        /** A 4x4 block with each channel stored separately, so that the texels can be processed kSimdWidth at a time
+        */
+        struct Block
+        {
+            float channels[4][16];
+        };
+
+        Block loadBlock(const uint8_t texels[16][4])
+        {
+            Block block;
+            for (uint32_t t = 0; t < 16; t++)
+            {
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    block.channels[c][t] = texels[t][c];
+                }
+            }
+            return block;
+        }
+
+        /** Find the closest palette entry to each texel
+            \return The sum of the squared distances
+        */
+        float selectIndices(const Block& block, uint32_t channelCount, const float palette[][4], uint32_t paletteSize, uint8_t indices[16])
+        {
+            float error = 0;
+            for (uint32_t t = 0; t < 16; t += kSimdWidth)
+            {
+                SimdFloat bestDistance = splat(FLT_MAX);
+                SimdFloat bestIndex = splat(0);
+                for (uint32_t i = 0; i < paletteSize; i++)
+                {
+                    SimdFloat distance = splat(0);
+                    for (uint32_t c = 0; c < channelCount; c++)
+                    {
+                        SimdFloat d = sub(load(&block.channels[c][t]), splat(palette[i][c]));
+                        distance = add(distance, mul(d, d));
+                    }
+                    bestIndex = select(lessThan(distance, bestDistance), splat((float)i), bestIndex);
+                    bestDistance = minimum(distance, bestDistance);
+                }
+
+                float distances[kSimdWidth];
+                float bestIndices[kSimdWidth];
+                store(distances, bestDistance);
+                store(bestIndices, bestIndex);
+                for (uint32_t i = 0; i < kSimdWidth; i++)
+                {
+                    error += distances[i];
+                    indices[t + i] = (uint8_t)bestIndices[i];
+                }
+            }
+            return error;
+        }
+
+        /** Find the endpoints of the segment of the texels' principal axis which covers all of them
+        */
+        void fitEndpoints(const Block& block, uint32_t channelCount, float e0[4], float e1[4])
+        {
+            float mean[4] = {};
+            for (uint32_t c = 0; c < channelCount; c++)
+            {
+                for (uint32_t t = 0; t < 16; t++) mean[c] += block.channels[c][t];
+                mean[c] /= 16;
+            }
+
+            float covariance[4][4] = {};
+            for (uint32_t t = 0; t < 16; t++)
+            {
+                for (uint32_t i = 0; i < channelCount; i++)
+                {
+                    for (uint32_t j = 0; j < channelCount; j++)
+                    {
+                        covariance[i][j] += (block.channels[i][t] - mean[i]) * (block.channels[j][t] - mean[j]);
+                    }
+                }
+            }
+
+            // Power iteration, starting from the channel with the largest variance
+            float axis[4] = {};
+            uint32_t largest = 0;
+            for (uint32_t c = 1; c < channelCount; c++)
+            {
+                if (covariance[c][c] > covariance[largest][largest]) largest = c;
+            }
+            for (uint32_t c = 0; c < channelCount; c++) axis[c] = covariance[largest][c];
+
+            for (uint32_t iteration = 0; iteration < 8; iteration++)
+            {
+                float next[4] = {};
+                float scale = 0;
+                for (uint32_t i = 0; i < channelCount; i++)
+                {
+                    for (uint32_t j = 0; j < channelCount; j++) next[i] += covariance[i][j] * axis[j];
+                    scale = std::max(scale, std::abs(next[i]));
+                }
+                if (scale == 0) break;
+                for (uint32_t c = 0; c < channelCount; c++) axis[c] = next[c] / scale;
+            }
+
+            float length = 0;
+            for (uint32_t c = 0; c < channelCount; c++) length += axis[c] * axis[c];
+            length = std::sqrt(length);
+            if (length > 0)
+            {
+                for (uint32_t c = 0; c < channelCount; c++) axis[c] /= length;
+            }
+
+            float minProjection = 0;
+            float maxProjection = 0;
+            for (uint32_t t = 0; t < 16; t++)
+            {
+                float projection = 0;
+                for (uint32_t c = 0; c < channelCount; c++) projection += (block.channels[c][t] - mean[c]) * axis[c];
+                minProjection = std::min(minProjection, projection);
+                maxProjection = std::max(maxProjection, projection);
+            }
+
+            for (uint32_t c = 0; c < channelCount; c++)
+            {
+                e0[c] = glm::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+                e1[c] = glm::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+            }
+        }
+
+        /** Solve for the endpoints which minimize the error of the texels, given their interpolation weights
+            \param[in] weights The weight of the second endpoint for each index
+            \return false if the weights don't determine both endpoints
+        */
+        bool refineEndpoints(const Block& block, uint32_t channelCount, const uint8_t indices[16], const float* weights, float e0[4], float e1[4])
+        {
+            float a = 0, b = 0, c = 0;
+            float x0[4] = {};
+            float x1[4] = {};
+            for (uint32_t t = 0; t < 16; t++)
+            {
+                float w = weights[indices[t]];
+                a += (1 - w) * (1 - w);
+                b += (1 - w) * w;
+                c += w * w;
+                for (uint32_t ch = 0; ch < channelCount; ch++)
+                {
+                    x0[ch] += (1 - w) * block.channels[ch][t];
+                    x1[ch] += w * block.channels[ch][t];
+                }
+            }
+
+            float det = a * c - b * b;
+            if (std::abs(det) < 1e-6f) return false;
+            for (uint32_t ch = 0; ch < channelCount; ch++)
+            {
+                e0[ch] = glm::clamp((c * x0[ch] - b * x1[ch]) / det, 0.0f, 255.0f);
+                e1[ch] = glm::clamp((a * x1[ch] - b * x0[ch]) / det, 0.0f, 255.0f);
+            }
+            return true;
+        }
+
+        /** Writes a block's fields from the least significant bit on
+        */
+        class BitWriter
+        {
+        public:
+            BitWriter(uint8_t* pDst, size_t size) : mpDst(pDst) { std::memset(pDst, 0, size); }
+            void write(uint32_t value, uint32_t bitCount)
+            {
+                for (uint32_t i = 0; i < bitCount; i++, mBit++)
+                {
+                    mpDst[mBit / 8] |= (uint8_t)(((value >> i) & 1) << (mBit % 8));
+                }
+            }
+        private:
+            uint8_t* mpDst;
+            uint32_t mBit = 0;
+        };
+
+        // BC1
+
+        const float kBc1Weights[4] = { 0, 1, 1.0f / 3, 2.0f / 3 };
+
+        uint16_t packRgb565(const float color[3])
+        {
+            uint32_t r = (uint32_t)(color[0] * 31 / 255 + 0.5f);
+            uint32_t g = (uint32_t)(color[1] * 63 / 255 + 0.5f);
+            uint32_t b = (uint32_t)(color[2] * 31 / 255 + 0.5f);
+            return (uint16_t)((r << 11) | (g << 5) | b);
+        }
+
+        void unpackRgb565(uint16_t packed, float color[4])
+        {
+            uint32_t r = (packed >> 11) & 0x1f;
+            uint32_t g = (packed >> 5) & 0x3f;
+            uint32_t b = packed & 0x1f;
+            color[0] = (float)((r << 3) | (r >> 2));
+            color[1] = (float)((g << 2) | (g >> 4));
+            color[2] = (float)((b << 3) | (b >> 2));
+            color[3] = 255;
+        }
+
+        float evaluateBc1(const Block& block, uint16_t c0, uint16_t c1, uint8_t indices[16])
+        {
+            float palette[4][4];
+            unpackRgb565(c0, palette[0]);
+            unpackRgb565(c1, palette[1]);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            return selectIndices(block, 3, palette, 4, indices);
+        }
+
+        /** Encode the color part of a block in the 4-color mode, which BC3 also uses
+        */
+        void encodeBc1Color(const Block& block, uint8_t dst[8])
+        {
+            float e0[4], e1[4];
+            fitEndpoints(block, 3, e0, e1);
+            uint16_t c0 = packRgb565(e1);
+            uint16_t c1 = packRgb565(e0);
+            uint8_t indices[16];
+            float error = evaluateBc1(block, c0, c1, indices);
+
+            for (uint32_t iteration = 0; iteration < 2 && error > 0; iteration++)
+            {
+                if (refineEndpoints(block, 3, indices, kBc1Weights, e0, e1) == false) break;
+                uint16_t r0 = packRgb565(e0);
+                uint16_t r1 = packRgb565(e1);
+                uint8_t refinedIndices[16];
+                float refinedError = evaluateBc1(block, r0, r1, refinedIndices);
+                if (refinedError >= error) break;
+                c0 = r0;
+                c1 = r1;
+                error = refinedError;
+                std::memcpy(indices, refinedIndices, sizeof(indices));
+            }
+
+            // The 4-color mode requires c0 > c1. Equal endpoints select the 3-color mode, where only the first two entries are safe to use.
+            if (c0 < c1)
+            {
+                std::swap(c0, c1);
+                for (uint8_t& i : indices) i ^= 1;
+            }
+            else if (c0 == c1)
+            {
+                std::memset(indices, 0, sizeof(indices));
+            }
+
+            uint32_t packedIndices = 0;
+            for (uint32_t t = 0; t < 16; t++) packedIndices |= (uint32_t)indices[t] << (2 * t);
+            dst[0] = (uint8_t)(c0 & 0xff);
+            dst[1] = (uint8_t)(c0 >> 8);
+            dst[2] = (uint8_t)(c1 & 0xff);
+            dst[3] = (uint8_t)(c1 >> 8);
+            for (uint32_t i = 0; i < 4; i++) dst[4 + i] = (uint8_t)(packedIndices >> (8 * i));
+        }
+
+        // BC4
+
+        const float kBc4Weights[8] = { 0, 1, 1.0f / 7, 2.0f / 7, 3.0f / 7, 4.0f / 7, 5.0f / 7, 6.0f / 7 };
+
+        float evaluateBc4(const Block& block, uint32_t a0, uint32_t a1, uint8_t indices[16])
+        {
+            float palette[8][4];
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                palette[i][0] = a0 * (1 - kBc4Weights[i]) + a1 * kBc4Weights[i];
+            }
+            return selectIndices(block, 1, palette, 8, indices);
+        }
+
+        /** Encode the first channel of a block in the 8-value mode
+        */
+        void encodeBc4Channel(const Block& block, uint8_t dst[8])
+        {
+            float minValue = block.channels[0][0];
+            float maxValue = block.channels[0][0];
+            for (uint32_t t = 1; t < 16; t++)
+            {
+                minValue = std::min(minValue, block.channels[0][t]);
+                maxValue = std::max(maxValue, block.channels[0][t]);
+            }
+
+            uint32_t a0 = (uint32_t)maxValue;
+            uint32_t a1 = (uint32_t)minValue;
+            uint8_t indices[16] = {};
+            float error = 0;
+            if (a0 != a1)
+            {
+                error = evaluateBc4(block, a0, a1, indices);
+                for (uint32_t iteration = 0; iteration < 2 && error > 0; iteration++)
+                {
+                    float e0[4], e1[4];
+                    if (refineEndpoints(block, 1, indices, kBc4Weights, e0, e1) == false) break;
+                    uint32_t r0 = (uint32_t)(e0[0] + 0.5f);
+                    uint32_t r1 = (uint32_t)(e1[0] + 0.5f);
+                    if (r0 < r1) std::swap(r0, r1);
+                    if (r0 == r1) break;
+                    uint8_t refinedIndices[16];
+                    float refinedError = evaluateBc4(block, r0, r1, refinedIndices);
+                    if (refinedError >= error) break;
+                    a0 = r0;
+                    a1 = r1;
+                    error = refinedError;
+                    std::memcpy(indices, refinedIndices, sizeof(indices));
+                }
+            }
+
+            // a0 > a1 selects the 8-value mode. With equal values every index decodes to a0.
+            BitWriter writer(dst, 8);
+            writer.write(a0, 8);
+            writer.write(a1, 8);
+            for (uint32_t t = 0; t < 16; t++) writer.write(indices[t], 3);
+        }
+
+        // BC7
+
+        const uint32_t kBc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        /** Mode 6 endpoints: 7 bits per channel, and a shared p-bit per endpoint
+        */
+        struct Bc7Endpoints
+        {
+            uint8_t values[2][4];
+            uint8_t pBits[2];
+        };
+
+        Bc7Endpoints quantizeBc7Endpoints(const float e0[4], const float e1[4], uint32_t p0, uint32_t p1)
+        {
+            Bc7Endpoints endpoints;
+            endpoints.pBits[0] = (uint8_t)p0;
+            endpoints.pBits[1] = (uint8_t)p1;
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                endpoints.values[0][c] = (uint8_t)glm::clamp((int32_t)std::floor((e0[c] - p0) / 2 + 0.5f), 0, 127);
+                endpoints.values[1][c] = (uint8_t)glm::clamp((int32_t)std::floor((e1[c] - p1) / 2 + 0.5f), 0, 127);
+            }
+            return endpoints;
+        }
+
+        float evaluateBc7(const Block& block, const Bc7Endpoints& endpoints, uint8_t indices[16])
+        {
+            float palette[16][4];
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                uint32_t v0 = (endpoints.values[0][c] << 1) | endpoints.pBits[0];
+                uint32_t v1 = (endpoints.values[1][c] << 1) | endpoints.pBits[1];
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    palette[i][c] = (float)(((64 - kBc7Weights4[i]) * v0 + kBc7Weights4[i] * v1 + 32) >> 6);
+                }
+            }
+            return selectIndices(block, 4, palette, 16, indices);
+        }
+
+        /** Try all the p-bit combinations for a pair of endpoints and keep the best result
+        */
+        void searchBc7PBits(const Block& block, const float e0[4], const float e1[4], Bc7Endpoints& bestEndpoints, uint8_t bestIndices[16], float& bestError)
+        {
+            for (uint32_t p = 0; p < 4; p++)
+            {
+                Bc7Endpoints endpoints = quantizeBc7Endpoints(e0, e1, p & 1, p >> 1);
+                uint8_t indices[16];
+                float error = evaluateBc7(block, endpoints, indices);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestEndpoints = endpoints;
+                    std::memcpy(bestIndices, indices, 16);
+                }
+            }
+        }
+    }
+
+    bool BlockCompression::isSupportedFormat(ResourceFormat format)
+    {
+        switch (format)
+        {
+        case ResourceFormat::BC1Unorm:
+        case ResourceFormat::BC1UnormSrgb:
+        case ResourceFormat::BC3Unorm:
+        case ResourceFormat::BC3UnormSrgb:
+        case ResourceFormat::BC4Unorm:
+        case ResourceFormat::BC5Unorm:
+        case ResourceFormat::BC7Unorm:
+        case ResourceFormat::BC7UnormSrgb:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void BlockCompression::encodeBC1Block(const uint8_t texels[16][4], uint8_t dst[8])
+    {
+        encodeBc1Color(loadBlock(texels), dst);
+    }
+
+    void BlockCompression::encodeBC3Block(const uint8_t texels[16][4], uint8_t dst[16])
+    {
+        Block block = loadBlock(texels);
+        Block alpha;
+        std::memcpy(alpha.channels[0], block.channels[3], sizeof(alpha.channels[0]));
+        encodeBc4Channel(alpha, dst);
+        encodeBc1Color(block, dst + 8);
+    }
+
+    void BlockCompression::encodeBC4Block(const uint8_t values[16], uint8_t dst[8])
+    {
+        Block block;
+        for (uint32_t t = 0; t < 16; t++) block.channels[0][t] = values[t];
+        encodeBc4Channel(block, dst);
+    }
+
+    void BlockCompression::encodeBC5Block(const uint8_t texels[16][4], uint8_t dst[16])
+    {
+        Block block = loadBlock(texels);
+        encodeBc4Channel(block, dst);
+        Block green;
+        std::memcpy(green.channels[0], block.channels[1], sizeof(green.channels[0]));
+        encodeBc4Channel(green, dst + 8);
+    }
+
+    void BlockCompression::encodeBC7Block(const uint8_t texels[16][4], uint8_t dst[16])
+    {
+        Block block = loadBlock(texels);
+        float e0[4], e1[4];
+        fitEndpoints(block, 4, e0, e1);
+
+        Bc7Endpoints endpoints;
+        uint8_t indices[16];
+        float error = FLT_MAX;
+        searchBc7PBits(block, e0, e1, endpoints, indices, error);
+
+        float weights[16];
+        for (uint32_t i = 0; i < 16; i++) weights[i] = kBc7Weights4[i] / 64.0f;
+        for (uint32_t iteration = 0; iteration < 2 && error > 0; iteration++)
+        {
+            float previousError = error;
+            if (refineEndpoints(block, 4, indices, weights, e0, e1) == false) break;
+            searchBc7PBits(block, e0, e1, endpoints, indices, error);
+            if (error >= previousError) break;
+        }
+
+        // The most significant bit of the first texel's index is implicitly 0
+        if (indices[0] >= 8)
+        {
+            std::swap(endpoints.values[0], endpoints.values[1]);
+            std::swap(endpoints.pBits[0], endpoints.pBits[1]);
+            for (uint8_t& i : indices) i = 15 - i;
+        }
+
+        BitWriter writer(dst, 16);
+        writer.write(1 << 6, 7);
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            writer.write(endpoints.values[0][c], 7);
+            writer.write(endpoints.values[1][c], 7);
+        }
+        writer.write(endpoints.pBits[0], 1);
+        writer.write(endpoints.pBits[1], 1);
+        writer.write(indices[0], 3);
+        for (uint32_t t = 1; t < 16; t++) writer.write(indices[t], 4);
+    }
+
+    bool BlockCompression::compress(ResourceFormat format, const uint8_t* pRgba8, uint32_t width, uint32_t height, uint8_t* pDst)
+    {
+        if (isSupportedFormat(format) == false)
+        {
+            logError("BlockCompression::compress() - format " + to_string(format) + " is not supported");
+            return false;
+        }
+
+        const uint32_t blocksX = (width + 3) / 4;
+        const uint32_t blocksY = (height + 3) / 4;
+        const uint32_t blockSize = getFormatBytesPerBlock(format);
+        TaskScheduler::get()->parallelFor(0, blocksY, [&](size_t begin, size_t end)
+        {
+            for (uint32_t by = (uint32_t)begin; by < (uint32_t)end; by++)
+            {
+                for (uint32_t bx = 0; bx < blocksX; bx++)
+                {
+                    uint8_t texels[16][4];
+                    for (uint32_t t = 0; t < 16; t++)
+                    {
+                        uint32_t x = std::min(bx * 4 + (t & 3), width - 1);
+                        uint32_t y = std::min(by * 4 + (t >> 2), height - 1);
+                        std::memcpy(texels[t], pRgba8 + ((size_t)y * width + x) * 4, 4);
+                    }
+
+                    uint8_t* pBlock = pDst + ((size_t)by * blocksX + bx) * blockSize;
+                    switch (format)
+                    {
+                    case ResourceFormat::BC1Unorm:
+                    case ResourceFormat::BC1UnormSrgb:
+                        encodeBC1Block(texels, pBlock);
+                        break;
+                    case ResourceFormat::BC3Unorm:
+                    case ResourceFormat::BC3UnormSrgb:
+                        encodeBC3Block(texels, pBlock);
+                        break;
+                    case ResourceFormat::BC4Unorm:
+                    {
+                        uint8_t values[16];
+                        for (uint32_t t = 0; t < 16; t++) values[t] = texels[t][0];
+                        encodeBC4Block(values, pBlock);
+                        break;
+                    }
+                    case ResourceFormat::BC5Unorm:
+                        encodeBC5Block(texels, pBlock);
+                        break;
+                    default:
+                        encodeBC7Block(texels, pBlock);
+                    }
+                }
+            }
+        });
+        return true;
+    }
+}
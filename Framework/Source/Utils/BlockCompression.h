@@ -0,0 +1,74 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/Formats.h"
+
+namespace Falcor
+{
+    /** CPU encoders for the BC1, BC3, BC4, BC5 and BC7 block-compressed formats.
+        Images are compressed on all the TaskScheduler's threads. The search for the closest palette entry is vectorized with SSE when it's available.
+        The encoders fit each block's endpoints to the principal axis of its texels and refine them with a least-squares solve. BC7 only uses mode 6 (a single RGBA subset with 4-bit indices).
+    */
+    class BlockCompression
+    {
+    public:
+        /** Check if a format can be encoded
+        */
+        static bool isSupportedFormat(ResourceFormat format);
+
+        /** Compress an image
+            \param[in] format The destination format. sRGB formats are encoded like the matching unorm format, the texels must already be in sRGB space.
+            \param[in] pRgba8 The texels, 4 bytes in RGBA order each, tightly packed and top row first. BC4 only reads the red channel and BC5 the red and green channels.
+            \param[in] width The image width. Partial blocks at the edges repeat the last column.
+            \param[in] height The image height. Partial blocks at the edges repeat the last row.
+            \param[out] pDst The compressed blocks, in row order. Must have room for getTextureMipChainSize(format, width, height, 0, 1) bytes.
+            \return false if the format isn't supported, otherwise true
+        */
+        static bool compress(ResourceFormat format, const uint8_t* pRgba8, uint32_t width, uint32_t height, uint8_t* pDst);
+
+        /** Encode a 4x4 block of opaque texels into BC1. The texels are RGBA8, in row order. Alpha is ignored.
+        */
+        static void encodeBC1Block(const uint8_t texels[16][4], uint8_t dst[8]);
+
+        /** Encode a 4x4 block of RGBA8 texels into BC3
+        */
+        static void encodeBC3Block(const uint8_t texels[16][4], uint8_t dst[16]);
+
+        /** Encode a 4x4 block of single-channel values into BC4
+        */
+        static void encodeBC4Block(const uint8_t values[16], uint8_t dst[8]);
+
+        /** Encode the red and green channels of a 4x4 block of RGBA8 texels into BC5
+        */
+        static void encodeBC5Block(const uint8_t texels[16][4], uint8_t dst[16]);
+
+        /** Encode a 4x4 block of RGBA8 texels into BC7
+        */
+        static void encodeBC7Block(const uint8_t texels[16][4], uint8_t dst[16]);
+    };
+}
@@ -0,0 +1,236 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BoundingBoxArray.h"
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FALCOR_BOUNDING_BOX_SIMD
+#elif defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FALCOR_BOUNDING_BOX_SIMD
+#endif
+
+namespace Falcor
+{
+    namespace
+    {
+#if defined(__AVX2__)
+        using SimdFloat = __m256;
+        const size_t kSimdWidth = 8;
+        inline SimdFloat load(const float* p) { return _mm256_loadu_ps(p); }
+        inline void store(float* p, SimdFloat v) { _mm256_storeu_ps(p, v); }
+        inline SimdFloat splat(float f) { return _mm256_set1_ps(f); }
+        inline SimdFloat add(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a, b); }
+        inline SimdFloat mul(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a, b); }
+        inline uint32_t lessEqualMask(SimdFloat a, SimdFloat b) { return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)); }
+#elif defined(FALCOR_BOUNDING_BOX_SIMD)
+        using SimdFloat = __m128;
+        const size_t kSimdWidth = 4;
+        inline SimdFloat load(const float* p) { return _mm_loadu_ps(p); }
+        inline void store(float* p, SimdFloat v) { _mm_storeu_ps(p, v); }
+        inline SimdFloat splat(float f) { return _mm_set1_ps(f); }
+        inline SimdFloat add(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+        inline SimdFloat mul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+        inline uint32_t lessEqualMask(SimdFloat a, SimdFloat b) { return (uint32_t)_mm_movemask_ps(_mm_cmple_ps(a, b)); }
+#endif
+
+        // Same as glm::sign(), so that the batch test matches Camera::isObjectCulled() bit-for-bit
+        inline float signOf(float f)
+        {
+            return (f > 0.0f) ? 1.0f : ((f < 0.0f) ? -1.0f : 0.0f);
+        }
+
+        struct CullPlane
+        {
+            float n[3];
+            float sign[3];
+            float w;
+        };
+    }
+
+    void BoundingBoxArray::resize(size_t count)
+    {
+        mCenterX.resize(count, 0.0f);
+        mCenterY.resize(count, 0.0f);
+        mCenterZ.resize(count, 0.0f);
+        mExtentX.resize(count, 0.0f);
+        mExtentY.resize(count, 0.0f);
+        mExtentZ.resize(count, 0.0f);
+    }
+
+    void BoundingBoxArray::push_back(const BoundingBox& box)
+    {
+        mCenterX.push_back(box.center.x);
+        mCenterY.push_back(box.center.y);
+        mCenterZ.push_back(box.center.z);
+        mExtentX.push_back(box.extent.x);
+        mExtentY.push_back(box.extent.y);
+        mExtentZ.push_back(box.extent.z);
+    }
+
+    void BoundingBoxArray::set(size_t index, const BoundingBox& box)
+    {
+        assert(index < size());
+        mCenterX[index] = box.center.x;
+        mCenterY[index] = box.center.y;
+        mCenterZ[index] = box.center.z;
+        mExtentX[index] = box.extent.x;
+        mExtentY[index] = box.extent.y;
+        mExtentZ[index] = box.extent.z;
+    }
+
+    BoundingBox BoundingBoxArray::get(size_t index) const
+    {
+        assert(index < size());
+        BoundingBox box;
+        box.center = glm::vec3(mCenterX[index], mCenterY[index], mCenterZ[index]);
+        box.extent = glm::vec3(mExtentX[index], mExtentY[index], mExtentZ[index]);
+        return box;
+    }
+
+    void BoundingBoxArray::transform(const glm::mat4& mat, BoundingBoxArray& result) const
+    {
+        // The transformed center is M * c. Each axis of the transformed extent is the sum of the extents projected onto it, abs(M) * e.
+        const size_t count = size();
+        result.resize(count);
+
+        float m[3][3];
+        float a[3][3];
+        for (uint32_t col = 0; col < 3; col++)
+        {
+            for (uint32_t row = 0; row < 3; row++)
+            {
+                m[col][row] = mat[col][row];
+                a[col][row] = std::abs(mat[col][row]);
+            }
+        }
+        const float t[3] = { mat[3][0], mat[3][1], mat[3][2] };
+
+        const float* pCenter[3] = { mCenterX.data(), mCenterY.data(), mCenterZ.data() };
+        const float* pExtent[3] = { mExtentX.data(), mExtentY.data(), mExtentZ.data() };
+        float* pOutCenter[3] = { result.mCenterX.data(), result.mCenterY.data(), result.mCenterZ.data() };
+        float* pOutExtent[3] = { result.mExtentX.data(), result.mExtentY.data(), result.mExtentZ.data() };
+
+        size_t i = 0;
+#ifdef FALCOR_BOUNDING_BOX_SIMD
+        for (; i + kSimdWidth <= count; i += kSimdWidth)
+        {
+            SimdFloat c[3] = { load(pCenter[0] + i), load(pCenter[1] + i), load(pCenter[2] + i) };
+            SimdFloat e[3] = { load(pExtent[0] + i), load(pExtent[1] + i), load(pExtent[2] + i) };
+
+            for (uint32_t row = 0; row < 3; row++)
+            {
+                SimdFloat center = add(add(add(mul(splat(m[0][row]), c[0]), mul(splat(m[1][row]), c[1])), mul(splat(m[2][row]), c[2])), splat(t[row]));
+                SimdFloat extent = add(add(mul(splat(a[0][row]), e[0]), mul(splat(a[1][row]), e[1])), mul(splat(a[2][row]), e[2]));
+                store(pOutCenter[row] + i, center);
+                store(pOutExtent[row] + i, extent);
+            }
+        }
+#endif
+        for (; i < count; i++)
+        {
+            float c[3] = { pCenter[0][i], pCenter[1][i], pCenter[2][i] };
+            float e[3] = { pExtent[0][i], pExtent[1][i], pExtent[2][i] };
+
+            for (uint32_t row = 0; row < 3; row++)
+            {
+                pOutCenter[row][i] = m[0][row] * c[0] + m[1][row] * c[1] + m[2][row] * c[2] + t[row];
+                pOutExtent[row][i] = a[0][row] * e[0] + a[1][row] * e[1] + a[2][row] * e[2];
+            }
+        }
+    }
+
+    size_t BoundingBoxArray::cull(const glm::vec4* pPlanes, uint32_t planeCount, std::vector<uint32_t>& visibleIndices) const
+    {
+        // Tests the corner furthest along each plane normal, c + sign(n) * e. See method 4b: https://fgiesen.wordpress.com/2010/10/17/view-frustum-culling/
+        const size_t count = size();
+        visibleIndices.clear();
+        visibleIndices.reserve(count);
+
+        std::vector<CullPlane> planes(planeCount);
+        for (uint32_t p = 0; p < planeCount; p++)
+        {
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                planes[p].n[j] = pPlanes[p][j];
+                planes[p].sign[j] = signOf(pPlanes[p][j]);
+            }
+            planes[p].w = pPlanes[p].w;
+        }
+
+        size_t i = 0;
+#ifdef FALCOR_BOUNDING_BOX_SIMD
+        const uint32_t allLanes = (1 << kSimdWidth) - 1;
+        for (; i + kSimdWidth <= count; i += kSimdWidth)
+        {
+            SimdFloat cx = load(mCenterX.data() + i);
+            SimdFloat cy = load(mCenterY.data() + i);
+            SimdFloat cz = load(mCenterZ.data() + i);
+            SimdFloat ex = load(mExtentX.data() + i);
+            SimdFloat ey = load(mExtentY.data() + i);
+            SimdFloat ez = load(mExtentZ.data() + i);
+
+            uint32_t culled = 0;
+            for (const auto& plane : planes)
+            {
+                SimdFloat px = add(cx, mul(ex, splat(plane.sign[0])));
+                SimdFloat py = add(cy, mul(ey, splat(plane.sign[1])));
+                SimdFloat pz = add(cz, mul(ez, splat(plane.sign[2])));
+                SimdFloat d = add(add(mul(px, splat(plane.n[0])), mul(py, splat(plane.n[1]))), mul(pz, splat(plane.n[2])));
+                culled |= lessEqualMask(d, splat(plane.w));
+                if (culled == allLanes) break;
+            }
+
+            for (uint32_t lane = 0; lane < kSimdWidth; lane++)
+            {
+                if ((culled & (1 << lane)) == 0) visibleIndices.push_back((uint32_t)(i + lane));
+            }
+        }
+#endif
+        for (; i < count; i++)
+        {
+            bool isCulled = false;
+            for (const auto& plane : planes)
+            {
+                float px = mCenterX[i] + mExtentX[i] * plane.sign[0];
+                float py = mCenterY[i] + mExtentY[i] * plane.sign[1];
+                float pz = mCenterZ[i] + mExtentZ[i] * plane.sign[2];
+                if (px * plane.n[0] + py * plane.n[1] + pz * plane.n[2] <= plane.w)
+                {
+                    isCulled = true;
+                    break;
+                }
+            }
+            if (!isCulled) visibleIndices.push_back((uint32_t)i);
+        }
+
+        return visibleIndices.size();
+    }
+}
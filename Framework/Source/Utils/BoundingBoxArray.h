@@ -0,0 +1,94 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "Utils/AABB.h"
+
+namespace Falcor
+{
+    /** Structure-of-arrays storage for a batch of bounding boxes.
+        Each component of the center and extent lives in its own array, which lets the batch kernels process several boxes per SIMD instruction.
+        The kernels use SSE2 on x64 (and AVX2 when the compiler targets it), and fall back to scalar code otherwise.
+    */
+    class BoundingBoxArray
+    {
+    public:
+        /** Get the number of boxes in the array
+        */
+        size_t size() const { return mCenterX.size(); }
+
+        /** Resize the array. New boxes are zero-initialized.
+        */
+        void resize(size_t count);
+
+        /** Remove all boxes
+        */
+        void clear() { resize(0); }
+
+        /** Append a box to the end of the array
+        */
+        void push_back(const BoundingBox& box);
+
+        /** Overwrite the box at a specific index
+        */
+        void set(size_t index, const BoundingBox& box);
+
+        /** Get the box at a specific index
+        */
+        BoundingBox get(size_t index) const;
+
+        /** Transform all the boxes by a matrix. The result is the same as calling BoundingBox#transform() on each box.
+            \param[in] mat Transform matrix
+            \param[out] result The transformed boxes. Can be the same object as this.
+        */
+        void transform(const glm::mat4& mat, BoundingBoxArray& result) const;
+
+        /** Test all the boxes against a set of planes and output the indices of the boxes which are not culled.
+            A box is culled if it is fully behind at least one of the planes, that is if dot(c, n) + dot(e, abs(n)) <= w for the plane (n, w).
+            \param[in] pPlanes Array of planes. xyz is the plane normal, w is the distance the box has to exceed along the normal.
+            \param[in] planeCount Number of planes in pPlanes
+            \param[out] visibleIndices Indices of the boxes which passed the test, in increasing order. The vector is cleared first.
+            \return The number of visible boxes
+        */
+        size_t cull(const glm::vec4* pPlanes, uint32_t planeCount, std::vector<uint32_t>& visibleIndices) const;
+
+        const float* getCenterX() const { return mCenterX.data(); }
+        const float* getCenterY() const { return mCenterY.data(); }
+        const float* getCenterZ() const { return mCenterZ.data(); }
+        const float* getExtentX() const { return mExtentX.data(); }
+        const float* getExtentY() const { return mExtentY.data(); }
+        const float* getExtentZ() const { return mExtentZ.data(); }
+    private:
+        std::vector<float> mCenterX;
+        std::vector<float> mCenterY;
+        std::vector<float> mCenterZ;
+        std::vector<float> mExtentX;
+        std::vector<float> mExtentY;
+        std::vector<float> mExtentZ;
+    };
+}
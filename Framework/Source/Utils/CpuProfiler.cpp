@@ -0,0 +1,271 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#if defined(_M_X64)
+#include <intrin.h>
+#define FALCOR_CPU_PROFILER_USE_TSC
+#elif defined(__x86_64__)
+#include <x86intrin.h>
+#define FALCOR_CPU_PROFILER_USE_TSC
+#endif
+
+namespace Falcor
+{
+    std::atomic<bool> CpuProfiler::sEnabled{ false };
+
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Events are timestamped with raw ticks, which are converted to nanoseconds on export. On x64 the ticks come from the TSC, which is a lot cheaper to read than the OS clock.
+        uint64_t getTimestamp()
+        {
+#ifdef FALCOR_CPU_PROFILER_USE_TSC
+            return __rdtsc();
+#else
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+#endif
+        }
+
+        struct ClockSample
+        {
+            ClockSample() : time(Clock::now()), ticks(getTimestamp()) {}
+            Clock::time_point time;
+            uint64_t ticks;
+        };
+
+        // Reference point for converting ticks into time. The tick rate is measured between this and the time of the export.
+        const ClockSample gEpoch;
+
+        struct Event
+        {
+            const char* name;
+            uint64_t start;     // In ticks
+            uint64_t duration;
+            uint32_t depth;
+        };
+
+        static_assert((CpuProfiler::kEventsPerThread & (CpuProfiler::kEventsPerThread - 1)) == 0, "Ring-buffer size must be a power of 2");
+
+        struct ThreadBuffer
+        {
+            uint32_t threadId = 0;
+            std::string name;                           // Protected by the registry mutex
+            std::unique_ptr<Event[]> pEvents;           // Allocated when the first event starts
+            std::atomic<uint64_t> writeIndex{ 0 };      // Total number of events recorded. Only written by the owning thread
+            std::atomic<uint64_t> clearIndex{ 0 };      // Events before this index were cleared
+
+            // Only accessed by the owning thread
+            uint32_t depth = 0;
+            const char* names[CpuProfiler::kMaxDepth];
+            uint64_t startTimes[CpuProfiler::kMaxDepth];
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers; // Kept after their threads exit, so their events can still be exported
+            std::unordered_set<std::string> names;
+        };
+
+        Registry& getRegistry()
+        {
+            // Never destroyed, threads can still record events during static destruction
+            static Registry* pRegistry = new Registry;
+            return *pRegistry;
+        }
+
+        thread_local ThreadBuffer* tlsBuffer = nullptr;
+
+        ThreadBuffer* getThreadBuffer()
+        {
+            if (tlsBuffer == nullptr)
+            {
+                auto pBuffer = std::make_shared<ThreadBuffer>();
+                Registry& registry = getRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                pBuffer->threadId = (uint32_t)registry.buffers.size();
+                pBuffer->name = "Thread " + std::to_string(pBuffer->threadId);
+                registry.buffers.push_back(pBuffer);
+                tlsBuffer = pBuffer.get();
+            }
+            return tlsBuffer;
+        }
+
+        void writeJsonString(std::ostream& stream, const char* str)
+        {
+            stream << '"';
+            for (const char* c = str; *c; c++)
+            {
+                switch (*c)
+                {
+                case '"': stream << "\\\""; break;
+                case '\\': stream << "\\\\"; break;
+                default:
+                    if ((unsigned char)*c < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                        stream << escaped;
+                    }
+                    else
+                    {
+                        stream << *c;
+                    }
+                }
+            }
+            stream << '"';
+        }
+    }
+
+    void CpuProfiler::beginEvent(const char* name)
+    {
+        ThreadBuffer* pBuffer = getThreadBuffer();
+        if (pBuffer->depth < kMaxDepth)
+        {
+            if (pBuffer->pEvents == nullptr)
+            {
+                pBuffer->pEvents.reset(new Event[kEventsPerThread]);
+            }
+            pBuffer->names[pBuffer->depth] = name;
+            pBuffer->startTimes[pBuffer->depth] = getTimestamp();
+        }
+        pBuffer->depth++;
+    }
+
+    void CpuProfiler::endEvent()
+    {
+        uint64_t end = getTimestamp();
+        ThreadBuffer* pBuffer = tlsBuffer;
+        if (pBuffer == nullptr || pBuffer->depth == 0) return;
+
+        pBuffer->depth--;
+        if (pBuffer->depth >= kMaxDepth) return;
+
+        // Only this thread writes the index. Publish the event after it was written, so that the exporter never sees a partial event
+        uint64_t index = pBuffer->writeIndex.load(std::memory_order_relaxed);
+        Event& event = pBuffer->pEvents[index & (kEventsPerThread - 1)];
+        event.name = pBuffer->names[pBuffer->depth];
+        event.start = pBuffer->startTimes[pBuffer->depth];
+        event.duration = end - event.start;
+        event.depth = pBuffer->depth;
+        pBuffer->writeIndex.store(index + 1, std::memory_order_release);
+    }
+
+    const char* CpuProfiler::internName(const std::string& name)
+    {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        return registry.names.insert(name).first->c_str();
+    }
+
+    void CpuProfiler::setThreadName(const std::string& name)
+    {
+        ThreadBuffer* pBuffer = getThreadBuffer();
+        std::lock_guard<std::mutex> lock(getRegistry().mutex);
+        pBuffer->name = name;
+    }
+
+    void CpuProfiler::clear()
+    {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (auto& pBuffer : registry.buffers)
+        {
+            pBuffer->clearIndex.store(pBuffer->writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+        }
+    }
+
+    bool CpuProfiler::exportChromeTrace(const std::string& filename)
+    {
+        std::ofstream stream(filename);
+        if (stream.fail())
+        {
+            logError("CpuProfiler::exportChromeTrace() - can't open file '" + filename + "' for writing");
+            return false;
+        }
+
+        ClockSample now;
+        double elapsedNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(now.time - gEpoch.time).count();
+        double nsPerTick = (now.ticks > gEpoch.ticks && elapsedNs > 0) ? elapsedNs / double(now.ticks - gEpoch.ticks) : 1.0;
+
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        bool first = true;
+        std::vector<Event> events;
+        char line[256];
+        for (auto& pBuffer : registry.buffers)
+        {
+            // Thread name metadata
+            if (first == false) stream << ",\n";
+            first = false;
+            stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << pBuffer->threadId << ",\"args\":{\"name\":";
+            writeJsonString(stream, pBuffer->name.c_str());
+            stream << "}}";
+
+            // Copy the events out of the ring-buffer. The owning thread keeps recording, so anything it could have overwritten during the copy is dropped afterwards
+            uint64_t end = pBuffer->writeIndex.load(std::memory_order_acquire);
+            uint64_t begin = std::max(pBuffer->clearIndex.load(std::memory_order_relaxed), (end > kEventsPerThread) ? end - kEventsPerThread : 0);
+            events.clear();
+            for (uint64_t i = begin; i < end; i++)
+            {
+                events.push_back(pBuffer->pEvents[i & (kEventsPerThread - 1)]);
+            }
+            uint64_t latest = pBuffer->writeIndex.load(std::memory_order_acquire);
+            uint64_t firstValid = (latest + 1 > kEventsPerThread) ? latest + 1 - kEventsPerThread : 0;
+
+            for (uint64_t i = std::max(begin, firstValid); i < end; i++)
+            {
+                const Event& event = events[i - begin];
+                stream << ",\n{\"name\":";
+                writeJsonString(stream, event.name);
+                std::snprintf(line, sizeof(line), ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%u}}",
+                    pBuffer->threadId, double(int64_t(event.start - gEpoch.ticks)) * nsPerTick * 1e-3, double(event.duration) * nsPerTick * 1e-3, event.depth);
+                stream << line;
+            }
+        }
+        stream << "\n]}\n";
+
+        if (stream.fail())
+        {
+            logError("CpuProfiler::exportChromeTrace() - failed writing to '" + filename + "'");
+            return false;
+        }
+        return true;
+    }
+}
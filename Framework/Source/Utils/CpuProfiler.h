@@ -0,0 +1,107 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <atomic>
+#include <string>
+#include "FalcorConfig.h"
+
+namespace Falcor
+{
+    /** Low-overhead CPU event recorder, which can be used from any thread.
+        Every thread records into its own fixed-size ring buffer, so recording an event doesn't take locks or allocate. When a buffer is full the oldest events are overwritten.
+        Events are stored as complete scopes with nanosecond-resolution timestamps, the thread they ran on and their nesting depth, and can be exported into the Chrome trace event format, which can be opened in chrome://tracing or Perfetto.
+        Use the PROFILE_CPU macro or CpuProfilerScope to record scopes.
+    */
+    class CpuProfiler
+    {
+    public:
+        /** Number of events each thread can hold before it starts overwriting the oldest ones
+        */
+        static const uint32_t kEventsPerThread = 1 << 15;
+
+        /** Maximum nesting depth. Deeper scopes are not recorded.
+        */
+        static const uint32_t kMaxDepth = 64;
+
+        /** Enable or disable recording. Recording is disabled by default.
+        */
+        static void setEnabled(bool enable) { sEnabled.store(enable, std::memory_order_relaxed); }
+
+        /** Check if recording is enabled
+        */
+        static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+        /** Start a scope on the calling thread. Prefer CpuProfilerScope, which pairs this with endEvent().
+            \param[in] name Event name. Only the pointer is stored, so it must stay valid until the events are exported - use a string literal or internName().
+        */
+        static void beginEvent(const char* name);
+
+        /** End the innermost scope of the calling thread and record it
+        */
+        static void endEvent();
+
+        /** Get a pointer to a copy of a string which stays valid for the lifetime of the process. Use it for event names which are built at runtime.
+        */
+        static const char* internName(const std::string& name);
+
+        /** Name the calling thread. The name is used for the thread's track in the exported trace.
+        */
+        static void setThreadName(const std::string& name);
+
+        /** Write all the recorded events into a Chrome trace event JSON file.
+            Can be called while other threads are recording. Events which are overwritten while the export is running are skipped.
+            \param[in] filename Output file
+            \return true on success, otherwise false
+        */
+        static bool exportChromeTrace(const std::string& filename);
+
+        /** Remove all recorded events
+        */
+        static void clear();
+
+    private:
+        static std::atomic<bool> sEnabled;
+    };
+
+    /** Records a scope into the CpuProfiler. Events are only recorded if profiling was enabled when the scope started.
+    */
+    class CpuProfilerScope
+    {
+    public:
+        CpuProfilerScope(const char* name) : mActive(CpuProfiler::isEnabled()) { if (mActive) { CpuProfiler::beginEvent(name); } }
+        ~CpuProfilerScope() { if (mActive) { CpuProfiler::endEvent(); } }
+    private:
+        bool mActive;
+    };
+
+#if _PROFILING_ENABLED
+#define PROFILE_CPU(_name) Falcor::CpuProfilerScope _cpuProfileScope ## _name(#_name);
+#else
+#define PROFILE_CPU(_name)
+#endif
+}
@@ -0,0 +1,210 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Lz4.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace Falcor
+{
+    namespace
+    {
+        const size_t kMinMatch = 4;
+        const size_t kLastLiterals = 5;     // The last bytes of a block are always literals
+        const size_t kMatchStartLimit = 12; // A match can't start in the last bytes of a block
+        const size_t kMaxOffset = 65535;
+        const uint32_t kHashBits = 16;
+        const uint32_t kRunMask = 15;
+
+        uint32_t read32(const uint8_t* p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        uint32_t hash(uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - kHashBits);
+        }
+
+        /** Write a length which doesn't fit into its token field
+        */
+        uint8_t* writeLength(uint8_t* pOut, size_t length)
+        {
+            while (length >= 255)
+            {
+                *pOut++ = 255;
+                length -= 255;
+            }
+            *pOut++ = (uint8_t)length;
+            return pOut;
+        }
+
+        /** Emit a sequence. The final sequence has no match, pass matchLength = 0 for it.
+            \return The new output position, or nullptr if the sequence doesn't fit
+        */
+        uint8_t* writeSequence(uint8_t* pOut, const uint8_t* pOutEnd, const uint8_t* pLiterals, size_t literalCount, size_t offset, size_t matchLength)
+        {
+            size_t worstCase = 1 + literalCount / 255 + 1 + literalCount + 2 + matchLength / 255 + 1;
+            if ((size_t)(pOutEnd - pOut) < worstCase) return nullptr;
+
+            uint8_t* pToken = pOut++;
+            *pToken = (uint8_t)(std::min<size_t>(literalCount, kRunMask) << 4);
+            if (literalCount >= kRunMask) pOut = writeLength(pOut, literalCount - kRunMask);
+            std::memcpy(pOut, pLiterals, literalCount);
+            pOut += literalCount;
+
+            if (matchLength != 0)
+            {
+                *pOut++ = (uint8_t)offset;
+                *pOut++ = (uint8_t)(offset >> 8);
+                size_t length = matchLength - kMinMatch;
+                *pToken |= (uint8_t)std::min<size_t>(length, kRunMask);
+                if (length >= kRunMask) pOut = writeLength(pOut, length - kRunMask);
+            }
+            return pOut;
+        }
+
+        /** Read the continuation bytes of a length
+        */
+        bool readLength(const uint8_t*& pIn, const uint8_t* pInEnd, size_t& length)
+        {
+            uint8_t b;
+            do
+            {
+                if (pIn >= pInEnd) return false;
+                b = *pIn++;
+                length += b;
+            } while (b == 255);
+            return true;
+        }
+    }
+
+    size_t Lz4::compress(const void* pSrc, size_t srcSize, void* pDst, size_t dstCapacity)
+    {
+        const uint8_t* pBase = (const uint8_t*)pSrc;
+        const uint8_t* pIn = pBase;
+        const uint8_t* pAnchor = pBase;
+        const uint8_t* pEnd = pBase + srcSize;
+        uint8_t* pOut = (uint8_t*)pDst;
+        uint8_t* pOutEnd = pOut + dstCapacity;
+
+        if (srcSize > kMatchStartLimit)
+        {
+            const uint8_t* pMatchStartLimit = pEnd - kMatchStartLimit;
+            const uint8_t* pMatchEndLimit = pEnd - kLastLiterals;
+            std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+
+            pIn++;
+            while (pIn < pMatchStartLimit)
+            {
+                uint32_t sequence = read32(pIn);
+                uint32_t& entry = table[hash(sequence)];
+                const uint8_t* pMatch = pBase + entry;
+                entry = (uint32_t)(pIn - pBase);
+
+                if ((pMatch >= pIn) || ((size_t)(pIn - pMatch) > kMaxOffset) || (read32(pMatch) != sequence))
+                {
+                    // Skip faster through incompressible data
+                    pIn += 1 + ((pIn - pAnchor) >> 6);
+                    continue;
+                }
+
+                // Extend the match in both directions
+                while ((pIn > pAnchor) && (pMatch > pBase) && (pIn[-1] == pMatch[-1]))
+                {
+                    pIn--;
+                    pMatch--;
+                }
+                size_t length = kMinMatch;
+                while ((pIn + length < pMatchEndLimit) && (pIn[length] == pMatch[length])) length++;
+
+                pOut = writeSequence(pOut, pOutEnd, pAnchor, pIn - pAnchor, pIn - pMatch, length);
+                if (pOut == nullptr) return 0;
+
+                pIn += length;
+                pAnchor = pIn;
+                if (pIn < pMatchStartLimit)
+                {
+                    table[hash(read32(pIn - 2))] = (uint32_t)(pIn - 2 - pBase);
+                }
+            }
+        }
+
+        pOut = writeSequence(pOut, pOutEnd, pAnchor, pEnd - pAnchor, 0, 0);
+        return pOut ? (size_t)(pOut - (uint8_t*)pDst) : 0;
+    }
+
+    bool Lz4::decompress(const void* pSrc, size_t srcSize, void* pDst, size_t dstSize)
+    {
+        const uint8_t* pIn = (const uint8_t*)pSrc;
+        const uint8_t* pInEnd = pIn + srcSize;
+        uint8_t* pOut = (uint8_t*)pDst;
+        uint8_t* pOutEnd = pOut + dstSize;
+
+        while (pIn < pInEnd)
+        {
+            uint8_t token = *pIn++;
+
+            size_t literalCount = token >> 4;
+            if ((literalCount == kRunMask) && (readLength(pIn, pInEnd, literalCount) == false)) return false;
+            if (((size_t)(pInEnd - pIn) < literalCount) || ((size_t)(pOutEnd - pOut) < literalCount)) return false;
+            std::memcpy(pOut, pIn, literalCount);
+            pIn += literalCount;
+            pOut += literalCount;
+
+            // The last sequence has no match
+            if (pIn == pInEnd) break;
+
+            if (pInEnd - pIn < 2) return false;
+            size_t offset = pIn[0] | (pIn[1] << 8);
+            pIn += 2;
+            if ((offset == 0) || (offset > (size_t)(pOut - (uint8_t*)pDst))) return false;
+
+            size_t length = token & kRunMask;
+            if ((length == kRunMask) && (readLength(pIn, pInEnd, length) == false)) return false;
+            length += kMinMatch;
+            if ((size_t)(pOutEnd - pOut) < length) return false;
+
+            // The source and destination overlap when the offset is shorter than the match, which repeats the last offset bytes.
+            // Copy in non-overlapping pieces, each one twice as long as the previous.
+            const uint8_t* pMatch = pOut - offset;
+            while (length != 0)
+            {
+                size_t count = std::min(length, (size_t)(pOut - pMatch));
+                std::memcpy(pOut, pMatch, count);
+                pOut += count;
+                length -= count;
+            }
+        }
+
+        return pOut == pOutEnd;
+    }
+}
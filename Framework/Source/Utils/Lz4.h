@@ -0,0 +1,61 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstddef>
+
+namespace Falcor
+{
+    /** Compression in the LZ4 block format. Output can be decompressed by the reference LZ4_decompress_safe() and vice versa.
+        Uses a single-probe hash table, favoring decompression speed over compression ratio. Used for data that is compressed once and loaded often, like the model cache.
+    */
+    class Lz4
+    {
+    public:
+        /** Get the largest size compressing srcSize bytes can produce
+        */
+        static size_t getMaxCompressedSize(size_t srcSize) { return srcSize + srcSize / 255 + 16; }
+
+        /** Compress a block of data
+            \param[in] pSrc The data to compress
+            \param[in] srcSize Size of the data in bytes
+            \param[out] pDst Receives the compressed data
+            \param[in] dstCapacity Size of the destination buffer. If it's at least getMaxCompressedSize(srcSize), compression can't fail.
+            \return The size of the compressed data, or 0 if it doesn't fit into the destination buffer
+        */
+        static size_t compress(const void* pSrc, size_t srcSize, void* pDst, size_t dstCapacity);
+
+        /** Decompress a block of data. Safe to use with corrupt data, never reads or writes out of bounds.
+            \param[in] pSrc The compressed data
+            \param[in] srcSize Size of the compressed data in bytes
+            \param[out] pDst Receives the decompressed data
+            \param[in] dstSize The exact size of the decompressed data
+            \return false if the data is corrupt or doesn't decompress to exactly dstSize bytes
+        */
+        static bool decompress(const void* pSrc, size_t srcSize, void* pDst, size_t dstSize);
+    };
+}
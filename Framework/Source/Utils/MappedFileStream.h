@@ -0,0 +1,209 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstring>
+#include <string>
+#include "Utils/Platform/OS.h"
+
+namespace Falcor
+{
+    /** Non-owning view of a contiguous array of elements
+    */
+    template<typename T>
+    class ConstSpan
+    {
+    public:
+        ConstSpan() = default;
+        ConstSpan(const T* pData, size_t count) : mpData(pData), mCount(count) {}
+
+        const T* data() const { return mpData; }
+        size_t size() const { return mCount; }
+        size_t sizeInBytes() const { return mCount * sizeof(T); }
+        bool empty() const { return mCount == 0; }
+        const T* begin() const { return mpData; }
+        const T* end() const { return mpData + mCount; }
+        const T& operator[](size_t i) const { return mpData[i]; }
+
+    private:
+        const T* mpData = nullptr;
+        size_t mCount = 0;
+    };
+
+    /** Read-only binary file stream backed by a memory mapping.
+        Offsets and sizes are 64-bit, so files larger than 4GB are supported. Use readSpan() to access data in-place without copying it. The returned spans are valid as long as the stream is open.
+        Data in the file is not necessarily aligned to the element size, so the spans may be unaligned.
+    */
+    class MappedFileStream
+    {
+    public:
+        /** Default constructor.
+        */
+        MappedFileStream() = default;
+
+        /** Constructor that opens a file
+            \param[in] filename Full path of the file to open
+        */
+        MappedFileStream(const std::string& filename)
+        {
+            open(filename);
+        }
+
+        MappedFileStream(const MappedFileStream&) = delete;
+        MappedFileStream& operator=(const MappedFileStream&) = delete;
+
+        /** Destructor
+        */
+        ~MappedFileStream()
+        {
+            close();
+        }
+
+        /** Map a file. Closes the currently open file, if any.
+            \param[in] filename Full path of the file to open
+            \return true if the file was mapped successfully
+        */
+        bool open(const std::string& filename)
+        {
+            close();
+            mpData = (const uint8_t*)mapFileForReading(filename, mSize);
+            mFilename = filename;
+            mFail = (mpData == nullptr);
+            return !mFail;
+        }
+
+        /** Unmap the file. Invalidates all spans returned from this stream.
+        */
+        void close()
+        {
+            unmapFile(mpData, mSize);
+            mpData = nullptr;
+            mSize = 0;
+            mOffset = 0;
+        }
+
+        /** Get the size of the file in bytes
+        */
+        uint64_t getSize() const { return mSize; }
+
+        /** Get the current read offset
+        */
+        uint64_t tell() const { return mOffset; }
+
+        /** Set the current read offset. Fails if the offset is past the end of the file.
+        */
+        void seek(uint64_t offset)
+        {
+            if (offset > mSize) { mFail = true; mOffset = mSize; }
+            else mOffset = offset;
+        }
+
+        /** Skip data. Advances the stream without reading.
+            \param[in] count Bytes to skip
+        */
+        void skip(uint64_t count)
+        {
+            seek(mOffset + count);
+        }
+
+        /** Calculates amount of remaining data in the file.
+            \return Number of bytes remaining in the stream
+        */
+        uint64_t getRemainingStreamSize() const { return mSize - mOffset; }
+
+        /** Checks for validity of the stream
+            \return Returns true if no errors have been encountered and the end of the stream has not been reached
+        */
+        bool isGood() const { return !mFail && !isEof(); }
+
+        /** Checks for stream errors.
+            \return Returns true if the file couldn't be mapped or a read went past the end of the file.
+        */
+        bool isFail() const { return mFail; }
+
+        /** Checks if the end of file has been reached.
+            \return Returns true if stream has reached the end of the file
+        */
+        bool isEof() const { return mOffset >= mSize; }
+
+        /** Get a pointer to the start of the mapping
+        */
+        const uint8_t* getData() const { return mpData; }
+
+        /** Get a pointer to the current read position
+        */
+        const uint8_t* getCurrentPtr() const { return mpData + mOffset; }
+
+        /** Copy data from the file stream. Reads past the end of the file fill the destination with zeros and set the fail bit.
+            \param[out] pData Pointer to a buffer to copy data into
+            \param[in] count Number of bytes to read
+        */
+        MappedFileStream& read(void* pData, uint64_t count)
+        {
+            const void* pSrc = acquire(count);
+            if (pSrc) std::memcpy(pData, pSrc, (size_t)count);
+            else std::memset(pData, 0, (size_t)count);
+            return *this;
+        }
+
+        /** Get a view of an array of elements in the file and advance the stream past them. No data is copied.
+            \param[in] count Number of elements
+            \return A span pointing into the mapping. If the array extends past the end of the file, returns an empty span and sets the fail bit.
+        */
+        template<typename T>
+        ConstSpan<T> readSpan(uint64_t count)
+        {
+            const T* pData = (const T*)acquire(count * sizeof(T));
+            return pData ? ConstSpan<T>(pData, (size_t)count) : ConstSpan<T>();
+        }
+
+        /** Extracts a single value from the stream
+            \param[out] val Reference of value to extract into
+        */
+        template<typename T>
+        MappedFileStream& operator>>(T& val) { return read(&val, sizeof(T)); }
+
+    private:
+        const void* acquire(uint64_t count)
+        {
+            if (mFail || count > getRemainingStreamSize())
+            {
+                mFail = true;
+                return nullptr;
+            }
+            const void* pData = mpData + mOffset;
+            mOffset += count;
+            return pData;
+        }
+
+        const uint8_t* mpData = nullptr;
+        uint64_t mSize = 0;
+        uint64_t mOffset = 0;
+        bool mFail = false;
+        std::string mFilename;
+    };
+}
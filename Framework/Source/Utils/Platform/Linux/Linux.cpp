@@ -34,6 +34,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ptrace.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <gtk/gtk.h>
 #include <fstream>
 #include <fcntl.h>
@@ -379,6 +381,46 @@ namespace Falcor
         return s.st_mtime;
     }
 
+    const void* mapFileForReading(const std::string& fullpath, uint64_t& size)
+    {
+        size = 0;
+        int fd = open(fullpath.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            logError("Can't open file '" + fullpath + "' for mapping");
+            return nullptr;
+        }
+
+        struct stat s;
+        if (fstat(fd, &s) != 0 || s.st_size == 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        void* pData = mmap(nullptr, (size_t)s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping holds its own reference to the file
+        close(fd);
+        if (pData == MAP_FAILED)
+        {
+            logError("mapFileForReading() - mmap() failed for '" + fullpath + "' with error code " + std::to_string(errno));
+            return nullptr;
+        }
+
+        // Most readers walk the file front to back
+        madvise(pData, (size_t)s.st_size, MADV_SEQUENTIAL);
+        size = (uint64_t)s.st_size;
+        return pData;
+    }
+
+    void unmapFile(const void* pData, uint64_t size)
+    {
+        if (pData)
+        {
+            munmap(const_cast<void*>(pData), (size_t)size);
+        }
+    }
+
     uint32_t bitScanReverse(uint32_t a)
     {
         // __builtin_clz counts 0's from the MSB, convert to index from the LSB
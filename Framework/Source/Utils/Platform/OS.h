@@ -223,6 +223,19 @@ namespace Falcor
     */
     time_t getFileModifiedTime(const std::string& filename);
 
+    /** Map a file into memory for read-only access. The function expects a full path to the file, and will not look in the common directories.
+        \param[in] fullpath The file to map
+        \param[out] size The size of the file in bytes
+        \return Pointer to the start of the mapped file, or nullptr if the file couldn't be mapped. The mapping must be released with unmapFile()
+    */
+    const void* mapFileForReading(const std::string& fullpath, uint64_t& size);
+
+    /** Release a mapping created by mapFileForReading()
+        \param[in] pData The pointer returned by mapFileForReading()
+        \param[in] size The size of the mapping
+    */
+    void unmapFile(const void* pData, uint64_t size);
+
     enum class ThreadPriorityType : int32_t
     {
         BackgroundBegin     = -2,   //< Indicates I/O-intense thread
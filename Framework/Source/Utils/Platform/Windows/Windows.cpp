@@ -303,6 +303,48 @@ namespace Falcor
         return s.st_mtime;
     }
 
+    const void* mapFileForReading(const std::string& fullpath, uint64_t& size)
+    {
+        size = 0;
+        HANDLE hFile = CreateFileA(fullpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            logError("Can't open file '" + fullpath + "' for mapping");
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(hFile, &fileSize) == FALSE || fileSize.QuadPart == 0)
+        {
+            CloseHandle(hFile);
+            return nullptr;
+        }
+
+        HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* pData = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        // The view holds its own references to the mapping and the file
+        if (hMapping) CloseHandle(hMapping);
+        CloseHandle(hFile);
+
+        if (pData == nullptr)
+        {
+            logError("mapFileForReading() - MapViewOfFile() failed for '" + fullpath + "' with error code " + std::to_string(GetLastError()));
+            return nullptr;
+        }
+
+        size = (uint64_t)fileSize.QuadPart;
+        return pData;
+    }
+
+    void unmapFile(const void* pData, uint64_t size)
+    {
+        if (pData)
+        {
+            UnmapViewOfFile(pData);
+        }
+    }
+
     uint64_t getTotalVirtualMemory()
     {
         MEMORYSTATUSEX memInfo;
@@ -28,7 +28,7 @@
 #include "Framework.h"
 #include "Profiler.h"
 #include "API/GpuTimer.h"
-#include "API/LowLevel/FencedPool.h"
+#include "API/LowLevel/FencedRecycler.h"
 
 #include <iostream>
 #include <fstream>
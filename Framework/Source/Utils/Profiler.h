@@ -32,6 +32,7 @@
 #include <vector>
 #include "API/GpuTimer.h"
 #include "Utils/CpuTimer.h"
+#include "Utils/CpuProfiler.h"
 #include "FalcorConfig.h"
 #include <stack>
 
@@ -174,7 +175,7 @@ namespace Falcor
     };
 
 #if _PROFILING_ENABLED
-#define PROFILE(_name) static const Falcor::HashedString hashed ## _name(#_name); Falcor::ProfilerEvent _profileEvent(hashed ## _name);
+#define PROFILE(_name) static const Falcor::HashedString hashed ## _name(#_name); Falcor::ProfilerEvent _profileEvent(hashed ## _name); PROFILE_CPU(_name)
 #else
 #define PROFILE(_name)
 #endif
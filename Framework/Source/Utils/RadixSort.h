@@ -0,0 +1,90 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Stable LSD radix sort of 64-bit keys, carrying a value along with each key.
+        Sorts 8 bits per pass and skips passes where all the keys share the same digit, so sorting keys which only use a few of their bits is cheap.
+        \param[in,out] keys The keys to sort
+        \param[in,out] values The values to reorder together with the keys. Must have the same size as keys.
+        \param[in] tempKeys Scratch storage. Pass the same vector every time to avoid reallocating it.
+        \param[in] tempValues Scratch storage. Pass the same vector every time to avoid reallocating it.
+    */
+    template<typename ValueType>
+    void radixSort(std::vector<uint64_t>& keys, std::vector<ValueType>& values, std::vector<uint64_t>& tempKeys, std::vector<ValueType>& tempValues)
+    {
+        const size_t count = keys.size();
+        assert(values.size() == count);
+        if (count < 2) return;
+
+        // Build the histograms for all the digits in a single pass over the keys
+        const uint32_t kDigitCount = sizeof(uint64_t);
+        const uint32_t kBucketCount = 256;
+        std::vector<size_t> histograms(kDigitCount * kBucketCount, 0);
+        for (uint64_t key : keys)
+        {
+            for (uint32_t digit = 0; digit < kDigitCount; digit++)
+            {
+                histograms[digit * kBucketCount + ((key >> (digit * 8)) & 0xff)]++;
+            }
+        }
+
+        tempKeys.resize(count);
+        tempValues.resize(count);
+        for (uint32_t digit = 0; digit < kDigitCount; digit++)
+        {
+            size_t* pHistogram = histograms.data() + digit * kBucketCount;
+            const uint32_t shift = digit * 8;
+
+            // All keys fall into the same bucket, this pass wouldn't change the order
+            if (pHistogram[(keys[0] >> shift) & 0xff] == count) continue;
+
+            // Convert the counts into offsets
+            size_t offset = 0;
+            for (uint32_t bucket = 0; bucket < kBucketCount; bucket++)
+            {
+                size_t bucketSize = pHistogram[bucket];
+                pHistogram[bucket] = offset;
+                offset += bucketSize;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                size_t dst = pHistogram[(keys[i] >> shift) & 0xff]++;
+                tempKeys[dst] = keys[i];
+                tempValues[dst] = values[i];
+            }
+            keys.swap(tempKeys);
+            values.swap(tempValues);
+        }
+    }
+}
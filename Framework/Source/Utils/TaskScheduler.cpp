@@ -0,0 +1,388 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TaskScheduler.h"
+#include "CpuProfiler.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        struct ThreadRegistration
+        {
+            const TaskScheduler* pScheduler = nullptr;
+            uint32_t index = TaskScheduler::kInvalidThreadIndex;
+        };
+
+        thread_local ThreadRegistration tlsRegistration;
+
+        TaskScheduler::SharedPtr gpScheduler;
+    }
+
+    void TaskScheduler::WorkQueue::push(TaskEntry&& entry)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(entry));
+    }
+
+    bool TaskScheduler::WorkQueue::popBack(TaskEntry& entry)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) return false;
+        entry = std::move(tasks.back());
+        tasks.pop_back();
+        return true;
+    }
+
+    bool TaskScheduler::WorkQueue::popFront(TaskEntry& entry)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) return false;
+        entry = std::move(tasks.front());
+        tasks.pop_front();
+        return true;
+    }
+
+    bool TaskScheduler::WorkQueue::empty()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tasks.empty();
+    }
+
+    TaskScheduler::SharedPtr TaskScheduler::create(uint32_t workerCount)
+    {
+        if (workerCount == kDefaultWorkerCount)
+        {
+            uint32_t hwThreads = std::thread::hardware_concurrency();
+            workerCount = (hwThreads > 1) ? hwThreads - 1 : 1;
+        }
+        return SharedPtr(new TaskScheduler(workerCount));
+    }
+
+    void TaskScheduler::init(uint32_t workerCount)
+    {
+        if (gpScheduler)
+        {
+            logWarning("TaskScheduler::init() was called more than once. Ignoring the call.");
+            return;
+        }
+        gpScheduler = create(workerCount);
+    }
+
+    void TaskScheduler::shutdown()
+    {
+        if (gpScheduler == nullptr) return;
+
+        // Tasks which are still running may call get(), so the global pointer has to stay valid until the workers exited
+        gpScheduler->stop();
+        gpScheduler = nullptr;
+    }
+
+    TaskScheduler* TaskScheduler::get()
+    {
+        if (gpScheduler == nullptr)
+        {
+            logError("TaskScheduler::get() was called before TaskScheduler::init(). The calling thread becomes the scheduler's main thread.");
+            init();
+        }
+        return gpScheduler.get();
+    }
+
+    TaskScheduler::TaskScheduler(uint32_t workerCount)
+    {
+        // The creating thread is the main thread
+        tlsRegistration.pScheduler = this;
+        tlsRegistration.index = 0;
+        CpuProfiler::setThreadName("Main");
+
+        mQueues.resize(workerCount + 1);
+        for (auto& pQueue : mQueues)
+        {
+            pQueue = std::make_unique<WorkQueue>();
+        }
+
+        mWorkers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            mWorkers.push_back(std::thread(&TaskScheduler::workerLoop, this, i + 1));
+        }
+    }
+
+    TaskScheduler::~TaskScheduler()
+    {
+        stop();
+
+        if (tlsRegistration.pScheduler == this)
+        {
+            tlsRegistration = ThreadRegistration();
+        }
+    }
+
+    void TaskScheduler::stop()
+    {
+        // Workers drain the queues before exiting, so no submitted task is lost
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mShutdown = true;
+        }
+        mWakeCondition.notify_all();
+
+        for (auto& t : mWorkers)
+        {
+            if (t.joinable()) t.join();
+        }
+        mWorkers.clear();
+
+        // Anything left was queued for the main thread
+        TaskEntry entry;
+        while (mMainThreadQueue.popFront(entry))
+        {
+            execute(entry);
+        }
+    }
+
+    uint32_t TaskScheduler::getCurrentThreadIndex() const
+    {
+        return (tlsRegistration.pScheduler == this) ? tlsRegistration.index : kInvalidThreadIndex;
+    }
+
+    void TaskScheduler::enqueue(WorkQueue& queue, TaskEntry&& entry)
+    {
+        if (entry.pGroup)
+        {
+            entry.pGroup->mPendingTasks.fetch_add(1, std::memory_order_relaxed);
+        }
+        queue.push(std::move(entry));
+    }
+
+    void TaskScheduler::run(Task task, TaskGroup* pGroup)
+    {
+        TaskEntry entry;
+        entry.task = std::move(task);
+        entry.pGroup = pGroup;
+
+        // Count the task before it becomes visible. Otherwise a thread could pop it and decrement the counter first, wrapping it around.
+        uint32_t index = getCurrentThreadIndex();
+        mQueuedTasks.fetch_add(1, std::memory_order_release);
+        enqueue((index == kInvalidThreadIndex) ? mExternalQueue : *mQueues[index], std::move(entry));
+
+        // Taking the lock guarantees that a thread which is about to sleep either sees the new task or receives the notification
+        bool hasWaiters;
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            hasWaiters = (mWaitingThreads > 0);
+        }
+        mWakeCondition.notify_one();
+        if (hasWaiters) mWaitCondition.notify_all();
+    }
+
+    void TaskScheduler::runOnMainThread(Task task, TaskGroup* pGroup)
+    {
+        TaskEntry entry;
+        entry.task = std::move(task);
+        entry.pGroup = pGroup;
+        enqueue(mMainThreadQueue, std::move(entry));
+        notifyWaiters();
+    }
+
+    void TaskScheduler::notifyWaiters()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            if (mWaitingThreads == 0) return;
+        }
+        mWaitCondition.notify_all();
+    }
+
+    bool TaskScheduler::findTask(uint32_t threadIndex, TaskEntry& entry)
+    {
+        // Main-thread tasks first, they usually unblock other work
+        if (threadIndex == 0 && mMainThreadQueue.popFront(entry)) return true;
+
+        // Our own queue, newest first
+        if (threadIndex != kInvalidThreadIndex && mQueues[threadIndex]->popBack(entry))
+        {
+            mQueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        if (mExternalQueue.popFront(entry))
+        {
+            mQueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Steal the oldest task from someone else, starting at a pseudo-random victim to spread the contention
+        uint32_t queueCount = (uint32_t)mQueues.size();
+        uint32_t start = mStealSeed.fetch_add(1, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < queueCount; i++)
+        {
+            uint32_t victim = (start + i) % queueCount;
+            if (victim == threadIndex) continue;
+            if (mQueues[victim]->popFront(entry))
+            {
+                mQueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TaskScheduler::execute(TaskEntry& entry)
+    {
+        // The group has to be updated even if the task throws, otherwise wait() never returns
+        try
+        {
+            entry.task();
+        }
+        catch (...)
+        {
+            if (entry.pGroup)
+            {
+                std::lock_guard<std::mutex> lock(entry.pGroup->mExceptionMutex);
+                if (entry.pGroup->mpException == nullptr) entry.pGroup->mpException = std::current_exception();
+            }
+            else
+            {
+                // Nobody waits on the task. Letting the exception escape a worker would terminate the application.
+                logError("TaskScheduler: a task without a group threw an exception. The exception is ignored.");
+            }
+        }
+        entry.task = nullptr;
+
+        // The group can be destroyed as soon as its last task finished, so it must not be touched after the decrement
+        if (entry.pGroup && entry.pGroup->mPendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            notifyWaiters();
+        }
+    }
+
+    void TaskScheduler::workerLoop(uint32_t threadIndex)
+    {
+        tlsRegistration.pScheduler = this;
+        tlsRegistration.index = threadIndex;
+        CpuProfiler::setThreadName("Worker " + std::to_string(threadIndex));
+
+        TaskEntry entry;
+        while (true)
+        {
+            if (findTask(threadIndex, entry))
+            {
+                execute(entry);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+            mWakeCondition.wait(lock, [this]() { return mShutdown || mQueuedTasks.load(std::memory_order_acquire) > 0; });
+            if (mShutdown && mQueuedTasks.load(std::memory_order_acquire) == 0) break;
+        }
+    }
+
+    void TaskScheduler::wait(TaskGroup& group)
+    {
+        uint32_t threadIndex = getCurrentThreadIndex();
+        TaskEntry entry;
+        while (group.isDone() == false)
+        {
+            if (findTask(threadIndex, entry))
+            {
+                execute(entry);
+                continue;
+            }
+
+            // Nothing to help with, the group's remaining tasks are running on other threads. Sleep until the group finishes or new work is queued.
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+            mWaitingThreads++;
+            mWaitCondition.wait(lock, [&]()
+            {
+                return group.isDone() || mQueuedTasks.load(std::memory_order_acquire) > 0 || (threadIndex == 0 && mMainThreadQueue.empty() == false);
+            });
+            mWaitingThreads--;
+        }
+
+        // All the tasks finished, nobody else accesses the exception. Reset it so the group can be reused.
+        std::exception_ptr pException = nullptr;
+        std::swap(pException, group.mpException);
+        if (pException) std::rethrow_exception(pException);
+    }
+
+    void TaskScheduler::runPendingTasks()
+    {
+        uint32_t threadIndex = getCurrentThreadIndex();
+        TaskEntry entry;
+        while (findTask(threadIndex, entry))
+        {
+            execute(entry);
+        }
+    }
+
+    bool TaskScheduler::runOneTask()
+    {
+        TaskEntry entry;
+        if (findTask(getCurrentThreadIndex(), entry) == false) return false;
+        execute(entry);
+        return true;
+    }
+
+    void TaskScheduler::parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& func, size_t grainSize)
+    {
+        if (begin >= end) return;
+        size_t count = end - begin;
+        if (grainSize == 0)
+        {
+            // Aim for a few chunks per thread so that stealing can balance uneven chunks
+            grainSize = std::max<size_t>(1, count / (getThreadCount() * 4));
+        }
+
+        if (count <= grainSize)
+        {
+            func(begin, end);
+            return;
+        }
+
+        TaskGroup group;
+        for (size_t chunkBegin = begin + grainSize; chunkBegin < end; chunkBegin += grainSize)
+        {
+            size_t chunkEnd = std::min(chunkBegin + grainSize, end);
+            run([&func, chunkBegin, chunkEnd]() { func(chunkBegin, chunkEnd); }, &group);
+        }
+
+        // Execute the first chunk on the calling thread. The other chunks reference func and the group, so wait for them before propagating an exception.
+        std::exception_ptr pException = nullptr;
+        try
+        {
+            func(begin, begin + grainSize);
+        }
+        catch (...)
+        {
+            pException = std::current_exception();
+        }
+        wait(group);
+        if (pException) std::rethrow_exception(pException);
+    }
+}
@@ -0,0 +1,211 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+    /** Work-stealing task scheduler.
+        Every worker thread owns a deque of tasks. Tasks spawned from a worker are pushed to and popped from the back of its own deque, idle workers steal from the front of other workers' deques.
+        The thread that creates the scheduler is registered as the main thread and participates in execution whenever it waits on a task group. The global scheduler is created by init(), which Sample calls on the main thread during startup. Tasks that must run on the main thread (for example, tasks that touch the device) can be queued with runOnMainThread().
+    */
+    class TaskScheduler
+    {
+    public:
+        using SharedPtr = std::shared_ptr<TaskScheduler>;
+        using Task = std::function<void()>;
+
+        static const uint32_t kDefaultWorkerCount = uint32_t(-1);
+        static const uint32_t kInvalidThreadIndex = uint32_t(-1);
+
+        /** A group of tasks which can be waited on.
+            The group must outlive all tasks submitted into it. Call TaskScheduler#wait() before destroying it.
+            If a task throws, the first exception is stored in the group and rethrown by TaskScheduler#wait(). The remaining tasks still execute.
+        */
+        class TaskGroup
+        {
+        public:
+            TaskGroup() = default;
+            TaskGroup(const TaskGroup&) = delete;
+            TaskGroup& operator=(const TaskGroup&) = delete;
+
+            /** Check if all the tasks in the group finished executing
+            */
+            bool isDone() const { return mPendingTasks.load(std::memory_order_acquire) == 0; }
+        private:
+            friend class TaskScheduler;
+            std::atomic<uint32_t> mPendingTasks{ 0 };
+            std::mutex mExceptionMutex;
+            std::exception_ptr mpException;
+        };
+
+        /** Create a new scheduler. The calling thread becomes the scheduler's main thread.
+            \param[in] workerCount Number of background worker threads. kDefaultWorkerCount creates one worker per hardware thread, minus one for the main thread.
+        */
+        static SharedPtr create(uint32_t workerCount = kDefaultWorkerCount);
+
+        /** Create the global scheduler. The calling thread becomes its main thread, so this must be called from the application's main thread before any other thread uses the scheduler.
+            \param[in] workerCount Number of background worker threads. See create().
+        */
+        static void init(uint32_t workerCount = kDefaultWorkerCount);
+
+        /** Destroy the global scheduler. Waits for all the queued tasks to finish, including the ones queued for the main thread.
+        */
+        static void shutdown();
+
+        /** Get the global scheduler. init() has to be called first.
+        */
+        static TaskScheduler* get();
+
+        ~TaskScheduler();
+
+        /** Submit a task.
+            \param[in] task The task to execute
+            \param[in] pGroup Optional group to add the task into
+        */
+        void run(Task task, TaskGroup* pGroup = nullptr);
+
+        /** Submit a task and get a future for its result
+        */
+        template<typename Func>
+        auto async(Func&& func) -> std::future<decltype(func())>
+        {
+            using ResultType = decltype(func());
+            auto pTask = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+            std::future<ResultType> result = pTask->get_future();
+            run([pTask]() { (*pTask)(); });
+            return result;
+        }
+
+        /** Queue a task which will only be executed by the main thread. It will run the next time the main thread waits on a group or calls runPendingTasks().
+            \param[in] task The task to execute
+            \param[in] pGroup Optional group to add the task into
+        */
+        void runOnMainThread(Task task, TaskGroup* pGroup = nullptr);
+
+        /** Wait for all the tasks in a group to finish. The calling thread executes pending tasks while waiting, and sleeps when the only remaining tasks are running on other threads.
+            If any of the group's tasks threw, the first exception is rethrown once all the tasks finished.
+        */
+        void wait(TaskGroup& group);
+
+        /** Wait for a future to become ready. The calling thread executes pending tasks while waiting.
+        */
+        template<typename FutureType>
+        void waitForFuture(const FutureType& future)
+        {
+            while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                if (runOneTask() == false) std::this_thread::yield();
+            }
+        }
+
+        /** Execute a single pending task on the calling thread.
+            \return false if there was no task available to the calling thread
+        */
+        bool runOneTask();
+
+        /** Execute tasks on the calling thread until there is no more work available to it. On the main thread this includes the main-thread queue.
+        */
+        void runPendingTasks();
+
+        /** Split the range [begin, end) into chunks and execute them in parallel. Returns once all chunks were executed.
+            If a chunk throws, the first exception is rethrown after all the chunks finished.
+            \param[in] begin First index in the range
+            \param[in] end One past the last index in the range
+            \param[in] func Called with the [chunkBegin, chunkEnd) range of each chunk
+            \param[in] grainSize Number of elements per chunk. 0 will select a size based on the number of threads
+        */
+        void parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& func, size_t grainSize = 0);
+
+        /** Get the number of background worker threads
+        */
+        uint32_t getWorkerCount() const { return (uint32_t)mWorkers.size(); }
+
+        /** Get the total number of threads executing tasks, including the main thread
+        */
+        uint32_t getThreadCount() const { return getWorkerCount() + 1; }
+
+        /** Get the index of the calling thread within this scheduler. 0 is the main thread, workers are 1-based. Returns kInvalidThreadIndex for threads which don't belong to the scheduler.
+        */
+        uint32_t getCurrentThreadIndex() const;
+
+        /** Check if the calling thread is the scheduler's main thread
+        */
+        bool isMainThread() const { return getCurrentThreadIndex() == 0; }
+
+    private:
+        TaskScheduler(uint32_t workerCount);
+
+        struct TaskEntry
+        {
+            Task task;
+            TaskGroup* pGroup = nullptr;
+        };
+
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<TaskEntry> tasks;
+
+            void push(TaskEntry&& entry);
+            bool popBack(TaskEntry& entry);
+            bool popFront(TaskEntry& entry);
+            bool empty();
+        };
+
+        void stop();
+        void workerLoop(uint32_t threadIndex);
+        bool findTask(uint32_t threadIndex, TaskEntry& entry);
+        void execute(TaskEntry& entry);
+        void enqueue(WorkQueue& queue, TaskEntry&& entry);
+        void notifyWaiters();
+
+        std::vector<std::thread> mWorkers;
+        std::vector<std::unique_ptr<WorkQueue>> mQueues;    // One per thread. Index 0 belongs to the main thread
+        WorkQueue mExternalQueue;                           // Tasks submitted from threads which don't belong to the scheduler
+        WorkQueue mMainThreadQueue;                         // Tasks which can only be executed by the main thread
+
+        std::mutex mSleepMutex;
+        std::condition_variable mWakeCondition;            // Signaled when tasks are queued, workers sleep on it
+        std::condition_variable mWaitCondition;            // Signaled when tasks are queued or a group finishes, threads blocked in wait() sleep on it
+        uint32_t mWaitingThreads = 0;                       // Number of threads sleeping in wait(). Protected by mSleepMutex
+        std::atomic<uint32_t> mQueuedTasks{ 0 };
+        std::atomic<uint32_t> mStealSeed{ 0 };
+        bool mShutdown = false;
+    };
+}
@@ -0,0 +1,211 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "BindlessMaterials.h"
+
+static const char* kDefaultScene = "Scenes/DragonPlane.fscene";
+static const char* kBindlessDefine = "_MS_BINDLESS_MATERIALS";
+
+void BindlessMaterials::Renderer::setPrograms(const GraphicsProgram::SharedPtr& pBindlessProgram, const GraphicsVars::SharedPtr& pBindlessVars, const GraphicsProgram::SharedPtr& pProgram, const GraphicsVars::SharedPtr& pVars)
+{
+    mpBindlessProgram = pBindlessProgram;
+    mpBindlessVars = pBindlessVars;
+    mpProgram = pProgram;
+    mpVars = pVars;
+}
+
+void BindlessMaterials::Renderer::setPerFrameData(const CurrentWorkingData& currentData)
+{
+    // Either vars can be active during the pass, so both need the camera and the lights
+    CurrentWorkingData data = currentData;
+    for (GraphicsVars* pVars : { mpBindlessVars.get(), mpVars.get() })
+    {
+        data.pVars = pVars;
+        SceneRenderer::setPerFrameData(data);
+    }
+}
+
+bool BindlessMaterials::Renderer::setPerModelData(const CurrentWorkingData& currentData)
+{
+    if (mAlternatePrograms == false)
+    {
+        return SceneRenderer::setPerModelData(currentData);
+    }
+
+    // Replace the vars in the middle of the pass. The renderer picks up the new vars after the hook returns, the base implementation needs them now.
+    bool bindless = (currentData.modelID % 2) == 0;
+    GraphicsVars* pVars = bindless ? mpBindlessVars.get() : mpVars.get();
+    currentData.pState->setProgram(bindless ? mpBindlessProgram : mpProgram);
+    currentData.pContext->setGraphicsVars(bindless ? mpBindlessVars : mpVars);
+
+    CurrentWorkingData data = currentData;
+    data.pVars = pVars;
+    return SceneRenderer::setPerModelData(data);
+}
+
+void BindlessMaterials::onGuiRender()
+{
+    if (mpGui->addButton("Load Scene"))
+    {
+        loadScene();
+    }
+
+    if (mpRenderer)
+    {
+        if (mpGui->addCheckBox("Bindless Materials", mBindless))
+        {
+            updateRendererState();
+        }
+        if (mBindless && mpGui->addCheckBox("Alternate Programs Per Model", mAlternatePrograms))
+        {
+            updateRendererState();
+        }
+
+        const SceneRenderer::DrawStats& stats = mpRenderer->getDrawStats();
+        std::string text = "Draw calls: " + std::to_string(stats.drawCalls) + "\n";
+        text += "Mesh instances: " + std::to_string(stats.meshInstances) + "\n";
+        text += "Material binds: " + std::to_string(stats.materialChanges) + "\n";
+        text += "Program changes: " + std::to_string(stats.programChanges) + "\n";
+        const MaterialTable::SharedPtr& pTable = mpRenderer->getMaterialTable();
+        if (pTable)
+        {
+            text += "Table: " + std::to_string(pTable->getMaterialCount()) + " materials, " + std::to_string(pTable->getTextureCount()) + " textures, " + std::to_string(pTable->getSamplerCount()) + " samplers\n";
+        }
+        mpGui->addText(text.c_str());
+    }
+}
+
+void BindlessMaterials::createPrograms()
+{
+    // The same shader compiled both ways. The define selects the material source in the vertex and the pixel shader.
+    mpBindlessProgram = GraphicsProgram::createFromFile("", "BindlessMaterials.ps.slang");
+    mpBindlessProgram->addDefine(kBindlessDefine);
+    mpBindlessVars = GraphicsVars::create(mpBindlessProgram->getActiveVersion()->getReflector());
+
+    mpProgram = GraphicsProgram::createFromFile("", "BindlessMaterials.ps.slang");
+    mpVars = GraphicsVars::create(mpProgram->getActiveVersion()->getReflector());
+}
+
+void BindlessMaterials::updateRendererState()
+{
+    // The bindless program only works with the table, so only alternate while it's enabled
+    mpRenderer->setBindlessMaterialState(mBindless);
+    mpRenderer->setAlternatePrograms(mBindless && mAlternatePrograms);
+}
+
+void BindlessMaterials::loadScene()
+{
+    std::string filename;
+    if (openFileDialog(Scene::kFileFormatString, filename))
+    {
+        loadScene(filename);
+    }
+}
+
+void BindlessMaterials::loadScene(const std::string& filename)
+{
+    mpScene = Scene::loadFromFile(filename);
+    if (mpScene == nullptr)
+    {
+        mpRenderer = nullptr;
+        return;
+    }
+
+    for (uint32_t m = 0; m < mpScene->getModelCount(); m++)
+    {
+        mpScene->getModel(m)->bindSamplerToMaterials(mpSampler);
+    }
+
+    mpRenderer = Renderer::create(mpScene);
+    mpRenderer->setPrograms(mpBindlessProgram, mpBindlessVars, mpProgram, mpVars);
+    updateRendererState();
+}
+
+void BindlessMaterials::onLoad()
+{
+    Sampler::Desc samplerDesc;
+    samplerDesc.setFilterMode(Sampler::Filter::Linear, Sampler::Filter::Linear, Sampler::Filter::Linear);
+    mpSampler = Sampler::create(samplerDesc);
+
+    createPrograms();
+    loadScene(kDefaultScene);
+}
+
+void BindlessMaterials::onFrameRender()
+{
+    const glm::vec4 clearColor(0.38f, 0.52f, 0.10f, 1);
+    mpRenderContext->clearFbo(mpDefaultFBO.get(), clearColor, 1.0f, 0, FboAttachmentType::All);
+
+    if (mpRenderer)
+    {
+        mpDefaultPipelineState->setBlendState(nullptr);
+        mpDefaultPipelineState->setDepthStencilState(nullptr);
+        mpDefaultPipelineState->setProgram(mBindless ? mpBindlessProgram : mpProgram);
+        mpRenderContext->setGraphicsVars(mBindless ? mpBindlessVars : mpVars);
+
+        mpRenderer->update(mCurrentTime);
+        mpRenderer->renderScene(mpRenderContext.get());
+    }
+}
+
+void BindlessMaterials::onShutdown()
+{
+    mpRenderer = nullptr;
+    mpScene = nullptr;
+}
+
+bool BindlessMaterials::onKeyEvent(const KeyboardEvent& keyEvent)
+{
+    return mpRenderer ? mpRenderer->onKeyEvent(keyEvent) : false;
+}
+
+bool BindlessMaterials::onMouseEvent(const MouseEvent& mouseEvent)
+{
+    return mpRenderer ? mpRenderer->onMouseEvent(mouseEvent) : false;
+}
+
+void BindlessMaterials::onResizeSwapChain()
+{
+    if (mpScene)
+    {
+        float aspectRatio = (float)mpDefaultFBO->getWidth() / (float)mpDefaultFBO->getHeight();
+        for (uint32_t i = 0; i < mpScene->getCameraCount(); i++)
+        {
+            mpScene->getCamera(i)->setAspectRatio(aspectRatio);
+        }
+    }
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    BindlessMaterials sample;
+    SampleConfig config;
+    config.windowDesc.title = "Bindless Materials";
+    config.windowDesc.resizableWindow = true;
+    sample.run(config);
+    return 0;
+}
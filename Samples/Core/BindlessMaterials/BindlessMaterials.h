@@ -0,0 +1,86 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+
+using namespace Falcor;
+
+/** Renders a scene through the SceneRenderer's bindless material path.
+    The models can alternate between a program which fetches its materials from the MaterialTable and one which binds them one by one, which switches the vars in the middle of the pass.
+*/
+class BindlessMaterials : public Sample
+{
+public:
+    void onLoad() override;
+    void onFrameRender() override;
+    void onShutdown() override;
+    void onResizeSwapChain() override;
+    bool onKeyEvent(const KeyboardEvent& keyEvent) override;
+    bool onMouseEvent(const MouseEvent& mouseEvent) override;
+    void onGuiRender() override;
+
+private:
+    /** Scene renderer which can select the program of every model. When alternating, even models use the bindless program and odd ones the regular program.
+    */
+    class Renderer : public SceneRenderer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<Renderer>;
+        static SharedPtr create(const Scene::SharedPtr& pScene) { return SharedPtr(new Renderer(pScene)); }
+
+        void setPrograms(const GraphicsProgram::SharedPtr& pBindlessProgram, const GraphicsVars::SharedPtr& pBindlessVars, const GraphicsProgram::SharedPtr& pProgram, const GraphicsVars::SharedPtr& pVars);
+        void setAlternatePrograms(bool alternate) { mAlternatePrograms = alternate; }
+
+    private:
+        Renderer(const Scene::SharedPtr& pScene) : SceneRenderer(pScene) {}
+        void setPerFrameData(const CurrentWorkingData& currentData) override;
+        bool setPerModelData(const CurrentWorkingData& currentData) override;
+
+        GraphicsProgram::SharedPtr mpBindlessProgram;
+        GraphicsVars::SharedPtr mpBindlessVars;
+        GraphicsProgram::SharedPtr mpProgram;
+        GraphicsVars::SharedPtr mpVars;
+        bool mAlternatePrograms = false;
+    };
+
+    void loadScene();
+    void loadScene(const std::string& filename);
+    void createPrograms();
+    void updateRendererState();
+
+    Scene::SharedPtr mpScene;
+    Renderer::SharedPtr mpRenderer;
+    GraphicsProgram::SharedPtr mpBindlessProgram;
+    GraphicsVars::SharedPtr mpBindlessVars;
+    GraphicsProgram::SharedPtr mpProgram;
+    GraphicsVars::SharedPtr mpVars;
+    Sampler::SharedPtr mpSampler;
+
+    bool mBindless = true;
+    bool mAlternatePrograms = false;
+};
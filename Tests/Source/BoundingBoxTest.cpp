@@ -0,0 +1,170 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "BoundingBoxTest.h"
+
+static const uint32_t kBoxCount = 100003; // Not a multiple of the SIMD width, so the scalar tail is tested too
+static const uint32_t kBenchmarkIterations = 50;
+
+void BoundingBoxTest::addTests()
+{
+    addTestToList<TestTransform>();
+    addTestToList<TestCull>();
+    addTestToList<TestCullPerformance>();
+}
+
+testing_func(BoundingBoxTest, TestTransform)
+{
+    std::vector<BoundingBox> boxes;
+    BoundingBoxArray boxArray;
+    generateBoxes(kBoxCount, boxes, boxArray);
+
+    glm::mat4 mat = glm::translate(glm::mat4(), glm::vec3(3.0f, -2.0f, 1.0f)) * glm::rotate(glm::mat4(), 0.7f, glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f))) * glm::scale(glm::mat4(), glm::vec3(2.0f, 0.5f, 1.5f));
+    BoundingBoxArray transformed;
+    boxArray.transform(mat, transformed);
+
+    for (uint32_t i = 0; i < kBoxCount; i++)
+    {
+        BoundingBox expected = boxes[i].transform(mat);
+        BoundingBox result = transformed.get(i);
+        glm::vec3 centerDiff = glm::abs(expected.center - result.center);
+        glm::vec3 extentDiff = glm::abs(expected.extent - result.extent);
+        const float epsilon = 1e-3f;
+        if (glm::any(glm::greaterThan(centerDiff, glm::vec3(epsilon))) || glm::any(glm::greaterThan(extentDiff, glm::vec3(epsilon))))
+        {
+            return test_fail("Batch transform doesn't match BoundingBox::transform() for box " + std::to_string(i));
+        }
+    }
+
+    return test_pass();
+}
+
+testing_func(BoundingBoxTest, TestCull)
+{
+    std::vector<BoundingBox> boxes;
+    BoundingBoxArray boxArray;
+    generateBoxes(kBoxCount, boxes, boxArray);
+    Camera::SharedPtr pCamera = createCamera();
+
+    std::vector<uint32_t> visibleIndices;
+    pCamera->cullBoundingBoxes(boxArray, visibleIndices);
+
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < kBoxCount; i++)
+    {
+        if (pCamera->isObjectCulled(boxes[i]) == false) expected.push_back(i);
+    }
+
+    if (expected.empty() || expected.size() == kBoxCount)
+    {
+        return test_fail("Test camera should cull some, but not all, of the boxes");
+    }
+
+    if (visibleIndices != expected)
+    {
+        return test_fail("Batch culling doesn't match Camera::isObjectCulled()");
+    }
+
+    return test_pass();
+}
+
+testing_func(BoundingBoxTest, TestCullPerformance)
+{
+    std::vector<BoundingBox> boxes;
+    BoundingBoxArray boxArray;
+    generateBoxes(kBoxCount, boxes, boxArray);
+    Camera::SharedPtr pCamera = createCamera();
+    glm::mat4 mat = glm::translate(glm::mat4(), glm::vec3(0.5f, 0.0f, -0.5f));
+
+    // Per-box path, the way the scene renderer used to transform and test each mesh instance
+    std::vector<uint32_t> visibleIndices;
+    visibleIndices.reserve(kBoxCount);
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    for (uint32_t iteration = 0; iteration < kBenchmarkIterations; iteration++)
+    {
+        visibleIndices.clear();
+        for (uint32_t i = 0; i < kBoxCount; i++)
+        {
+            if (pCamera->isObjectCulled(boxes[i].transform(mat)) == false) visibleIndices.push_back(i);
+        }
+    }
+    float scalarTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    size_t scalarVisible = visibleIndices.size();
+
+    // Batch path
+    BoundingBoxArray transformed;
+    start = CpuTimer::getCurrentTimePoint();
+    for (uint32_t iteration = 0; iteration < kBenchmarkIterations; iteration++)
+    {
+        boxArray.transform(mat, transformed);
+        pCamera->cullBoundingBoxes(transformed, visibleIndices);
+    }
+    float batchTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    logInfo("BoundingBoxTest: " + std::to_string(kBoxCount) + " boxes x " + std::to_string(kBenchmarkIterations) + " iterations. Per-box " + std::to_string(scalarTime) + " ms, batch " + std::to_string(batchTime) + " ms");
+
+    // The transforms round differently, so allow boxes right on a plane to differ
+    size_t difference = (scalarVisible > visibleIndices.size()) ? scalarVisible - visibleIndices.size() : visibleIndices.size() - scalarVisible;
+    if (difference > kBoxCount / 1000)
+    {
+        return test_fail("Batch path visible count doesn't match the per-box path");
+    }
+
+    return test_pass();
+}
+
+void BoundingBoxTest::generateBoxes(uint32_t count, std::vector<BoundingBox>& boxes, BoundingBoxArray& boxArray)
+{
+    srand(0);
+    auto randomFloat = [](float minVal, float maxVal) { return minVal + (maxVal - minVal) * static_cast<float>(rand()) / static_cast<float>(RAND_MAX); };
+
+    boxes.resize(count);
+    boxArray.clear();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        boxes[i].center = glm::vec3(randomFloat(-50.0f, 50.0f), randomFloat(-50.0f, 50.0f), randomFloat(-50.0f, 50.0f));
+        boxes[i].extent = glm::vec3(randomFloat(0.1f, 2.0f), randomFloat(0.1f, 2.0f), randomFloat(0.1f, 2.0f));
+        boxArray.push_back(boxes[i]);
+    }
+}
+
+Camera::SharedPtr BoundingBoxTest::createCamera()
+{
+    Camera::SharedPtr pCamera = Camera::create();
+    pCamera->setPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+    pCamera->setTarget(glm::vec3(1.0f, 0.2f, 0.5f));
+    pCamera->setDepthRange(0.1f, 40.0f);
+    return pCamera;
+}
+
+int main()
+{
+    BoundingBoxTest bbt;
+    bbt.init();
+    bbt.run();
+    return 0;
+}
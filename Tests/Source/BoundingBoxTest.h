@@ -25,29 +25,18 @@
 # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
-#include <thread>
+#pragma once
+#include "TestBase.h"
 
-template<uint32_t threadCount>
-class ThreadPool
+class BoundingBoxTest : public TestBase
 {
-public:
-    ~ThreadPool()
-    {
-        for (auto& t : mThreads)
-        {
-            if (t.joinable()) t.join();
-        }
-    }
-
-    std::thread& getAvailable()
-    {
-        std::thread& t = mThreads[mCurrent];
-        if (t.joinable()) t.join();
-        mCurrent = (mCurrent + 1) % arraysize(mThreads);
-        return t;
-    }
-
 private:
-    std::thread mThreads[threadCount];
-    uint32_t mCurrent = 0;
-};
\ No newline at end of file
+    void addTests() override;
+    void onInit() override {};
+    register_testing_func(TestTransform);
+    register_testing_func(TestCull);
+    register_testing_func(TestCullPerformance);
+
+    static void generateBoxes(uint32_t count, std::vector<BoundingBox>& boxes, BoundingBoxArray& boxArray);
+    static Camera::SharedPtr createCamera();
+};
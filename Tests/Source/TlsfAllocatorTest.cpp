@@ -0,0 +1,270 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "TlsfAllocatorTest.h"
+#include <random>
+
+static const uint64_t kHeapSize = 64ull * 1024 * 1024;
+static const uint32_t kRandomIterations = 200000;
+static const uint32_t kMaxLiveAllocations = 2000;
+static const uint32_t kStatsInterval = 1000;
+static const uint32_t kBenchmarkAllocations = 10000;
+static const uint32_t kBenchmarkIterations = 100;
+static const uint32_t kRequiredSizeIterations = 10000;
+
+void TlsfAllocatorTest::addTests()
+{
+    addTestToList<TestRandomAllocations>();
+    addTestToList<TestFillAndRelease>();
+    addTestToList<TestRequiredFreeBlockSize>();
+    addTestToList<TestPerformance>();
+}
+
+testing_func(TlsfAllocatorTest, TestRandomAllocations)
+{
+    TlsfAllocator::UniquePtr pAllocator = TlsfAllocator::create(kHeapSize);
+    std::mt19937 rng(0);
+    ShadowMap live;
+    uint32_t failedAllocations = 0;
+
+    for (uint32_t i = 0; i < kRandomIterations; i++)
+    {
+        if ((live.size() < kMaxLiveAllocations) && (rng() % 3 != 0))
+        {
+            // Mostly small allocations, with an occasional large one to fragment the heap
+            uint64_t size = 1 + rng() % ((rng() % 50 == 0) ? (1024 * 1024) : 8192);
+            uint64_t alignment = 1ull << (rng() % 17);
+            uint64_t offset = pAllocator->allocate(size, alignment);
+            if (offset == TlsfAllocator::kInvalidOffset)
+            {
+                failedAllocations++;
+                continue;
+            }
+
+            std::string error = checkAllocation(pAllocator.get(), live, offset, size, alignment);
+            if (error.size()) return test_fail(error);
+            live[offset] = align_to(TlsfAllocator::kMinBlockSize, size);
+        }
+        else if (live.size())
+        {
+            auto it = live.begin();
+            std::advance(it, rng() % live.size());
+            pAllocator->release(it->first);
+            live.erase(it);
+        }
+
+        if (i % kStatsInterval == 0)
+        {
+            std::string error = checkStats(pAllocator.get(), live);
+            if (error.size()) return test_fail(error);
+        }
+    }
+
+    // The live allocations take up well under half of the heap, so failures point at a fragmentation problem
+    if (failedAllocations > kRandomIterations / 100)
+    {
+        return test_fail("Too many allocations failed: " + std::to_string(failedAllocations));
+    }
+
+    for (const auto& allocation : live)
+    {
+        pAllocator->release(allocation.first);
+    }
+    live.clear();
+
+    std::string error = checkMerged(pAllocator.get());
+    if (error.size()) return test_fail(error);
+    return test_pass();
+}
+
+testing_func(TlsfAllocatorTest, TestFillAndRelease)
+{
+    // Fill the whole range with minimal blocks, then release every other block before the rest, so that every release has to merge with both neighbors
+    const uint64_t size = 1024 * TlsfAllocator::kMinBlockSize;
+    TlsfAllocator::UniquePtr pAllocator = TlsfAllocator::create(size);
+    ShadowMap live;
+    for (uint64_t i = 0; i < size / TlsfAllocator::kMinBlockSize; i++)
+    {
+        uint64_t offset = pAllocator->allocate(1);
+        if (offset == TlsfAllocator::kInvalidOffset) return test_fail("Allocation failed before the range was full");
+        std::string error = checkAllocation(pAllocator.get(), live, offset, 1, 1);
+        if (error.size()) return test_fail(error);
+        live[offset] = TlsfAllocator::kMinBlockSize;
+    }
+
+    if (pAllocator->allocate(1) != TlsfAllocator::kInvalidOffset) return test_fail("Allocation succeeded in a full range");
+    std::string error = checkStats(pAllocator.get(), live);
+    if (error.size()) return test_fail(error);
+
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        for (auto it = live.begin(); it != live.end();)
+        {
+            if ((it->first / TlsfAllocator::kMinBlockSize) % 2 == pass)
+            {
+                pAllocator->release(it->first);
+                it = live.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        error = checkStats(pAllocator.get(), live);
+        if (error.size()) return test_fail(error);
+    }
+
+    error = checkMerged(pAllocator.get());
+    if (error.size()) return test_fail(error);
+
+    // After merging, the whole range can be allocated at once
+    if (pAllocator->allocate(size) != 0) return test_fail("Can't allocate the whole range after releasing all the blocks");
+    return test_pass();
+}
+
+testing_func(TlsfAllocatorTest, TestRequiredFreeBlockSize)
+{
+    // ResourceAllocator relies on this to decide which allocations go to a page. An empty allocator has to satisfy exactly the allocations whose required size fits.
+    std::mt19937 rng(0);
+    for (uint32_t i = 0; i < kRequiredSizeIterations; i++)
+    {
+        const uint64_t rangeSize = TlsfAllocator::kMinBlockSize * (1 + rng() % 100000);
+        const uint64_t size = 1 + rng() % (rangeSize + rangeSize / 4);
+        const uint64_t alignment = 1ull << (rng() % 20);
+        const uint64_t requiredSize = TlsfAllocator::getRequiredFreeBlockSize(size, alignment);
+        if (requiredSize < align_to(TlsfAllocator::kMinBlockSize, size) + std::max<uint64_t>(alignment, TlsfAllocator::kMinBlockSize) - TlsfAllocator::kMinBlockSize)
+        {
+            return test_fail("The required size of a " + std::to_string(size) + " byte allocation doesn't cover the alignment padding");
+        }
+
+        TlsfAllocator::UniquePtr pAllocator = TlsfAllocator::create(rangeSize);
+        const bool allocated = (pAllocator->allocate(size, alignment) != TlsfAllocator::kInvalidOffset);
+        if (allocated != (requiredSize <= rangeSize))
+        {
+            return test_fail("Allocating " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment) + " from an empty " + std::to_string(rangeSize) + " byte range " +
+                (allocated ? "succeeded" : "failed") + ", but the required size is " + std::to_string(requiredSize));
+        }
+    }
+    return test_pass();
+}
+
+testing_func(TlsfAllocatorTest, TestPerformance)
+{
+    TlsfAllocator::UniquePtr pAllocator = TlsfAllocator::create(kHeapSize);
+    std::vector<uint64_t> offsets;
+    offsets.reserve(kBenchmarkAllocations);
+
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    for (uint32_t iteration = 0; iteration < kBenchmarkIterations; iteration++)
+    {
+        for (uint32_t i = 0; i < kBenchmarkAllocations; i++)
+        {
+            offsets.push_back(pAllocator->allocate(TlsfAllocator::kMinBlockSize * (1 + 2 * (i % 7))));
+        }
+        for (uint64_t offset : offsets)
+        {
+            if (offset == TlsfAllocator::kInvalidOffset) return test_fail("Benchmark allocation failed");
+            pAllocator->release(offset);
+        }
+        offsets.clear();
+    }
+    float time = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    const double operationCount = 2.0 * kBenchmarkAllocations * kBenchmarkIterations;
+    logInfo("TlsfAllocatorTest: " + std::to_string(kBenchmarkIterations) + " x " + std::to_string(kBenchmarkAllocations) + " allocations and releases in " + std::to_string(time) + " ms, " + std::to_string(time * 1e6 / operationCount) + " ns per operation");
+
+    std::string error = checkMerged(pAllocator.get());
+    if (error.size()) return test_fail(error);
+    return test_pass();
+}
+
+std::string TlsfAllocatorTest::checkAllocation(const TlsfAllocator* pAllocator, const ShadowMap& live, uint64_t offset, uint64_t size, uint64_t alignment)
+{
+    const uint64_t roundedSize = align_to(TlsfAllocator::kMinBlockSize, size);
+    if (offset % std::max<uint64_t>(alignment, TlsfAllocator::kMinBlockSize) != 0)
+    {
+        return "Offset " + std::to_string(offset) + " isn't aligned to " + std::to_string(alignment);
+    }
+    if (offset + roundedSize > pAllocator->getSize())
+    {
+        return "Allocation at offset " + std::to_string(offset) + " ends past the range";
+    }
+
+    // Compare against the closest live allocations on both sides
+    auto next = live.lower_bound(offset);
+    if ((next != live.end()) && (offset + roundedSize > next->first))
+    {
+        return "Allocation at offset " + std::to_string(offset) + " overlaps the one at " + std::to_string(next->first);
+    }
+    if (next != live.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second > offset)
+        {
+            return "Allocation at offset " + std::to_string(offset) + " overlaps the one at " + std::to_string(prev->first);
+        }
+    }
+    return "";
+}
+
+std::string TlsfAllocatorTest::checkStats(const TlsfAllocator* pAllocator, const ShadowMap& live)
+{
+    uint64_t usedBytes = 0;
+    for (const auto& allocation : live)
+    {
+        usedBytes += allocation.second;
+    }
+
+    TlsfAllocator::Stats stats = pAllocator->getStats();
+    if (stats.allocationCount != live.size()) return "Stats report " + std::to_string(stats.allocationCount) + " allocations, expected " + std::to_string(live.size());
+    if (stats.usedBytes != usedBytes) return "Stats report " + std::to_string(stats.usedBytes) + " used bytes, expected " + std::to_string(usedBytes);
+    if (stats.usedBytes + stats.freeBytes != stats.size) return "Used and free bytes don't add up to the range size";
+    if (stats.largestFreeBlock > stats.freeBytes) return "Largest free block is larger than the free bytes";
+    if ((stats.freeBytes != 0) && (stats.freeBlockCount == 0)) return "Free bytes reported without free blocks";
+    if (pAllocator->isEmpty() != live.empty()) return "isEmpty() doesn't match the live allocations";
+    return "";
+}
+
+std::string TlsfAllocatorTest::checkMerged(const TlsfAllocator* pAllocator)
+{
+    TlsfAllocator::Stats stats = pAllocator->getStats();
+    if ((pAllocator->isEmpty() == false) || (stats.usedBytes != 0)) return "Allocations remain after releasing all of them";
+    if ((stats.freeBlockCount != 1) || (stats.largestFreeBlock != stats.size) || (stats.freeBytes != stats.size))
+    {
+        return "Free blocks weren't merged back into one block. " + std::to_string(stats.freeBlockCount) + " free blocks remain";
+    }
+    if (stats.getFragmentation() != 0) return "Fragmentation should be 0 after all the blocks were merged";
+    return "";
+}
+
+int main()
+{
+    TlsfAllocatorTest tat;
+    tat.init();
+    tat.run();
+    return 0;
+}